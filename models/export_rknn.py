@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+YOLOv8 -> RKNN 转换脚本 (在 PC 上用 ultralytics + rknn-toolkit2 运行)
+
+两种导出方式：
+  默认        : 与 yolov8s_rknn_model 相同的 ultralytics RKNN 导出，后处理全部在 ARM 上做
+  --postprocess: 把 DFL 解码、类别取最大、分数阈值 + top-K 放进 RKNN 图里，
+                 输出压缩成 [1, K, 6] = (x1, y1, x2, y2, score, class)，
+                 NPU -> CPU 的传输和 CPU 后处理都只剩几 KB / 帧。
+                 Inference 加载时按输出形状 + metadata.yaml 的 postprocess: topk 自动识别。
+
+用法：
+  python3 export_rknn.py yolov8s.pt --data coco8.yaml --out yolov8s_int8.rknn
+  python3 export_rknn.py weed.pt --dataset calib.txt --postprocess --topk 100 --conf 0.25 --out weed_topk.rknn
+  python3 export_rknn.py weed.pt --dataset calib_nv12.txt --nv12-input --postprocess --out weed_nv12.rknn
+
+--nv12-input : 模型输入改为单通道 NV12 ([1, 1, H*3/2, W])，颜色转换和归一化在图里做，
+               采集缓冲区只经过一次 RGA 缩放就送进 NPU；校准图片列表需为同尺寸的 NV12 原始数据 (.npy)。
+
+--postprocess / --nv12-input 时输出 .rknn 旁边会生成 <模型名>_rknn_model/metadata.yaml，Inference 用它读取类别表、输入格式 (input: nv12) 和后处理类型。
+rknn-toolkit2 不支持的算子 (个别版本的 TopK) 会在 build 时回落到 CPU 算子，仍然只传 K 行结果。
+"""
+
+import argparse
+import os
+import shutil
+
+import torch
+import torch.nn as nn
+
+
+class Nv12Input(nn.Module):
+    """模型前面插一层 NV12 -> RGB：输入 [1, 1, H*3/2, W] 的 uint8 NV12，直接吃摄像头缓冲区的 RGA 缩放结果。
+    运算与 tests/test_nv12letterbox.cpp 的 referenceRGB 完全一致 (色度双线性上采样 + BT.601 limited range)，
+    改这里时两边要一起改，并用 ctest -R nv12 -V 的 "NV12输入校验" 看误差。"""
+
+    def __init__(self, model, imgsz):
+        super().__init__()
+        self.model = model
+        self.h = imgsz
+        self.w = imgsz
+
+    def forward(self, x):
+        h, w = self.h, self.w
+        y = x[:, :, :h, :]
+        uv = x[:, :, h:, :].reshape(1, h // 2, w // 2, 2).permute(0, 3, 1, 2)   # [1, 2, h/2, w/2]
+        uv = nn.functional.interpolate(uv, scale_factor=2, mode="bilinear", align_corners=False)
+        du = uv[:, 0:1] - 128.0
+        dv = uv[:, 1:2] - 128.0
+        yy = (y - 16.0) * 1.164
+        r = yy + 1.596 * dv
+        g = yy - 0.813 * dv - 0.391 * du
+        b = yy + 2.018 * du
+        rgb = torch.cat([r, g, b], dim=1).clamp(0.0, 255.0) / 255.0
+        return self.model(rgb)
+
+
+class InGraphPostprocess(nn.Module):
+    """包住 ultralytics 的检测模型：输出 [1, K, 6] 的 top-K 候选框 (未做 NMS)"""
+
+    def __init__(self, model, topk, conf):
+        super().__init__()
+        self.model = model
+        self.topk = topk
+        self.conf = conf
+
+    def forward(self, x):
+        y = self.model(x)
+        if isinstance(y, (list, tuple)):
+            y = y[0]
+        # 导出模式下 Detect 头已经在图里做完 DFL：[1, 4 + nc, N]，框为 cx, cy, w, h (输入像素)
+        boxes = y[:, :4, :]
+        scores = y[:, 4:, :]
+        score, cls = scores.max(dim=1)                       # [1, N]
+        top_score, top_idx = score.topk(self.topk, dim=1)    # [1, K]
+        top_boxes = boxes.gather(2, top_idx.unsqueeze(1).expand(-1, 4, -1))
+        top_cls = cls.gather(1, top_idx).float()
+
+        cx, cy, w, h = top_boxes[:, 0], top_boxes[:, 1], top_boxes[:, 2], top_boxes[:, 3]
+        # 低于阈值的行分数置 0，CPU 侧直接跳过
+        keep = (top_score > self.conf).float()
+        out = torch.stack([cx - w * 0.5, cy - h * 0.5, cx + w * 0.5, cy + h * 0.5,
+                           top_score * keep, top_cls], dim=2)
+        return out                                           # [1, K, 6]
+
+
+def export_onnx(args):
+    from ultralytics import YOLO
+
+    yolo = YOLO(args.weights)
+    if not args.postprocess and not args.nv12_input:
+        # 直接用 ultralytics 的 RKNN 导出 (即 yolov8s_rknn_model 的来源)，目录里自带 metadata.yaml
+        path = yolo.export(format="rknn", imgsz=args.imgsz, name=args.platform,
+                           int8=not args.fp16, data=args.data)
+        return path, yolo.names
+
+    model = yolo.model.float().eval()
+    for m in model.modules():
+        # 让 Detect 头走导出分支 (输出 [1, 4+nc, N]，DFL 在图内)
+        if m.__class__.__name__ == "Detect":
+            m.export = True
+            m.format = "onnx"
+    wrapped = InGraphPostprocess(model, args.topk, args.conf).eval() if args.postprocess else model
+    dummy = torch.zeros(1, 3, args.imgsz, args.imgsz)
+    if args.nv12_input:
+        wrapped = Nv12Input(wrapped, args.imgsz).eval()
+        dummy = torch.zeros(1, 1, args.imgsz * 3 // 2, args.imgsz)
+    onnx_path = os.path.splitext(args.out)[0] + ".onnx"
+    # NV12 输入的张量名与 metadata.yaml 的 input: nv12 一起作为 Inference 识别 NV12 模型的标记
+    input_name = "images_nv12" if args.nv12_input else "images"
+    torch.onnx.export(wrapped, dummy, onnx_path, opset_version=args.opset,
+                      input_names=[input_name], output_names=["detections"])
+    return onnx_path, yolo.names
+
+
+def build_rknn(onnx_path, args):
+    from rknn.api import RKNN
+
+    rknn = RKNN(verbose=False)
+    # 与 Inference 的输入一致：RGB888、0~255，归一化在图里做
+    if args.nv12_input:
+        # 单通道 NV12 原样进图，颜色转换和归一化都在 Nv12Input 里
+        rknn.config(mean_values=[[0]], std_values=[[1]], target_platform=args.platform)
+    else:
+        rknn.config(mean_values=[[0, 0, 0]], std_values=[[255, 255, 255]], target_platform=args.platform)
+    if rknn.load_onnx(model=onnx_path) != 0:
+        raise SystemExit("load_onnx 失败: " + onnx_path)
+    if rknn.build(do_quantization=not args.fp16, dataset=args.dataset) != 0:
+        raise SystemExit("rknn build 失败")
+    if rknn.export_rknn(args.out) != 0:
+        raise SystemExit("export_rknn 失败")
+    rknn.release()
+
+
+def write_metadata(names, args):
+    stem = os.path.splitext(os.path.basename(args.out))[0]
+    meta_dir = os.path.join(os.path.dirname(os.path.abspath(args.out)), stem + "_rknn_model")
+    os.makedirs(meta_dir, exist_ok=True)
+    with open(os.path.join(meta_dir, "metadata.yaml"), "w", encoding="utf-8") as f:
+        f.write("description: %s exported by export_rknn.py\n" % os.path.basename(args.weights))
+        f.write("stride: 32\n")
+        f.write("task: detect\n")
+        f.write("head: Detect\n")
+        f.write("batch: 1\n")
+        f.write("imgsz:\n- %d\n- %d\n" % (args.imgsz, args.imgsz))
+        f.write("names:\n")
+        for i in sorted(names):
+            f.write("  %d: %s\n" % (i, names[i]))
+        if args.nv12_input:
+            f.write("input: nv12\n")
+        if args.postprocess:
+            f.write("postprocess: topk\n")
+            f.write("topk: %d\n" % args.topk)
+        f.write("end2end: false\n")
+    if args.dataset and os.path.isfile(args.dataset):
+        shutil.copy(args.dataset, os.path.join(meta_dir, "dataset.txt"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="YOLOv8 -> RKNN (可选图内后处理)")
+    parser.add_argument("weights", help="ultralytics .pt 权重")
+    parser.add_argument("--dataset", help="量化校准图片列表 (每行一个路径)，--postprocess 时必填")
+    parser.add_argument("--data", default="coco8.yaml", help="默认导出方式的量化校准数据集 (ultralytics 数据集 yaml)")
+    parser.add_argument("--out", default="yolov8s_int8.rknn")
+    parser.add_argument("--imgsz", type=int, default=640)
+    parser.add_argument("--platform", default="rk3588")
+    parser.add_argument("--opset", type=int, default=12)
+    parser.add_argument("--fp16", action="store_true", help="不量化 (调试精度用)")
+    parser.add_argument("--postprocess", action="store_true", help="DFL + 类别最大 + top-K 放进图里，输出 [1, K, 6]")
+    parser.add_argument("--nv12-input", action="store_true",
+                        help="模型输入改为 [1, 1, H*3/2, W] 的 NV12，颜色转换放进图里 (可与 --postprocess 同时用)")
+    parser.add_argument("--topk", type=int, default=100)
+    parser.add_argument("--conf", type=float, default=0.25, help="图内分数阈值 (Inference 还会再按 0.45 过滤)")
+    args = parser.parse_args()
+    if (args.postprocess or args.nv12_input) and not args.dataset:
+        parser.error("--postprocess / --nv12-input 需要 --dataset 指定量化校准图片列表")
+
+    path, names = export_onnx(args)
+    if not args.postprocess and not args.nv12_input:
+        # ultralytics 导出的是 <模型名>_rknn_model/ 目录，把其中的 .rknn 拷到 --out，元数据留在原目录
+        rknn_files = [f for f in os.listdir(path) if f.endswith(".rknn")] if os.path.isdir(path) else []
+        if not rknn_files:
+            raise SystemExit("没有找到导出的 .rknn: " + str(path))
+        shutil.copy(os.path.join(path, rknn_files[0]), args.out)
+        print("导出完成:", args.out, "(元数据:", path, ")")
+        return
+    build_rknn(path, args)
+    write_metadata(names, args)
+    print("导出完成:", args.out)
+
+
+if __name__ == "__main__":
+    main()
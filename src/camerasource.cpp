@@ -0,0 +1,398 @@
+#include "camerasource.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <errno.h>
+#include <time.h>
+#include <linux/videodev2.h>
+
+// 按行拷贝一个平面，兼容驱动给出的 bytesperline 大于宽度的情况
+static void copyPlane(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width, int rows)
+{
+    if (dstStride == srcStride && dstStride == width) {
+        memcpy(dst, src, (size_t)width * rows);
+        return;
+    }
+    for (int r = 0; r < rows; ++r) {
+        memcpy(dst + (size_t)r * dstStride, src + (size_t)r * srcStride, width);
+    }
+}
+
+CameraSource* CameraSource::create(const CameraConfig& config)
+{
+    if (config.kind == CameraConfig::File) return new FileCamera(config);
+    return new V4l2Camera(config);
+}
+
+// ==========================================
+// V4l2Camera
+// ==========================================
+bool V4l2Camera::open()
+{
+    // 非阻塞打开，取帧时由 epoll 等待驱动通知
+    m_fd = ::open(m_config.source.c_str(), O_RDWR | O_NONBLOCK);
+    if (m_fd < 0) {
+        qDebug() << "【致命错误】打开摄像头设备失败！" << m_config.source.c_str();
+        return false;
+    }
+
+    // 1. 判断是多平面 (rkisp) 还是单平面 (v4l2loopback) 设备
+    v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if (ioctl(m_fd, VIDIOC_QUERYCAP, &cap) == 0) {
+        uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+        m_mplane = (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) != 0;
+    }
+    v4l2_buf_type type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    // 2. 设置格式 NV12
+    v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = type;
+    if (m_mplane) {
+        fmt.fmt.pix_mp.width = m_config.width;
+        fmt.fmt.pix_mp.height = m_config.height;
+        fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_NV12M;
+        fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        fmt.fmt.pix_mp.num_planes = 2;
+    } else {
+        fmt.fmt.pix.width = m_config.width;
+        fmt.fmt.pix.height = m_config.height;
+        fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_NV12;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    }
+    if (ioctl(m_fd, VIDIOC_S_FMT, &fmt) < 0) {
+        qDebug() << "【致命错误】设置摄像头格式失败！" << m_config.source.c_str();
+        close();
+        return false;
+    }
+
+    // 驱动可能会调整分辨率，以实际值为准
+    if (m_mplane) {
+        m_config.width = fmt.fmt.pix_mp.width;
+        m_config.height = fmt.fmt.pix_mp.height;
+        m_numPlanes = fmt.fmt.pix_mp.num_planes;
+        m_bytesPerLine = fmt.fmt.pix_mp.plane_fmt[0].bytesperline;
+    } else {
+        m_config.width = fmt.fmt.pix.width;
+        m_config.height = fmt.fmt.pix.height;
+        m_numPlanes = 1;
+        m_bytesPerLine = fmt.fmt.pix.bytesperline;
+    }
+    if (m_bytesPerLine <= 0) m_bytesPerLine = m_config.width;
+
+    // 3. 设置帧率
+    v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = type;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = m_config.fps;
+    ioctl(m_fd, VIDIOC_S_PARM, &parm);
+
+    // 4. 申请 mmap 缓冲区 (个数可配置，驱动可能会改成它支持的值)
+    v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = std::max(2, m_config.bufferCount);
+    req.type = type;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (ioctl(m_fd, VIDIOC_REQBUFS, &req) < 0) {
+        qDebug() << "【致命错误】申请缓冲区失败！" << m_config.source.c_str();
+        close();
+        return false;
+    }
+
+    // 5. mmap 每个 buffer 的每个 plane
+    m_buffers.assign(req.count, std::vector<PlaneBuf>());
+    for (unsigned i = 0; i < req.count; i++) {
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (m_mplane) {
+            buf.m.planes = planes;
+            buf.length = m_numPlanes;
+        }
+
+        if (ioctl(m_fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            qDebug() << "【致命错误】查询缓冲区失败！";
+            close();
+            return false;
+        }
+
+        for (int p = 0; p < m_numPlanes; p++) {
+            size_t length = m_mplane ? planes[p].length : buf.length;
+            off_t offset = m_mplane ? planes[p].m.mem_offset : buf.m.offset;
+            PlaneBuf pb;
+            pb.length = length;
+            pb.start = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+            if (pb.start == MAP_FAILED) {
+                qDebug() << "【致命错误】mmap失败！";
+                close();
+                return false;
+            }
+            m_buffers[i].push_back(pb);
+        }
+        ioctl(m_fd, VIDIOC_QBUF, &buf);
+    }
+
+    // 6. 注册 epoll，驱动有帧可取时唤醒采集线程
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    if (m_epollFd < 0 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fd, &ev) < 0) {
+        qDebug() << "【致命错误】epoll 注册失败！" << m_config.source.c_str();
+        close();
+        return false;
+    }
+
+    // 7. 开始 streaming
+    if (ioctl(m_fd, VIDIOC_STREAMON, &type) < 0) {
+        qDebug() << "【致命错误】启动streaming失败！" << m_config.source.c_str();
+        close();
+        return false;
+    }
+    m_haveSeq = false;
+
+    qDebug() << "✅ 摄像头" << m_config.id << m_config.source.c_str() << "采集初始化成功:"
+             << m_config.width << "x" << m_config.height << (m_mplane ? "(多平面)" : "(单平面)")
+             << "缓冲区:" << req.count;
+    return true;
+}
+
+bool V4l2Camera::grab(CameraFrame& frame)
+{
+    if (m_fd < 0) return false;
+
+    // 等驱动出帧，100ms 超时是为了让采集线程能及时响应停止
+    epoll_event ev;
+    int n = epoll_wait(m_epollFd, &ev, 1, 100);
+    if (n <= 0) return false;
+    if (ev.events & (EPOLLERR | EPOLLHUP)) {
+        // 设备出错 (拔线/驱动复位)，避免空转占满 CPU
+        usleep(10000);
+        return false;
+    }
+
+    v4l2_buffer buf;
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buf, 0, sizeof(buf));
+    memset(planes, 0, sizeof(planes));
+    buf.type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (m_mplane) {
+        buf.m.planes = planes;
+        buf.length = m_numPlanes;
+    }
+
+    if (ioctl(m_fd, VIDIOC_DQBUF, &buf) < 0) {
+        if (errno != EAGAIN) {
+            qDebug() << "【警告】DQBUF 失败:" << strerror(errno);
+        }
+        return false;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // 拷贝成一块连续的 NV12，立刻把 buffer 还给驱动
+    int w = m_config.width, h = m_config.height;
+    frame.nv12.create(h + h / 2, w, CV_8UC1);
+    const std::vector<PlaneBuf>& pb = m_buffers[buf.index];
+    const uint8_t* ySrc = (const uint8_t*)pb[0].start;
+    const uint8_t* uvSrc = (m_numPlanes > 1) ? (const uint8_t*)pb[1].start
+                                              : ySrc + (size_t)m_bytesPerLine * h;
+    copyPlane(frame.nv12.data, w, ySrc, m_bytesPerLine, w, h);
+    copyPlane(frame.nv12.data + (size_t)w * h, w, uvSrc, m_bytesPerLine, w, h / 2);
+
+    ioctl(m_fd, VIDIOC_QBUF, &buf);
+
+    frame.cameraId = m_config.id;
+    frame.seq = m_seq++;
+    frame.width = w;
+    frame.height = h;
+
+    // 驱动序号不连续说明驱动侧已经丢帧 (用户态取得太慢，缓冲区被覆盖)
+    frame.driverSeq = buf.sequence;
+    frame.driverDropped = (m_haveSeq && buf.sequence > m_lastSeq + 1) ? buf.sequence - m_lastSeq - 1 : 0;
+    m_lastSeq = buf.sequence;
+    m_haveSeq = true;
+
+    // rkisp 的时间戳是 CLOCK_MONOTONIC，与 steady_clock 同源，可以直接当采集时刻用
+    int64_t nowUs = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    int64_t tsUs = (int64_t)buf.timestamp.tv_sec * 1000000 + buf.timestamp.tv_usec;
+    bool monotonic = (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+    if (monotonic && tsUs > 0 && tsUs <= nowUs) {
+        frame.captureTime = std::chrono::steady_clock::time_point(std::chrono::microseconds(tsUs));
+        frame.ispDelayMs = (nowUs - tsUs) / 1000.0;
+    } else {
+        frame.captureTime = std::chrono::steady_clock::now();
+        frame.ispDelayMs = 0.0;
+    }
+    return true;
+}
+
+void V4l2Camera::close()
+{
+    if (m_epollFd >= 0) {
+        ::close(m_epollFd);
+        m_epollFd = -1;
+    }
+    if (m_fd < 0) return;
+    v4l2_buf_type type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ioctl(m_fd, VIDIOC_STREAMOFF, &type);
+    for (auto& planeBufs : m_buffers) {
+        for (auto& pb : planeBufs) {
+            munmap(pb.start, pb.length);
+        }
+    }
+    m_buffers.clear();
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+void bgrToNv12(const cv::Mat& bgr, cv::Mat& nv12)
+{
+    // OpenCV 只能直接转 I420，这里把 U/V 两个平面交织成 NV12 的 UV 平面
+    cv::Mat i420;
+    cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+    int w = bgr.cols, h = bgr.rows;
+    size_t ySize = (size_t)w * h;
+    size_t cSize = ySize / 4;
+    nv12.create(h * 3 / 2, w, CV_8UC1);
+    memcpy(nv12.data, i420.data, ySize);
+    const uint8_t* u = i420.data + ySize;
+    const uint8_t* v = u + cSize;
+    uint8_t* uv = nv12.data + ySize;
+    for (size_t i = 0; i < cSize; ++i) {
+        uv[2 * i] = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+}
+
+// ==========================================
+// FileCamera
+// ==========================================
+static bool endsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool FileCamera::open()
+{
+    const std::string& path = m_config.source;
+    if (endsWith(path, ".nv12") || endsWith(path, ".yuv")) {
+        m_raw = fopen(path.c_str(), "rb");
+        if (!m_raw) {
+            qDebug() << "【致命错误】打开 NV12 回放文件失败:" << path.c_str();
+            return false;
+        }
+    } else if (!m_video.open(path)) {
+        qDebug() << "【致命错误】打开视频回放文件失败:" << path.c_str();
+        return false;
+    }
+    m_nextFrameTime = std::chrono::steady_clock::now();
+    qDebug() << "✅ 虚拟摄像头" << m_config.id << "回放:" << path.c_str()
+             << m_config.width << "x" << m_config.height << "@" << m_config.fps << "fps";
+    return true;
+}
+
+bool FileCamera::readRawFrame(cv::Mat& nv12)
+{
+    size_t frameBytes = (size_t)m_config.width * m_config.height * 3 / 2;
+    nv12.create(m_config.height * 3 / 2, m_config.width, CV_8UC1);
+    if (fread(nv12.data, 1, frameBytes, m_raw) == frameBytes) return true;
+
+    // 播完了从头循环
+    rewind(m_raw);
+    return fread(nv12.data, 1, frameBytes, m_raw) == frameBytes;
+}
+
+bool FileCamera::readVideoFrame(cv::Mat& nv12)
+{
+    cv::Mat bgr;
+    if (!m_video.read(bgr)) {
+        m_video.set(cv::CAP_PROP_POS_FRAMES, 0);
+        if (!m_video.read(bgr)) return false;
+    }
+    if (bgr.cols != m_config.width || bgr.rows != m_config.height) {
+        cv::resize(bgr, bgr, cv::Size(m_config.width, m_config.height));
+    }
+    bgrToNv12(bgr, nv12);
+    return true;
+}
+
+bool FileCamera::grab(CameraFrame& frame)
+{
+    // 按帧率节拍出帧，模拟真实摄像头
+    std::this_thread::sleep_until(m_nextFrameTime);
+    m_nextFrameTime += std::chrono::microseconds(1000000 / std::max(1, m_config.fps));
+
+    bool ok = m_raw ? readRawFrame(frame.nv12) : readVideoFrame(frame.nv12);
+    if (!ok) return false;
+
+    frame.cameraId = m_config.id;
+    frame.seq = m_seq++;
+    frame.width = m_config.width;
+    frame.height = m_config.height;
+    frame.captureTime = std::chrono::steady_clock::now();
+    return true;
+}
+
+void FileCamera::close()
+{
+    if (m_raw) {
+        fclose(m_raw);
+        m_raw = nullptr;
+    }
+    m_video.release();
+}
+
+// ==========================================
+// 摄像头列表解析
+// ==========================================
+std::vector<CameraConfig> parseCameraList(const std::string& spec)
+{
+    std::vector<CameraConfig> configs;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        CameraConfig cfg;
+        cfg.id = (int)configs.size();
+
+        size_t star = item.find('*');
+        if (star != std::string::npos) {
+            cfg.weight = std::max(1, atoi(item.c_str() + star + 1));
+            item = item.substr(0, star);
+        }
+        size_t at = item.find('@');
+        if (at != std::string::npos) {
+            int w = 0, h = 0;
+            if (sscanf(item.c_str() + at + 1, "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                cfg.width = w;
+                cfg.height = h;
+            }
+            item = item.substr(0, at);
+        }
+        if (item.compare(0, 5, "file:") == 0) {
+            cfg.kind = CameraConfig::File;
+            item = item.substr(5);
+        }
+        cfg.source = item;
+        configs.push_back(cfg);
+    }
+    return configs;
+}
@@ -0,0 +1,118 @@
+#ifndef CAMERASOURCE_H
+#define CAMERASOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ==========================================
+// 摄像头数据源抽象
+// 真实的 V4L2 设备 (rkisp / v4l2loopback) 和文件回放的虚拟摄像头共用一套接口，
+// 由 CaptureManager 为每个数据源开一个采集线程
+// ==========================================
+
+// 单路摄像头配置
+struct CameraConfig {
+    enum Kind { V4L2, File };
+
+    int id = 0;              // 摄像头编号，会写进检测结果
+    Kind kind = V4L2;
+    std::string source;      // /dev/videoX 或文件路径
+    int width = 800;
+    int height = 600;
+    int fps = 60;
+    int weight = 1;          // 调度权重，越大分到的 NPU 时间越多
+    int bufferCount = 4;     // V4L2 驱动缓冲区个数
+};
+
+// 采集到的一帧 (连续存放的 NV12：Y 平面在上，UV 平面在下)
+struct CameraFrame {
+    int cameraId = -1;
+    uint64_t seq = 0;
+    cv::Mat nv12;
+    int width = 0;
+    int height = 0;
+    // 采集时刻：V4L2 设备取驱动打的单调时钟时间戳 (ISP 出帧时刻)，其余取到帧的时刻
+    std::chrono::steady_clock::time_point captureTime;
+
+    uint32_t driverSeq = 0;     // 驱动帧序号 (v4l2_buffer.sequence)
+    uint32_t driverDropped = 0; // 与上一帧之间驱动侧丢掉的帧数
+    double ispDelayMs = 0.0;    // ISP 出帧 -> 用户态拿到 的延迟
+};
+
+class CameraSource
+{
+public:
+    explicit CameraSource(const CameraConfig& config) : m_config(config) {}
+    virtual ~CameraSource() {}
+
+    virtual bool open() = 0;
+    // 取一帧；内部最多阻塞约 100ms 等数据，超时或出错返回 false，调用方直接重试
+    virtual bool grab(CameraFrame& frame) = 0;
+    virtual void close() = 0;
+
+    const CameraConfig& config() const { return m_config; }
+
+    static CameraSource* create(const CameraConfig& config);
+
+protected:
+    CameraConfig m_config;
+    uint64_t m_seq = 0;
+};
+
+// 原生 V4L2 + mmap 采集，兼容多平面 (rkisp NV12M) 和单平面 (v4l2loopback NV12)
+// 非阻塞 fd + epoll 等帧，不再 DQBUF 失败后 sleep 重试
+class V4l2Camera : public CameraSource
+{
+public:
+    explicit V4l2Camera(const CameraConfig& config) : CameraSource(config) {}
+    ~V4l2Camera() override { close(); }
+
+    bool open() override;
+    bool grab(CameraFrame& frame) override;
+    void close() override;
+
+private:
+    struct PlaneBuf { void* start; size_t length; };
+
+    int m_fd = -1;
+    int m_epollFd = -1;
+    bool m_mplane = true;
+    bool m_haveSeq = false;
+    uint32_t m_lastSeq = 0;
+    int m_numPlanes = 2;
+    int m_bytesPerLine = 0;
+    std::vector<std::vector<PlaneBuf>> m_buffers;
+};
+
+// 文件回放的虚拟摄像头：裸 NV12 帧序列 (*.nv12/*.yuv) 或 OpenCV 能打开的视频文件
+// 按配置帧率节拍出帧，播完自动循环，用于没有硬件时的联调和压测
+class FileCamera : public CameraSource
+{
+public:
+    explicit FileCamera(const CameraConfig& config) : CameraSource(config) {}
+    ~FileCamera() override { close(); }
+
+    bool open() override;
+    bool grab(CameraFrame& frame) override;
+    void close() override;
+
+private:
+    bool readRawFrame(cv::Mat& nv12);
+    bool readVideoFrame(cv::Mat& nv12);
+
+    FILE* m_raw = nullptr;
+    cv::VideoCapture m_video;
+    std::chrono::steady_clock::time_point m_nextFrameTime;
+};
+
+// 解析摄像头列表，格式：逗号分隔，每项为 [file:]路径[@宽x高][*权重]
+// 例如 "/dev/video11,/dev/video20@1280x720*2,file:/data/row3.nv12@800x600"
+std::vector<CameraConfig> parseCameraList(const std::string& spec);
+
+// BGR 图转成连续存放的 NV12 (宽高需为偶数)，文件回放和离线评测共用
+void bgrToNv12(const cv::Mat& bgr, cv::Mat& nv12);
+
+#endif // CAMERASOURCE_H
@@ -0,0 +1,237 @@
+#include "capturemanager.h"
+#include <QDebug>
+#include <QString>
+
+CaptureManager::CaptureManager()
+{
+    m_statsStart = std::chrono::steady_clock::now();
+}
+
+CaptureManager::~CaptureManager()
+{
+    stop();
+}
+
+void CaptureManager::addCamera(const CameraConfig& config)
+{
+    std::unique_ptr<Camera> cam(new Camera);
+    cam->source.reset(CameraSource::create(config));
+    cam->weight = std::max(1, config.weight);
+
+    // 推理线程可能已经在 waitFrame 里遍历摄像头列表，改列表要加锁
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 同一个 id 重复添加 (还没 start 就又配了一次) 时以后一次为准，不会出现两路同号摄像头
+    for (auto& existing : m_cameras) {
+        if (existing->source->config().id != config.id) continue;
+        if (m_running) {
+            qDebug() << "【警告】摄像头" << config.id << "已在采集中，忽略重复添加";
+        } else {
+            existing = std::move(cam);
+        }
+        return;
+    }
+    m_cameras.push_back(std::move(cam));
+}
+
+bool CaptureManager::start()
+{
+    if (m_running) return true;
+
+    // 打不开的摄像头直接剔除，剩下的照常工作 (open 比较慢，先不加锁)
+    std::vector<bool> opened;
+    for (auto& cam : m_cameras) {
+        bool ok = cam->source->open();
+        if (!ok) qDebug() << "【警告】摄像头" << cam->source->config().id << "打开失败，已跳过";
+        opened.push_back(ok);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::unique_ptr<Camera>> alive;
+        for (size_t i = 0; i < m_cameras.size(); ++i) {
+            if (opened[i]) alive.push_back(std::move(m_cameras[i]));
+        }
+        m_cameras.swap(alive);
+    }
+    if (m_cameras.empty()) {
+        qDebug() << "【致命错误】没有可用的摄像头！";
+        return false;
+    }
+
+    m_shutdown = false;
+    m_running = true;
+    resetStats();
+    for (auto& cam : m_cameras) {
+        cam->thread = std::thread(&CaptureManager::captureLoop, this, cam.get());
+    }
+    qDebug() << "✅ 多摄像头采集已启动，共" << (int)m_cameras.size() << "路";
+    return true;
+}
+
+void CaptureManager::stop()
+{
+    m_running = false;
+    m_shutdown = true;
+    m_condition.notify_all();
+    for (auto& cam : m_cameras) {
+        if (cam->thread.joinable()) cam->thread.join();
+        cam->source->close();
+    }
+    // 摄像头列表随 stop 清空：下次 start 前由 Vision 重新 addCamera，避免每次启停都多出一份
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cameras.clear();
+}
+
+// ==========================================
+// 每路摄像头的采集线程：只负责取帧塞进自己的环形队列
+// ==========================================
+void CaptureManager::captureLoop(Camera* cam)
+{
+    qDebug() << ">>> [采集" << cam->source->config().id << "] 线程启动";
+
+    while (m_running) {
+        // grab 内部用 epoll / 帧率节拍阻塞等待，这里不需要再 sleep
+        CameraFrame frame;
+        if (!cam->source->grab(frame)) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // ⚠️ 处理不过来就丢弃最老的帧，保证最新画面的实时性
+            if (cam->ring.size() >= m_ringCapacity) {
+                cam->ring.pop_front();
+                cam->dropped++;
+            }
+            cam->captured++;
+            cam->driverDropped += frame.driverDropped;
+            cam->ispDelaySumMs += frame.ispDelayMs;
+            if (frame.ispDelayMs > cam->ispDelayMaxMs) cam->ispDelayMaxMs = frame.ispDelayMs;
+            cam->ring.push_back(std::move(frame));
+        }
+        m_condition.notify_one();
+    }
+
+    qDebug() << ">>> [采集" << cam->source->config().id << "] 线程安全退出。";
+}
+
+// 平滑加权轮询 (同 nginx)：只在有待处理帧的摄像头之间分配，
+// 权重 2:1 的两路摄像头在都有帧时按 A A B 的节奏交替，不会饿死任何一路
+int CaptureManager::pickCameraLocked()
+{
+    int best = -1;
+    int totalWeight = 0;
+    for (size_t i = 0; i < m_cameras.size(); ++i) {
+        Camera* cam = m_cameras[i].get();
+        if (cam->ring.empty()) continue;
+        cam->currentWeight += cam->weight;
+        totalWeight += cam->weight;
+        if (best < 0 || cam->currentWeight > m_cameras[best]->currentWeight) {
+            best = (int)i;
+        }
+    }
+    if (best >= 0) m_cameras[best]->currentWeight -= totalWeight;
+    return best;
+}
+
+bool CaptureManager::waitFrame(CameraFrame& frame)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int idx = -1;
+    m_condition.wait(lock, [&]{
+        if (m_shutdown) return true;
+        idx = pickCameraLocked();
+        return idx >= 0;
+    });
+    if (idx < 0) return false;
+
+    Camera* cam = m_cameras[idx].get();
+    frame = std::move(cam->ring.front());
+    cam->ring.pop_front();
+    return true;
+}
+
+bool CaptureManager::waitFrame(CameraFrame& frame, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int idx = -1;
+    m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]{
+        if (m_shutdown) return true;
+        idx = pickCameraLocked();
+        return idx >= 0;
+    });
+    if (idx < 0) return false;
+
+    Camera* cam = m_cameras[idx].get();
+    frame = std::move(cam->ring.front());
+    cam->ring.pop_front();
+    return true;
+}
+
+void CaptureManager::reportProcessed(const CameraFrame& frame)
+{
+    double latencyMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - frame.captureTime).count();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& cam : m_cameras) {
+        if (cam->source->config().id != frame.cameraId) continue;
+        cam->processed++;
+        cam->latencySumMs += latencyMs;
+        if (latencyMs > cam->latencyMaxMs) cam->latencyMaxMs = latencyMs;
+        break;
+    }
+}
+
+std::vector<CaptureManager::CameraStats> CaptureManager::snapshot()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_statsStart).count();
+
+    std::vector<CameraStats> stats;
+    for (auto& cam : m_cameras) {
+        CameraStats s;
+        s.cameraId = cam->source->config().id;
+        s.source = cam->source->config().source;
+        s.captureFps = elapsed > 0 ? cam->captured / elapsed : 0.0;
+        s.processFps = elapsed > 0 ? cam->processed / elapsed : 0.0;
+        s.dropped = cam->dropped;
+        s.driverDropped = cam->driverDropped;
+        s.avgIspDelayMs = cam->captured > 0 ? cam->ispDelaySumMs / cam->captured : 0.0;
+        s.maxIspDelayMs = cam->ispDelayMaxMs;
+        s.avgLatencyMs = cam->processed > 0 ? cam->latencySumMs / cam->processed : 0.0;
+        s.maxLatencyMs = cam->latencyMaxMs;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void CaptureManager::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& cam : m_cameras) {
+        cam->captured = 0;
+        cam->processed = 0;
+        cam->dropped = 0;
+        cam->driverDropped = 0;
+        cam->ispDelaySumMs = 0.0;
+        cam->ispDelayMaxMs = 0.0;
+        cam->latencySumMs = 0.0;
+        cam->latencyMaxMs = 0.0;
+    }
+    m_statsStart = std::chrono::steady_clock::now();
+}
+
+void CaptureManager::dumpStats()
+{
+    for (const auto& s : snapshot()) {
+        qDebug() << "[摄像头" << s.cameraId << "]" << s.source.c_str()
+                 << "采集:" << QString::number(s.captureFps, 'f', 1) << "fps"
+                 << "推理:" << QString::number(s.processFps, 'f', 1) << "fps"
+                 << "丢帧:" << s.dropped
+                 << "驱动丢帧:" << s.driverDropped
+                 << "ISP延迟:" << QString::number(s.avgIspDelayMs, 'f', 1) << "/"
+                 << QString::number(s.maxIspDelayMs, 'f', 1) << "ms"
+                 << "平均延迟:" << QString::number(s.avgLatencyMs, 'f', 1) << "ms"
+                 << "最大延迟:" << QString::number(s.maxLatencyMs, 'f', 1) << "ms";
+    }
+}
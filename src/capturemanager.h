@@ -0,0 +1,88 @@
+#ifndef CAPTUREMANAGER_H
+#define CAPTUREMANAGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "camerasource.h"
+
+// ==========================================
+// 多摄像头采集管理器
+// 每路摄像头一个采集线程 + 一个小环形队列 (满了丢最老的帧，保证实时性)，
+// NPU 推理线程通过 waitFrame() 按加权轮询从各路摄像头公平取帧
+// ==========================================
+class CaptureManager
+{
+public:
+    struct CameraStats {
+        int cameraId;
+        std::string source;
+        double captureFps;    // 采集帧率
+        double processFps;    // 实际被推理的帧率
+        uint64_t dropped;     // 因队列满被丢弃的帧数
+        uint64_t driverDropped; // 驱动侧丢帧 (帧序号不连续)
+        double avgIspDelayMs; // ISP 出帧 -> 用户态取到 平均延迟
+        double maxIspDelayMs;
+        double avgLatencyMs;  // 采集 -> 推理完成 平均延迟
+        double maxLatencyMs;
+    };
+
+    CaptureManager();
+    ~CaptureManager();
+
+    // 同一 id 只保留一路 (未启动时后添加的覆盖先添加的)
+    void addCamera(const CameraConfig& config);
+    bool start();
+    // 停止采集并清空摄像头列表，之后可以重新 addCamera + start
+    void stop();
+    bool isRunning() const { return m_running; }
+    int cameraCount() const { return (int)m_cameras.size(); }
+
+    // 推理线程调用：阻塞直到拿到一帧 (摄像头还没启动时也会一直等)，stop() 后返回 false
+    bool waitFrame(CameraFrame& frame);
+    // 带超时版本：超时或 stop() 都返回 false，给还要兼顾其他任务的推理线程用
+    bool waitFrame(CameraFrame& frame, int timeoutMs);
+    // 推理线程处理完一帧后回报，用于统计每路延迟
+    void reportProcessed(const CameraFrame& frame);
+
+    std::vector<CameraStats> snapshot();
+    void resetStats();
+    void dumpStats();
+
+private:
+    struct Camera {
+        std::unique_ptr<CameraSource> source;
+        std::thread thread;
+        std::deque<CameraFrame> ring;
+        int weight = 1;
+        int currentWeight = 0;   // 平滑加权轮询的当前权值
+
+        // 统计 (受 m_mutex 保护)
+        uint64_t captured = 0;
+        uint64_t processed = 0;
+        uint64_t dropped = 0;
+        uint64_t driverDropped = 0;
+        double ispDelaySumMs = 0.0;
+        double ispDelayMaxMs = 0.0;
+        double latencySumMs = 0.0;
+        double latencyMaxMs = 0.0;
+    };
+
+    void captureLoop(Camera* cam);
+    int pickCameraLocked();
+
+    std::vector<std::unique_ptr<Camera>> m_cameras;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::atomic<bool> m_running{false};   // 采集线程运行标志
+    std::atomic<bool> m_shutdown{false};  // 整个模块关闭，唤醒并放走所有推理线程
+    size_t m_ringCapacity = 2;
+    std::chrono::steady_clock::time_point m_statsStart;
+};
+
+#endif // CAPTUREMANAGER_H
@@ -0,0 +1,112 @@
+#include "detectroi.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+cv::Rect DetectRoi::bounds(const cv::Size& frameSize) const
+{
+    cv::Rect box;
+    bool first = true;
+    for (const auto& r : rects) {
+        box = first ? r : (box | r);
+        first = false;
+    }
+    if (polygon.size() >= 3) {
+        cv::Rect p = cv::boundingRect(polygon);
+        box = first ? p : (box | p);
+        first = false;
+    }
+    box &= cv::Rect(0, 0, frameSize.width, frameSize.height);
+    if (box.width <= 0 || box.height <= 0) return cv::Rect();
+
+    // 起点向下取偶，终点向上取偶 (不超出帧)
+    int x0 = box.x & ~1;
+    int y0 = box.y & ~1;
+    int x1 = std::min(frameSize.width & ~1, (box.x + box.width + 1) & ~1);
+    int y1 = std::min(frameSize.height & ~1, (box.y + box.height + 1) & ~1);
+    if (x1 <= x0 || y1 <= y0) return cv::Rect();
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+bool DetectRoi::parse(const std::string& spec, DetectRoi& roi)
+{
+    roi = DetectRoi();
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        if (item.empty()) continue;
+        if (item.compare(0, 5, "poly:") == 0) {
+            std::stringstream ps(item.substr(5));
+            std::string pt;
+            roi.polygon.clear();
+            while (ps >> pt) {
+                int x = 0, y = 0;
+                if (sscanf(pt.c_str(), "%d,%d", &x, &y) != 2) return false;
+                roi.polygon.push_back(cv::Point(x, y));
+            }
+            if (roi.polygon.size() < 3) return false;
+        } else {
+            int x = 0, y = 0, w = 0, h = 0;
+            if (sscanf(item.c_str(), "%d,%d,%d,%d", &x, &y, &w, &h) != 4 || w <= 0 || h <= 0) return false;
+            roi.rects.push_back(cv::Rect(x, y, w, h));
+        }
+    }
+    return !roi.empty();
+}
+
+void RoiCellMask::build(const DetectRoi& roi, const cv::Size& frame, const cv::Rect& cropRect,
+                        const cv::Size& modelSize, float scale, int padLeft, int padTop,
+                        const std::vector<int>& strideList)
+{
+    frameSize = frame;
+    crop = cropRect;
+    strides = strideList;
+    cells.assign(strides.size(), std::vector<uint8_t>());
+    activeCells = 0;
+    totalCells = 0;
+
+    // 先在裁剪区坐标系里把 ROI 画成二值图，再用积分图查每个格子覆盖的范围里有没有 ROI 像素
+    cv::Mat area = cv::Mat::zeros(crop.height, crop.width, CV_8UC1);
+    for (const auto& r : roi.rects) {
+        cv::Rect local = (r & crop) - crop.tl();
+        if (local.width > 0 && local.height > 0) area(local).setTo(cv::Scalar(1));
+    }
+    if (roi.polygon.size() >= 3) {
+        std::vector<std::vector<cv::Point>> polys(1);
+        for (const auto& p : roi.polygon) polys[0].push_back(p - crop.tl());
+        cv::fillPoly(area, polys, cv::Scalar(1));
+    }
+    cv::Mat integral;
+    cv::integral(area, integral, CV_32S);
+
+    for (size_t s = 0; s < strides.size(); ++s) {
+        const int stride = strides[s];
+        const int gridW = modelSize.width / stride;
+        const int gridH = modelSize.height / stride;
+        std::vector<uint8_t>& mask = cells[s];
+        mask.assign((size_t)gridW * gridH, 0);
+        totalCells += gridW * gridH;
+
+        for (int gy = 0; gy < gridH; ++gy) {
+            // 格子在模型输入上的范围 -> 裁剪区像素范围 (落在灰边里的格子自然为空)
+            int y0 = std::max(0, (int)std::floor((gy * stride - padTop) / scale));
+            int y1 = std::min(crop.height, (int)std::ceil(((gy + 1) * stride - padTop) / scale));
+            if (y1 <= y0) continue;
+            for (int gx = 0; gx < gridW; ++gx) {
+                int x0 = std::max(0, (int)std::floor((gx * stride - padLeft) / scale));
+                int x1 = std::min(crop.width, (int)std::ceil(((gx + 1) * stride - padLeft) / scale));
+                if (x1 <= x0) continue;
+                int sum = integral.at<int>(y1, x1) - integral.at<int>(y0, x1)
+                        - integral.at<int>(y1, x0) + integral.at<int>(y0, x0);
+                if (sum > 0) {
+                    mask[(size_t)gy * gridW + gx] = 1;
+                    activeCells++;
+                }
+            }
+        }
+    }
+    qDebug() << ">>> ROI 网格掩码: 帧" << frame.width << "x" << frame.height
+             << "裁剪" << crop.x << crop.y << crop.width << "x" << crop.height
+             << "有效格子" << activeCells << "/" << totalCells;
+}
@@ -0,0 +1,47 @@
+#ifndef DETECTROI_H
+#define DETECTROI_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ==========================================
+// 推理感兴趣区域 (激光可达区)
+// 激光只能打到画面里固定的一条带，带外的苗检测出来也没用。
+// ROI 由若干矩形和 / 或一个多边形组成 (检测流图像坐标)：
+// 预处理只裁剪 ROI 外接矩形送进 letterbox，解码时按每个 stride 预先算好的网格掩码跳过 ROI 外的格子，
+// 输出框再平移回整帧坐标。
+// ==========================================
+
+struct DetectRoi {
+    std::vector<cv::Rect> rects;
+    std::vector<cv::Point> polygon;
+
+    bool empty() const { return rects.empty() && polygon.size() < 3; }
+    // 外接矩形与 frameSize 的交集，起点和宽高 2 对齐 (NV12 要求)
+    cv::Rect bounds(const cv::Size& frameSize) const;
+
+    // 解析 "x,y,w,h;x,y,w,h" 或 "poly:x,y x,y x,y ..."，两种写法可以用 ';' 混合；格式不对返回 false
+    static bool parse(const std::string& spec, DetectRoi& roi);
+};
+
+// 一种 (帧尺寸, 裁剪区, letterbox) 组合下，每个检测头的网格掩码：1 表示该格子与 ROI 有交集
+struct RoiCellMask {
+    cv::Size frameSize;
+    cv::Rect crop;
+    std::vector<int> strides;
+    std::vector<std::vector<uint8_t>> cells;   // 与 strides 一一对应，按 grid_h x grid_w 行优先
+    int activeCells = 0;
+    int totalCells = 0;
+
+    // crop 区域按 scale / pad 放进 modelSize 的输入后，把 ROI 形状投到每个 stride 的网格上
+    void build(const DetectRoi& roi, const cv::Size& frameSize, const cv::Rect& crop,
+               const cv::Size& modelSize, float scale, int padLeft, int padTop,
+               const std::vector<int>& strides);
+    const uint8_t* forStride(int index) const {
+        return index < (int)cells.size() ? cells[index].data() : nullptr;
+    }
+};
+
+#endif // DETECTROI_H
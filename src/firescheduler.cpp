@@ -0,0 +1,351 @@
+#include "firescheduler.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+#include "motionpredictor.h"
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+// 贪心打分时截止余量的折算系数：余量每多 1ms 相当于多花 0.05ms，越临近截止越先打
+const float kSlackWeight = 0.05f;
+// 余量超过这个值就不再区分 (底盘不动时截止时间是 kNoDeadline)
+const float kSlackCapMs = 2000.f;
+
+// 振镜从 from (画面内静止) 跳到以速度 v 移动、当前在 to 的目标所需时间：|d + v*T| = speed * T 的正根
+float interceptMs(const cv::Point2f& from, const cv::Point2f& to, const cv::Point2f& v, float speed)
+{
+    cv::Point2f d = to - from;
+    float c = d.dot(d);
+    if (c < 1e-6f) return 0.f;
+    float a = v.dot(v) - speed * speed;
+    float b = 2.f * d.dot(v);
+    // 地面比振镜还快 (配置错误)，退化为按静态距离算
+    if (a >= -1e-6f) return std::sqrt(c) / speed;
+    // a < 0、c > 0，两根一正一负，取正根
+    return (-b - std::sqrt(b * b - 4.f * a * c)) / (2.f * a);
+}
+
+// 振镜沿序列推进的状态：t 为相对排程起点的时刻，g 为振镜位置
+struct Cursor {
+    float t = 0.f;
+    cv::Point2f g;
+};
+
+struct Evaluator {
+    const std::vector<FireTask>& tasks;
+    cv::Point2f ground;
+    float speed;
+    float settleMs;
+
+    // 跳到 idx 并打完，驻留期间振镜跟着草走；赶在截止前打完返回 true
+    bool step(Cursor& c, int idx) const
+    {
+        const FireTask& task = tasks[idx];
+        c.t += interceptMs(c.g, task.pos + ground * c.t, ground, speed) + settleMs + task.dwellMs;
+        c.g = task.pos + ground * c.t;
+        return c.t <= task.deadlineMs;
+    }
+
+    // 从 c 开始依次打 seq[from..]，中途有一个来不及就返回 false
+    bool run(const std::vector<int>& seq, size_t from, Cursor c, float& finish) const
+    {
+        for (size_t i = from; i < seq.size(); ++i) {
+            if (!step(c, seq[i])) return false;
+        }
+        finish = c.t;
+        return true;
+    }
+};
+
+// 改进阶段：2-opt (首次改进即采纳) 缩短总用时，没有可翻转的了再把没排上的目标插到最省时的位置，循环到无改进或超预算
+int improve(const Evaluator& ev, const cv::Point2f& galvo, std::vector<int>& seq, std::vector<bool>& used,
+            Clock::time_point deadline, bool& budgetHit)
+{
+    int accepted = 0;
+    std::vector<Cursor> prefix;          // prefix[i] 为打 seq[i] 之前的状态
+    auto rebuild = [&]() {
+        prefix.assign(seq.size() + 1, Cursor());
+        prefix[0].g = galvo;
+        for (size_t i = 0; i < seq.size(); ++i) {
+            prefix[i + 1] = prefix[i];
+            ev.step(prefix[i + 1], seq[i]);
+        }
+    };
+    auto overBudget = [&]() {
+        if (Clock::now() > deadline) budgetHit = true;
+        return budgetHit;
+    };
+
+    bool improved = true;
+    while (improved && !overBudget()) {
+        improved = false;
+        rebuild();
+        const float best = prefix.back().t;
+
+        for (size_t i = 0; i + 1 < seq.size() && !improved && !overBudget(); ++i) {
+            for (size_t k = i + 1; k < seq.size(); ++k) {
+                std::reverse(seq.begin() + i, seq.begin() + k + 1);
+                float finish = 0.f;
+                if (ev.run(seq, i, prefix[i], finish) && finish < best - 1e-3f) {
+                    improved = true;
+                    accepted++;
+                    break;
+                }
+                std::reverse(seq.begin() + i, seq.begin() + k + 1);
+            }
+        }
+        if (improved) continue;
+
+        // 权重大的先插，同权重截止早的先插
+        std::vector<int> pending;
+        for (size_t j = 0; j < used.size(); ++j) {
+            if (!used[j]) pending.push_back((int)j);
+        }
+        std::sort(pending.begin(), pending.end(), [&ev](int a, int b) {
+            const FireTask& ta = ev.tasks[a];
+            const FireTask& tb = ev.tasks[b];
+            return ta.weight != tb.weight ? ta.weight > tb.weight : ta.deadlineMs < tb.deadlineMs;
+        });
+        for (int j : pending) {
+            if (overBudget()) break;
+            int bestPos = -1;
+            float bestFinish = 0.f;
+            for (size_t pos = 0; pos <= seq.size(); ++pos) {
+                seq.insert(seq.begin() + pos, j);
+                float finish = 0.f;
+                if (ev.run(seq, pos, prefix[pos], finish) && (bestPos < 0 || finish < bestFinish)) {
+                    bestPos = (int)pos;
+                    bestFinish = finish;
+                }
+                seq.erase(seq.begin() + pos);
+            }
+            if (bestPos < 0) continue;
+            seq.insert(seq.begin() + bestPos, j);
+            used[j] = true;
+            improved = true;
+            accepted++;
+            rebuild();
+        }
+    }
+    return accepted;
+}
+
+} // namespace
+
+FireScheduler& FireScheduler::instance()
+{
+    static FireScheduler scheduler;
+    return scheduler;
+}
+
+FireScheduler::FireScheduler()
+{
+    m_statsTime = Clock::now();
+
+    const char* mode = getenv("CAR_HMI_SCHED");
+    if (mode && strcmp(mode, "off") == 0) m_enabled = false;
+
+    const char* band = getenv("CAR_HMI_FIRE_BAND");
+    if (band && *band) {
+        float x, y, w, h;
+        if (sscanf(band, "%f,%f,%f,%f", &x, &y, &w, &h) == 4 && w > 0 && h > 0) {
+            m_config.band = cv::Rect2f(x, y, w, h);
+        } else {
+            qDebug() << "【警告】CAR_HMI_FIRE_BAND 格式错误 (应为 x,y,w,h):" << band;
+        }
+    }
+
+    // 例如 CAR_HMI_DWELL_MS="60,thistle:120"：不带类别名的是默认值
+    const char* dwell = getenv("CAR_HMI_DWELL_MS");
+    if (dwell && *dwell) {
+        std::stringstream ss(dwell);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t colon = item.find(':');
+            if (colon == std::string::npos) {
+                if (atof(item.c_str()) > 0) m_config.defaultDwellMs = (float)atof(item.c_str());
+            } else if (atof(item.c_str() + colon + 1) > 0) {
+                m_config.dwellByClass[item.substr(0, colon)] = (float)atof(item.c_str() + colon + 1);
+            }
+        }
+    }
+
+    const char* speed = getenv("CAR_HMI_GALVO_PX_PER_MS");
+    if (speed && atof(speed) > 0) m_config.galvoPxPerMs = (float)atof(speed);
+    const char* settle = getenv("CAR_HMI_GALVO_SETTLE_MS");
+    if (settle && atof(settle) >= 0) m_config.settleMs = (float)atof(settle);
+    const char* budget = getenv("CAR_HMI_SCHED_BUDGET_US");
+    if (budget && atoi(budget) > 0) m_config.budgetUs = atoi(budget);
+}
+
+float FireScheduler::dwellMs(const std::string& className) const
+{
+    auto it = m_config.dwellByClass.find(className);
+    return it != m_config.dwellByClass.end() ? it->second : m_config.defaultDwellMs;
+}
+
+float FireScheduler::exitTimeMs(const cv::Point2f& pos, const cv::Point2f& ground) const
+{
+    const cv::Rect2f& b = m_config.band;
+    if (pos.x < b.x || pos.x > b.x + b.width || pos.y < b.y || pos.y > b.y + b.height) return 0.f;
+    float t = kNoDeadline;
+    if (ground.x > 0) t = std::min(t, (b.x + b.width - pos.x) / ground.x);
+    else if (ground.x < 0) t = std::min(t, (pos.x - b.x) / -ground.x);
+    if (ground.y > 0) t = std::min(t, (b.y + b.height - pos.y) / ground.y);
+    else if (ground.y < 0) t = std::min(t, (pos.y - b.y) / -ground.y);
+    return t;
+}
+
+FireScheduler::Plan FireScheduler::plan(const std::vector<FireTask>& tasks, const cv::Point2f& galvo,
+                                        const cv::Point2f& ground, Strategy strategy) const
+{
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::microseconds(m_config.budgetUs);
+    Evaluator ev{tasks, ground, std::max(1e-3f, m_config.galvoPxPerMs), m_config.settleMs};
+    const int n = (int)tasks.size();
+
+    Plan p;
+    std::vector<bool> used(n, false);
+    Cursor cur;
+    cur.g = galvo;
+
+    if (strategy == InputOrder || strategy == EarliestDeadline) {
+        std::vector<int> seq(n);
+        std::iota(seq.begin(), seq.end(), 0);
+        if (strategy == EarliestDeadline) {
+            std::stable_sort(seq.begin(), seq.end(), [&tasks](int a, int b) { return tasks[a].deadlineMs < tasks[b].deadlineMs; });
+        }
+        for (int idx : seq) {
+            Cursor next = cur;
+            if (!ev.step(next, idx)) continue;
+            cur = next;
+            p.order.push_back(idx);
+            used[idx] = true;
+        }
+    } else {
+        while (true) {
+            // 贪心本身是 O(n²)，目标多时也要守预算：剩下的不再挑，按截止时间附在最后
+            if (Clock::now() > deadline) {
+                p.budgetHit = true;
+                break;
+            }
+            int best = -1;
+            float bestScore = 0.f;
+            Cursor bestCursor;
+            for (int j = 0; j < n; ++j) {
+                if (used[j]) continue;
+                Cursor next = cur;
+                if (!ev.step(next, j)) continue;
+                float slack = std::min(kSlackCapMs, tasks[j].deadlineMs - next.t);
+                float score = (next.t - cur.t + kSlackWeight * slack) / std::max(1e-3f, tasks[j].weight);
+                if (best < 0 || score < bestScore) {
+                    best = j;
+                    bestScore = score;
+                    bestCursor = next;
+                }
+            }
+            if (best < 0) break;
+            cur = bestCursor;
+            p.order.push_back(best);
+            used[best] = true;
+        }
+        if (strategy == GreedyTwoOpt && !p.order.empty()) {
+            p.improvements = improve(ev, galvo, p.order, used, deadline, p.budgetHit);
+        }
+    }
+
+    Cursor end;
+    end.g = galvo;
+    p.finishMs.reserve(p.order.size());
+    for (int idx : p.order) {
+        ev.step(end, idx);
+        p.finishMs.push_back(end.t);
+    }
+    p.makespanMs = end.t;
+    for (int idx : p.order) p.weight += tasks[idx].weight;
+    for (int j = 0; j < n; ++j) {
+        if (!used[j]) p.dropped.push_back(j);
+    }
+    std::sort(p.dropped.begin(), p.dropped.end(), [&tasks](int a, int b) { return tasks[a].deadlineMs < tasks[b].deadlineMs; });
+    p.elapsedUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    return p;
+}
+
+void FireScheduler::schedule(std::vector<Detection>& dets, int cameraId)
+{
+    if (!m_enabled || dets.size() < 2) return;
+
+    // 排程起点取预计打击时刻：批量报文发出后再过 fireLatency 下位机才开始打第一棵
+    MotionPredictor& predictor = MotionPredictor::instance();
+    Clock::time_point fireTime = Clock::now() + std::chrono::microseconds((int64_t)(predictor.fireLatencyMs() * 1000.0));
+    cv::Point2f ground = predictor.imageVelocity(fireTime) * 0.001f;
+
+    std::vector<FireTask> tasks;
+    std::vector<int> source;
+    tasks.reserve(dets.size());
+    source.reserve(dets.size());
+    for (size_t i = 0; i < dets.size(); ++i) {
+        const Detection& det = dets[i];
+        // 与 makeTargetBatch 一致：没有瞄准点的不下发，原样放在最后
+        if (det.targetX <= 0 || det.targetY <= 0) continue;
+        FireTask task;
+        task.pos = predictor.predict(det, fireTime);
+        task.dwellMs = dwellMs(det.className);
+        task.deadlineMs = exitTimeMs(task.pos, ground);
+        task.weight = 1.f + (float)std::max(0, det.priority);
+        tasks.push_back(task);
+        source.push_back((int)i);
+    }
+    if (tasks.size() < 2) return;
+
+    const cv::Rect2f& b = m_config.band;
+    cv::Point2f galvo(b.x + b.width * 0.5f, b.y + b.height * 0.5f);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_galvo.find(cameraId);
+        if (it != m_galvo.end()) galvo = it->second;
+    }
+    Plan p = plan(tasks, galvo, ground, GreedyTwoOpt);
+
+    std::vector<Detection> ordered;
+    ordered.reserve(dets.size());
+    std::vector<bool> taken(dets.size(), false);
+    for (const std::vector<int>* part : {&p.order, &p.dropped}) {
+        for (int idx : *part) {
+            ordered.push_back(std::move(dets[source[idx]]));
+            taken[source[idx]] = true;
+        }
+    }
+    for (size_t i = 0; i < dets.size(); ++i) {
+        if (!taken[i]) ordered.push_back(std::move(dets[i]));
+    }
+    dets.swap(ordered);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 振镜实际位置拿不到，下一帧从这一帧排在第一个的目标算起 (帧间隔内它多半刚打完这一棵附近)
+    if (!p.order.empty()) m_galvo[cameraId] = tasks[p.order.front()].pos;
+
+    m_frames++;
+    m_tasks += tasks.size();
+    m_scheduled += p.order.size();
+    if (p.budgetHit) m_budgetHits++;
+    m_sumUs += p.elapsedUs;
+    m_maxUs = std::max(m_maxUs, p.elapsedUs);
+    auto now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_statsTime).count();
+    if (elapsed >= 10.0) {
+        qDebug() << ">>> [打击排程]" << (unsigned long long)m_frames << "帧 | 平均目标" << (double)m_tasks / m_frames
+                 << "| 可打完" << (double)m_scheduled / m_frames << "| 耗时 平均" << m_sumUs / m_frames << "us 最大" << m_maxUs
+                 << "us | 超预算" << (unsigned long long)m_budgetHits;
+        m_frames = m_tasks = m_scheduled = m_budgetHits = 0;
+        m_sumUs = m_maxUs = 0.0;
+        m_statsTime = now;
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef FIRESCHEDULER_H
+#define FIRESCHEDULER_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+// ==========================================
+// 激光打击排程
+// NMS 之后的检测是无序的，而下位机按 CMD_TARGET_BATCH 里的条目顺序依次打。
+// 草多的时候，先打哪棵决定了在它们移出可打击带之前能打掉几棵。
+// 这里按三样东西排一个近似最优的打击顺序：振镜跳转 + 到位稳定时间、每类草的驻留时间、
+// 每棵草离开可打击带的时刻 (截止时间)：
+//   1. 贪心：每一步挑"打完最快、越临近截止越优先"的可行目标
+//   2. 改进：2-opt 翻转子序列缩短总用时，省出来的时间把没排上的目标插进去，直到没有改进
+// 两步都受本帧预算约束：预算到了就用当前最好的结果 (贪心没排完的按截止时间附在后面)，不会拖慢推理结果下发。
+// 地面在画面里整体平移 (速度取自 MotionPredictor)：振镜跳到下一棵按追击点算，驻留期间跟着草走。
+// 来不及在离开前打完的目标按截止时间附在最后，不丢。
+// 配置：CAR_HMI_FIRE_BAND="x,y,w,h"       可打击带 (检测流像素，默认整幅 800x600)
+//       CAR_HMI_DWELL_MS="60,thistle:120"  驻留毫秒数：默认值 + 按类别名覆盖
+//       CAR_HMI_GALVO_PX_PER_MS / CAR_HMI_GALVO_SETTLE_MS  振镜速度 (像素/毫秒) 和到位稳定时间
+//       CAR_HMI_SCHED_BUDGET_US            每帧排程时间预算 (默认 1500us)
+//       CAR_HMI_SCHED=off 关闭 (保持检测顺序)
+// 各策略的吞吐对比见 tests/test_firescheduler.cpp (合成草场滚动仿真)
+// ==========================================
+
+struct FireTask {
+    cv::Point2f pos;            // 排程起点时刻的位置 (检测流像素)
+    float dwellMs = 0.f;
+    float deadlineMs = 0.f;     // 离开可打击带的时刻 (相对排程起点)，必须在这之前打完
+    float weight = 1.f;         // 1 + 类别优先级
+};
+
+class FireScheduler
+{
+public:
+    enum Strategy {
+        InputOrder,             // 按传入顺序打，来不及的跳过 (排程之前的行为)
+        EarliestDeadline,       // 按截止时间先后
+        Greedy,
+        GreedyTwoOpt,           // 贪心 + 2-opt / 插入改进 (默认)
+    };
+
+    struct Config {
+        cv::Rect2f band{0.f, 0.f, 800.f, 600.f};
+        float galvoPxPerMs = 40.f;
+        float settleMs = 1.f;
+        float defaultDwellMs = 60.f;
+        std::map<std::string, float> dwellByClass;
+        int budgetUs = 1500;
+    };
+
+    struct Plan {
+        std::vector<int> order;     // 能在截止前打完的序列 (任务下标)
+        std::vector<float> finishMs; // order 里每一棵打完的时刻 (相对排程起点)
+        std::vector<int> dropped;   // 来不及的，按截止时间排序
+        float makespanMs = 0.f;     // 打完整个序列的时刻
+        float weight = 0.f;         // 序列里目标的权重和
+        int improvements = 0;       // 改进阶段被采纳的 2-opt / 插入次数
+        bool budgetHit = false;
+        double elapsedUs = 0.0;
+    };
+
+    static FireScheduler& instance();
+
+    const Config& config() const { return m_config; }
+    void setConfig(const Config& config) { m_config = config; }
+    bool enabled() const { return m_enabled; }
+
+    float dwellMs(const std::string& className) const;
+    // 位置 pos 按 ground (像素/毫秒) 平移，离开可打击带的时刻 (毫秒)；已在带外返回 0，不动返回 kNoDeadline
+    float exitTimeMs(const cv::Point2f& pos, const cv::Point2f& ground) const;
+
+    // 纯计算，不改内部状态：galvo 为振镜起点 (画面内静止)，ground 为地面在画面里的速度 (像素/毫秒)
+    Plan plan(const std::vector<FireTask>& tasks, const cv::Point2f& galvo, const cv::Point2f& ground,
+              Strategy strategy) const;
+
+    // 一帧检测按排程结果重排 (推理线程在 sendDetections 之前调用，可并发)，
+    // UI 线程随后 makeTargetBatch 按新顺序打包。振镜位置按 cameraId 各记各的
+    void schedule(std::vector<Detection>& dets, int cameraId);
+
+    static constexpr float kNoDeadline = 1e9f;
+
+private:
+    FireScheduler();
+    FireScheduler(const FireScheduler&) = delete;
+    FireScheduler& operator=(const FireScheduler&) = delete;
+
+    Config m_config;
+    bool m_enabled = true;
+
+    // 多个推理线程同时排程，下面的振镜位置和统计由 m_mutex 保护 (plan 本身不持锁)
+    std::mutex m_mutex;
+    std::map<int, cv::Point2f> m_galvo;  // 每路摄像头上一帧排在第一个的目标，当作该路振镜的当前位置
+
+    // 统计，10 秒输出一次
+    uint64_t m_frames = 0;
+    uint64_t m_tasks = 0;
+    uint64_t m_scheduled = 0;
+    uint64_t m_budgetHits = 0;
+    double m_sumUs = 0.0;
+    double m_maxUs = 0.0;
+    std::chrono::steady_clock::time_point m_statsTime;
+};
+
+#endif // FIRESCHEDULER_H
@@ -0,0 +1,421 @@
+#include "headlayout.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <sstream>
+
+// 运行时 DFL bin 数的上限 (模板参数为 0 时按布局里的 regMax 循环)
+static const int kMaxRegMax = 32;
+
+struct TensorShape {
+    int c = 0, h = 0, w = 0;
+};
+
+static bool shapeOf(const rknn_tensor_attr& attr, bool& nhwc, TensorShape& s)
+{
+    if (attr.n_dims != 4) return false;
+    nhwc = attr.fmt == RKNN_TENSOR_NHWC;
+    if (nhwc) {
+        s.h = attr.dims[1]; s.w = attr.dims[2]; s.c = attr.dims[3];
+    } else {
+        s.c = attr.dims[1]; s.h = attr.dims[2]; s.w = attr.dims[3];
+    }
+    return s.c > 0 && s.h > 0 && s.w > 0;
+}
+
+std::vector<int> HeadLayout::strides() const
+{
+    std::vector<int> s;
+    for (const auto& b : branches) s.push_back(b.stride);
+    return s;
+}
+
+std::string HeadLayout::describe() const
+{
+    std::ostringstream os;
+    if (kind == HeadKind::SplitDfl) {
+        os << "SplitDfl " << (nhwc ? "NHWC" : "NCHW") << " reg=" << regMax << " nc=" << numClasses
+           << (branches.empty() || branches[0].sumIdx >= 0 ? " +clssum" : " 无clssum");
+    } else if (kind == HeadKind::TopK) {
+        os << "TopK [" << concatAnchors << ",6] (图内后处理)";
+    } else {
+        os << "Concat " << (channelsFirst ? "[1,4+nc,N]" : "[1,N,4+nc]") << " nc=" << numClasses
+           << " N=" << concatAnchors;
+    }
+    os << " strides=";
+    for (size_t i = 0; i < branches.size(); ++i) os << (i ? "/" : "") << branches[i].stride;
+    return os.str();
+}
+
+// 锚点按 stride 8/16/32 依次排列时的各级网格 (单输出布局用来套 ROI 网格掩码)
+static std::vector<HeadBranch> defaultBranches(const cv::Size& modelSize, const ModelMetadata& meta, int& total)
+{
+    std::vector<HeadBranch> branches;
+    total = 0;
+    for (int stride = 8; stride <= std::max(32, meta.stride); stride *= 2) {
+        HeadBranch br;
+        br.stride = stride;
+        br.gridW = modelSize.width / stride;
+        br.gridH = modelSize.height / stride;
+        total += br.gridW * br.gridH;
+        branches.push_back(br);
+    }
+    return branches;
+}
+
+// 单输出 [.., K, 6]：元数据标明图内后处理，或者 K 远小于锚点数 (不可能是 nc=2 的 Concat)
+static bool isTopK(const rknn_tensor_attr& attr, const cv::Size& modelSize, const ModelMetadata& meta)
+{
+    if (attr.n_dims < 2 || attr.dims[attr.n_dims - 1] != 6) return false;
+    if (meta.postprocess == "topk" || meta.end2end) return true;
+    int anchors = 0;
+    defaultBranches(modelSize, meta, anchors);
+    return (int)attr.dims[attr.n_dims - 2] < anchors;
+}
+
+// 单输出：最后两维是 (4+nc, N) 或 (N, 4+nc)
+static bool buildConcat(const rknn_tensor_attr& attr, const cv::Size& modelSize, const ModelMetadata& meta,
+                        HeadLayout& layout, std::string& err)
+{
+    if (attr.n_dims < 3) {
+        err = "单输出张量维数不足";
+        return false;
+    }
+    int a = attr.dims[attr.n_dims - 2];
+    int b = attr.dims[attr.n_dims - 1];
+    int nc = (int)meta.names.size();
+    if (nc > 0 && a == 4 + nc) layout.channelsFirst = true;
+    else if (nc > 0 && b == 4 + nc) layout.channelsFirst = false;
+    else layout.channelsFirst = a < b;   // 没有元数据时：通道数远小于锚点数
+    int channels = layout.channelsFirst ? a : b;
+    if (channels <= 4) {
+        err = "单输出张量通道数不足 4+nc";
+        return false;
+    }
+    layout.kind = HeadKind::Concat;
+    layout.numClasses = channels - 4;
+    layout.concatIdx = 0;
+    layout.concatAnchors = layout.channelsFirst ? b : a;
+    layout.wantFloat = true;   // 坐标是像素值、分数是概率，混在一个量化尺度里精度差，直接要 float
+
+    // 锚点对得上 stride 8/16/32 的网格时才能套用 ROI 网格掩码
+    int total = 0;
+    std::vector<HeadBranch> branches = defaultBranches(modelSize, meta, total);
+    if (total == layout.concatAnchors) layout.branches = branches;
+    return true;
+}
+
+bool HeadLayout::build(const rknn_tensor_attr* attrs, int numOutputs, const cv::Size& modelSize,
+                       const ModelMetadata& meta, HeadLayout& layout, std::string& err)
+{
+    layout = HeadLayout();
+    layout.numOutputs = numOutputs;
+    if (numOutputs <= 0) {
+        err = "模型没有输出";
+        return false;
+    }
+    if (numOutputs == 1 && isTopK(attrs[0], modelSize, meta)) {
+        layout.kind = HeadKind::TopK;
+        layout.concatIdx = 0;
+        layout.concatAnchors = attrs[0].dims[attrs[0].n_dims - 2];
+        layout.numClasses = (int)meta.names.size();
+        layout.wantFloat = true;
+        // ROI 按框中心落在哪个最细网格格子判断
+        int total = 0;
+        layout.branches = defaultBranches(modelSize, meta, total);
+        layout.branches.resize(1);
+        return true;
+    }
+    if (numOutputs == 1) return buildConcat(attrs[0], modelSize, meta, layout, err);
+
+    // 多输出：按网格尺寸分组，每组是同一个 stride 的 box / cls / clssum
+    std::map<int, std::vector<int>> groups;   // gridH*10000+gridW -> 输出下标 (保持导出顺序)
+    std::vector<TensorShape> shapes(numOutputs);
+    for (int i = 0; i < numOutputs; ++i) {
+        bool nhwc = false;
+        if (!shapeOf(attrs[i], nhwc, shapes[i])) {
+            err = "输出 " + std::to_string(i) + " 不是 4 维张量";
+            return false;
+        }
+        if (i == 0) layout.nhwc = nhwc;
+        else if (nhwc != layout.nhwc) {
+            err = "输出张量排布不一致 (NCHW/NHWC 混用)";
+            return false;
+        }
+        if (attrs[i].type != RKNN_TENSOR_INT8) layout.wantFloat = true;
+        groups[shapes[i].h * 10000 + shapes[i].w].push_back(i);
+    }
+
+    const int metaClasses = (int)meta.names.size();
+    for (auto it = groups.rbegin(); it != groups.rend(); ++it) {   // 网格从大到小 = stride 从小到大
+        HeadBranch br;
+        std::vector<int> wide;   // 通道数 > 1 的输出
+        for (int idx : it->second) {
+            if (shapes[idx].c == 1) br.sumIdx = idx;
+            else wide.push_back(idx);
+        }
+        if (wide.size() != 2) {
+            err = "网格 " + std::to_string(shapes[it->second[0]].w) + "x" + std::to_string(shapes[it->second[0]].h) +
+                  " 上应有 box 和 cls 两个输出";
+            return false;
+        }
+        // 有元数据时按类别数认 cls，否则按导出顺序 box 在前
+        br.boxIdx = wide[0];
+        br.clsIdx = wide[1];
+        if (metaClasses > 0 && shapes[wide[0]].c == metaClasses && shapes[wide[1]].c != metaClasses) {
+            std::swap(br.boxIdx, br.clsIdx);
+        }
+        const TensorShape& box = shapes[br.boxIdx];
+        const TensorShape& cls = shapes[br.clsIdx];
+        if (box.c % 4 != 0 || box.c / 4 > kMaxRegMax) {
+            err = "box 输出通道数 " + std::to_string(box.c) + " 不是 4*reg";
+            return false;
+        }
+        if (!layout.branches.empty() && (box.c / 4 != layout.regMax || cls.c != layout.numClasses)) {
+            err = "各 stride 的 reg / 类别数不一致";
+            return false;
+        }
+        layout.regMax = box.c / 4;
+        layout.numClasses = cls.c;
+        br.gridW = box.w;
+        br.gridH = box.h;
+        br.stride = modelSize.height / box.h;
+        if (br.stride * box.h != modelSize.height || br.stride * box.w != modelSize.width) {
+            err = "网格 " + std::to_string(box.w) + "x" + std::to_string(box.h) + " 与输入尺寸对不上";
+            return false;
+        }
+        layout.branches.push_back(br);
+    }
+    // 同一模型要么每组都有 clssum，要么都没有
+    bool withSum = layout.branches[0].sumIdx >= 0;
+    for (const auto& br : layout.branches) {
+        if ((br.sumIdx >= 0) != withSum) {
+            err = "clssum 输出只出现在部分 stride 上";
+            return false;
+        }
+    }
+    layout.kind = HeadKind::SplitDfl;
+    return true;
+}
+
+// ------------------------------------------------------------------
+// 解码内核
+// ------------------------------------------------------------------
+
+// int8 走仿射反量化；float (runtime 已反量化) 原样返回
+template <typename T>
+struct Dequant {
+    explicit Dequant(const rknn_tensor_attr&) {}
+    float operator()(T v) const { return (float)v; }
+    T above(float thr) const { return (T)thr; }      // "v > above(thr)" 等价于 "值 > thr"
+    T atLeast(float thr) const { return (T)thr; }    // "v < atLeast(thr)" 时值一定 < thr
+    static T lowest() { return -std::numeric_limits<T>::infinity(); }
+};
+
+template <>
+struct Dequant<int8_t> {
+    float scale;
+    int zp;
+    explicit Dequant(const rknn_tensor_attr& attr) : scale(attr.scale), zp(attr.zp) {}
+    float operator()(int8_t v) const { return (v - zp) * scale; }
+    int8_t above(float thr) const {
+        return (int8_t)std::max(-128, std::min(127, (int)std::round(thr / scale + zp)));
+    }
+    int8_t atLeast(float thr) const {
+        return (int8_t)std::max(-128, std::min(127, (int)std::floor(thr / scale + zp)));
+    }
+    static int8_t lowest() { return -128; }
+};
+
+// 模型输入坐标系下的框 -> 帧坐标，裁到帧内；无效框返回 false
+static inline void emitBox(const DecodeArgs& args, float x1, float y1, float x2, float y2,
+                           float score, int classId, DecodeResult& out)
+{
+    int final_x = std::max(0, (int)std::round((x1 - args.padLeft) / args.scale));
+    int final_y = std::max(0, (int)std::round((y1 - args.padTop) / args.scale));
+    int final_w = std::min((int)std::round((x2 - x1) / args.scale), args.frameSize.width - final_x);
+    int final_h = std::min((int)std::round((y2 - y1) / args.scale), args.frameSize.height - final_y);
+    if (final_w <= 0 || final_h <= 0) return;
+    out.boxes.push_back(cv::Rect(final_x, final_y, final_w, final_h));
+    out.confidences.push_back(score);
+    out.classIds.push_back(classId);
+}
+
+// 每个 stride 一组 box(4*REG) + cls [+ clssum]；REG == 0 表示 bin 数在运行时由布局给出
+template <typename T, int REG, bool NHWC, bool HAS_SUM>
+static void decodeSplit(const DecodeArgs& args, DecodeResult& out)
+{
+    const HeadLayout& layout = *args.layout;
+    const int reg = REG > 0 ? REG : layout.regMax;
+    const int nc = layout.numClasses;
+    const float conf = args.confThreshold;
+
+    for (size_t b = 0; b < layout.branches.size(); ++b) {
+        const HeadBranch& br = layout.branches[b];
+        const T* box_ptr = (const T*)args.bufs[br.boxIdx];
+        const T* cls_ptr = (const T*)args.bufs[br.clsIdx];
+        const T* sum_ptr = HAS_SUM ? (const T*)args.bufs[br.sumIdx] : nullptr;
+        Dequant<T> boxQ(args.attrs[br.boxIdx]);
+        Dequant<T> clsQ(args.attrs[br.clsIdx]);
+        Dequant<T> sumQ(args.attrs[HAS_SUM ? br.sumIdx : br.clsIdx]);
+
+        const int stride = br.stride;
+        const int grid_w = br.gridW;
+        const int grid_area = br.gridW * br.gridH;
+        // NCHW：同一通道的格子连续；NHWC：同一格子的通道连续
+        const int ch_step = NHWC ? 1 : grid_area;
+        const T sum_thres = sumQ.above(conf);
+        // 没有 clssum，或者只解码白名单子集 (clssum 包含了无关类别) 时，用最大类别分数提前拒绝
+        const bool cls_gate = !HAS_SUM || args.classSubset;
+        const T cls_thres = clsQ.atLeast(conf);
+        const uint8_t* roi_cells = args.cellMask ? args.cellMask->forStride((int)b) : nullptr;
+
+        for (int g_idx = 0; g_idx < grid_area; ++g_idx) {
+            if (roi_cells && !roi_cells[g_idx]) continue;
+            if (HAS_SUM && sum_ptr[g_idx] <= sum_thres) continue;
+
+            const T* cls_cell = NHWC ? cls_ptr + (size_t)g_idx * nc : cls_ptr + g_idx;
+            T maxScore_q = Dequant<T>::lowest();
+            int classId = -1;
+            for (int k = 0; k < args.numActive; ++k) {
+                int c = args.activeClasses[k];
+                T score_q = cls_cell[c * ch_step];
+                if (score_q > maxScore_q) {
+                    maxScore_q = score_q;
+                    classId = c;
+                }
+            }
+            if (cls_gate && maxScore_q < cls_thres) continue;
+            float maxScore = clsQ(maxScore_q);
+            if (maxScore <= conf) continue;
+
+            // DFL：每条边 reg 个 bin 做 softmax 求期望
+            const T* box_cell = NHWC ? box_ptr + (size_t)g_idx * reg * 4 : box_ptr + g_idx;
+            float dist[4];
+            for (int side = 0; side < 4; ++side) {
+                float logits[REG > 0 ? REG : kMaxRegMax];
+                float maxLogit = -1e9f;
+                for (int bin = 0; bin < reg; ++bin) {
+                    float v = boxQ(box_cell[(side * reg + bin) * ch_step]);
+                    logits[bin] = v;
+                    if (v > maxLogit) maxLogit = v;
+                }
+                float sumExp = 0.f;
+                float weighted = 0.f;
+                for (int bin = 0; bin < reg; ++bin) {
+                    float p = std::exp(logits[bin] - maxLogit);
+                    sumExp += p;
+                    weighted += p * bin;
+                }
+                dist[side] = weighted / sumExp;
+            }
+
+            int x = g_idx % grid_w;
+            int y = g_idx / grid_w;
+            float cx = (x + 0.5f) * stride;
+            float cy = (y + 0.5f) * stride;
+            emitBox(args, cx - dist[0] * stride, cy - dist[1] * stride,
+                    cx + dist[2] * stride, cy + dist[3] * stride, maxScore, classId, out);
+        }
+    }
+}
+
+// 单输出 (float)：每个锚点 cx, cy, w, h, 类别分数...
+template <bool CHANNELS_FIRST>
+static void decodeConcat(const DecodeArgs& args, DecodeResult& out)
+{
+    const HeadLayout& layout = *args.layout;
+    const float* p = (const float*)args.bufs[layout.concatIdx];
+    const int n = layout.concatAnchors;
+    const int channels = 4 + layout.numClasses;
+    const float conf = args.confThreshold;
+    auto at = [&](int c, int a) { return CHANNELS_FIRST ? p[(size_t)c * n + a] : p[(size_t)a * channels + c]; };
+
+    auto decodeRange = [&](int begin, int end, const uint8_t* roi_cells) {
+        for (int a = begin; a < end; ++a) {
+            if (roi_cells && !roi_cells[a - begin]) continue;
+            float maxScore = -1.f;
+            int classId = -1;
+            for (int k = 0; k < args.numActive; ++k) {
+                int c = args.activeClasses[k];
+                float s = at(4 + c, a);
+                if (s > maxScore) {
+                    maxScore = s;
+                    classId = c;
+                }
+            }
+            if (maxScore <= conf) continue;
+            float cx = at(0, a), cy = at(1, a), w = at(2, a), h = at(3, a);
+            emitBox(args, cx - w * 0.5f, cy - h * 0.5f, cx + w * 0.5f, cy + h * 0.5f, maxScore, classId, out);
+        }
+    };
+
+    if (layout.branches.empty()) {
+        decodeRange(0, n, nullptr);
+        return;
+    }
+    int begin = 0;
+    for (size_t b = 0; b < layout.branches.size(); ++b) {
+        int count = layout.branches[b].gridW * layout.branches[b].gridH;
+        decodeRange(begin, begin + count, args.cellMask ? args.cellMask->forStride((int)b) : nullptr);
+        begin += count;
+    }
+}
+
+// 图内后处理 (float)：每行 x1, y1, x2, y2, score, class，分数低于阈值的行 (含补齐行) 直接跳过
+// 类别号超出 numClasses 的行丢掉 (下游按类别号查优先级 / 类别名)
+static void decodeTopK(const DecodeArgs& args, DecodeResult& out)
+{
+    const HeadLayout& layout = *args.layout;
+    const float* p = (const float*)args.bufs[layout.concatIdx];
+    const uint8_t* roi_cells = args.cellMask ? args.cellMask->forStride(0) : nullptr;
+    const HeadBranch* fine = layout.branches.empty() ? nullptr : &layout.branches[0];
+    const int* active_end = args.activeClasses + args.numActive;
+
+    for (int k = 0; k < layout.concatAnchors; ++k) {
+        const float* row = p + (size_t)k * 6;
+        float score = row[4];
+        if (score <= args.confThreshold) continue;
+        int classId = (int)std::lround(row[5]);
+        if (classId < 0 || classId >= layout.numClasses) continue;
+        if (args.classSubset && !std::binary_search(args.activeClasses, active_end, classId)) continue;
+        if (roi_cells && fine) {
+            int gx = (int)((row[0] + row[2]) * 0.5f) / fine->stride;
+            int gy = (int)((row[1] + row[3]) * 0.5f) / fine->stride;
+            if (gx < 0 || gy < 0 || gx >= fine->gridW || gy >= fine->gridH) continue;
+            if (!roi_cells[gy * fine->gridW + gx]) continue;
+        }
+        emitBox(args, row[0], row[1], row[2], row[3], score, classId, out);
+    }
+}
+
+template <typename T, int REG>
+static DecodeFn pickSplit(bool nhwc, bool sum)
+{
+    if (nhwc) return sum ? &decodeSplit<T, REG, true, true> : &decodeSplit<T, REG, true, false>;
+    return sum ? &decodeSplit<T, REG, false, true> : &decodeSplit<T, REG, false, false>;
+}
+
+DecodeFn selectDecoder(const HeadLayout& layout, const char** name)
+{
+    const char* dummy = nullptr;
+    const char*& n = name ? *name : dummy;
+    if (layout.kind == HeadKind::TopK) {
+        n = "topk<K,6>";
+        return &decodeTopK;
+    }
+    if (layout.kind == HeadKind::Concat) {
+        n = layout.channelsFirst ? "concat<C,N>" : "concat<N,C>";
+        return layout.channelsFirst ? &decodeConcat<true> : &decodeConcat<false>;
+    }
+    const bool sum = !layout.branches.empty() && layout.branches[0].sumIdx >= 0;
+    // 常见的 reg=16 展开为编译期常量，其余 bin 数走通用版本
+    if (layout.wantFloat) {
+        n = layout.regMax == 16 ? "split<float,16>" : "split<float,N>";
+        return layout.regMax == 16 ? pickSplit<float, 16>(layout.nhwc, sum) : pickSplit<float, 0>(layout.nhwc, sum);
+    }
+    n = layout.regMax == 16 ? "split<int8,16>" : "split<int8,N>";
+    return layout.regMax == 16 ? pickSplit<int8_t, 16>(layout.nhwc, sum) : pickSplit<int8_t, 0>(layout.nhwc, sum);
+}
@@ -0,0 +1,86 @@
+#ifndef HEADLAYOUT_H
+#define HEADLAYOUT_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "rknn_api.h"
+#include "detectroi.h"
+#include "modelmeta.h"
+
+// ==========================================
+// 检测头输出布局描述
+// 模型加载时根据 output_attrs (+ metadata.yaml) 识别输出张量的排布，
+// 然后一次性选定对应的解码内核 (模板特化，DFL bin 数、NCHW/NHWC、有无 clssum 都是编译期常量)，
+// 每帧直接调用函数指针，不再逐帧判断。支持的布局：
+//   SplitDfl : 每个 stride 一组 box(4*reg) + cls(nc) [+ clssum(1)]，rknn_model_zoo 导出的 YOLOv8 / YOLO11 均为此类
+//   Concat   : 单输出 [1, 4+nc, N] 或 [1, N, 4+nc]，框已解码为 cx,cy,w,h (Ultralytics 默认 ONNX 头)
+//   TopK     : 单输出 [1, K, 6] = x1,y1,x2,y2,score,class，DFL / 类别最大 / top-K 已在图内完成
+//              (models/export_rknn.py --postprocess 导出，或 end2end 模型)
+// ==========================================
+
+enum class HeadKind {
+    SplitDfl,
+    Concat,
+    TopK,
+};
+
+struct HeadBranch {
+    int stride = 0;
+    int gridW = 0;
+    int gridH = 0;
+    int boxIdx = -1;      // 各输出在 outputs[] 中的下标
+    int clsIdx = -1;
+    int sumIdx = -1;      // 没有 clssum 时为 -1
+};
+
+struct HeadLayout {
+    HeadKind kind = HeadKind::SplitDfl;
+    bool nhwc = false;            // SplitDfl：张量排布
+    bool channelsFirst = true;    // Concat：[1, C, N] 为 true，[1, N, C] 为 false
+    int regMax = 16;              // DFL bin 数
+    int numClasses = 0;
+    int numOutputs = 0;
+    bool wantFloat = false;       // 需要 runtime 反量化成 float 的布局
+    int concatIdx = -1;
+    int concatAnchors = 0;        // Concat：锚点数 N；TopK：行数 K
+    std::vector<HeadBranch> branches;   // 按 stride 从小到大
+
+    std::vector<int> strides() const;
+    std::string describe() const;
+
+    // 识别失败返回 false，err 里说明原因
+    static bool build(const rknn_tensor_attr* attrs, int numOutputs, const cv::Size& modelSize,
+                      const ModelMetadata& meta, HeadLayout& layout, std::string& err);
+};
+
+// 一帧的解码输入 / 输出
+struct DecodeArgs {
+    void* const* bufs = nullptr;               // outputs[i].buf
+    const rknn_tensor_attr* attrs = nullptr;
+    const HeadLayout* layout = nullptr;
+    const int* activeClasses = nullptr;        // 参与 argmax 的类别通道 (升序)
+    int numActive = 0;
+    bool classSubset = false;
+    const RoiCellMask* cellMask = nullptr;     // 与 layout.branches 一一对应
+    float confThreshold = 0.45f;
+    float scale = 1.f;                         // letterbox 参数，用于把框还原到 frameSize
+    int padLeft = 0;
+    int padTop = 0;
+    cv::Size frameSize;
+};
+
+struct DecodeResult {
+    std::vector<cv::Rect> boxes;
+    std::vector<float> confidences;
+    std::vector<int> classIds;
+
+    void clear() { boxes.clear(); confidences.clear(); classIds.clear(); }
+};
+
+typedef void (*DecodeFn)(const DecodeArgs& args, DecodeResult& out);
+
+// 为布局选出解码内核 (加载时调用一次)
+DecodeFn selectDecoder(const HeadLayout& layout, const char** name = nullptr);
+
+#endif // HEADLAYOUT_H
@@ -0,0 +1,475 @@
+#include "highrespath.h"
+#include "rgascheduler.h"
+#include "nv12letterbox.h"
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <linux/videodev2.h>
+
+// 单个目标高清小图的最大边长：3864 宽的 Sensor 对 800 宽的检测流约 4.8 倍，
+// 检测流上 80 像素的目标裁出来约 390 像素，再大就等比缩小，精修不需要更多细节
+static const int kMaxCropSide = 384;
+// 按时间戳兜底匹配时允许的最大偏差 (60fps 下半帧多一点)
+static const double kMatchToleranceMs = 10.0;
+
+static int alignDown2(int v) { return v & ~1; }
+static int alignUp2(int v) { return (v + 1) & ~1; }
+static int alignUp16(int v) { return (v + 15) & ~15; }
+
+// 超绿指数 ExG = 2G - R - B 加权质心：秧苗是框里最绿的部分，质心即茎叶中心
+// 绿色像素太少 (土块、反光) 时认为精修失败，沿用框中心
+static bool greenCentroid(const cv::Mat& rgb, cv::Point2f& centroid)
+{
+    double sumX = 0.0, sumY = 0.0, sumW = 0.0;
+    int count = 0;
+    for (int y = 0; y < rgb.rows; ++y) {
+        const uint8_t* p = rgb.ptr<uint8_t>(y);
+        for (int x = 0; x < rgb.cols; ++x, p += 3) {
+            int exg = 2 * p[1] - p[0] - p[2];
+            if (exg > 24) {
+                sumX += (double)x * exg;
+                sumY += (double)y * exg;
+                sumW += exg;
+                ++count;
+            }
+        }
+    }
+    if (count < (int)(rgb.total() / 20) || sumW <= 0.0) return false;
+    centroid.x = (float)(sumX / sumW);
+    centroid.y = (float)(sumY / sumW);
+    return true;
+}
+
+HighResPath::HighResPath()
+{
+    m_statsStart = std::chrono::steady_clock::now();
+}
+
+HighResPath::~HighResPath()
+{
+    stop();
+}
+
+bool HighResPath::open(const std::string& node, int width, int height, int fps, int bufferCount, int holdDepth)
+{
+    m_fd = ::open(node.c_str(), O_RDWR | O_NONBLOCK);
+    if (m_fd < 0) {
+        qDebug() << "【警告】打开高清通路失败:" << node.c_str();
+        return false;
+    }
+
+    v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if (ioctl(m_fd, VIDIOC_QUERYCAP, &cap) == 0) {
+        uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+        m_mplane = (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) != 0;
+    }
+    v4l2_buf_type type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    // 要单平面 NV12 (Y/UV 在同一个 dma-buf 里)，RGA 才能按一个 fd 直接读
+    v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = type;
+    if (m_mplane) {
+        fmt.fmt.pix_mp.width = width;
+        fmt.fmt.pix_mp.height = height;
+        fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_NV12;
+        fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        fmt.fmt.pix_mp.num_planes = 1;
+    } else {
+        fmt.fmt.pix.width = width;
+        fmt.fmt.pix.height = height;
+        fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_NV12;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    }
+    if (ioctl(m_fd, VIDIOC_S_FMT, &fmt) < 0) {
+        qDebug() << "【警告】高清通路设置格式失败:" << node.c_str();
+        close();
+        return false;
+    }
+    int numPlanes = 1;
+    if (m_mplane) {
+        m_width = fmt.fmt.pix_mp.width;
+        m_height = fmt.fmt.pix_mp.height;
+        m_bytesPerLine = fmt.fmt.pix_mp.plane_fmt[0].bytesperline;
+        numPlanes = fmt.fmt.pix_mp.num_planes;
+    } else {
+        m_width = fmt.fmt.pix.width;
+        m_height = fmt.fmt.pix.height;
+        m_bytesPerLine = fmt.fmt.pix.bytesperline;
+    }
+    if (m_bytesPerLine <= 0) m_bytesPerLine = m_width;
+    m_planeHeight = m_height;
+    if (numPlanes != 1) {
+        // 驱动坚持给 NV12M 时 Y/UV 分属两块内存，RGA 按 fd 读不了，整条通路没有意义
+        qDebug() << "【警告】高清通路不支持单平面 NV12，已放弃双通路模式";
+        close();
+        return false;
+    }
+
+    v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = type;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = fps;
+    ioctl(m_fd, VIDIOC_S_PARM, &parm);
+
+    // 扣住 holdDepth 帧 + 每个推理线程可能正在裁剪的 1 帧，驱动手里至少还要留 2 个
+    m_holdDepth = (size_t)std::max(1, holdDepth);
+    v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = std::max(bufferCount, holdDepth + 3 + 2);
+    req.type = type;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (ioctl(m_fd, VIDIOC_REQBUFS, &req) < 0) {
+        qDebug() << "【警告】高清通路申请缓冲区失败";
+        close();
+        return false;
+    }
+
+    m_buffers.assign(req.count, Buffer());
+    for (unsigned i = 0; i < req.count; i++) {
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (m_mplane) {
+            buf.m.planes = planes;
+            buf.length = 1;
+        }
+        if (ioctl(m_fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            qDebug() << "【警告】高清通路查询缓冲区失败";
+            close();
+            return false;
+        }
+
+        Buffer& b = m_buffers[i];
+        b.length = m_mplane ? planes[0].length : buf.length;
+        off_t offset = m_mplane ? planes[0].m.mem_offset : buf.m.offset;
+        // mmap 只给 CPU 兜底路径用；正常情况下像素数据从不经过 CPU
+        b.start = mmap(NULL, b.length, PROT_READ, MAP_SHARED, m_fd, offset);
+        if (b.start == MAP_FAILED) {
+            b.start = nullptr;
+            qDebug() << "【警告】高清通路 mmap 失败";
+            close();
+            return false;
+        }
+
+        v4l2_exportbuffer expbuf;
+        memset(&expbuf, 0, sizeof(expbuf));
+        expbuf.type = type;
+        expbuf.index = i;
+        expbuf.plane = 0;
+        expbuf.flags = O_RDONLY | O_CLOEXEC;
+        if (ioctl(m_fd, VIDIOC_EXPBUF, &expbuf) == 0) {
+            b.dmaFd = expbuf.fd;
+        }
+        queueBuffer(i);
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    if (m_epollFd < 0 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fd, &ev) < 0) {
+        qDebug() << "【警告】高清通路 epoll 注册失败";
+        close();
+        return false;
+    }
+
+    if (ioctl(m_fd, VIDIOC_STREAMON, &type) < 0) {
+        qDebug() << "【警告】高清通路启动 streaming 失败";
+        close();
+        return false;
+    }
+
+    qDebug() << "✅ 高清通路" << node.c_str() << "已打开:" << m_width << "x" << m_height
+             << "缓冲区:" << req.count << "扣留:" << (int)m_holdDepth
+             << (m_buffers[0].dmaFd >= 0 ? "(dma-buf)" : "(无 dma-buf，走 CPU 裁剪)");
+    return true;
+}
+
+bool HighResPath::queueBuffer(int index)
+{
+    v4l2_buffer buf;
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buf, 0, sizeof(buf));
+    memset(planes, 0, sizeof(planes));
+    buf.type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if (m_mplane) {
+        buf.m.planes = planes;
+        buf.length = 1;
+    }
+    return ioctl(m_fd, VIDIOC_QBUF, &buf) == 0;
+}
+
+void HighResPath::start()
+{
+    if (m_fd < 0 || m_running) return;
+    m_running = true;
+    resetStats();
+    m_thread = std::thread(&HighResPath::captureLoop, this);
+}
+
+void HighResPath::stop()
+{
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+    close();
+}
+
+void HighResPath::close()
+{
+    if (m_epollFd >= 0) {
+        ::close(m_epollFd);
+        m_epollFd = -1;
+    }
+    if (m_fd < 0) return;
+    v4l2_buf_type type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    ioctl(m_fd, VIDIOC_STREAMOFF, &type);
+    for (auto& b : m_buffers) {
+        if (b.dmaFd >= 0) ::close(b.dmaFd);
+        if (b.start) munmap(b.start, b.length);
+    }
+    m_buffers.clear();
+    m_held.clear();
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+// ==========================================
+// 高清通路采集线程：只做 DQBUF / QBUF 轮转，像素一个字节都不碰
+// ==========================================
+void HighResPath::captureLoop()
+{
+    qDebug() << ">>> [高清通路] 线程启动";
+    v4l2_buf_type type = m_mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    while (m_running) {
+        epoll_event ev;
+        int n = epoll_wait(m_epollFd, &ev, 1, 100);
+        if (n <= 0) continue;
+        if (ev.events & (EPOLLERR | EPOLLHUP)) {
+            usleep(10000);
+            continue;
+        }
+
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type = type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (m_mplane) {
+            buf.m.planes = planes;
+            buf.length = 1;
+        }
+        if (ioctl(m_fd, VIDIOC_DQBUF, &buf) < 0) continue;
+
+        Slot slot;
+        slot.index = buf.index;
+        slot.sequence = buf.sequence;
+        int64_t tsUs = (int64_t)buf.timestamp.tv_sec * 1000000 + buf.timestamp.tv_usec;
+        slot.captureTime = tsUs > 0 ? std::chrono::steady_clock::time_point(std::chrono::microseconds(tsUs))
+                                    : std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_held.push_back(slot);
+        m_frames++;
+        // 超出扣留深度就把最老的、没人在用的 buffer 还给驱动
+        while (m_held.size() > m_holdDepth) {
+            auto it = std::find_if(m_held.begin(), m_held.end(), [](const Slot& s) { return s.pins == 0; });
+            if (it == m_held.end()) break;
+            queueBuffer(it->index);
+            m_held.erase(it);
+        }
+    }
+    qDebug() << ">>> [高清通路] 线程安全退出。";
+}
+
+int HighResPath::pinFrame(const CameraFrame& lowRes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // rkisp 的 mainpath/selfpath 共用 ISP 帧计数，序号相同就是同一帧
+    for (auto it = m_held.rbegin(); it != m_held.rend(); ++it) {
+        if (it->sequence == lowRes.driverSeq) {
+            it->pins++;
+            return it->index;
+        }
+    }
+    Slot* best = nullptr;
+    double bestDiff = kMatchToleranceMs;
+    for (auto& s : m_held) {
+        double diff = std::abs(std::chrono::duration<double, std::milli>(s.captureTime - lowRes.captureTime).count());
+        if (diff <= bestDiff) {
+            bestDiff = diff;
+            best = &s;
+        }
+    }
+    if (!best) return -1;
+    best->pins++;
+    return best->index;
+}
+
+void HighResPath::unpinFrame(int index)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& s : m_held) {
+        if (s.index == index && s.pins > 0) {
+            s.pins--;
+            return;
+        }
+    }
+}
+
+bool HighResPath::cropRoi(int index, const cv::Rect& roi, cv::Mat& buffer, cv::Mat& rgb, int rgaCore, bool& usedCpu)
+{
+    const Buffer& b = m_buffers[index];
+    float shrink = std::min(1.f, (float)kMaxCropSide / std::max(roi.width, roi.height));
+    int outW = std::max(2, alignDown2((int)(roi.width * shrink)));
+    int outH = std::max(2, alignDown2((int)(roi.height * shrink)));
+    usedCpu = false;
+
+    // RGA3 要求 RGB888 目标行宽 16 对齐，多出来的列裁掉不用
+    int wstride = alignUp16(outW);
+    buffer.create(outH, wstride, CV_8UC3);
+
+    bool rga_ok = false;
+    if (b.dmaFd >= 0) {
+        rga_buffer_t src = wrapbuffer_fd(b.dmaFd, m_width, m_height, RK_FORMAT_YCbCr_420_SP,
+                                         m_bytesPerLine, m_planeHeight);
+        rga_buffer_t dst = wrapbuffer_virtualaddr((void*)buffer.data, outW, outH, RK_FORMAT_RGB_888, wstride, outH);
+        im_rect src_rect = {roi.x, roi.y, roi.width, roi.height};
+        im_rect dst_rect = {0, 0, outW, outH};
+        im_rect pat_rect = {0, 0, 0, 0};
+        rga_buffer_t pat = {};
+        RgaCoreGuard rgaGuard(rgaCore);
+        if (imcheck(src, dst, src_rect, dst_rect) == IM_STATUS_NOERROR) {
+            rga_ok = (improcess(src, dst, pat, src_rect, dst_rect, pat_rect, IM_SYNC) == IM_STATUS_SUCCESS);
+        }
+    }
+    if (!rga_ok) {
+        // CPU 兜底：只读 ROI 覆盖的那几行，同样没有整帧拷贝
+        if (!b.start) return false;
+        const uint8_t* base = (const uint8_t*)b.start;
+        Nv12Frame view;
+        view.y = base + (size_t)roi.y * m_bytesPerLine + roi.x;
+        view.uv = base + (size_t)m_planeHeight * m_bytesPerLine + (size_t)(roi.y / 2) * m_bytesPerLine + roi.x;
+        view.width = roi.width;
+        view.height = roi.height;
+        view.yStride = m_bytesPerLine;
+        view.uvStride = m_bytesPerLine;
+
+        LetterboxParams lb;
+        lb.dstW = lb.newW = outW;
+        lb.dstH = lb.newH = outH;
+        cv::Mat packed(outH, outW, CV_8UC3);
+        nv12::letterboxRGB(view, packed.data, lb);
+        packed.copyTo(buffer(cv::Rect(0, 0, outW, outH)));
+        usedCpu = true;
+    }
+    rgb = buffer(cv::Rect(0, 0, outW, outH));
+    return true;
+}
+
+void HighResPath::refineTargets(std::vector<Detection>& dets, const CameraFrame& lowRes, int rgaCore)
+{
+    if (dets.empty() || m_fd < 0 || lowRes.width <= 0 || lowRes.height <= 0) return;
+
+    int index = pinFrame(lowRes);
+    if (index < 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_missed += dets.size();
+        return;
+    }
+
+    // 检测流 -> 高清帧 的坐标比例 (两条通路出自同一 ISP 帧，视场一致)
+    float sx = (float)m_width / lowRes.width;
+    float sy = (float)m_height / lowRes.height;
+    cv::Rect bounds(0, 0, m_width, m_height);
+    cv::Mat buffer, rgb;   // 各目标共用一块裁剪缓冲，尺寸不变时不重新分配
+    uint64_t refined = 0, cpuFallback = 0;
+    double cropMs = 0.0;
+
+    for (auto& det : dets) {
+        auto t0 = std::chrono::steady_clock::now();
+
+        // NV12 裁剪起点和宽高都要 2 对齐
+        int x0 = alignDown2((int)(det.box.x * sx));
+        int y0 = alignDown2((int)(det.box.y * sy));
+        int x1 = alignUp2((int)std::ceil((det.box.x + det.box.width) * sx));
+        int y1 = alignUp2((int)std::ceil((det.box.y + det.box.height) * sy));
+        cv::Rect roi = cv::Rect(x0, y0, x1 - x0, y1 - y0) & bounds;
+        roi.width = alignDown2(roi.width);
+        roi.height = alignDown2(roi.height);
+        if (roi.width < 4 || roi.height < 4) continue;
+
+        bool usedCpu = false;
+        cv::Point2f c;
+        if (cropRoi(index, roi, buffer, rgb, rgaCore, usedCpu) && greenCentroid(rgb, c)) {
+            // 高清小图坐标 -> 高清帧坐标 -> 检测流坐标 (保留亚像素)
+            float hx = roi.x + c.x * roi.width / rgb.cols;
+            float hy = roi.y + c.y * roi.height / rgb.rows;
+            det.preciseTarget = cv::Point2f(hx / sx, hy / sy);
+            det.targetX = cvRound(det.preciseTarget.x);
+            det.targetY = cvRound(det.preciseTarget.y);
+            det.refined = true;
+            refined++;
+        }
+        if (usedCpu) cpuFallback++;
+        cropMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    unpinFrame(index);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_crops += dets.size();
+    m_refined += refined;
+    m_cpuFallback += cpuFallback;
+    m_cropMsSum += cropMs;
+}
+
+HighResPath::Stats HighResPath::snapshot()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_statsStart).count();
+    Stats s;
+    s.fps = elapsed > 0 ? m_frames / elapsed : 0.0;
+    s.crops = m_crops;
+    s.refined = m_refined;
+    s.missed = m_missed;
+    s.cpuFallback = m_cpuFallback;
+    s.avgCropMs = m_crops ? m_cropMsSum / m_crops : 0.0;
+    return s;
+}
+
+void HighResPath::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frames = m_crops = m_refined = m_missed = m_cpuFallback = 0;
+    m_cropMsSum = 0.0;
+    m_statsStart = std::chrono::steady_clock::now();
+}
+
+void HighResPath::dumpStats()
+{
+    Stats s = snapshot();
+    qDebug() << "[高清通路]" << m_width << "x" << m_height
+             << "出帧:" << QString::number(s.fps, 'f', 1) << "fps"
+             << "裁剪:" << s.crops << "精修成功:" << s.refined
+             << "未匹配:" << s.missed << "CPU兜底:" << s.cpuFallback
+             << "单目标耗时:" << QString::number(s.avgCropMs, 'f', 2) << "ms";
+}
@@ -0,0 +1,101 @@
+#ifndef HIGHRESPATH_H
+#define HIGHRESPATH_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "camerasource.h"
+#include "inference.h"
+
+// ==========================================
+// ISP 双通路采集的高清通路
+// selfpath 出 800x600 小图给 NPU 检测，mainpath 按 Sensor 全分辨率出图但不拷贝到用户态：
+// 最近几帧的 V4L2 buffer 暂时扣住不还给驱动，检测出结果后按帧序号找到同一 ISP 帧，
+// 只把每个目标框对应的那一小块高清区域用 RGA 裁出来，在高清小图上精修激光瞄准点
+// ==========================================
+class HighResPath
+{
+public:
+    struct Stats {
+        double fps;            // 高清通路出帧率
+        uint64_t crops;        // 裁剪的目标数
+        uint64_t refined;      // 精修成功的目标数
+        uint64_t missed;       // 找不到对应高清帧 (已被驱动回收) 的目标数
+        uint64_t cpuFallback;  // RGA 不可用、走 CPU 裁剪的次数
+        double avgCropMs;      // 单个目标 裁剪+精修 平均耗时
+    };
+
+    HighResPath();
+    ~HighResPath();
+
+    // 以 NV12 单平面格式打开 mainpath，holdDepth 为扣住不还的最近帧数
+    bool open(const std::string& node, int width, int height, int fps, int bufferCount = 6, int holdDepth = 3);
+    void start();
+    void stop();
+    bool isOpen() const { return m_fd >= 0; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    // 对检测流上的结果做高清精修：det.box 为 lowRes 坐标，精修后写回 preciseTarget / targetX / targetY
+    // rgaCore 为调用线程的专属 RGA 核心 (见 RgaScheduler)
+    void refineTargets(std::vector<Detection>& dets, const CameraFrame& lowRes, int rgaCore);
+
+    Stats snapshot();
+    void resetStats();
+    void dumpStats();
+
+private:
+    struct Slot {
+        int index = -1;
+        uint32_t sequence = 0;
+        std::chrono::steady_clock::time_point captureTime;
+        int pins = 0;          // 正在被推理线程裁剪的次数，> 0 时不能还给驱动
+    };
+
+    struct Buffer {
+        void* start = nullptr;
+        size_t length = 0;
+        int dmaFd = -1;        // VIDIOC_EXPBUF 导出的 dma-buf，RGA 直接按 fd 读，不经过 CPU
+    };
+
+    void captureLoop();
+    void close();
+    bool queueBuffer(int index);
+    // 按驱动帧序号找同一 ISP 帧，序号对不上时退回按时间戳找最近的一帧
+    int pinFrame(const CameraFrame& lowRes);
+    void unpinFrame(int index);
+    // 把高清帧上的 roi 转成 RGB 小图：buffer 为 16 对齐的底层缓冲，rgb 为其中的有效区域
+    bool cropRoi(int index, const cv::Rect& roi, cv::Mat& buffer, cv::Mat& rgb, int rgaCore, bool& usedCpu);
+
+    int m_fd = -1;
+    int m_epollFd = -1;
+    bool m_mplane = true;
+    int m_width = 0;
+    int m_height = 0;
+    int m_bytesPerLine = 0;
+    int m_planeHeight = 0;     // Y 平面行数 (UV 紧跟其后)
+    size_t m_holdDepth = 3;
+    std::vector<Buffer> m_buffers;
+
+    std::deque<Slot> m_held;   // 已出帧、暂未还给驱动的 buffer，按时间从旧到新
+    std::mutex m_mutex;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    // 统计 (受 m_mutex 保护)
+    uint64_t m_frames = 0;
+    uint64_t m_crops = 0;
+    uint64_t m_refined = 0;
+    uint64_t m_missed = 0;
+    uint64_t m_cpuFallback = 0;
+    double m_cropMsSum = 0.0;
+    std::chrono::steady_clock::time_point m_statsStart;
+};
+
+#endif // HIGHRESPATH_H
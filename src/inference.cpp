@@ -4,14 +4,32 @@
 #include <QFile>
 #include <cmath>
 #include <algorithm>
+#include <sstream>
+#include <cstring>
 #include <chrono> // 引入高精度计时器
 #include "im2d.hpp" 
+#include "rgascheduler.h"
+#include "camerasource.h"
 
 Inference::Inference(const std::string& modelPath, const cv::Size& inputSize, const QString& classesPath, rknn_core_mask core_mask)
 {
     modelInputSize = inputSize;
     loadClasses(classesPath);
 
+    // 模型目录里带 metadata.yaml 时，类别表以模型自带的为准 (剪枝 / 重新训练的模型不用再改 classes.txt)
+    std::string metaPath = ModelMetadata::locate(modelPath);
+    if (!metaPath.empty() && ModelMetadata::load(metaPath, m_meta) && !m_meta.names.empty()) {
+        if (m_meta.names.size() != classes.size()) {
+            qDebug() << ">>> metadata.yaml 类别数" << m_meta.names.size() << "与 classes.txt" << classes.size() << "不同，以模型为准";
+        }
+        classes = m_meta.names;
+    }
+
+    // NPU Core0/1/2 分别对应 RGA3_CORE0 / RGA3_CORE1 / RGA2_CORE0
+    if (core_mask == RKNN_NPU_CORE_1) m_rgaCore = 1;
+    else if (core_mask == RKNN_NPU_CORE_2) m_rgaCore = 2;
+    else m_rgaCore = 0;
+
     // 1. 读取 .rknn 模型文件到内存
     FILE *fp = fopen(modelPath.c_str(), "rb");
     if (!fp) {
@@ -55,6 +73,28 @@ Inference::Inference(const std::string& modelPath, const cv::Size& inputSize, co
         rknn_query(ctx, RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
     }
 
+    // 模型输入尺寸以 .rknn 实际导出的为准：例如只覆盖激光带的扁长输入 (640x256)，NPU 算量随之缩小
+    if (io_num.n_input > 0 && input_attrs[0].n_dims == 4) {
+        bool nhwc = input_attrs[0].fmt == RKNN_TENSOR_NHWC;
+        int in_h = nhwc ? input_attrs[0].dims[1] : input_attrs[0].dims[2];
+        int in_w = nhwc ? input_attrs[0].dims[2] : input_attrs[0].dims[3];
+        int in_c = nhwc ? input_attrs[0].dims[3] : input_attrs[0].dims[1];
+        // 图内做颜色转换的 NV12 模型 (export_rknn.py --nv12-input) 以导出时留下的标记为准：
+        // metadata.yaml 的 input: nv12 或输入张量名 images_nv12；只看形状会把单通道灰度模型误认成 NV12
+        bool nv12Marked = m_meta.input == "nv12" || strcmp(input_attrs[0].name, "images_nv12") == 0;
+        if (nv12Marked && in_c == 1 && in_h % 3 == 0) {
+            m_nv12Input = true;
+            in_h = in_h * 2 / 3;
+            qDebug() << ">>> 模型直接接收 NV12 输入 (图内颜色转换)，预处理只做 RGA 缩放";
+        } else if (nv12Marked) {
+            qDebug() << "【警告】模型标记为 NV12 输入，但输入形状不是 [1, 1, H*3/2, W]，按 RGB 输入处理";
+        }
+        if (in_w > 0 && in_h > 0 && (in_w != modelInputSize.width || in_h != modelInputSize.height)) {
+            qDebug() << ">>> 模型输入尺寸" << in_w << "x" << in_h << "与配置不同，以模型为准";
+            modelInputSize = cv::Size(in_w, in_h);
+        }
+    }
+
     // ✅ 动态读取输出节点数量
     output_attrs = new rknn_tensor_attr[io_num.n_output];
     for (int i = 0; i < io_num.n_output; i++) {
@@ -62,6 +102,36 @@ Inference::Inference(const std::string& modelPath, const cv::Size& inputSize, co
         rknn_query(ctx, RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
     }
 
+    // 识别检测头布局并选定解码内核，之后每帧直接调用
+    std::string layoutErr;
+    if (HeadLayout::build(output_attrs, io_num.n_output, modelInputSize, m_meta, m_layout, layoutErr)) {
+        const char* kernel = "";
+        m_decode = selectDecoder(m_layout, &kernel);
+        qDebug() << ">>> 检测头布局:" << m_layout.describe().c_str() << "| 解码内核:" << kernel;
+    } else {
+        qDebug() << "【致命错误】无法识别模型输出布局:" << layoutErr.c_str();
+    }
+    m_outputs.resize(io_num.n_output);
+    m_outputBufs.resize(io_num.n_output, nullptr);
+
+    // 类别通道数以 cls 输出张量为准，默认全部参与解码
+    // (图内后处理的模型输出里没有类别通道，类别数取自元数据或 classes.txt)
+    m_numClassChannels = m_decode && m_layout.numClasses > 0 ? m_layout.numClasses : (int)classes.size();
+    if (m_layout.kind == HeadKind::TopK) {
+        m_layout.numClasses = m_numClassChannels;
+        // 图内后处理只给类别号，没有元数据也没有 classes.txt 就不知道合法范围，优先级表也建不起来：不解码
+        if (m_numClassChannels <= 0) {
+            qDebug() << "【致命错误】TopK 输出模型缺少类别数 (元数据 / classes.txt 都没有)，不做解码";
+            m_decode = nullptr;
+        }
+    }
+    if ((int)classes.size() < m_numClassChannels) {
+        qDebug() << "【警告】类别名只有" << classes.size() << "个，模型输出" << m_numClassChannels << "个类别通道";
+    }
+    m_activeClasses.clear();
+    for (int c = 0; c < m_numClassChannels; ++c) m_activeClasses.push_back(c);
+    m_classPriority.assign(m_numClassChannels, 0);
+
     // 构造函数里 rknn_init 之后加这几行
     rknn_sdk_version sdk_ver;
     rknn_query(ctx, RKNN_QUERY_SDK_VERSION, &sdk_ver, sizeof(sdk_ver));
@@ -114,11 +184,59 @@ void Inference::loadClasses(const QString& classesPath) {
     }
 }
 
+bool Inference::setClassFilter(const std::string& spec) {
+    std::vector<int> active;
+    std::vector<int> priority(m_numClassChannels, 0);
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int prio = 0;
+        size_t colon = item.find_last_of(':');
+        if (colon != std::string::npos) {
+            prio = atoi(item.c_str() + colon + 1);
+            item = item.substr(0, colon);
+        }
+        if (item.empty()) continue;
+        int id = -1;
+        auto it = std::find(classes.begin(), classes.end(), item);
+        if (it != classes.end()) {
+            id = (int)(it - classes.begin());
+        } else if (item.find_first_not_of("0123456789") == std::string::npos) {
+            id = atoi(item.c_str());
+        }
+        if (id < 0 || id >= m_numClassChannels) {
+            qDebug() << "【警告】类别白名单里的" << item.c_str() << "不在模型类别表中，已忽略";
+            continue;
+        }
+        if (std::find(active.begin(), active.end(), id) == active.end()) active.push_back(id);
+        priority[id] = prio;
+    }
+    if (active.empty()) return false;
+
+    // 升序排列：argmax 时按通道地址顺序访问，对缓存更友好
+    std::sort(active.begin(), active.end());
+    m_activeClasses = active;
+    m_classPriority = priority;
+    return true;
+}
+
 std::vector<Detection> Inference::runInference(const cv::Mat& frame) {
     std::vector<Detection> outputDetections;
     if (ctx == 0 || frame.empty()) return outputDetections;
 
-    auto t0 = std::chrono::steady_clock::now();
+    // NV12 输入的模型：BGR 先转成 NV12 再走同一条路 (只有离线评估会用到 BGR 入口)
+    if (m_nv12Input) {
+        cv::Mat nv12_img;
+        bgrToNv12(frame(cv::Rect(0, 0, frame.cols & ~1, frame.rows & ~1)), nv12_img);
+        Nv12Frame view;
+        view.width = frame.cols & ~1;
+        view.height = frame.rows & ~1;
+        view.y = nv12_img.data;
+        view.uv = nv12_img.data + (size_t)view.width * view.height;
+        view.yStride = view.width;
+        view.uvStride = view.width;
+        return runInference(view);
+    }
 
     // ========== 1. 预处理（保持不变）==========
     float scale = std::min((float)modelInputSize.width / frame.cols,
@@ -137,6 +255,7 @@ std::vector<Detection> Inference::runInference(const cv::Mat& frame) {
         im_rect dst_rect = {pad_left, pad_top, new_w, new_h};
         im_rect pat_rect = {0, 0, 0, 0};
         rga_buffer_t pat = {};
+        RgaCoreGuard rgaGuard(m_rgaCore); // 独占一个 RGA 核心，忙时自动回退
         IM_STATUS check_ret = imcheck(src, dst, src_rect, dst_rect);
         if (check_ret == IM_STATUS_NOERROR) {
             IM_STATUS run_ret = improcess(src, dst, pat, src_rect, dst_rect, pat_rect, IM_SYNC);
@@ -150,12 +269,159 @@ std::vector<Detection> Inference::runInference(const cv::Mat& frame) {
         cv::cvtColor(letterbox_img, letterbox_img, cv::COLOR_BGR2RGB);
     }
 
+    return inferLetterbox(letterbox_img, scale, pad_left, pad_top, cv::Size(frame.cols, frame.rows));
+}
+
+void Inference::setRoi(const DetectRoi& roi) {
+    m_roi = roi;
+    m_roiMask = RoiCellMask();
+}
+
+std::vector<Detection> Inference::runInference(const Nv12Frame& frame) {
+    if (m_roi.empty()) {
+        return runNv12(frame, cv::Rect(0, 0, frame.width, frame.height), false);
+    }
+    cv::Rect crop = m_roi.bounds(cv::Size(frame.width, frame.height));
+    if (crop.width <= 0 || crop.height <= 0) return std::vector<Detection>();
+    return runNv12(frame, crop, true);
+}
+
+std::vector<Detection> Inference::runInference(const Nv12Frame& frame, const cv::Rect& roi) {
+    return runNv12(frame, roi, false);
+}
+
+std::vector<Detection> Inference::runNv12(const Nv12Frame& frame, const cv::Rect& roi, bool useRoiMask) {
+    if (ctx == 0 || !frame.y || !frame.uv || roi.width <= 0 || roi.height <= 0) return std::vector<Detection>();
+
+    float scale = 1.f;
+    LetterboxParams lb = m_nv12Input
+        ? nv12::makeLetterboxEven(roi.width, roi.height, modelInputSize.width, modelInputSize.height, &scale)
+        : nv12::makeLetterbox(roi.width, roi.height, modelInputSize.width, modelInputSize.height, &scale);
+    // 网格掩码只和 (帧尺寸, 裁剪区) 有关，换分辨率或改 ROI 时才重建
+    const RoiCellMask* cellMask = nullptr;
+    if (useRoiMask) {
+        cv::Size frameSize(frame.width, frame.height);
+        if (m_roiMask.frameSize != frameSize || m_roiMask.crop != roi || m_roiMask.cells.empty()) {
+            m_roiMask.build(m_roi, frameSize, roi, modelInputSize, scale, lb.padLeft, lb.padTop, m_layout.strides());
+        }
+        cellMask = &m_roiMask;
+    }
+    if (m_nv12Input) return runNv12Input(frame, roi, lb, scale, cellMask);
+    if (m_letterbox.empty()) {
+        m_letterbox = cv::Mat(modelInputSize.height, modelInputSize.width, CV_8UC3);
+        m_letterboxLayout = LetterboxParams();
+    }
+    // RGA 只写 dst_rect，切块 / 整帧 / ROI 裁剪之间几何一变，上一种几何的画面会残留在填充带里
+    if (lb.newW != m_letterboxLayout.newW || lb.newH != m_letterboxLayout.newH ||
+        lb.padLeft != m_letterboxLayout.padLeft || lb.padTop != m_letterboxLayout.padTop) {
+        m_letterbox.setTo(cv::Scalar(114, 114, 114));
+        m_letterboxLayout = lb;
+    }
+
+    // RGA 只认 Y/UV 连续存放的 NV12；多平面 NV12M 或带 stride 的帧直接走 CPU 融合内核
+    bool contiguous = frame.yStride == frame.width && frame.uvStride == frame.width &&
+                      frame.uv == frame.y + (size_t)frame.width * frame.height;
+    bool rga_ok = false;
+    if (contiguous) {
+        rga_buffer_t src = wrapbuffer_virtualaddr((void*)frame.y, frame.width, frame.height, RK_FORMAT_YCbCr_420_SP);
+        rga_buffer_t dst = wrapbuffer_virtualaddr((void*)m_letterbox.data, m_letterbox.cols, m_letterbox.rows, RK_FORMAT_RGB_888);
+        im_rect src_rect = {roi.x, roi.y, roi.width, roi.height};
+        im_rect dst_rect = {lb.padLeft, lb.padTop, lb.newW, lb.newH};
+        im_rect pat_rect = {0, 0, 0, 0};
+        rga_buffer_t pat = {};
+        RgaCoreGuard rgaGuard(m_rgaCore);
+        if (imcheck(src, dst, src_rect, dst_rect) == IM_STATUS_NOERROR) {
+            rga_ok = (improcess(src, dst, pat, src_rect, dst_rect, pat_rect, IM_SYNC) == IM_STATUS_SUCCESS);
+        }
+    }
+    if (!rga_ok) {
+        // CPU 内核按 ROI 起点偏移平面指针即可 (NV12 的 ROI 起点是 2 对齐的)
+        Nv12Frame view = frame;
+        view.y = frame.y + (size_t)roi.y * frame.yStride + roi.x;
+        view.uv = frame.uv + (size_t)(roi.y / 2) * frame.uvStride + (roi.x & ~1);
+        view.width = roi.width;
+        view.height = roi.height;
+        nv12::letterboxRGB(view, m_letterbox.data, lb);
+    }
+
+    std::vector<Detection> dets = inferLetterbox(m_letterbox, scale, lb.padLeft, lb.padTop,
+                                                 cv::Size(roi.width, roi.height), cellMask);
+    offsetToFrame(dets, roi);
+    return dets;
+}
+
+std::vector<Detection> Inference::runNv12Input(const Nv12Frame& frame, const cv::Rect& roi,
+                                               const LetterboxParams& lb, float scale, const RoiCellMask* cellMask) {
+    const int W = modelInputSize.width;
+    const int H = modelInputSize.height;
+    if (m_letterbox.empty()) {
+        m_letterbox = cv::Mat(H * 3 / 2, W, CV_8UC1);
+        m_letterboxLayout = LetterboxParams();
+    }
+    // RGA 只写有效区：letterbox 几何变了 (切块 / 换 ROI) 才重新刷一遍填充色
+    if (lb.newW != m_letterboxLayout.newW || lb.newH != m_letterboxLayout.newH ||
+        lb.padLeft != m_letterboxLayout.padLeft || lb.padTop != m_letterboxLayout.padTop) {
+        memset(m_letterbox.data, nv12::PAD_Y, (size_t)W * H);
+        memset(m_letterbox.data + (size_t)W * H, nv12::PAD_UV, (size_t)W * H / 2);
+        m_letterboxLayout = lb;
+    }
+
+    // 采集缓冲区 -> 模型输入只剩一次 RGA 缩放 (NV12 -> NV12)，颜色转换和归一化在 NPU 图里做
+    bool contiguous = frame.yStride == frame.width && frame.uvStride == frame.width &&
+                      frame.uv == frame.y + (size_t)frame.width * frame.height;
+    bool rga_ok = false;
+    if (contiguous) {
+        rga_buffer_t src = wrapbuffer_virtualaddr((void*)frame.y, frame.width, frame.height, RK_FORMAT_YCbCr_420_SP);
+        rga_buffer_t dst = wrapbuffer_virtualaddr((void*)m_letterbox.data, W, H, RK_FORMAT_YCbCr_420_SP);
+        im_rect src_rect = {roi.x, roi.y, roi.width, roi.height};
+        im_rect dst_rect = {lb.padLeft, lb.padTop, lb.newW, lb.newH};
+        im_rect pat_rect = {0, 0, 0, 0};
+        rga_buffer_t pat = {};
+        RgaCoreGuard rgaGuard(m_rgaCore);
+        if (imcheck(src, dst, src_rect, dst_rect) == IM_STATUS_NOERROR) {
+            rga_ok = (improcess(src, dst, pat, src_rect, dst_rect, pat_rect, IM_SYNC) == IM_STATUS_SUCCESS);
+        }
+    }
+    if (!rga_ok) {
+        Nv12Frame view = frame;
+        view.y = frame.y + (size_t)roi.y * frame.yStride + roi.x;
+        view.uv = frame.uv + (size_t)(roi.y / 2) * frame.uvStride + (roi.x & ~1);
+        view.width = roi.width;
+        view.height = roi.height;
+        nv12::letterboxNV12(view, m_letterbox.data, lb);
+    }
+
+    std::vector<Detection> dets = inferLetterbox(m_letterbox, scale, lb.padLeft, lb.padTop,
+                                                 cv::Size(roi.width, roi.height), cellMask);
+    offsetToFrame(dets, roi);
+    return dets;
+}
+
+void Inference::offsetToFrame(std::vector<Detection>& dets, const cv::Rect& roi) {
+    if (roi.x != 0 || roi.y != 0) {
+        for (auto& det : dets) {
+            det.box.x += roi.x;
+            det.box.y += roi.y;
+            det.targetX += roi.x;
+            det.targetY += roi.y;
+            det.preciseTarget.x += roi.x;
+            det.preciseTarget.y += roi.y;
+        }
+    }
+}
+
+std::vector<Detection> Inference::inferLetterbox(const cv::Mat& letterbox_img, float scale,
+                                                 int pad_left, int pad_top, const cv::Size& frameSize,
+                                                 const RoiCellMask* cellMask) {
+    std::vector<Detection> outputDetections;
+    auto t0 = std::chrono::steady_clock::now();
+
     // ========== 2. NPU输入配置（保持不变）==========
     rknn_input inputs[1];
     memset(inputs, 0, sizeof(inputs));
     inputs[0].index = 0;
     inputs[0].type = RKNN_TENSOR_UINT8;
-    inputs[0].size = letterbox_img.cols * letterbox_img.rows * 3;
+    inputs[0].size = letterbox_img.total() * letterbox_img.elemSize();  // RGB888 或 NV12 (W*H*3/2)
     inputs[0].fmt = RKNN_TENSOR_NHWC;
     inputs[0].pass_through = 0;
     inputs[0].buf = letterbox_img.data;
@@ -166,114 +432,49 @@ std::vector<Detection> Inference::runInference(const cv::Mat& frame) {
     // ========== 3. NPU推理 ==========
     rknn_run(ctx, NULL);
 
-    // ========== 4. 获取9个输出（原生int8）==========
-    rknn_output outputs[9];
-    memset(outputs, 0, sizeof(outputs));
-    for (int i = 0; i < 9; i++) {
-        outputs[i].want_float = 0;
+    // ========== 4. 获取全部输出 (布局在加载时已识别) ==========
+    if (!m_decode) return outputDetections;
+    const int n_output = (int)m_outputs.size();
+    for (int i = 0; i < n_output; i++) {
+        memset(&m_outputs[i], 0, sizeof(rknn_output));
+        m_outputs[i].want_float = m_layout.wantFloat ? 1 : 0;
+    }
+    rknn_outputs_get(ctx, n_output, m_outputs.data(), NULL);
+    for (int i = 0; i < n_output; i++) {
+        m_outputBufs[i] = m_outputs[i].buf;
     }
-    rknn_outputs_get(ctx, 9, outputs, NULL);
 
     auto t2 = std::chrono::steady_clock::now();
 
-    // ========== 5. INT8解码（含DFL softmax）==========
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
-    int num_classes = classes.size();
-    int strides[] = {8, 16, 32};
-    const int REG_MAX = 16;  // DFL的bin数量
+    // ========== 5. 解码 (按布局特化的内核，含 DFL softmax) ==========
     float conf_threshold = 0.45f;
+    DecodeArgs args;
+    args.bufs = m_outputBufs.data();
+    args.attrs = output_attrs;
+    args.layout = &m_layout;
+    args.activeClasses = m_activeClasses.data();
+    args.numActive = (int)m_activeClasses.size();
+    args.classSubset = args.numActive < m_numClassChannels;
+    args.cellMask = cellMask;
+    args.confThreshold = conf_threshold;
+    args.scale = scale;
+    args.padLeft = pad_left;
+    args.padTop = pad_top;
+    args.frameSize = frameSize;
+    m_candidates.clear();
+    m_decode(args, m_candidates);
+    const std::vector<cv::Rect>& boxes = m_candidates.boxes;
+    const std::vector<float>& confidences = m_candidates.confidences;
+    const std::vector<int>& class_ids = m_candidates.classIds;
 
-    for (int i = 0; i < 3; ++i) {
-        // 每组3个输出：box(64ch) -> cls(80ch) -> clssum(1ch)
-        int box_idx    = i * 3 + 0;
-        int cls_idx    = i * 3 + 1;
-        int clssum_idx = i * 3 + 2;
-
-        int8_t* box_ptr    = (int8_t*)outputs[box_idx].buf;
-        int8_t* cls_ptr    = (int8_t*)outputs[cls_idx].buf;
-        int8_t* clssum_ptr = (int8_t*)outputs[clssum_idx].buf;
-
-        float box_scale    = output_attrs[box_idx].scale;
-        int   box_zp       = output_attrs[box_idx].zp;
-        float cls_scale    = output_attrs[cls_idx].scale;
-        int   cls_zp       = output_attrs[cls_idx].zp;
-        float clssum_scale = output_attrs[clssum_idx].scale;
-        int   clssum_zp    = output_attrs[clssum_idx].zp;
-
-        int stride = strides[i];
-        int grid_w = modelInputSize.width / stride;
-        int grid_h = modelInputSize.height / stride;
-        int grid_area = grid_w * grid_h;
-
-        int8_t clssum_thres_i8 = std::max((int8_t)-128,
-            (int8_t)std::min(127, (int)std::round(conf_threshold / clssum_scale + clssum_zp)));
-
-        for (int y = 0; y < grid_h; ++y) {
-            for (int x = 0; x < grid_w; ++x) {
-                int g_idx = y * grid_w + x;
-
-                if (clssum_ptr[g_idx] <= clssum_thres_i8) continue;
-
-                int8_t maxScore_i8 = -128;
-                int classId = -1;
-                for (int c = 0; c < num_classes; ++c) {
-                    int8_t score_i8 = cls_ptr[c * grid_area + g_idx];
-                    if (score_i8 > maxScore_i8) {
-                        maxScore_i8 = score_i8;
-                        classId = c;
-                    }
-                }
-                float maxScore = (maxScore_i8 - cls_zp) * cls_scale;
-                if (maxScore <= conf_threshold) continue;
-
-                float dist[4];
-                for (int side = 0; side < 4; ++side) {
-                    float logits[16];
-                    float maxLogit = -1e9f;
-                    for (int b = 0; b < 16; ++b) {
-                        int ch = side * 16 + b;
-                        float v = (box_ptr[ch * grid_area + g_idx] - box_zp) * box_scale;
-                        logits[b] = v;
-                        if (v > maxLogit) maxLogit = v;
-                    }
-                    float sumExp = 0.f;
-                    float probs[16];
-                    for (int b = 0; b < 16; ++b) {
-                        probs[b] = std::exp(logits[b] - maxLogit);
-                        sumExp += probs[b];
-                    }
-                    float weighted = 0.f;
-                    for (int b = 0; b < 16; ++b) {
-                        weighted += (probs[b] / sumExp) * b;
-                    }
-                    dist[side] = weighted;
-                }
-
-                float d_left = dist[0], d_top = dist[1], d_right = dist[2], d_bottom = dist[3];
-                float cx = (x + 0.5f) * stride;
-                float cy = (y + 0.5f) * stride;
-                float x1 = cx - d_left * stride;
-                float y1 = cy - d_top * stride;
-                float x2 = cx + d_right * stride;
-                float y2 = cy + d_bottom * stride;
-
-                int final_x = std::max(0, (int)std::round((x1 - pad_left) / scale));
-                int final_y = std::max(0, (int)std::round((y1 - pad_top) / scale));
-                int final_w = std::min((int)std::round((x2 - x1) / scale), frame.cols - final_x);
-                int final_h = std::min((int)std::round((y2 - y1) / scale), frame.rows - final_y);
-                if (final_w <= 0 || final_h <= 0) continue;
-
-                boxes.push_back(cv::Rect(final_x, final_y, final_w, final_h));
-                confidences.push_back(maxScore);
-                class_ids.push_back(classId);
-            }
-        }
-    }
     // ========== 6. NMS（保持不变）==========
     std::vector<int> indices;
     cv::dnn::NMSBoxes(boxes, confidences, conf_threshold, 0.5f, indices);
+    // 高优先级类别排在前面，同优先级按置信度
+    std::stable_sort(indices.begin(), indices.end(), [&](int a, int b) {
+        int pa = m_classPriority[class_ids[a]], pb = m_classPriority[class_ids[b]];
+        return pa != pb ? pa > pb : confidences[a] > confidences[b];
+    });
     for (int i : indices) {
         Detection det;
         det.class_id = class_ids[i];
@@ -281,12 +482,14 @@ std::vector<Detection> Inference::runInference(const cv::Mat& frame) {
         det.box = boxes[i];
         det.targetX = boxes[i].x + boxes[i].width / 2;
         det.targetY = boxes[i].y + boxes[i].height / 2;
+        det.preciseTarget = cv::Point2f(boxes[i].x + boxes[i].width * 0.5f, boxes[i].y + boxes[i].height * 0.5f);
         det.className = (det.class_id >= 0 && det.class_id < classes.size()) ? classes[det.class_id] : "Unknown";
+        det.priority = m_classPriority[det.class_id];
         outputDetections.push_back(det);
     }
 
-    // ========== 7. 释放9个输出 ==========
-    rknn_outputs_release(ctx, 9, outputs);
+    // ========== 7. 释放输出 ==========
+    rknn_outputs_release(ctx, n_output, m_outputs.data());
 
     auto t3 = std::chrono::steady_clock::now();
     double pre_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
@@ -2,10 +2,15 @@
 #define INFERENCE_H
 
 #include <opencv2/opencv.hpp>
+#include <chrono>
 #include <vector>
 #include <string>
 #include <QString>
 #include "rknn_api.h" // 替换为瑞芯微的 NPU API
+#include "nv12letterbox.h"
+#include "detectroi.h"
+#include "modelmeta.h"
+#include "headlayout.h"
 
 struct Detection {
     int class_id;
@@ -14,6 +19,22 @@ struct Detection {
     std::string className;
     int targetX;
     int targetY;
+    int cameraId = 0;   // 来自哪一路摄像头 (多摄像头模式)
+    cv::Point2f preciseTarget{-1.f, -1.f}; // 高清 ROI 精修后的亚像素瞄准点 (检测流坐标)
+    bool refined = false;                  // 是否经过高清精修 (双通路模式)
+    int trackId = -1;                      // 跟踪器分配的稳定 ID，-1 表示未跟踪
+    bool newTrack = false;                 // 本帧刚确认的新目标 (同一棵苗只记录 / 打击一次)
+    bool predicted = false;                // 本帧没跑 NPU，位置由跟踪器外推得到
+    int priority = 0;                      // 类别优先级 (CAR_HMI_CLASSES)，越大越先处理
+    std::chrono::steady_clock::time_point captureTime; // 所在帧的拍摄时刻 (运动补偿的起点)
+    uint64_t frameSeq = 0;                 // 所在帧的采集序号 (CameraFrame::seq)，批量下发时作为帧号
+};
+
+// 一帧推理结果来自哪一帧：没有目标的帧也要带上，用来下发空批次清掉下位机手里的旧目标
+struct FrameStamp {
+    int cameraId = 0;
+    uint64_t seq = 0;
+    std::chrono::steady_clock::time_point captureTime;
 };
 
 class Inference
@@ -27,18 +48,65 @@ public:
     ~Inference();
 
     std::vector<Detection> runInference(const cv::Mat& frame);
+    // 直接吃摄像头 NV12：RGA 一步完成缩放+转色，RGA 不可用时走 NEON/SSE 融合内核
+    std::vector<Detection> runInference(const Nv12Frame& frame);
+    // 只对帧上的 roi 区域做推理 (切块模式)，结果已映射回整帧坐标；roi 起点和宽高需 2 对齐
+    std::vector<Detection> runInference(const Nv12Frame& frame, const cv::Rect& roi);
+
+    // 激光可达区：设置后整帧 NV12 推理只裁剪 ROI 外接矩形，解码跳过 ROI 外的网格 (切块模式不受影响)
+    void setRoi(const DetectRoi& roi);
+    // 类别白名单 + 优先级："名称或编号[:优先级],..."，例如 "weed:2,thistle:5,12"
+    // 解码只在白名单的类别通道上做 argmax；解析不出任何类别时返回 false 并保持全部类别
+    bool setClassFilter(const std::string& spec);
+    const std::vector<std::string>& classNames() const { return classes; }
 
 private:
     void loadClasses(const QString& classesPath);
+    // letterbox 之后的公共流程：NPU 推理 + 解码 + NMS
+    std::vector<Detection> inferLetterbox(const cv::Mat& letterbox_img, float scale,
+                                          int pad_left, int pad_top, const cv::Size& frameSize,
+                                          const RoiCellMask* cellMask = nullptr);
+    // NV12 裁剪 + letterbox + 推理，结果映射回整帧坐标；useRoiMask 时按 m_roi 跳过网格
+    std::vector<Detection> runNv12(const Nv12Frame& frame, const cv::Rect& crop, bool useRoiMask);
+    // NV12 输入的模型：RGA 只做 NV12 -> NV12 缩放，颜色转换在图里
+    std::vector<Detection> runNv12Input(const Nv12Frame& frame, const cv::Rect& roi,
+                                        const LetterboxParams& lb, float scale, const RoiCellMask* cellMask);
+    // 裁剪区坐标 -> 整帧坐标
+    static void offsetToFrame(std::vector<Detection>& dets, const cv::Rect& roi);
 
     cv::Size modelInputSize;
     std::vector<std::string> classes;
+    ModelMetadata m_meta;              // 模型自带的 metadata.yaml (没有时 valid() 为 false)
+
+    // 检测头布局与加载时选定的解码内核；输出描述与候选框缓冲区逐帧复用
+    HeadLayout m_layout;
+    DecodeFn m_decode = nullptr;
+    std::vector<rknn_output> m_outputs;
+    std::vector<void*> m_outputBufs;
+    DecodeResult m_candidates;
+
+    // 参与解码的类别通道 (升序，紧凑排列) 与按类别编号索引的优先级
+    int m_numClassChannels = 0;
+    std::vector<int> m_activeClasses;
+    std::vector<int> m_classPriority;
 
     // NPU 核心上下文
     rknn_context ctx = 0;
     rknn_input_output_num io_num;
     rknn_tensor_attr* input_attrs = nullptr;
     rknn_tensor_attr* output_attrs = nullptr;
+
+    // 预处理使用的专属 RGA 核心 (与 NPU 核心一一对应，见 RgaScheduler)
+    int m_rgaCore = 0;
+
+    // NV12 路径复用的模型输入缓冲区，避免每帧分配 (RGB888，NV12 输入模型时为 W x H*3/2 的 NV12)
+    cv::Mat m_letterbox;
+    bool m_nv12Input = false;
+    LetterboxParams m_letterboxLayout;   // 上次填充过的 letterbox 几何 (变了要重刷填充区，RGA 只写有效区)
+
+    // 激光可达区与按 (帧尺寸, 裁剪区) 缓存的网格掩码
+    DetectRoi m_roi;
+    RoiCellMask m_roiMask;
 };
 
 #endif // INFERENCE_H
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "latencytracker.h"
+#include <QDebug>
+#include <algorithm>
+
+const double LatencyTracker::kBucketMs[LatencyTracker::kBuckets - 1] = {
+    0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000
+};
+
+static const char* commandName(int type)
+{
+    switch (type) {
+    case CMD_HEARTBEAT:    return "心跳";
+    case CMD_MOVE:         return "移动";
+    case CMD_CONTROL:      return "控制";
+    case CMD_TARGET:       return "目标";
+    case CMD_TARGET_BATCH: return "批量目标";
+    case CMD_ECHO:         return "回显";
+    }
+    return "?";
+}
+
+double LatencyTracker::TypeStats::percentileMs(double p) const
+{
+    if (acked == 0) return 0.0;
+    uint64_t need = (uint64_t)(p * acked + 0.5);
+    if (need == 0) need = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += hist[i];
+        if (seen >= need) return i < kBuckets - 1 ? std::min(kBucketMs[i], maxMs) : maxMs;
+    }
+    return maxMs;
+}
+
+LatencyTracker::LatencyTracker()
+{
+    m_windowStart = Clock::now();
+}
+
+void LatencyTracker::setLossTimeoutMs(double ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lossTimeoutMs = std::max(1.0, ms);
+}
+
+void LatencyTracker::stamp(uint8_t type, proto::Trace& trace)
+{
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint16_t seq = m_nextSeq++;
+    Pending& slot = m_pending[seq % kWindow];
+    // 槽位被复用时上一条还没回显：判丢失
+    if (slot.open && slot.type < proto::kCommandCount) m_stats[slot.type].lost++;
+
+    slot.open = true;
+    slot.type = type;
+    slot.seq = seq;
+    slot.sent = now;
+    // 单调时钟微秒的低 32 位，约 71 分钟回绕一次，只用来和回显比对
+    slot.sendUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    if (type < proto::kCommandCount) m_stats[type].sent++;
+
+    trace.seq = seq;
+    trace.sendUs = slot.sendUs;
+    trace.flags = FRAME_FLAG_ECHO;
+}
+
+void LatencyTracker::onEcho(const EchoPayload& echo)
+{
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Pending& slot = m_pending[echo.seq % kWindow];
+    // 序号和发送时刻都对上才算这一条的回显，防止序号回绕后配错
+    if (!slot.open || slot.seq != echo.seq || slot.sendUs != echo.sendUs || slot.type != echo.type) {
+        if (echo.type < proto::kCommandCount) m_stats[echo.type].late++;
+        return;
+    }
+    slot.open = false;
+    if (slot.type >= proto::kCommandCount) return;
+
+    TypeStats& st = m_stats[slot.type];
+    double rtt = std::chrono::duration<double, std::milli>(now - slot.sent).count();
+    if (st.acked == 0 || rtt < st.minMs) st.minMs = rtt;
+    if (st.acked == 0 || rtt > st.maxMs) st.maxMs = rtt;
+    st.acked++;
+    st.sumMs += rtt;
+    st.sumProcMs += echo.procUs / 1000.0;
+    if (echo.status != 0) st.rejected++;
+    int bucket = 0;
+    while (bucket < kBuckets - 1 && rtt > kBucketMs[bucket]) bucket++;
+    st.hist[bucket]++;
+}
+
+void LatencyTracker::expireLocked(Clock::time_point now)
+{
+    for (auto& slot : m_pending) {
+        if (!slot.open) continue;
+        double age = std::chrono::duration<double, std::milli>(now - slot.sent).count();
+        if (age > m_lossTimeoutMs) {
+            slot.open = false;
+            if (slot.type < proto::kCommandCount) m_stats[slot.type].lost++;
+        }
+    }
+}
+
+LatencyTracker::TypeStats LatencyTracker::stats(uint8_t type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    expireLocked(Clock::now());
+    return type < proto::kCommandCount ? m_stats[type] : TypeStats();
+}
+
+void LatencyTracker::dumpStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    expireLocked(now);
+    double window = std::chrono::duration<double>(now - m_windowStart).count();
+    for (int t = 0; t < proto::kCommandCount; ++t) {
+        const TypeStats& st = m_stats[t];
+        if (st.sent == 0 && st.late == 0) continue;
+        double lossPct = st.sent ? 100.0 * st.lost / st.sent : 0.0;
+        qDebug() << ">>> [往返时延]" << commandName(t) << "| 发送" << st.sent << "(" << st.sent / std::max(window, 1e-3) << "条/秒 )"
+                 << "| 回显" << st.acked << "| 丢失" << st.lost << "(" << lossPct << "% )"
+                 << "| 迟到" << st.late << "| 拒绝" << st.rejected;
+        if (st.acked == 0) continue;
+        qDebug() << "    RTT ms: min" << st.minMs << "| 平均" << st.meanMs()
+                 << "| p50" << st.percentileMs(0.5) << "| p90" << st.percentileMs(0.9)
+                 << "| p99" << st.percentileMs(0.99) << "| max" << st.maxMs
+                 << "| 下位机处理均值" << st.sumProcMs / st.acked;
+        QString hist;
+        for (int i = 0; i < kBuckets; ++i) {
+            hist += i < kBuckets - 1 ? QString("<=%1:").arg(kBucketMs[i]) : QString(">%1:").arg(kBucketMs[kBuckets - 2]);
+            hist += QString::number((unsigned long long)st.hist[i]) + " ";
+        }
+        qDebug() << "    直方图" << hist;
+    }
+}
+
+void LatencyTracker::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& st : m_stats) st = TypeStats();
+    m_windowStart = Clock::now();
+}
@@ -0,0 +1,76 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "protocolcodec.h"
+
+// ==========================================
+// 指令往返时延追踪
+// 发送端给每条 v2 报文分配序号、记下发送时刻；下位机回 CMD_ECHO 时按序号配对，
+// 按指令类型统计往返时延直方图 (扣除下位机处理耗时前后各一份) 和丢失数。
+// 超过 lossTimeout 还没回显的记为丢失；回显来得太晚 (已判丢失或序号被复用) 记为迟到。
+// 用于调 keep-alive / QoS / 遥控频率时有数据可看，而不是凭感觉。
+// ==========================================
+class LatencyTracker
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // 直方图桶上界 (毫秒)，最后一桶为溢出
+    static const int kBuckets = 12;
+    static const double kBucketMs[kBuckets - 1];
+
+    struct TypeStats {
+        uint64_t sent = 0;
+        uint64_t acked = 0;
+        uint64_t lost = 0;
+        uint64_t late = 0;
+        uint64_t rejected = 0;     // 回显 status != 0
+        double sumMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+        double sumProcMs = 0.0;    // 下位机处理耗时合计
+        uint64_t hist[kBuckets] = {0};
+
+        double meanMs() const { return acked ? sumMs / acked : 0.0; }
+        // 按直方图估计分位数 (取所在桶上界)
+        double percentileMs(double p) const;
+    };
+
+    LatencyTracker();
+
+    void setLossTimeoutMs(double ms);
+
+    // 发送前调用：分配序号、记录发送时刻，填好 trace (带 FRAME_FLAG_ECHO)
+    void stamp(uint8_t type, proto::Trace& trace);
+    // 收到回显
+    void onEcho(const EchoPayload& echo);
+
+    TypeStats stats(uint8_t type);
+    void dumpStats();
+    void resetStats();
+
+private:
+    void expireLocked(Clock::time_point now);
+
+    struct Pending {
+        bool open = false;
+        uint8_t type = 0;
+        uint16_t seq = 0;
+        uint32_t sendUs = 0;
+        Clock::time_point sent;
+    };
+    // 按 seq 取模存放在途报文，50Hz 遥控 + 60fps 目标时约能覆盖 8 秒
+    static const int kWindow = 1024;
+
+    std::mutex m_mutex;
+    Pending m_pending[kWindow];
+    uint16_t m_nextSeq = 0;
+    double m_lossTimeoutMs = 1000.0;
+    TypeStats m_stats[proto::kCommandCount];
+    Clock::time_point m_windowStart;
+};
+
+#endif // LATENCYTRACKER_H
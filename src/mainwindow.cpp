@@ -4,8 +4,12 @@
 #include <QMessageBox>
 #include <QDir>
 #include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QSqlQuery>
 #include <QSqlError>
+#include "motionpredictor.h"
+#include "telemetrystore.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -24,6 +28,7 @@ MainWindow::MainWindow(QWidget *parent)
     // 2. 注册自定义类型 (用于跨线程信号槽)
     qRegisterMetaType<cv::Mat>("cv::Mat");
     qRegisterMetaType<std::vector<Detection>>("std::vector<Detection>");
+    qRegisterMetaType<FrameStamp>("FrameStamp");
     qRegisterMetaType<uint8_t>("uint8_t");
 
     // UI 初始状态
@@ -35,7 +40,13 @@ MainWindow::MainWindow(QWidget *parent)
     // ==========================================
     m_mqttClient = new MqttClientManager(this);
     connect(m_mqttClient, &MqttClientManager::connectionStatusChanged, this, &MainWindow::onMqttConnectionChanged);
-    connect(m_mqttClient, &MqttClientManager::dataReceived, this, &MainWindow::onMqttDataReceived);
+
+    // PLC 底盘不跑 MQTT：CAR_HMI_TRANSPORT=modbus 时连接按钮、运动、使能、瞄准点都改走 Modbus TCP
+    if (qgetenv("CAR_HMI_TRANSPORT") == "modbus") {
+        m_modbusClient = new ModbusClient(this);
+        connect(m_modbusClient, &ModbusClient::connectionStatusChanged, this, &MainWindow::onMqttConnectionChanged);
+        qDebug() << ">>> 控制通道: Modbus TCP (PLC 底盘)";
+    }
 
     // ==========================================
     // 4. 视觉推理模块初始化 (多线程 + NPU 加速版)
@@ -68,15 +79,41 @@ MainWindow::MainWindow(QWidget *parent)
     });
 
     // 接收推理数据：存数据库并控制下位机
-    connect(visionprocess, &Vision::sendDetections, this, [this](std::vector<Detection> dets){
+    connect(visionprocess, &Vision::sendDetections, this, [this](std::vector<Detection> dets, FrameStamp frame){
         for(const auto& det : dets){
+            // 跟踪器给同一棵苗分配固定 ID，只在第一次确认时记录，避免每帧重复写库
+            if (det.trackId >= 0 && !det.newTrack) continue;
+
             // 存入数据库日志
             this->saveDetectionRecord(QString::fromStdString(det.className), det.confidence, det.targetX, det.targetY);
 
-            // 如果成功计算出目标坐标(如草心)，下发给小车
-            if (connectionState && det.targetX > 0 && det.targetY > 0) {
-                // 如果需要 MQTT 自动下发坐标，可以在这里调用
-                // m_mqttClient->sendTarget(det.targetX, det.targetY);
+            // 同一条记录也写进断网暂存发件箱，连上 broker 后补发给上位平台，断网期间不丢
+            QJsonObject event;
+            event["ts"] = QDateTime::currentMSecsSinceEpoch();
+            event["class"] = QString::fromStdString(det.className);
+            event["conf"] = det.confidence;
+            event["x"] = det.targetX;
+            event["y"] = det.targetY;
+            event["cam"] = det.cameraId;
+            event["track"] = det.trackId;
+            event["frame"] = (qint64)det.frameSeq;
+            QByteArray json = QJsonDocument(event).toJson(QJsonDocument::Compact);
+            m_mqttClient->publishStored(OutboxClass::Detection, "car/log/detections", json.constData(), json.size());
+        }
+
+        // 这一帧的全部瞄准点 (如草心) 打成一条报文下发给小车，按帧率发、最新覆盖；
+        // 头里带整帧的运动补偿平移量，小车按 validInMs 对齐打击时机。
+        // 没有目标的帧也下发 count = 0 的空批次，下位机据此停止打上一批里已经移出画面的目标
+        if (connectionState) {
+            // 下位机按条目顺序打：dets 已在推理线程里按振镜跳转 / 驻留 / 离开打击带的时刻排好 (FireScheduler)
+            TargetBatchHeader head;
+            TargetEntry entries[TARGET_BATCH_MAX];
+            int count = MotionPredictor::instance().makeTargetBatch(dets, frame, head, entries, TARGET_BATCH_MAX);
+            if (m_modbusClient) {
+                // PLC 只有一组瞄准寄存器：取本帧第一个目标，补偿平移直接加上去 (寄存器表里没有"无目标"，空帧不写)
+                if (count > 0) m_modbusClient->setLaserTarget(entries[0].x + head.shiftX, entries[0].y + head.shiftY);
+            } else {
+                m_mqttClient->sendTargetBatch(head, entries, count);
             }
         }
     });
@@ -99,6 +136,11 @@ MainWindow::MainWindow(QWidget *parent)
         }
     });
     m_logRefreshTimer->start(1000);
+
+    // 下位机状态由 MQTT 回调线程写进 TelemetryStore，这里按界面刷新率拉取，报文再密也不会堵事件循环
+    m_telemetryTimer = new QTimer(this);
+    connect(m_telemetryTimer, &QTimer::timeout, this, &MainWindow::refreshTelemetry);
+    m_telemetryTimer->start(100);
 }
 
 MainWindow::~MainWindow()
@@ -109,6 +151,9 @@ MainWindow::~MainWindow()
     if (m_mqttClient) {
         m_mqttClient->disconnectFromBroker();
     }
+    if (m_modbusClient) {
+        m_modbusClient->disconnectFromServer();
+    }
 
     // 2. 打破视觉线程的死循环
     if (visionprocess) {
@@ -346,9 +391,11 @@ void MainWindow::on_pushButton_connect_clicked()
     if(!connectionState){
         QString Car_IP = ui->lineEdit_IP->text();
         int Car_Port = ui->lineEdit_port->text().toInt();
-        m_mqttClient->connectToBroker(Car_IP, Car_Port);
+        if (m_modbusClient) m_modbusClient->connectToServer(Car_IP, Car_Port);
+        else m_mqttClient->connectToBroker(Car_IP, Car_Port);
     }else{
-        m_mqttClient->disconnectFromBroker();
+        if (m_modbusClient) m_modbusClient->disconnectFromServer();
+        else m_mqttClient->disconnectFromBroker();
     }
 }
 
@@ -367,20 +414,39 @@ void MainWindow::onMqttConnectionChanged(bool isConnected, const QString &messag
     ui->pushButton_connect->setEnabled(true);
 }
 
-void MainWindow::onMqttDataReceived(uint8_t type, const QByteArray &payload)
+void MainWindow::refreshTelemetry()
 {
-    if (type == CMD_CONTROL && payload.size() == sizeof(ControlPayload)) {
-        ControlPayload* status = (ControlPayload*)payload.data();
+    TelemetryStore& store = TelemetryStore::instance();
+    if (store.controlVersion() == m_controlVersion) return;
+
+    // 长度、包头、字节序已在 MqttClientManager 里按协议校验过
+    Telemetry<ControlPayload> snapshot = store.control();
+    m_controlVersion = snapshot.version;
+    const ControlPayload& status = snapshot.value;
+    if (m_haveControl && status.mode == m_lastControl.mode && status.led_switch == m_lastControl.led_switch &&
+        status.buzzer_switch == m_lastControl.buzzer_switch) {
+        return;
+    }
+    m_lastControl = status;
+    m_haveControl = true;
 
-        QTableWidgetItem *modeCell = ui->tableWidget_monitor->item(0, 3);
-        if(modeCell) modeCell->setText(status->mode == 1 ? "自动模式" : "手动模式");
+    QTableWidgetItem *modeCell = ui->tableWidget_monitor->item(0, 3);
+    if(modeCell) modeCell->setText(status.mode == 1 ? "自动模式" : "手动模式");
 
-        QTableWidgetItem *laserCell = ui->tableWidget_monitor->item(1, 3);
-        if(laserCell) {
-            laserCell->setText(status->led_switch ? "ON" : "OFF");
-            laserCell->setForeground(status->led_switch ? Qt::green : Qt::gray);
-        }
+    QTableWidgetItem *laserCell = ui->tableWidget_monitor->item(1, 3);
+    if(laserCell) {
+        laserCell->setText(status.led_switch ? "ON" : "OFF");
+        laserCell->setForeground(status.led_switch ? Qt::green : Qt::gray);
     }
+
+    // 状态变化记一条遥测，走发件箱补发
+    QJsonObject event;
+    event["ts"] = QDateTime::currentMSecsSinceEpoch();
+    event["mode"] = (int)status.mode;
+    event["led"] = (int)status.led_switch;
+    event["buzzer"] = (int)status.buzzer_switch;
+    QByteArray json = QJsonDocument(event).toJson(QJsonDocument::Compact);
+    m_mqttClient->publishStored(OutboxClass::Telemetry, "car/log/telemetry", json.constData(), json.size());
 }
 
 // ==========================================
@@ -406,12 +472,22 @@ void MainWindow::on_pushButton_enable_clicked()
     if (enableState) {
         ui->pushButton_enable->setText("Power Off");
         ui->pushButton_enable->setStyleSheet("background-color: green; color: white;");
-        m_mqttClient->sendControl(true, false, 1);
+        if (m_modbusClient) {
+            m_modbusClient->writeCoil(Addr_PowerEnable, true);
+            m_modbusClient->writeCoil(Addr_LaserSwitch, true);
+        } else {
+            m_mqttClient->sendControl(true, false, 1);
+        }
         qDebug() << ">>> 下发指令：系统已使能，激光开";
     } else {
         ui->pushButton_enable->setText("Power On");
         ui->pushButton_enable->setStyleSheet("background-color: red; color: white;");
-        m_mqttClient->sendControl(false, false, 0);
+        if (m_modbusClient) {
+            m_modbusClient->writeCoil(Addr_LaserSwitch, false);
+            m_modbusClient->writeCoil(Addr_PowerEnable, false);
+        } else {
+            m_mqttClient->sendControl(false, false, 0);
+        }
         qDebug() << ">>> 下发指令：系统已关闭，激光关";
     }
 }
@@ -428,7 +504,7 @@ void MainWindow::on_pushButton_front_pressed()
 {
     if (!connectionState) return;
     float current_speed = ui->verticalSlider->value() * 2.0f;
-    m_mqttClient->sendMove(current_speed, 0, 0);
+    commandMove(current_speed, 0, 0);
     qDebug() << ">>> 前进，速度 =" << current_speed;
 }
 
@@ -436,7 +512,7 @@ void MainWindow::on_pushButton_back_pressed()
 {
     if (!connectionState) return;
     float current_speed = ui->verticalSlider->value() * 2.0f;
-    m_mqttClient->sendMove(-current_speed, 0, 0);
+    commandMove(-current_speed, 0, 0);
     qDebug() << ">>> 后退，速度 =" << -current_speed;
 }
 
@@ -444,7 +520,7 @@ void MainWindow::on_pushButton_left_pressed()
 {
     if (!connectionState) return;
     float current_speed = ui->verticalSlider->value() * 2.0f;
-    m_mqttClient->sendMove(0, -current_speed, 0);
+    commandMove(0, -current_speed, 0);
     qDebug() << ">>> 左移，速度 =" << -current_speed;
 }
 
@@ -452,15 +528,24 @@ void MainWindow::on_pushButton_right_pressed()
 {
     if (!connectionState) return;
     float current_speed = ui->verticalSlider->value() * 2.0f;
-    m_mqttClient->sendMove(0, current_speed, 0);
+    commandMove(0, current_speed, 0);
     qDebug() << ">>> 右移，速度 =" << current_speed;
 }
 
+// 更新移动指令，同时告诉运动补偿模块底盘接下来的速度
+// 只写 MqttClientManager 的最新值槽位，真正的网络发送在遥控发布线程里，UI 线程不再碰 publish
+void MainWindow::commandMove(float vx, float vy, float vz)
+{
+    MotionPredictor::instance().onCommandedMove(vx, vy);
+    if (m_modbusClient) m_modbusClient->setMove(vx, vy);
+    else m_mqttClient->setMoveCommand(vx, vy, vz);
+}
+
 // 松开任意按钮，立即刹车 (下发全 0 速度)
-void MainWindow::on_pushButton_front_released() { if(connectionState) m_mqttClient->sendMove(0, 0, 0); }
-void MainWindow::on_pushButton_back_released()  { if(connectionState) m_mqttClient->sendMove(0, 0, 0); }
-void MainWindow::on_pushButton_left_released()  { if(connectionState) m_mqttClient->sendMove(0, 0, 0); }
-void MainWindow::on_pushButton_right_released() { if(connectionState) m_mqttClient->sendMove(0, 0, 0); }
+void MainWindow::on_pushButton_front_released() { if(connectionState) commandMove(0, 0, 0); }
+void MainWindow::on_pushButton_back_released()  { if(connectionState) commandMove(0, 0, 0); }
+void MainWindow::on_pushButton_left_released()  { if(connectionState) commandMove(0, 0, 0); }
+void MainWindow::on_pushButton_right_released() { if(connectionState) commandMove(0, 0, 0); }
 
 // ==========================================
 // 防链接器报错的“占位符”槽函数
@@ -17,6 +17,7 @@
 
 // 👉 [修改 1] 把 tcp 的头文件换成 mqtt 的头文件
 #include "mqttclientmanager.h"
+#include "modbusclient.h"
 #include "vision.h"
 #include "protocol_def.h"
 
@@ -60,7 +61,6 @@ private slots:
 
     // 👉 [修改 2] 网络与数据处理：名字改成 MQTT
     void onMqttConnectionChanged(bool isConnected, const QString &message);
-    void onMqttDataReceived(uint8_t type, const QByteArray &payload); 
     void on_pushButton_enable_clicked();
 
     // 视觉控制
@@ -74,12 +74,16 @@ private:
     void initModel();
     void initDataBase();
     void saveDetectionRecord(const QString &className, double confidence, int x = -1, int y = -1);
+    void commandMove(float vx, float vy, float vz);
+    void refreshTelemetry();
 
 private:
     Ui::MainWindow *ui;
 
     // 👉 [修改 4] 核心模块：从 TcpClientManager 改为 MqttClientManager
     MqttClientManager *m_mqttClient;
+    // PLC 底盘 (CAR_HMI_TRANSPORT=modbus) 时控制指令改走 Modbus TCP，MQTT 只剩日志 / 遥测上报
+    ModbusClient *m_modbusClient = nullptr;
     Vision *visionprocess;
     QThread* m_visionThread;
 
@@ -97,6 +101,12 @@ private:
     QSqlTableModel *m_logModel;
     // mainwindow.h 里加
     QTimer* m_logRefreshTimer;
+    // 轮询 TelemetryStore 刷新状态表格，版本号没变就不动 UI
+    QTimer* m_telemetryTimer;
+    uint32_t m_controlVersion = 0;
+    // 上一次记遥测时的状态：下位机每条状态报文都会让版本号 +1，只有内容变了才记
+    ControlPayload m_lastControl = {};
+    bool m_haveControl = false;
 
     // 日志数据包
     struct DetectionLog {
@@ -0,0 +1,349 @@
+#include "mediagraph.h"
+#include <QDebug>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/media.h>
+#include <linux/v4l2-subdev.h>
+
+// 由设备号反查 /dev 节点：/sys/dev/char/MAJ:MIN/uevent 里的 DEVNAME
+std::string MediaGraph::resolveDevnode(uint32_t major, uint32_t minor)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/dev/char/%u:%u/uevent", major, minor);
+    std::ifstream uevent(path);
+    std::string line;
+    while (std::getline(uevent, line)) {
+        if (line.compare(0, 8, "DEVNAME=") == 0) {
+            return "/dev/" + line.substr(8);
+        }
+    }
+    return "";
+}
+
+bool MediaGraph::open(const std::string& mediaDevice)
+{
+    int fd = ::open(mediaDevice.c_str(), O_RDWR);
+    if (fd < 0) return false;
+
+    // G_TOPOLOGY 要调两次：第一次拿数量，第二次带上缓冲区拿内容
+    // 两次之间拓扑版本变了 (热插拔) 就重来
+    std::vector<media_v2_entity> ents;
+    std::vector<media_v2_interface> intfs;
+    std::vector<media_v2_pad> pads;
+    std::vector<media_v2_link> links;
+    bool ok = false;
+    for (int attempt = 0; attempt < 3 && !ok; ++attempt) {
+        media_v2_topology topo;
+        memset(&topo, 0, sizeof(topo));
+        if (ioctl(fd, MEDIA_IOC_G_TOPOLOGY, &topo) < 0) break;
+        uint64_t version = topo.topology_version;
+
+        ents.resize(topo.num_entities);
+        intfs.resize(topo.num_interfaces);
+        pads.resize(topo.num_pads);
+        links.resize(topo.num_links);
+        topo.ptr_entities = (uintptr_t)ents.data();
+        topo.ptr_interfaces = (uintptr_t)intfs.data();
+        topo.ptr_pads = (uintptr_t)pads.data();
+        topo.ptr_links = (uintptr_t)links.data();
+        if (ioctl(fd, MEDIA_IOC_G_TOPOLOGY, &topo) < 0) break;
+        ok = (topo.topology_version == version);
+    }
+    ::close(fd);
+    if (!ok) {
+        qDebug() << "【警告】读取 media 拓扑失败:" << mediaDevice.c_str() << strerror(errno);
+        return false;
+    }
+
+    m_device = mediaDevice;
+    m_entities.clear();
+    m_pads.clear();
+    m_links.clear();
+
+    for (const auto& e : ents) {
+        MediaEntity ent;
+        ent.id = e.id;
+        ent.function = e.function;
+        ent.name = e.name;
+        m_entities.push_back(ent);
+    }
+
+    std::map<uint32_t, std::string> intfNodes;
+    for (const auto& i : intfs) {
+        intfNodes[i.id] = resolveDevnode(i.devnode.major, i.devnode.minor);
+    }
+
+    for (const auto& p : pads) {
+        MediaPad pad;
+        pad.id = p.id;
+        pad.entityId = p.entity_id;
+        pad.index = p.index;
+        pad.flags = p.flags;
+        m_pads.push_back(pad);
+    }
+
+    for (const auto& l : links) {
+        // 接口链接：接口 -> 实体，用来给实体挂上 /dev 节点
+        if ((l.flags & MEDIA_LNK_FL_LINK_TYPE) == MEDIA_LNK_FL_INTERFACE_LINK) {
+            for (auto& ent : m_entities) {
+                if (ent.id == l.sink_id) ent.devnode = intfNodes[l.source_id];
+            }
+            continue;
+        }
+        MediaLink link;
+        link.id = l.id;
+        link.sourceId = l.source_id;
+        link.sinkId = l.sink_id;
+        link.flags = l.flags;
+        m_links.push_back(link);
+    }
+    return true;
+}
+
+// 导出格式 (一行一条，名字放最后因为可能带空格)：
+//   device /dev/media0
+//   entity <id> <function> <devnode|-> <name>
+//   pad <id> <entity_id> <index> <flags>
+//   link <id> <source_id> <sink_id> <flags>
+bool MediaGraph::saveDump(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "# car_hmi media topology dump\n";
+    out << "device " << m_device << "\n";
+    for (const auto& e : m_entities) {
+        out << "entity " << e.id << " " << e.function << " "
+            << (e.devnode.empty() ? "-" : e.devnode) << " " << e.name << "\n";
+    }
+    for (const auto& p : m_pads) {
+        out << "pad " << p.id << " " << p.entityId << " " << p.index << " " << p.flags << "\n";
+    }
+    for (const auto& l : m_links) {
+        out << "link " << l.id << " " << l.sourceId << " " << l.sinkId << " " << l.flags << "\n";
+    }
+    return out.good();
+}
+
+bool MediaGraph::loadDump(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+
+    m_device.clear();
+    m_entities.clear();
+    m_pads.clear();
+    m_links.clear();
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        std::string kind;
+        ss >> kind;
+        if (kind == "device") {
+            ss >> m_device;
+        } else if (kind == "entity") {
+            MediaEntity e;
+            ss >> e.id >> e.function >> e.devnode;
+            if (e.devnode == "-") e.devnode.clear();
+            std::getline(ss >> std::ws, e.name);
+            m_entities.push_back(e);
+        } else if (kind == "pad") {
+            MediaPad p;
+            ss >> p.id >> p.entityId >> p.index >> p.flags;
+            m_pads.push_back(p);
+        } else if (kind == "link") {
+            MediaLink l;
+            ss >> l.id >> l.sourceId >> l.sinkId >> l.flags;
+            m_links.push_back(l);
+        } else {
+            qDebug() << "【警告】无法识别的拓扑导出行:" << line.c_str();
+            return false;
+        }
+    }
+    return !m_entities.empty();
+}
+
+MediaGraph* MediaGraph::findCached(const std::string& entityName)
+{
+    static std::mutex cacheMutex;
+    static std::vector<std::unique_ptr<MediaGraph>> cache;
+    static bool scanned = false;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!scanned) {
+        scanned = true;
+        const char* dump = getenv("CAR_HMI_MEDIA_DUMP");
+        if (dump && *dump) {
+            std::unique_ptr<MediaGraph> graph(new MediaGraph);
+            if (graph->loadDump(dump)) {
+                qDebug() << ">>> 从导出文件加载 media 拓扑:" << dump;
+                cache.push_back(std::move(graph));
+            }
+        } else {
+            // 设置 CAR_HMI_MEDIA_DUMP_SAVE 时顺手把读到的拓扑录下来，给离线调试用
+            const char* savePrefix = getenv("CAR_HMI_MEDIA_DUMP_SAVE");
+            for (int i = 0; i < 16; ++i) {
+                std::unique_ptr<MediaGraph> graph(new MediaGraph);
+                if (graph->open("/dev/media" + std::to_string(i))) {
+                    if (savePrefix && *savePrefix) {
+                        graph->saveDump(std::string(savePrefix) + std::to_string(i) + ".txt");
+                    }
+                    cache.push_back(std::move(graph));
+                }
+            }
+        }
+    }
+
+    for (auto& graph : cache) {
+        if (graph->findEntity(entityName)) return graph.get();
+    }
+    return nullptr;
+}
+
+const MediaEntity* MediaGraph::findEntity(const std::string& name) const
+{
+    for (const auto& e : m_entities) {
+        if (e.name.find(name) != std::string::npos) return &e;
+    }
+    return nullptr;
+}
+
+const MediaEntity* MediaGraph::findEntityByFunction(uint32_t function) const
+{
+    for (const auto& e : m_entities) {
+        if (e.function == function) return &e;
+    }
+    return nullptr;
+}
+
+std::string MediaGraph::videoNode(const std::string& name) const
+{
+    const MediaEntity* e = findEntity(name);
+    return e ? e->devnode : std::string();
+}
+
+std::vector<SensorMode> MediaGraph::enumSensorModes(const MediaEntity& sensor, uint32_t pad) const
+{
+    std::vector<SensorMode> modes;
+    int fd = ::open(sensor.devnode.c_str(), O_RDWR);
+    if (fd < 0) return modes;
+
+    for (uint32_t ci = 0;; ++ci) {
+        v4l2_subdev_mbus_code_enum code;
+        memset(&code, 0, sizeof(code));
+        code.pad = pad;
+        code.index = ci;
+        code.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+        if (ioctl(fd, VIDIOC_SUBDEV_ENUM_MBUS_CODE, &code) < 0) break;
+
+        for (uint32_t si = 0;; ++si) {
+            v4l2_subdev_frame_size_enum size;
+            memset(&size, 0, sizeof(size));
+            size.pad = pad;
+            size.index = si;
+            size.code = code.code;
+            size.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+            if (ioctl(fd, VIDIOC_SUBDEV_ENUM_FRAME_SIZE, &size) < 0) break;
+
+            size_t before = modes.size();
+            for (uint32_t ii = 0;; ++ii) {
+                v4l2_subdev_frame_interval_enum fie;
+                memset(&fie, 0, sizeof(fie));
+                fie.pad = pad;
+                fie.index = ii;
+                fie.code = code.code;
+                fie.width = size.max_width;
+                fie.height = size.max_height;
+                fie.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+                if (ioctl(fd, VIDIOC_SUBDEV_ENUM_FRAME_INTERVAL, &fie) < 0) break;
+
+                SensorMode m;
+                m.code = code.code;
+                m.width = size.max_width;
+                m.height = size.max_height;
+                m.intervalNum = fie.interval.numerator;
+                m.intervalDen = fie.interval.denominator;
+                modes.push_back(m);
+            }
+            // 驱动不支持枚举帧间隔时，至少把分辨率记下来 (帧率未知)
+            if (modes.size() == before) {
+                SensorMode m;
+                m.code = code.code;
+                m.width = size.max_width;
+                m.height = size.max_height;
+                m.intervalNum = 0;
+                m.intervalDen = 0;
+                modes.push_back(m);
+            }
+        }
+    }
+    ::close(fd);
+    return modes;
+}
+
+bool MediaGraph::pickSensorMode(const MediaEntity& sensor, double minFps, SensorMode& mode) const
+{
+    bool found = false;
+    for (const auto& m : enumSensorModes(sensor)) {
+        if (m.fps() + 1e-3 < minFps) continue;
+        long area = (long)m.width * m.height;
+        long bestArea = (long)mode.width * mode.height;
+        if (!found || area > bestArea || (area == bestArea && m.fps() < mode.fps())) {
+            mode = m;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool MediaGraph::applySensorMode(const MediaEntity& sensor, const SensorMode& mode, uint32_t pad) const
+{
+    int fd = ::open(sensor.devnode.c_str(), O_RDWR);
+    if (fd < 0) {
+        qDebug() << "【致命错误】打开 Sensor 子设备失败:" << sensor.devnode.c_str();
+        return false;
+    }
+
+    v4l2_subdev_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+    fmt.pad = pad;
+    fmt.format.width = mode.width;
+    fmt.format.height = mode.height;
+    fmt.format.code = mode.code;
+    fmt.format.field = V4L2_FIELD_NONE;
+    if (ioctl(fd, VIDIOC_SUBDEV_S_FMT, &fmt) < 0) {
+        qDebug() << "【致命错误】VIDIOC_SUBDEV_S_FMT 失败:" << strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if ((int)fmt.format.width != mode.width || (int)fmt.format.height != mode.height || fmt.format.code != mode.code) {
+        qDebug() << "【警告】Sensor 调整了格式:" << fmt.format.width << "x" << fmt.format.height
+                 << "code:" << fmt.format.code;
+    }
+
+    bool ok = true;
+    if (mode.intervalNum > 0 && mode.intervalDen > 0) {
+        v4l2_subdev_frame_interval fi;
+        memset(&fi, 0, sizeof(fi));
+        fi.pad = pad;
+        fi.interval.numerator = mode.intervalNum;
+        fi.interval.denominator = mode.intervalDen;
+        if (ioctl(fd, VIDIOC_SUBDEV_S_FRAME_INTERVAL, &fi) < 0) {
+            qDebug() << "【警告】VIDIOC_SUBDEV_S_FRAME_INTERVAL 失败:" << strerror(errno);
+            ok = false;
+        }
+    }
+    ::close(fd);
+    return ok;
+}
@@ -0,0 +1,87 @@
+#ifndef MEDIAGRAPH_H
+#define MEDIAGRAPH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ==========================================
+// 原生 Media Controller 拓扑 (取代 system("media-ctl ...") 和 sysfs 扫描)
+// 通过 MEDIA_IOC_G_TOPOLOGY 一次性拿到实体/端口/链接，解析出每个实体对应的 /dev 节点，
+// 再用 VIDIOC_SUBDEV_S_FMT / S_FRAME_INTERVAL 直接配置 Sensor，不再 fork shell
+// 拓扑可以导出成文本，离线时从导出文件加载，方便在没有板子的机器上调试
+// ==========================================
+
+struct MediaPad {
+    uint32_t id = 0;
+    uint32_t entityId = 0;
+    uint32_t index = 0;
+    uint32_t flags = 0;
+};
+
+struct MediaLink {
+    uint32_t id = 0;
+    uint32_t sourceId = 0;
+    uint32_t sinkId = 0;
+    uint32_t flags = 0;
+};
+
+struct MediaEntity {
+    uint32_t id = 0;
+    uint32_t function = 0;   // MEDIA_ENT_F_*
+    std::string name;        // 例如 "m00_b_imx415 7-001a"、"rkisp_mainpath"
+    std::string devnode;     // /dev/videoX 或 /dev/v4l-subdevX，没有则为空
+};
+
+// Sensor 工作模式：总线格式 + 分辨率 + 帧间隔
+struct SensorMode {
+    uint32_t code = 0;       // MEDIA_BUS_FMT_*
+    int width = 0;
+    int height = 0;
+    uint32_t intervalNum = 1;
+    uint32_t intervalDen = 30;
+
+    double fps() const { return intervalNum ? (double)intervalDen / intervalNum : 0.0; }
+};
+
+class MediaGraph
+{
+public:
+    // 从 /dev/mediaN 读取拓扑
+    bool open(const std::string& mediaDevice);
+    // 从 saveDump() 导出的文本加载 (离线调试 / 回归用)
+    bool loadDump(const std::string& path);
+    bool saveDump(const std::string& path) const;
+
+    // 进程内缓存：在 /dev/media0~15 里找到包含该实体的拓扑，只解析一次
+    // 设置 CAR_HMI_MEDIA_DUMP 时改为从导出文件加载；设置 CAR_HMI_MEDIA_DUMP_SAVE=<前缀> 时把读到的拓扑导出
+    static MediaGraph* findCached(const std::string& entityName);
+
+    const std::string& device() const { return m_device; }
+    const std::vector<MediaEntity>& entities() const { return m_entities; }
+    const std::vector<MediaPad>& pads() const { return m_pads; }
+    const std::vector<MediaLink>& links() const { return m_links; }
+
+    // 名字包含 name 的第一个实体
+    const MediaEntity* findEntity(const std::string& name) const;
+    const MediaEntity* findEntityByFunction(uint32_t function) const;
+    // 实体对应的设备节点，例如 videoNode("rkisp_mainpath") -> "/dev/video11"
+    std::string videoNode(const std::string& name) const;
+
+    // 枚举 Sensor 支持的全部 格式 x 分辨率 x 帧间隔 组合
+    std::vector<SensorMode> enumSensorModes(const MediaEntity& sensor, uint32_t pad = 0) const;
+    // 在支持的模式里挑一个：帧率不低于 minFps 的最高分辨率，同分辨率下帧率最接近 minFps
+    bool pickSensorMode(const MediaEntity& sensor, double minFps, SensorMode& mode) const;
+    // 设置 Sensor 输出格式和帧率 (等价于 media-ctl --set-v4l2 '"sensor":0[fmt:.../WxH@num/den]')
+    bool applySensorMode(const MediaEntity& sensor, const SensorMode& mode, uint32_t pad = 0) const;
+
+private:
+    static std::string resolveDevnode(uint32_t major, uint32_t minor);
+
+    std::string m_device;
+    std::vector<MediaEntity> m_entities;
+    std::vector<MediaPad> m_pads;
+    std::vector<MediaLink> m_links;
+};
+
+#endif // MEDIAGRAPH_H
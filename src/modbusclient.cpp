@@ -0,0 +1,607 @@
+#include "modbusclient.h"
+#include <QDebug>
+#include "motionpredictor.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+typedef std::chrono::steady_clock Clock;
+
+namespace modbus {
+
+int frameLength(const uint8_t* data, size_t len)
+{
+    if (len < MBAP_SIZE) return 0;
+    if (getU16(data + 2) != 0) return -1;
+    uint16_t follow = getU16(data + 4);   // 单元号 + PDU
+    if (follow < 2 || follow > MAX_PDU + 1) return -1;
+    size_t total = 6 + (size_t)follow;
+    return len < total ? 0 : (int)total;
+}
+
+} // namespace modbus
+
+using namespace modbus;
+
+ModbusClient::ModbusClient(QObject *parent) : QObject{parent} {
+    const char* pollMs = getenv("CAR_HMI_MODBUS_POLL_MS");
+    if (pollMs && atoi(pollMs) >= 0) m_pollMs = atoi(pollMs);
+    const char* timeoutMs = getenv("CAR_HMI_MODBUS_TIMEOUT_MS");
+    if (timeoutMs && atoi(timeoutMs) > 0) m_timeoutMs = atoi(timeoutMs);
+    const char* pipeline = getenv("CAR_HMI_MODBUS_PIPELINE");
+    if (pipeline && atoi(pipeline) > 0) m_pipeline = std::min(64, atoi(pipeline));
+
+    if (pipe(m_wakePipe) == 0) {
+        fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(m_wakePipe[1], F_SETFL, O_NONBLOCK);
+    }
+    m_nextPoll = Clock::now();
+    m_running = true;
+    m_ioThread = std::thread(&ModbusClient::ioLoop, this);
+}
+
+ModbusClient::~ModbusClient() {
+    m_running = false;
+    wake();
+    if (m_ioThread.joinable()) m_ioThread.join();
+    if (m_fd >= 0) ::close(m_fd);
+    for (int fd : m_wakePipe) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+void ModbusClient::connectToServer(const QString &ip, int port, int unitId){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_host = ip.toStdString();
+        m_port = port;
+        m_unit = (uint8_t)unitId;
+        m_wantConnected = true;
+        m_reconnect = true;
+    }
+    qDebug() << ">>> 正在连接 Modbus TCP 底盘:" << ip << ":" << port << "单元号" << unitId;
+    wake();
+}
+
+void ModbusClient::disconnectFromServer(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wantConnected = false;
+        // 断开前没发出去的运动 / 瞄准指令一律作废，重连后从停车状态开始
+        m_moveCoils = 0;
+        m_moveSpeed = 0;
+        m_moveCoilsPending = m_moveSpeedPending = false;
+        m_targetPending = false;
+        m_queue.clear();
+    }
+    wake();
+}
+
+void ModbusClient::wake(){
+    if (m_wakePipe[1] < 0) return;
+    uint8_t b = 1;
+    ssize_t n = ::write(m_wakePipe[1], &b, 1);
+    (void)n;
+}
+
+void ModbusClient::enqueue(Request&& req){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(req));
+    }
+    wake();
+}
+
+void ModbusClient::setMove(float vx, float vy){
+    uint8_t coils = 0;
+    if (vx > 0) coils |= 0x01;
+    if (vx < 0) coils |= 0x02;
+    if (vy < 0) coils |= 0x04;
+    if (vy > 0) coils |= 0x08;
+    float magnitude = std::max(std::abs(vx), std::abs(vy));
+    uint16_t speed = (uint16_t)std::min(65535.f, std::round(magnitude));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_moveCoilsPending || m_moveSpeedPending) m_stats.moveCoalesced++;
+        if (coils != m_moveCoils) m_moveCoilsPending = true;
+        if (speed != m_moveSpeed) m_moveSpeedPending = true;
+        m_moveCoils = coils;
+        m_moveSpeed = speed;
+    }
+    wake();
+}
+
+void ModbusClient::setLaserTarget(int x, int y){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_targetPending) m_stats.targetCoalesced++;
+        m_targetX = (uint16_t)std::max(0, std::min(65535, x));
+        m_targetY = (uint16_t)std::max(0, std::min(65535, y));
+        m_targetPending = true;
+    }
+    wake();
+}
+
+void ModbusClient::writeCoil(uint16_t addr, bool on, Callback cb){
+    Request req;
+    req.pdu[0] = FC_WRITE_SINGLE_COIL;
+    putU16(req.pdu + 1, addr);
+    putU16(req.pdu + 3, on ? 0xFF00 : 0x0000);
+    req.len = 5;
+    req.cb = std::move(cb);
+    enqueue(std::move(req));
+}
+
+void ModbusClient::writeRegister(uint16_t addr, uint16_t value, Callback cb){
+    Request req;
+    req.pdu[0] = FC_WRITE_SINGLE_REGISTER;
+    putU16(req.pdu + 1, addr);
+    putU16(req.pdu + 3, value);
+    req.len = 5;
+    req.cb = std::move(cb);
+    enqueue(std::move(req));
+}
+
+void ModbusClient::writeRegisters(uint16_t addr, const uint16_t* values, int count, Callback cb){
+    if (count < 1 || count > MAX_WRITE_REGISTERS) {
+        qDebug() << "【警告】Modbus 写多个寄存器个数非法:" << count;
+        return;
+    }
+    Request req;
+    req.pdu[0] = FC_WRITE_MULTIPLE_REGISTERS;
+    putU16(req.pdu + 1, addr);
+    putU16(req.pdu + 3, (uint16_t)count);
+    req.pdu[5] = (uint8_t)(count * 2);
+    for (int i = 0; i < count; ++i) putU16(req.pdu + 6 + i * 2, values[i]);
+    req.len = 6 + count * 2;
+    req.cb = std::move(cb);
+    enqueue(std::move(req));
+}
+
+void ModbusClient::readHoldingRegisters(uint16_t addr, int count, Callback cb){
+    if (count < 1 || count > MAX_READ_REGISTERS) {
+        qDebug() << "【警告】Modbus 读寄存器个数非法:" << count;
+        return;
+    }
+    Request req;
+    req.pdu[0] = FC_READ_HOLDING_REGISTERS;
+    putU16(req.pdu + 1, addr);
+    putU16(req.pdu + 3, (uint16_t)count);
+    req.len = 5;
+    req.cb = std::move(cb);
+    enqueue(std::move(req));
+}
+
+void ModbusClient::readCoils(uint16_t addr, int count, Callback cb){
+    // 结果数组按寄存器上限开的，线圈一次最多读这么多
+    if (count < 1 || count > MAX_READ_REGISTERS) {
+        qDebug() << "【警告】Modbus 读线圈个数非法:" << count;
+        return;
+    }
+    Request req;
+    req.pdu[0] = FC_READ_COILS;
+    putU16(req.pdu + 1, addr);
+    putU16(req.pdu + 3, (uint16_t)count);
+    req.len = 5;
+    req.cb = std::move(cb);
+    enqueue(std::move(req));
+}
+
+void ModbusClient::setPollIntervalMs(int ms){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pollMs = std::max(0, ms);
+        m_nextPoll = Clock::now();
+    }
+    wake();
+}
+
+bool ModbusClient::nextRequestLocked(Request& req, Clock::time_point now){
+    if (!m_queue.empty()) {
+        req = std::move(m_queue.front());
+        m_queue.pop_front();
+        return true;
+    }
+    // 停车时先把速度清零再改方向，起步时先给方向再给速度
+    bool speedFirst = m_moveSpeedPending && m_moveSpeed == 0;
+    if (m_moveCoilsPending && !speedFirst) {
+        req.pdu[0] = FC_WRITE_MULTIPLE_COILS;
+        putU16(req.pdu + 1, Addr_DirectionForward);
+        putU16(req.pdu + 3, 4);
+        req.pdu[5] = 1;
+        req.pdu[6] = m_moveCoils;
+        req.len = 7;
+        req.kind = Request::Move;
+        m_moveCoilsPending = false;
+        m_stats.moveWrites++;
+        return true;
+    }
+    if (m_moveSpeedPending) {
+        req.pdu[0] = FC_WRITE_SINGLE_REGISTER;
+        putU16(req.pdu + 1, Reg_SpeedSet);
+        putU16(req.pdu + 3, m_moveSpeed);
+        req.len = 5;
+        req.kind = Request::Move;
+        m_moveSpeedPending = false;
+        m_stats.moveWrites++;
+        return true;
+    }
+    if (m_targetPending) {
+        // X、Y 相邻，一条 FC16 写完，PLC 不会读到一半新一半旧的坐标
+        req.pdu[0] = FC_WRITE_MULTIPLE_REGISTERS;
+        putU16(req.pdu + 1, Reg_LaserTargetX);
+        putU16(req.pdu + 3, 2);
+        req.pdu[5] = 4;
+        putU16(req.pdu + 6, m_targetX);
+        putU16(req.pdu + 8, m_targetY);
+        req.len = 10;
+        req.kind = Request::Target;
+        m_targetPending = false;
+        m_stats.targetWrites++;
+        return true;
+    }
+    if (m_pollMs > 0 && !m_pollInFlight && now >= m_nextPoll) {
+        req.pdu[0] = FC_READ_HOLDING_REGISTERS;
+        putU16(req.pdu + 1, Reg_CurrentSpeed);
+        putU16(req.pdu + 3, 1);
+        req.len = 5;
+        req.kind = Request::Poll;
+        m_pollInFlight = true;
+        m_nextPoll += std::chrono::milliseconds(m_pollMs);
+        // 线程被耽搁了好几个周期时不补读，直接对齐到下一个周期
+        if (m_nextPoll <= now) m_nextPoll = now + std::chrono::milliseconds(m_pollMs);
+        return true;
+    }
+    return false;
+}
+
+bool ModbusClient::openSocket(){
+    std::string host;
+    int port;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        host = m_host;
+        port = m_port;
+    }
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        qDebug() << "【警告】Modbus 地址非法:" << QString::fromStdString(host);
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int rc = ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+    if (rc != 0 && errno == EINPROGRESS) {
+        pollfd pfd = {fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t errLen = sizeof(err);
+        if (poll(&pfd, 1, std::max(1000, m_timeoutMs * 2)) == 1 &&
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 && err == 0) {
+            rc = 0;
+        }
+    }
+    if (rc != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_nextTid = 1;
+    m_consecutiveTimeouts = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 新连接上先把当前运动状态写一遍 (PLC 可能刚重启)，轮询立即开始
+        m_moveCoilsPending = m_moveSpeedPending = true;
+        m_pollInFlight = false;
+        m_nextPoll = Clock::now();
+        m_stats.reconnects++;
+    }
+    m_connected = true;
+    QString msg = QString("Modbus 已连接 %1:%2").arg(QString::fromStdString(host)).arg(port);
+    qDebug() << ">>>" << msg;
+    emit connectionStatusChanged(true, msg);
+    return true;
+}
+
+void ModbusClient::closeSocket(const char* reason){
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_tx.clear();
+    m_rx.clear();
+    failInFlight(false, Clock::now());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pollInFlight = false;
+    }
+    if (m_connected.exchange(false)) {
+        qDebug() << ">>> Modbus 连接断开:" << reason;
+        emit connectionStatusChanged(false, QString::fromUtf8(reason));
+    }
+}
+
+void ModbusClient::failInFlight(bool timeoutOnly, Clock::time_point now){
+    const auto timeout = std::chrono::milliseconds(m_timeoutMs);
+    for (size_t i = 0; i < m_inFlight.size();) {
+        InFlight& f = m_inFlight[i];
+        if (timeoutOnly && now - f.sent < timeout) {
+            ++i;
+            continue;
+        }
+        InFlight dead = std::move(f);
+        m_inFlight.erase(m_inFlight.begin() + i);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (dead.kind == Request::Poll) m_pollInFlight = false;
+            if (timeoutOnly) m_stats.timeouts++;
+            rearmLocked(dead, EX_NONE);
+        }
+        if (timeoutOnly) m_consecutiveTimeouts++;
+        if (dead.cb) {
+            Result r;
+            r.timeout = timeoutOnly;
+            dead.cb(r);
+        }
+    }
+}
+
+void ModbusClient::rearmLocked(const InFlight& f, uint8_t exception){
+    // 槽位只记最新值，写失败 (超时 / 断线 / 异常响应) 不补发的话停车指令丢了底盘就一直跑：
+    // 重新置为待发，下一轮写槽里的最新值。已经 disconnectFromServer 的不恢复 (那边已作废)；
+    // 功能码 / 地址 / 值非法重发也不会成功，不重发
+    if (!m_wantConnected) return;
+    if (exception == EX_ILLEGAL_FUNCTION || exception == EX_ILLEGAL_ADDRESS || exception == EX_ILLEGAL_VALUE) return;
+    if (f.kind == Request::Move) {
+        if (f.function == FC_WRITE_MULTIPLE_COILS) m_moveCoilsPending = true;
+        else m_moveSpeedPending = true;
+    } else if (f.kind == Request::Target) {
+        m_targetPending = true;
+    } else {
+        return;
+    }
+    m_stats.retries++;
+}
+
+void ModbusClient::handleResponse(const uint8_t* adu, size_t len){
+    uint16_t tid = getU16(adu);
+    auto it = std::find_if(m_inFlight.begin(), m_inFlight.end(), [tid](const InFlight& f) { return f.tid == tid; });
+    if (it == m_inFlight.end()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.unmatched++;
+        return;
+    }
+    InFlight f = std::move(*it);
+    m_inFlight.erase(it);
+    m_consecutiveTimeouts = 0;
+
+    const uint8_t* pdu = adu + MBAP_SIZE;
+    size_t pduLen = len - MBAP_SIZE;
+    Result r;
+    r.rttMs = std::chrono::duration<double, std::milli>(Clock::now() - f.sent).count();
+    if (pdu[0] == (f.function | 0x80)) {
+        r.exception = pduLen >= 2 ? pdu[1] : EX_SERVER_FAILURE;
+    } else if (pdu[0] != f.function) {
+        r.exception = EX_SERVER_FAILURE;
+    } else if (f.function == FC_READ_HOLDING_REGISTERS) {
+        int bytes = pduLen >= 2 ? pdu[1] : 0;
+        if (bytes == f.quantity * 2 && pduLen >= (size_t)(2 + bytes)) {
+            r.count = f.quantity;
+            for (int i = 0; i < r.count; ++i) r.values[i] = getU16(pdu + 2 + i * 2);
+            r.ok = true;
+        }
+    } else if (f.function == FC_READ_COILS) {
+        int bytes = pduLen >= 2 ? pdu[1] : 0;
+        if (bytes == (f.quantity + 7) / 8 && pduLen >= (size_t)(2 + bytes)) {
+            r.count = f.quantity;
+            for (int i = 0; i < r.count; ++i) r.values[i] = (pdu[2 + i / 8] >> (i % 8)) & 1;
+            r.ok = true;
+        }
+    } else {
+        // 写请求的正常响应是回显地址和个数 / 值
+        r.ok = pduLen >= 5;
+    }
+
+    if (f.kind == Request::Poll && r.ok) {
+        // 车速回报按有符号解释 (倒车为负)，运动补偿只用大小
+        int speed = (int16_t)r.values[0];
+        m_lastSpeed = speed;
+        MotionPredictor::instance().onReportedSpeed((float)speed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (f.kind == Request::Poll) {
+            m_pollInFlight = false;
+            if (r.ok) m_stats.polls++;
+        }
+        if (!r.ok) rearmLocked(f, r.exception);
+        m_stats.responses++;
+        if (r.exception != EX_NONE) m_stats.exceptions++;
+        m_stats.sumRttMs += r.rttMs;
+        m_stats.maxRttMs = std::max(m_stats.maxRttMs, r.rttMs);
+    }
+    if (r.exception != EX_NONE && f.kind != Request::Generic) {
+        qDebug() << "【警告】Modbus 异常响应: 功能码" << (int)f.function << "异常码" << (int)r.exception;
+    }
+    if (f.cb) f.cb(r);
+}
+
+void ModbusClient::ioLoop(){
+    auto statsTime = Clock::now();
+    auto nextConnect = Clock::now();
+    int backoffMs = 0;
+    uint8_t adu[MAX_ADU];
+
+    while (m_running) {
+        auto now = Clock::now();
+        bool want, reconnect;
+        uint8_t unit;
+        int pipeline;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            want = m_wantConnected;
+            reconnect = m_reconnect;
+            m_reconnect = false;
+            unit = m_unit;
+            pipeline = m_pipeline;
+        }
+        if (reconnect) {
+            if (m_fd >= 0) closeSocket("切换服务端地址");
+            nextConnect = now;
+            backoffMs = 0;
+        }
+        if (!want && m_fd >= 0) closeSocket("主动断开");
+
+        int waitMs = 100;
+        if (want && m_fd < 0) {
+            if (now >= nextConnect) {
+                if (!openSocket()) {
+                    backoffMs = std::min(5000, std::max(500, backoffMs * 2));
+                    nextConnect = Clock::now() + std::chrono::milliseconds(backoffMs);
+                    if (backoffMs == 500) emit connectionStatusChanged(false, "Modbus 连接失败，稍后重试");
+                } else {
+                    backoffMs = 0;
+                }
+            }
+            waitMs = (int)std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::milliseconds>(nextConnect - Clock::now()).count());
+        }
+
+        if (m_fd >= 0) {
+            // 填满流水线
+            while ((int)m_inFlight.size() < pipeline) {
+                Request req;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!nextRequestLocked(req, now)) break;
+                    m_stats.requests++;
+                    m_stats.maxInFlight = std::max(m_stats.maxInFlight, (int)m_inFlight.size() + 1);
+                }
+                InFlight f;
+                f.tid = m_nextTid++;
+                f.function = req.pdu[0];
+                f.kind = req.kind;
+                f.quantity = (f.function == FC_READ_HOLDING_REGISTERS || f.function == FC_READ_COILS) ? getU16(req.pdu + 3) : 0;
+                f.cb = std::move(req.cb);
+                f.sent = now;
+                size_t n = writeMbap(adu, f.tid, unit, req.len);
+                memcpy(adu + MBAP_SIZE, req.pdu, req.len);
+                m_tx.insert(m_tx.end(), adu, adu + n);
+                m_inFlight.push_back(std::move(f));
+            }
+
+            if (!m_tx.empty()) {
+                ssize_t w = ::send(m_fd, m_tx.data(), m_tx.size(), MSG_NOSIGNAL);
+                if (w > 0) {
+                    m_tx.erase(m_tx.begin(), m_tx.begin() + w);
+                } else if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    closeSocket("发送失败");
+                    continue;
+                }
+            }
+
+            // 等到最早的超时或下一次轮询
+            auto deadline = now + std::chrono::milliseconds(100);
+            for (const auto& f : m_inFlight) deadline = std::min(deadline, f.sent + std::chrono::milliseconds(m_timeoutMs));
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_pollMs > 0 && !m_pollInFlight) deadline = std::min(deadline, m_nextPoll);
+            }
+            waitMs = (int)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count());
+        }
+
+        pollfd fds[2];
+        int nfds = 0;
+        fds[nfds++] = {m_wakePipe[0], POLLIN, 0};
+        if (m_fd >= 0) fds[nfds++] = {m_fd, (short)(POLLIN | (m_tx.empty() ? 0 : POLLOUT)), 0};
+        poll(fds, nfds, waitMs);
+
+        if (fds[0].revents & POLLIN) {
+            uint8_t drain[64];
+            while (::read(m_wakePipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (m_fd >= 0 && nfds == 2) {
+            if (fds[1].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                closeSocket("连接异常");
+                continue;
+            }
+            if (fds[1].revents & POLLIN) {
+                uint8_t buf[4096];
+                ssize_t r = ::recv(m_fd, buf, sizeof(buf), 0);
+                if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    closeSocket("对端关闭");
+                    continue;
+                }
+                if (r > 0) m_rx.insert(m_rx.end(), buf, buf + r);
+                bool bad = false;
+                while (!m_rx.empty()) {
+                    int n = frameLength(m_rx.data(), m_rx.size());
+                    if (n < 0) {
+                        bad = true;
+                        break;
+                    }
+                    if (n == 0) break;
+                    handleResponse(m_rx.data(), (size_t)n);
+                    m_rx.erase(m_rx.begin(), m_rx.begin() + n);
+                }
+                if (bad) {
+                    closeSocket("响应帧非法");
+                    continue;
+                }
+            }
+        }
+
+        if (m_fd >= 0) {
+            failInFlight(true, Clock::now());
+            // 连续超时说明 PLC 卡死或链路半开，断开重连比一直等下去快
+            if (m_consecutiveTimeouts >= 3) closeSocket("连续超时");
+        }
+
+        now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - statsTime).count();
+        if (elapsed >= 10.0) {
+            dumpStats(elapsed);
+            resetStats();
+            statsTime = now;
+        }
+    }
+}
+
+ModbusClient::Stats ModbusClient::stats(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ModbusClient::dumpStats(double elapsedSec){
+    Stats st = stats();
+    if (st.requests == 0 && st.timeouts == 0) return;
+    double secs = std::max(elapsedSec, 1e-3);
+    qDebug() << ">>> [Modbus] 请求" << st.requests << "(" << st.requests / secs << "条/秒 ) | 响应" << st.responses
+             << "| 异常" << st.exceptions << "| 超时" << st.timeouts << "| 错配" << st.unmatched
+             << "| 流水线峰值" << st.maxInFlight;
+    qDebug() << "    RTT ms: 平均" << (st.responses ? st.sumRttMs / st.responses : 0.0) << "| max" << st.maxRttMs
+             << "| 目标写入" << st.targetWrites << "合并" << st.targetCoalesced
+             << "| 移动写入" << st.moveWrites << "合并" << st.moveCoalesced << "| 失败重发" << st.retries
+             << "| 车速轮询" << st.polls << "| 当前车速" << m_lastSpeed.load();
+}
+
+void ModbusClient::resetStats(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats = Stats();
+}
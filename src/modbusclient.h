@@ -0,0 +1,203 @@
+#ifndef MODBUSCLIENT_H
+#define MODBUSCLIENT_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "car_modbus_protocol.h"
+
+// ==========================================
+// Modbus TCP 底盘通道 (PLC 底盘用，替代 MQTT，不经过 broker)
+// 寄存器 / 线圈地址见 car_modbus_protocol.h。
+//   - 异步：所有请求进队列由 I/O 线程发出，调用方不阻塞；结果通过回调 (在 I/O 线程里) 返回
+//   - 流水线：同时最多 pipeline 个请求在途，按事务号 (MBAP transaction id) 配对响应
+//   - 合并：激光目标 X/Y 一条 FC16 写两个寄存器；移动指令 (方向线圈 + Reg_SpeedSet) 和
+//     激光目标都是最新值槽位，还没发出就被新值覆盖
+//   - 轮询：按 pollMs 周期读 Reg_CurrentSpeed，喂给 MotionPredictor::onReportedSpeed
+// 启用：CAR_HMI_TRANSPORT=modbus；CAR_HMI_MODBUS_POLL_MS / _TIMEOUT_MS / _PIPELINE 调参数
+// ==========================================
+
+namespace modbus {
+
+// 功能码
+enum Function : uint8_t {
+    FC_READ_COILS              = 0x01,
+    FC_READ_HOLDING_REGISTERS  = 0x03,
+    FC_WRITE_SINGLE_COIL       = 0x05,
+    FC_WRITE_SINGLE_REGISTER   = 0x06,
+    FC_WRITE_MULTIPLE_COILS    = 0x0F,
+    FC_WRITE_MULTIPLE_REGISTERS= 0x10,
+};
+
+// 异常码 (响应功能码最高位置 1 时跟在后面)
+enum Exception : uint8_t {
+    EX_NONE                 = 0x00,
+    EX_ILLEGAL_FUNCTION     = 0x01,
+    EX_ILLEGAL_ADDRESS      = 0x02,
+    EX_ILLEGAL_VALUE        = 0x03,
+    EX_SERVER_FAILURE       = 0x04,
+};
+
+static const size_t MBAP_SIZE = 7;        // 事务号 2 + 协议号 2 + 长度 2 + 单元号 1
+static const size_t MAX_PDU = 253;
+static const size_t MAX_ADU = MBAP_SIZE + MAX_PDU;
+static const int MAX_READ_REGISTERS = 125;
+static const int MAX_WRITE_REGISTERS = 123;
+static const int MAX_WRITE_COILS = 1968;
+
+// Modbus 全部大端
+inline void putU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)(v >> 8); p[1] = (uint8_t)v; }
+inline uint16_t getU16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+// 写 MBAP 头，pduLen 为功能码 + 数据的长度；返回整条 ADU 长度
+inline size_t writeMbap(uint8_t* out, uint16_t tid, uint8_t unit, size_t pduLen)
+{
+    putU16(out, tid);
+    putU16(out + 2, 0);
+    putU16(out + 4, (uint16_t)(pduLen + 1));
+    out[6] = unit;
+    return MBAP_SIZE + pduLen;
+}
+
+// 从流缓冲区头部切出一条 ADU：不完整返回 0，协议号 / 长度非法返回 -1，否则返回 ADU 长度
+int frameLength(const uint8_t* data, size_t len);
+
+} // namespace modbus
+
+class ModbusClient : public QObject
+{
+    Q_OBJECT
+public:
+    struct Result {
+        bool ok = false;
+        bool timeout = false;
+        uint8_t exception = modbus::EX_NONE;
+        double rttMs = 0.0;
+        int count = 0;                       // 读请求返回的寄存器 / 线圈个数
+        uint16_t values[modbus::MAX_READ_REGISTERS] = {0};
+    };
+    typedef std::function<void(const Result&)> Callback;
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t responses = 0;
+        uint64_t exceptions = 0;
+        uint64_t timeouts = 0;
+        uint64_t unmatched = 0;              // 事务号对不上的响应 (已超时判死的迟到响应)
+        uint64_t targetWrites = 0;
+        uint64_t targetCoalesced = 0;        // 还没发出就被新目标覆盖的
+        uint64_t moveWrites = 0;
+        uint64_t moveCoalesced = 0;
+        uint64_t retries = 0;                // 移动 / 目标写失败后重新置为待发的次数
+        uint64_t polls = 0;
+        uint64_t reconnects = 0;
+        int maxInFlight = 0;                 // 流水线实际达到的深度
+        double sumRttMs = 0.0;
+        double maxRttMs = 0.0;
+    };
+
+    explicit ModbusClient(QObject *parent = nullptr);
+    virtual ~ModbusClient();
+
+    void connectToServer(const QString &ip, int port, int unitId = CarServerID);
+    void disconnectFromServer();
+    bool isConnected() const { return m_connected.load(); }
+
+    // 业务接口 (最新值覆盖)：方向线圈 Addr_DirectionForward..Right 一条 FC15，速度 Reg_SpeedSet 一条 FC06
+    void setMove(float vx, float vy);
+    // 激光瞄准点：Reg_LaserTargetX / Reg_LaserTargetY 一条 FC16
+    void setLaserTarget(int x, int y);
+
+    // 通用请求
+    void writeCoil(uint16_t addr, bool on, Callback cb = nullptr);
+    void writeRegister(uint16_t addr, uint16_t value, Callback cb = nullptr);
+    void writeRegisters(uint16_t addr, const uint16_t* values, int count, Callback cb = nullptr);
+    void readHoldingRegisters(uint16_t addr, int count, Callback cb);
+    void readCoils(uint16_t addr, int count, Callback cb);
+
+    void setPollIntervalMs(int ms);      // 0 关闭轮询
+    int lastReportedSpeed() const { return m_lastSpeed.load(); }
+    Stats stats();
+    void dumpStats(double elapsedSec);
+    void resetStats();
+
+signals:
+    // 与 MqttClientManager 同签名，MainWindow 共用一个槽更新连接按钮
+    void connectionStatusChanged(bool connected, const QString &message);
+
+private:
+    struct Request {
+        uint8_t pdu[modbus::MAX_PDU];
+        size_t len = 0;
+        Callback cb;
+        enum Kind { Generic, Move, Target, Poll } kind = Generic;
+    };
+    struct InFlight {
+        uint16_t tid = 0;
+        uint8_t function = 0;
+        Request::Kind kind = Request::Generic;
+        uint16_t quantity = 0;               // 读请求的个数，解析线圈位图时用
+        Callback cb;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    void enqueue(Request&& req);
+    void wake();
+    void ioLoop();
+    bool openSocket();
+    void closeSocket(const char* reason);
+    // 按优先级取下一条要发的：普通请求 > 移动 > 激光目标 > 轮询
+    bool nextRequestLocked(Request& req, std::chrono::steady_clock::time_point now);
+    void handleResponse(const uint8_t* adu, size_t len);
+    void failInFlight(bool timeoutOnly, std::chrono::steady_clock::time_point now);
+    // 移动 / 目标写失败时把对应槽位重新置为待发 (调用时持有 m_mutex)
+    void rearmLocked(const InFlight& f, uint8_t exception);
+
+    // 连接参数 (m_mutex 保护)
+    std::string m_host;
+    int m_port = 0;
+    uint8_t m_unit = 1;
+    bool m_wantConnected = false;
+    bool m_reconnect = false;            // 换了地址，I/O 线程要先断开旧连接
+    int m_timeoutMs = 500;
+    int m_pipeline = 4;
+    int m_pollMs = 100;
+
+    std::mutex m_mutex;
+    std::deque<Request> m_queue;
+    // 最新值槽位
+    bool m_moveCoilsPending = false;
+    bool m_moveSpeedPending = false;
+    uint8_t m_moveCoils = 0;             // bit0 前进 bit1 后退 bit2 左 bit3 右
+    uint16_t m_moveSpeed = 0;
+    bool m_targetPending = false;
+    uint16_t m_targetX = 0;
+    uint16_t m_targetY = 0;
+    std::chrono::steady_clock::time_point m_nextPoll;
+    bool m_pollInFlight = false;
+    Stats m_stats;
+
+    // 以下只在 I/O 线程访问
+    int m_fd = -1;
+    uint16_t m_nextTid = 1;
+    std::vector<InFlight> m_inFlight;
+    std::vector<uint8_t> m_tx;
+    std::vector<uint8_t> m_rx;
+    int m_consecutiveTimeouts = 0;
+
+    int m_wakePipe[2] = {-1, -1};
+    std::atomic<bool> m_connected{false};
+    std::atomic<int> m_lastSpeed{0};
+    std::thread m_ioThread;
+    std::atomic<bool> m_running{false};
+};
+
+#endif // MODBUSCLIENT_H
@@ -0,0 +1,123 @@
+#include "modelmeta.h"
+#include <QDebug>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+static bool fileExists(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static std::string trim(const std::string& s)
+{
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+// 去掉 YAML 标量两侧的引号
+static std::string unquote(const std::string& s)
+{
+    std::string v = trim(s);
+    if (v.size() >= 2 && ((v.front() == '\'' && v.back() == '\'') || (v.front() == '"' && v.back() == '"'))) {
+        v = v.substr(1, v.size() - 2);
+    }
+    return v;
+}
+
+std::string ModelMetadata::locate(const std::string& modelPath)
+{
+    size_t slash = modelPath.find_last_of('/');
+    std::string dir = slash == std::string::npos ? std::string(".") : modelPath.substr(0, slash);
+    std::string file = slash == std::string::npos ? modelPath : modelPath.substr(slash + 1);
+    std::string stem = file.substr(0, file.find_last_of('.'));
+
+    std::string candidate = dir + "/metadata.yaml";
+    if (fileExists(candidate)) return candidate;
+    candidate = dir + "/" + stem + "_rknn_model/metadata.yaml";
+    if (fileExists(candidate)) return candidate;
+
+    // 导出目录名和部署时改过的模型文件名对不上时，取唯一一个 *_rknn_model 目录
+    std::vector<std::string> found;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(d)) {
+            std::string name = ent->d_name;
+            const std::string suffix = "_rknn_model";
+            if (name.size() > suffix.size() &&
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+                fileExists(dir + "/" + name + "/metadata.yaml")) {
+                found.push_back(dir + "/" + name + "/metadata.yaml");
+            }
+        }
+        closedir(d);
+    }
+    if (found.size() == 1) return found.front();
+    if (found.size() > 1) {
+        qDebug() << "【警告】找到多个模型元数据目录，无法确定用哪个，改用 classes.txt";
+    }
+    return std::string();
+}
+
+bool ModelMetadata::load(const std::string& yamlPath, ModelMetadata& meta)
+{
+    std::ifstream in(yamlPath);
+    if (!in.is_open()) return false;
+
+    meta = ModelMetadata();
+    std::string section;    // 当前所在的顶层块 (names / imgsz / args ...)
+    std::string line;
+    while (std::getline(in, line)) {
+        if (trim(line).empty() || trim(line)[0] == '#') continue;
+        std::string body = trim(line);
+        // 列表项在导出文件里是顶格写的 ("imgsz:\n- 640")，也算作所在块的内容
+        bool indented = line[0] == ' ' || line[0] == '\t' || body[0] == '-';
+
+        if (!indented) {
+            size_t colon = body.find(':');
+            if (colon == std::string::npos) continue;
+            std::string key = body.substr(0, colon);
+            std::string value = unquote(body.substr(colon + 1));
+            section = value.empty() ? key : std::string();
+            if (key == "stride") meta.stride = atoi(value.c_str());
+            else if (key == "task") meta.task = value;
+            else if (key == "head") meta.head = value;
+            else if (key == "end2end") meta.end2end = (value == "true" || value == "True");
+            else if (key == "postprocess") meta.postprocess = value;
+            else if (key == "topk") meta.topk = atoi(value.c_str());
+            else if (key == "input") meta.input = value;
+            else if (key == "imgsz" && !value.empty()) {
+                // 行内写法 imgsz: [640, 640]
+                int h = 0, w = 0;
+                if (sscanf(value.c_str(), "[%d, %d]", &h, &w) == 2 || sscanf(value.c_str(), "[%d,%d]", &h, &w) == 2) {
+                    meta.imgszH = h;
+                    meta.imgszW = w;
+                }
+            }
+            continue;
+        }
+
+        if (section == "names") {
+            // "  12: parking meter"
+            size_t colon = body.find(':');
+            if (colon == std::string::npos) continue;
+            int id = atoi(body.substr(0, colon).c_str());
+            if (id < 0 || id > 4096) continue;
+            if ((int)meta.names.size() <= id) meta.names.resize(id + 1);
+            meta.names[id] = unquote(body.substr(colon + 1));
+        } else if (section == "imgsz" && body[0] == '-') {
+            // 块写法：先 h 后 w
+            int v = atoi(trim(body.substr(1)).c_str());
+            if (meta.imgszH == 0) meta.imgszH = v;
+            else if (meta.imgszW == 0) meta.imgszW = v;
+        }
+    }
+    if (meta.imgszW == 0) meta.imgszW = meta.imgszH;
+    meta.path = yamlPath;
+    return true;
+}
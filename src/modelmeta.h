@@ -0,0 +1,35 @@
+#ifndef MODELMETA_H
+#define MODELMETA_H
+
+#include <string>
+#include <vector>
+
+// ==========================================
+// 模型元数据 (Ultralytics 导出 RKNN 时附带的 metadata.yaml)
+// 换成剪枝 / 重新训练的除草模型时，类别表、输入尺寸、检测头类型都以模型自带的为准，
+// 不用再手工同步 classes.txt。
+// 这里只解析导出文件用到的简单 YAML 子集：顶层 key: value、names 映射块、imgsz 列表。
+// ==========================================
+
+struct ModelMetadata {
+    std::vector<std::string> names;   // 下标即类别编号
+    int imgszW = 0;
+    int imgszH = 0;
+    int stride = 0;                   // 最大 stride
+    std::string task;                 // detect / segment / ...
+    std::string head;                 // Detect / v10Detect / ...
+    bool end2end = false;             // 模型内已做后处理 (NMS)
+    std::string postprocess;          // export_rknn.py --postprocess 导出时为 "topk"
+    int topk = 0;                     // 图内 top-K 的 K
+    std::string input;                // export_rknn.py --nv12-input 导出时为 "nv12"，否则为空 (RGB888)
+    std::string path;                 // 实际读取的文件
+
+    bool valid() const { return !path.empty(); }
+
+    // 依次查找 <模型目录>/metadata.yaml、<模型目录>/<模型名>_rknn_model/metadata.yaml、
+    // <模型目录>/*_rknn_model/metadata.yaml；都没有返回空字符串
+    static std::string locate(const std::string& modelPath);
+    static bool load(const std::string& yamlPath, ModelMetadata& meta);
+};
+
+#endif // MODELMETA_H
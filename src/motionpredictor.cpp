@@ -0,0 +1,233 @@
+#include "motionpredictor.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// 底盘加减速的时间常数：指令变化后约 0.25s 达到 63%
+static const double kChassisTau = 0.25;
+// 车速回报、光流超过这个时长就认为过期
+static const double kReportedFreshSec = 0.3;
+static const double kFlowFreshSec = 0.15;
+// 标定最小二乘的遗忘因子，约等于最近 200 个样本
+static const double kGainForget = 0.995;
+// 分母小于该值说明这个方向几乎没动过，标定不可信
+static const double kGainMinEnergy = 1.0;
+
+static double secondsBetween(MotionPredictor::TimePoint a, MotionPredictor::TimePoint b)
+{
+    return std::chrono::duration<double>(b - a).count();
+}
+
+MotionPredictor& MotionPredictor::instance()
+{
+    static MotionPredictor predictor;
+    return predictor;
+}
+
+MotionPredictor::MotionPredictor()
+{
+    m_estimateTime = std::chrono::steady_clock::now();
+
+    const char* latency = getenv("CAR_HMI_FIRE_LATENCY_MS");
+    if (latency && atof(latency) >= 0) m_fireLatencyMs = atof(latency);
+
+    // 事先量过的比例 (像素/秒 每单位速度) 可以作为标定初值，之后仍会被光流修正
+    const char* pxPerSpeed = getenv("CAR_HMI_PX_PER_SPEED");
+    if (pxPerSpeed && atof(pxPerSpeed) > 0) {
+        float k = (float)atof(pxPerSpeed);
+        m_gain[0] = -k;
+        m_gain[1] = k;
+        m_sxx[0] = m_sxx[1] = kGainMinEnergy * 10;
+        m_sxy[0] = m_gain[0] * m_sxx[0];
+        m_sxy[1] = m_gain[1] * m_sxx[1];
+    }
+}
+
+void MotionPredictor::advanceLocked(TimePoint t)
+{
+    double dt = secondsBetween(m_estimateTime, t);
+    if (dt <= 0.0) return;
+    float a = (float)(1.0 - std::exp(-dt / kChassisTau));
+    m_estimate += (m_commanded - m_estimate) * a;
+    m_estimateTime = t;
+}
+
+void MotionPredictor::onCommandedMove(float vx, float vy, TimePoint t)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    advanceLocked(t);
+    m_commanded = cv::Point2f(vx, vy);
+    float norm = std::sqrt(vx * vx + vy * vy);
+    if (norm > 1e-3f) m_lastDirection = cv::Point2f(vx / norm, vy / norm);
+}
+
+void MotionPredictor::onReportedSpeed(float speed, TimePoint t)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reportedSpeed = speed;
+    m_reportedTime = t;
+    m_haveReported = true;
+}
+
+cv::Point2f MotionPredictor::chassisVelocity(TimePoint t)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    advanceLocked(t);
+    cv::Point2f v = m_estimate;
+    // 下位机回报的是实际车速的大小：方向沿用模型 (或最近一次指令)，大小以回报为准
+    if (m_haveReported && secondsBetween(m_reportedTime, t) < kReportedFreshSec) {
+        float norm = std::sqrt(v.x * v.x + v.y * v.y);
+        cv::Point2f dir = norm > 1e-3f ? v * (1.f / norm) : m_lastDirection;
+        v = dir * std::abs(m_reportedSpeed);
+    }
+    return v;
+}
+
+bool MotionPredictor::gainsReadyLocked() const
+{
+    return m_sxx[0] >= kGainMinEnergy || m_sxx[1] >= kGainMinEnergy;
+}
+
+void MotionPredictor::onImageVelocity(const cv::Point2f& pxPerSec, TimePoint t)
+{
+    cv::Point2f chassis = chassisVelocity(t);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_flow = pxPerSec;
+    m_flowChassis = chassis;
+    m_flowTime = t;
+    m_haveFlow = true;
+
+    // 画面 x <- 右移速度，画面 y <- 前进速度，各自做一元最小二乘
+    const float drive[2] = {chassis.y, chassis.x};
+    const float image[2] = {pxPerSec.x, pxPerSec.y};
+    for (int axis = 0; axis < 2; ++axis) {
+        m_sxx[axis] *= kGainForget;
+        m_sxy[axis] *= kGainForget;
+        if (std::abs(drive[axis]) < 1e-3f) continue;
+        m_sxx[axis] += (double)drive[axis] * drive[axis];
+        m_sxy[axis] += (double)drive[axis] * image[axis];
+        if (m_sxx[axis] >= kGainMinEnergy) m_gain[axis] = (float)(m_sxy[axis] / m_sxx[axis]);
+    }
+}
+
+bool MotionPredictor::chassisImageVelocity(TimePoint t, cv::Point2f& pxPerSec)
+{
+    cv::Point2f chassis = chassisVelocity(t);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!gainsReadyLocked()) return false;
+    pxPerSec = cv::Point2f(m_gain[0] * chassis.y, m_gain[1] * chassis.x);
+    return true;
+}
+
+cv::Point2f MotionPredictor::imageVelocity(TimePoint t)
+{
+    cv::Point2f fromChassis;
+    bool haveChassis = chassisImageVelocity(t, fromChassis);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool flowFresh = m_haveFlow && secondsBetween(m_flowTime, t) < kFlowFreshSec;
+    if (flowFresh && haveChassis) {
+        // 光流是实测值但滞后一帧；再叠加底盘模型预计的这段时间里的速度变化 (加减速)
+        cv::Point2f then(m_gain[0] * m_flowChassis.y, m_gain[1] * m_flowChassis.x);
+        return m_flow + (fromChassis - then);
+    }
+    if (flowFresh) return m_flow;
+    if (haveChassis) return fromChassis;
+    return cv::Point2f(0.f, 0.f);
+}
+
+void MotionPredictor::setFireLatencyMs(double ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_fireLatencyMs = std::max(0.0, ms);
+}
+
+double MotionPredictor::fireLatencyMs()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fireLatencyMs;
+}
+
+cv::Point2f MotionPredictor::predict(const Detection& det, TimePoint fireTime)
+{
+    double dt = secondsBetween(det.captureTime, fireTime);
+    // 拍摄时刻未知 (没经过采集链路的检测) 时不做外推
+    if (det.captureTime.time_since_epoch().count() == 0 || dt <= 0.0 || dt > 1.0) return det.preciseTarget;
+    cv::Point2f v = imageVelocity(std::chrono::steady_clock::now());
+    return det.preciseTarget + v * (float)dt;
+}
+
+TargetPayload MotionPredictor::makeTarget(const Detection& det)
+{
+    TimePoint now = std::chrono::steady_clock::now();
+    double fireLatency = fireLatencyMs();
+    TimePoint fireTime = now + std::chrono::microseconds((int64_t)(fireLatency * 1000.0));
+    cv::Point2f predicted = predict(det, fireTime);
+
+    auto clamp16 = [](float v) {
+        return (int16_t)std::max(-32768.f, std::min(32767.f, std::round(v)));
+    };
+    int64_t captureMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        det.captureTime.time_since_epoch()).count();
+    double totalMs = std::chrono::duration<double, std::milli>(fireTime - det.captureTime).count();
+
+    TargetPayload payload;
+    payload.x = clamp16(det.preciseTarget.x);
+    payload.y = clamp16(det.preciseTarget.y);
+    payload.predX = clamp16(predicted.x);
+    payload.predY = clamp16(predicted.y);
+    payload.captureMs = (uint32_t)(captureMs & 0xFFFFFFFF);
+    payload.validInMs = (uint16_t)std::min(65535.0, fireLatency);
+    payload.latencyMs = (uint16_t)std::max(0.0, std::min(65535.0, totalMs));
+    payload.classId = (uint8_t)std::max(0, std::min(255, det.class_id));
+    payload.confidence = (uint8_t)std::max(0.f, std::min(255.f, det.confidence * 255.f));
+    payload.trackId = det.trackId >= 0 ? (uint16_t)(det.trackId & 0xFFFF) : 0xFFFF;
+    return payload;
+}
+
+int MotionPredictor::makeTargetBatch(const std::vector<Detection>& dets, const FrameStamp& frame,
+                                     TargetBatchHeader& head, TargetEntry* entries, int maxEntries)
+{
+    auto clamp16 = [](float v) {
+        return (int16_t)std::max(-32768.f, std::min(32767.f, std::round(v)));
+    };
+
+    memset(&head, 0, sizeof(head));
+    int count = 0;
+    for (const auto& det : dets) {
+        if (count >= maxEntries) break;
+        if (det.targetX <= 0 || det.targetY <= 0) continue;
+        TargetEntry& e = entries[count++];
+        e.x = clamp16(det.preciseTarget.x);
+        e.y = clamp16(det.preciseTarget.y);
+        e.classId = (uint8_t)std::max(0, std::min(255, det.class_id));
+        e.confidence = (uint8_t)std::max(0.f, std::min(255.f, det.confidence * 255.f));
+        e.trackId = det.trackId >= 0 ? (uint16_t)(det.trackId & 0xFFFF) : 0xFFFF;
+    }
+
+    // 同一帧的目标拍摄时刻相同，外推只算一次 (imageVelocity 对整帧是同一个值)
+    TimePoint now = std::chrono::steady_clock::now();
+    double fireLatency = fireLatencyMs();
+    TimePoint fireTime = now + std::chrono::microseconds((int64_t)(fireLatency * 1000.0));
+    Detection probe;
+    probe.captureTime = frame.captureTime;
+    probe.preciseTarget = cv::Point2f(0.f, 0.f);
+    cv::Point2f shift = predict(probe, fireTime);
+
+    int64_t captureMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        frame.captureTime.time_since_epoch()).count();
+    double totalMs = std::chrono::duration<double, std::milli>(fireTime - frame.captureTime).count();
+
+    head.frameId = (uint32_t)(frame.seq & 0xFFFFFFFF);
+    head.captureMs = (uint32_t)(captureMs & 0xFFFFFFFF);
+    head.validInMs = (uint16_t)std::min(65535.0, fireLatency);
+    head.latencyMs = (uint16_t)std::max(0.0, std::min(65535.0, totalMs));
+    head.shiftX = clamp16(shift.x);
+    head.shiftY = clamp16(shift.y);
+    head.cameraId = (uint8_t)std::max(0, std::min(255, frame.cameraId));
+    head.count = (uint8_t)count;
+    return count;
+}
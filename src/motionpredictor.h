@@ -0,0 +1,90 @@
+#ifndef MOTIONPREDICTOR_H
+#define MOTIONPREDICTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <mutex>
+#include "inference.h"
+#include "protocol_def.h"
+
+// ==========================================
+// 目标运动补偿
+// 检测框中心是拍摄时刻的位置，等 CMD_TARGET 发出去、激光真正打出时，
+// 底盘已经走了 (采集 + 推理 + 发布 + 执行) x 速度 这么远。
+// 这里持续估计底盘速度 (下发的 MovePayload + 下位机回报的 Reg_CurrentSpeed)，
+// 并用画面光流在线标定 "底盘速度 -> 画面像素速度" 的比例，
+// 把瞄准点外推到预计打击时刻，连同有效时刻一起放进 CMD_TARGET。
+//
+// 约定：相机朝下安装，画面上方为车头方向。前进时地面在画面里向下走 (+y)，
+// 右移时地面向左走 (-x)。
+// ==========================================
+class MotionPredictor
+{
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    static MotionPredictor& instance();
+
+    // 下发的移动指令 (MovePayload 的 vx/vy)
+    void onCommandedMove(float vx, float vy, TimePoint t = std::chrono::steady_clock::now());
+    // 下位机回报的当前车速 (Reg_CurrentSpeed，与 Reg_SpeedSet 同单位)
+    void onReportedSpeed(float speed, TimePoint t = std::chrono::steady_clock::now());
+    // 画面整体运动 (跟踪器光流，像素/秒)，同时用来在线标定比例
+    void onImageVelocity(const cv::Point2f& pxPerSec, TimePoint t);
+
+    // 底盘速度估计 (x 前进, y 右移，速度单位)
+    cv::Point2f chassisVelocity(TimePoint t);
+    // 画面上的地面运动速度估计 (像素/秒)
+    cv::Point2f imageVelocity(TimePoint t);
+    // 按底盘速度换算出的画面速度；比例还没标定出来时返回 false
+    bool chassisImageVelocity(TimePoint t, cv::Point2f& pxPerSec);
+
+    // 报文发出 -> 激光实际打出 的时延 (链路 + 云台执行)，默认取 CAR_HMI_FIRE_LATENCY_MS 或 30ms
+    void setFireLatencyMs(double ms);
+    double fireLatencyMs();
+
+    // 把瞄准点从拍摄时刻外推到 fireTime
+    cv::Point2f predict(const Detection& det, TimePoint fireTime);
+    // 以当前时刻为发送时刻，生成带预测坐标和有效时刻的 CMD_TARGET 载荷
+    TargetPayload makeTarget(const Detection& det);
+    // 同一帧的全部目标打包成 CMD_TARGET_BATCH：坐标取拍摄时刻，外推平移量整帧共用一个放进头里。
+    // 只收有瞄准点的目标，按传入顺序 (优先级 -> 置信度) 截断到 maxEntries；返回写入的条数。
+    // 帧号 / 拍摄时刻 / 摄像头取自 frame，没有目标时也填好头 (count = 0 的空批次)
+    int makeTargetBatch(const std::vector<Detection>& dets, const FrameStamp& frame, TargetBatchHeader& head,
+                        TargetEntry* entries, int maxEntries);
+
+private:
+    MotionPredictor();
+    MotionPredictor(const MotionPredictor&) = delete;
+    MotionPredictor& operator=(const MotionPredictor&) = delete;
+
+    // 底盘一阶惯性模型：估计值以时间常数 tau 追踪下发的速度
+    void advanceLocked(TimePoint t);
+    bool gainsReadyLocked() const;
+
+    std::mutex m_mutex;
+
+    // 底盘模型
+    cv::Point2f m_commanded;
+    cv::Point2f m_estimate;
+    cv::Point2f m_lastDirection{1.f, 0.f};   // 最近一次非零指令的方向，车速回报没有方向
+    TimePoint m_estimateTime;
+    float m_reportedSpeed = 0.f;
+    TimePoint m_reportedTime;
+    bool m_haveReported = false;
+
+    // 光流
+    cv::Point2f m_flow;
+    cv::Point2f m_flowChassis;               // 光流时刻对应的底盘速度估计
+    TimePoint m_flowTime;
+    bool m_haveFlow = false;
+
+    // 比例标定：gainX = 画面 x 速度 / 右移速度，gainY = 画面 y 速度 / 前进速度 (带遗忘的最小二乘)
+    double m_sxy[2] = {0.0, 0.0};
+    double m_sxx[2] = {0.0, 0.0};
+    float m_gain[2] = {0.f, 0.f};
+
+    double m_fireLatencyMs = 30.0;
+};
+
+#endif // MOTIONPREDICTOR_H
@@ -0,0 +1,255 @@
+#include "mqttchannel.h"
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+
+MqttChannel::MqttChannel(const ChannelConfig& config) : m_config(config) {
+    if (m_config.maxQueue > 0) {
+        m_running = true;
+        m_sendThread = std::thread(&MqttChannel::sendLoop, this);
+    }
+}
+
+MqttChannel::~MqttChannel() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_running = false;
+    }
+    m_queueCond.notify_all();
+    if (m_sendThread.joinable()) m_sendThread.join();
+
+    std::lock_guard<std::mutex> lock(m_clientMutex);
+    if (m_client) {
+        if (m_client->is_connected()) {
+            try {
+                m_client->disconnect()->wait();
+            } catch (...) {}
+        }
+        delete m_client;
+        m_client = nullptr;
+    }
+}
+
+bool MqttChannel::connect(const std::string& url, const std::string& clientIdBase, mqtt::callback* callback,
+                          std::string* error){
+    std::lock_guard<std::mutex> lock(m_clientMutex);
+    if (m_client) {
+        if (m_client->is_connected()) {
+            try {
+                m_client->disconnect()->wait();
+            } catch (...) {}
+        }
+        delete m_client;
+    }
+
+    // 同一个客户端 ID 在 broker 上会互相踢下线，每条通道加后缀区分
+    m_client = new mqtt::async_client(url, clientIdBase + m_config.clientIdSuffix);
+    m_client->set_callback(callback ? *callback : *this);
+
+    mqtt::connect_options opts = mqtt::connect_options_builder()
+        .clean_session(true)
+        .keep_alive_interval(std::chrono::seconds(m_config.keepAliveSec))
+        .automatic_reconnect(true)
+        .max_inflight(m_config.maxInflight)
+        .finalize();
+    try {
+        m_client->connect(opts);
+        return true;
+    } catch (const mqtt::exception& exc) {
+        qDebug() << "【警告】" << m_config.name << "通道连接失败:" << exc.what();
+        if (error) *error = exc.what();
+        return false;
+    }
+}
+
+void MqttChannel::disconnect(){
+    // 等断开完成时不能拿着 m_clientMutex：paho 回调线程里可能正在 publish 等这把锁，两边互等就卡死。
+    // 指针在锁内取出即可，客户端对象只在 connect / 析构里替换，和这里同在主线程
+    mqtt::async_client* client = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_clientMutex);
+        client = m_client;
+    }
+    if (client && client->is_connected()) {
+        try {
+            client->disconnect()->wait();
+        } catch (const mqtt::exception& exc) {
+            qDebug() << ">>>" << m_config.name << "通道断开时异常:" << exc.what();
+        }
+    }
+}
+
+bool MqttChannel::isConnected(){
+    std::lock_guard<std::mutex> lock(m_clientMutex);
+    return m_client && m_client->is_connected();
+}
+
+void MqttChannel::subscribe(const std::string& topic, int qos){
+    std::lock_guard<std::mutex> lock(m_clientMutex);
+    if (!m_client) return;
+    try {
+        m_client->subscribe(topic, qos);
+    } catch (const mqtt::exception& exc) {
+        qDebug() << ">>> 订阅主题失败:" << QString::fromStdString(topic) << exc.what();
+    }
+}
+
+bool MqttChannel::busy(){
+    if (m_publishing.load() > 0) return true;
+    // 拿不到锁说明有人正在发布 / 重连，同样算忙
+    std::unique_lock<std::mutex> lock(m_clientMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return true;
+    // QoS 0 的 token 在报文写进 socket 后才完成，还挂着说明 Paho 队列里有没写出去的控制报文
+    return m_client && !m_client->get_pending_delivery_tokens().empty();
+}
+
+void MqttChannel::waitForHigher(){
+    if (!m_higher || !m_higher->busy()) return;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(m_config.yieldMaxMs);
+    while (m_higher->busy() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_stats.yielded++;
+    m_stats.yieldMs += waited;
+}
+
+mqtt::delivery_token_ptr MqttChannel::publish(const std::string& topic, const void* data, size_t len, int qos){
+    waitForHigher();
+
+    mqtt::delivery_token_ptr token;
+    m_publishing++;
+    {
+        std::lock_guard<std::mutex> lock(m_clientMutex);
+        if (m_client && m_client->is_connected()) {
+            try {
+                token = m_client->publish(topic, data, len, qos, false);
+            } catch (...) {}
+        }
+    }
+    m_publishing--;
+
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if (token) {
+        m_stats.sent++;
+        m_stats.bytes += len;
+    } else {
+        m_stats.failed++;
+    }
+    return token;
+}
+
+bool MqttChannel::post(const std::string& topic, const void* data, size_t len){
+    if (m_config.maxQueue == 0) return false;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        auto full = [&]() {
+            return m_queue.size() >= m_config.maxQueue ||
+                   (m_config.maxQueueBytes > 0 && m_queueBytes + len > m_config.maxQueueBytes);
+        };
+        if (full() && !m_config.dropOldest) {
+            m_stats.dropped++;
+            return false;
+        }
+        while (!m_queue.empty() && full()) {
+            m_queueBytes -= m_queue.front().payload.size();
+            m_queue.pop_front();
+            m_stats.dropped++;
+        }
+        Item item;
+        item.seq = m_nextSeq++;
+        item.topic = topic;
+        item.payload.assign(static_cast<const char*>(data), len);
+        m_queueBytes += len;
+        m_queue.push_back(std::move(item));
+        m_stats.posted++;
+        m_stats.queueHigh = std::max(m_stats.queueHigh, m_queue.size());
+    }
+    m_queueCond.notify_one();
+    return true;
+}
+
+void MqttChannel::sendLoop(){
+    typedef std::chrono::steady_clock Clock;
+    // 字节令牌桶，容量 0.1 秒的量，避免攒出一大串突发把控制报文挤在后面
+    double burst = m_config.bytesPerSec * 0.1;
+    double tokens = burst;
+    auto refillTime = Clock::now();
+
+    while (true) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCond.wait(lock, [this]() { return !m_running || !m_queue.empty(); });
+            if (!m_running) break;
+            item = m_queue.front();
+        }
+
+        if (!isConnected()) {
+            // 断线期间不出队，队列满了由 post() 按策略丢弃
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCond.wait_for(lock, std::chrono::milliseconds(200), [this]() { return !m_running; });
+            continue;
+        }
+
+        if (m_config.bytesPerSec > 0) {
+            auto now = Clock::now();
+            tokens = std::min(burst, tokens + std::chrono::duration<double>(now - refillTime).count() * m_config.bytesPerSec);
+            refillTime = now;
+            double need = std::min((double)item.payload.size(), burst);
+            if (tokens < need) {
+                std::this_thread::sleep_for(std::chrono::duration<double>((need - tokens) / m_config.bytesPerSec));
+                continue;
+            }
+            tokens -= need;
+        }
+
+        mqtt::delivery_token_ptr token = publish(item.topic, item.payload.data(), item.payload.size(), m_config.qos);
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        if (!token) {
+            // 连着但发布异常 (Paho 在途窗口满等)：稍等再试，别空转
+            m_queueCond.wait_for(lock, std::chrono::milliseconds(50), [this]() { return !m_running; });
+            continue;
+        }
+        // 发送期间队首可能已被 post() 挤掉，只在还是同一条时出队
+        if (!m_queue.empty() && m_queue.front().seq == item.seq) {
+            m_queueBytes -= m_queue.front().payload.size();
+            m_queue.pop_front();
+        }
+    }
+}
+
+MqttChannel::Stats MqttChannel::stats(){
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    Stats st = m_stats;
+    st.queueDepth = m_queue.size();
+    st.queueBytes = m_queueBytes;
+    return st;
+}
+
+void MqttChannel::dumpStats(double elapsedSec){
+    Stats st = stats();
+    if (st.sent == 0 && st.failed == 0 && st.posted == 0) return;
+    double secs = std::max(elapsedSec, 1e-3);
+    qDebug() << ">>> [" << m_config.name << "通道] 发出" << st.sent << "(" << st.sent / secs << "条/秒,"
+             << st.bytes / secs / 1024.0 << "KB/秒 ) | 失败" << st.failed
+             << "| 入队" << st.posted << "| 丢弃" << st.dropped
+             << "| 队列" << (int)st.queueDepth << "条" << (int)(st.queueBytes / 1024) << "KB 峰值" << (int)st.queueHigh
+             << "| 让路" << st.yielded << "次" << st.yieldMs << "ms";
+}
+
+void MqttChannel::resetStats(){
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_stats = Stats();
+}
+
+void MqttChannel::connected(const mqtt::string& cause){
+    qDebug() << ">>>" << m_config.name << "通道已连接" << QString::fromStdString(cause);
+    m_queueCond.notify_one();
+}
+
+void MqttChannel::connection_lost(const mqtt::string& cause){
+    qDebug() << "【警告】" << m_config.name << "通道连接丢失:" << QString::fromStdString(cause);
+}
@@ -0,0 +1,118 @@
+#ifndef MQTTCHANNEL_H
+#define MQTTCHANNEL_H
+
+#include <mqtt/async_client.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ==========================================
+// MQTT 通道：每类流量一条独立的 broker 连接
+//   控制   car/cmd、car/status     移动 / 打击 / 批量目标，QoS 0，直发不排队
+//   遥测   car/log/...             发件箱补发，QoS 1
+//   大块   car/bulk/...            预览图、检测流等，QoS 0，有界队列 + 限速发送线程
+// 各通道的 TCP 发送缓冲、Paho 在途窗口、QoS 和排队上限互不影响，大块数据把链路塞满时
+// 控制报文不会排在它后面 (队头阻塞)。低优先级通道每次发布前先看高优先级通道是否还有
+// 报文没写出去，有就等它发完 (最多 yieldMaxMs)，实现严格优先。
+// ==========================================
+
+enum class ChannelClass : uint8_t {
+    Control   = 0,
+    Telemetry = 1,
+    Bulk      = 2,
+};
+
+struct ChannelConfig {
+    ChannelClass cls = ChannelClass::Control;
+    const char* name = "控制";
+    std::string clientIdSuffix;          // 拼在主客户端 ID 后面，broker 上区分各条连接
+    int qos = 0;                         // post() 排队报文的 QoS
+    int maxInflight = 10;                // Paho 在途窗口
+    int keepAliveSec = 5;
+    size_t maxQueue = 0;                 // 排队条数上限，0 表示不开发送线程、只能 publish() 直发
+    size_t maxQueueBytes = 0;            // 排队字节上限，0 不限
+    bool dropOldest = true;              // 队列满时丢最老的 (true) 还是拒收新的 (false)
+    double bytesPerSec = 0.0;            // 发送线程限速，0 不限
+    int yieldMaxMs = 20;                 // 给高优先级通道让路最多等多久
+};
+
+class MqttChannel : public virtual mqtt::callback
+{
+public:
+    struct Stats {
+        uint64_t posted = 0;             // 进队列的
+        uint64_t sent = 0;
+        uint64_t bytes = 0;
+        uint64_t dropped = 0;            // 队列满丢掉 / 拒收的
+        uint64_t failed = 0;             // 未连接或 publish 异常
+        uint64_t yielded = 0;            // 因高优先级通道忙而等待的次数
+        double yieldMs = 0.0;            // 累计让路时长
+        size_t queueDepth = 0;
+        size_t queueBytes = 0;
+        size_t queueHigh = 0;            // 统计周期内的队列峰值
+    };
+
+    explicit MqttChannel(const ChannelConfig& config);
+    virtual ~MqttChannel();
+    MqttChannel(const MqttChannel&) = delete;
+    MqttChannel& operator=(const MqttChannel&) = delete;
+
+    // 重新建连 (已有连接先断开)。callback 为空时用通道自己的日志回调；
+    // 控制通道传 MqttClientManager，由它订阅 car/status 并处理上行报文。发起连接就抛异常时返回 false
+    bool connect(const std::string& url, const std::string& clientIdBase, mqtt::callback* callback = nullptr,
+                 std::string* error = nullptr);
+    void disconnect();
+    bool isConnected();
+    void subscribe(const std::string& topic, int qos);
+
+    // 在调用线程直接发布 (低优先级通道会先让路)；未连接或异常返回空 token
+    mqtt::delivery_token_ptr publish(const std::string& topic, const void* data, size_t len, int qos);
+    // 排进发送队列，由通道线程按限速发出；通道没开队列或满了 (拒收模式) 返回 false
+    bool post(const std::string& topic, const void* data, size_t len);
+
+    // 设定要让路的高优先级通道
+    void yieldTo(MqttChannel* higher) { m_higher = higher; }
+    // 有报文正在发布或还积压在 Paho 发送队列里
+    bool busy();
+
+    const ChannelConfig& config() const { return m_config; }
+    Stats stats();
+    void dumpStats(double elapsedSec);
+    void resetStats();
+
+protected:
+    void connected(const mqtt::string& cause) override;
+    void connection_lost(const mqtt::string& cause) override;
+
+private:
+    void waitForHigher();
+    void sendLoop();
+
+    struct Item {
+        uint64_t seq = 0;
+        std::string topic;
+        std::string payload;
+    };
+
+    ChannelConfig m_config;
+    MqttChannel* m_higher = nullptr;
+
+    std::mutex m_clientMutex;            // 保护 m_client，publish / connect / disconnect 都要拿
+    mqtt::async_client* m_client = nullptr;
+    std::atomic<int> m_publishing{0};
+
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCond;
+    std::deque<Item> m_queue;
+    size_t m_queueBytes = 0;
+    uint64_t m_nextSeq = 0;
+    std::thread m_sendThread;
+    bool m_running = false;
+    Stats m_stats;                       // m_queueMutex 保护
+};
+
+#endif // MQTTCHANNEL_H
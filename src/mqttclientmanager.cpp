@@ -1,106 +1,466 @@
 #include "mqttclientmanager.h"
 #include <QDebug>
+#include <QCoreApplication>
+#include "telemetrystore.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 MqttClientManager::MqttClientManager(QObject *parent) : QObject{parent} {
-    // 初始化时给一个占位符地址，防止新版 Paho MQTT 库禁用空参数构造
-    m_client = new mqtt::async_client("tcp://127.0.0.1:1883", "InitialClient");
-    m_client->set_callback(*this); // 提前绑定好回调接口
+    // 三类流量各一条连接：控制直发不排队；遥测由发件箱补发线程驱动，QoS 1、在途窗口 1 条；
+    // 大块数据有界队列 + 限速 (CAR_HMI_BULK_BPS，默认 256KB/s，给 Wi-Fi 上行留余量)，满了丢最老的
+    ChannelConfig controlConfig;
+    controlConfig.cls = ChannelClass::Control;
+    controlConfig.name = "控制";
+    m_control = new MqttChannel(controlConfig);
+
+    ChannelConfig telemetryConfig;
+    telemetryConfig.cls = ChannelClass::Telemetry;
+    telemetryConfig.name = "遥测";
+    telemetryConfig.clientIdSuffix = "_telemetry";
+    telemetryConfig.qos = 1;
+    telemetryConfig.maxInflight = 1;
+    telemetryConfig.keepAliveSec = 15;
+    m_telemetry = new MqttChannel(telemetryConfig);
+    m_telemetry->yieldTo(m_control);
+
+    ChannelConfig bulkConfig;
+    bulkConfig.cls = ChannelClass::Bulk;
+    bulkConfig.name = "大块";
+    bulkConfig.clientIdSuffix = "_bulk";
+    bulkConfig.maxInflight = 4;
+    bulkConfig.keepAliveSec = 15;
+    bulkConfig.maxQueue = 32;
+    bulkConfig.maxQueueBytes = 2 * 1024 * 1024;
+    bulkConfig.bytesPerSec = 256 * 1024;
+    const char* bulkBps = getenv("CAR_HMI_BULK_BPS");
+    if (bulkBps && atof(bulkBps) > 0) bulkConfig.bytesPerSec = atof(bulkBps);
+    m_bulk = new MqttChannel(bulkConfig);
+    m_bulk->yieldTo(m_control);
+
+    // 旧固件不认 v2 帧头，需要时延数据时再打开；可选 CAR_HMI_TRACE_TIMEOUT_MS 调丢失判定时长
+    m_traceEnabled = getenv("CAR_HMI_TRACE") != nullptr;
+    const char* traceTimeout = getenv("CAR_HMI_TRACE_TIMEOUT_MS");
+    if (traceTimeout && atof(traceTimeout) > 0) m_latency.setLossTimeoutMs(atof(traceTimeout));
+    if (m_traceEnabled) {
+        qDebug() << ">>> 指令时延追踪已开启：下行使用 v2 帧头，等待下位机 CMD_ECHO 回显";
+    }
+
+    // 打击通道直连下位机 UDP 端口 (地址与 broker 相同)，MQTT 只保留控制指令、回显和遥测
+    const char* firePort = getenv("CAR_HMI_FIRE_UDP");
+    if (firePort && atoi(firePort) > 0) m_fireUdpPort = atoi(firePort);
+    const char* fireCopies = getenv("CAR_HMI_FIRE_UDP_COPIES");
+    if (fireCopies && atoi(fireCopies) > 0) m_fireLink.setCopies(atoi(fireCopies));
+
+    m_batchStatsTime = std::chrono::steady_clock::now();
+    m_batchRunning = true;
+    m_batchThread = std::thread(&MqttClientManager::batchPublishLoop, this);
+
+    const char* hz = getenv("CAR_HMI_TELEOP_HZ");
+    if (hz && atoi(hz) > 0) m_teleopHz = std::min(500, atoi(hz));
+    m_teleopRunning = true;
+    m_teleopThread = std::thread(&MqttClientManager::teleopLoop, this);
+
+    // 发件箱默认放在程序目录，CAR_HMI_OUTBOX 可改路径 (比如挂到 U 盘)，
+    // CAR_HMI_OUTBOX_KB / CAR_HMI_OUTBOX_MAX_AGE (秒) 调容量和过期时长
+    OutboxConfig outboxConfig;
+    const char* outboxPath = getenv("CAR_HMI_OUTBOX");
+    outboxConfig.path = outboxPath ? std::string(outboxPath)
+                                   : (QCoreApplication::applicationDirPath() + "/outbox.ring").toStdString();
+    const char* outboxKb = getenv("CAR_HMI_OUTBOX_KB");
+    if (outboxKb && atoi(outboxKb) > 0) outboxConfig.bytes = (size_t)atoi(outboxKb) * 1024;
+    const char* outboxAge = getenv("CAR_HMI_OUTBOX_MAX_AGE");
+    if (outboxAge && atof(outboxAge) > 0) outboxConfig.maxAgeSec = atof(outboxAge);
+    const char* drainRate = getenv("CAR_HMI_OUTBOX_RATE");
+    if (drainRate && atof(drainRate) > 0) m_drainMsgRate = atof(drainRate);
+    const char* drainBps = getenv("CAR_HMI_OUTBOX_BPS");
+    if (drainBps && atof(drainBps) > 0) m_drainByteRate = atof(drainBps);
+    if (m_outbox.open(outboxConfig)) {
+        m_drainRunning = true;
+        m_drainThread = std::thread(&MqttClientManager::outboxDrainLoop, this);
+    } else {
+        qDebug() << "【警告】发件箱不可用，断网期间的检测记录 / 遥测将直接丢弃";
+    }
 }
 
 MqttClientManager::~MqttClientManager() {
-    // 析构函数，先安全断开连接再删除客户端实例
-    if (m_client) {
-        // 增加 is_connected() 校验，防止对未连接的客户端强行断开引发异常
-        if (m_client->is_connected()) {
-            try {
-                m_client->disconnect()->wait();
-            } catch (...) {} // 析构函数中忽略异常，防止程序崩溃退出
-        }
-        delete m_client;
+    // 先停发布线程，再断开连接，避免线程还在用通道
+    {
+        std::lock_guard<std::mutex> lock(m_batchMutex);
+        m_batchRunning = false;
     }
+    m_batchCond.notify_all();
+    if (m_batchThread.joinable()) m_batchThread.join();
+    {
+        std::lock_guard<std::mutex> lock(m_moveMutex);
+        m_teleopRunning = false;
+    }
+    m_moveCond.notify_all();
+    if (m_teleopThread.joinable()) m_teleopThread.join();
+    {
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        m_drainRunning = false;
+    }
+    m_drainCond.notify_all();
+    if (m_drainThread.joinable()) m_drainThread.join();
+
+    // 各通道析构时自己停发送线程、安全断开并删除客户端实例
+    delete m_bulk;
+    delete m_telemetry;
+    delete m_control;
 }
 
 void MqttClientManager::connectToBroker(const QString &ip, int port){
     // 构建 MQTT Broker URL = tcp://[IP地址]:[端口号]
     std::string brokerUrl = QString("tcp://%1:%2").arg(ip).arg(port).toStdString();
     
-    // 如果已有客户端实例，先安全断开连接并删除
-    if(m_client) {
-        if (m_client->is_connected()) {
-            try {
-                m_client->disconnect()->wait();
-            } catch (...) {}
-        }
-        delete m_client;
+    // 每条通道各自新建客户端实例，启用自动重连和心跳机制；控制通道的回调绑定到本类
+    qDebug() << ">>> 正在尝试连接 MQTT Broker:" << QString::fromStdString(brokerUrl);
+    std::string error;
+    if (!m_control->connect(brokerUrl, "OrangePi5_HMI_Main", this, &error)) {
+        // 连接失败，发出连接状态改变信号，携带错误信息
+        emit connectionStatusChanged(false, QString::fromStdString(error));
     }
+    m_telemetry->connect(brokerUrl, "OrangePi5_HMI_Main");
+    m_bulk->connect(brokerUrl, "OrangePi5_HMI_Main");
+    if (m_fireUdpPort > 0) m_fireLink.open(ip.toStdString(), m_fireUdpPort);
+}
 
-    // 创建新的 MQTT 客户端实例
-    m_client = new mqtt::async_client(brokerUrl, "OrangePi5_HMI_Main");
-    m_client->set_callback(*this); // 绑定回调接口
+void MqttClientManager::disconnectFromBroker(){
+    // 主动断开时清掉遥控指令，重连后不会按断开前的速度继续开
+    {
+        std::lock_guard<std::mutex> lock(m_moveMutex);
+        m_moveDesired = MovePayload{0.f, 0.f, 0.f};
+    }
+    m_control->disconnect();
+    m_telemetry->disconnect();
+    m_bulk->disconnect();
+    m_fireLink.close();
+}
 
-    // 配置连接选项，启用自动重连和心跳机制
-    m_connOpts = mqtt::connect_options_builder()
-        .clean_session(true)
-        .keep_alive_interval(std::chrono::seconds(5))
-        .automatic_reconnect(true)
-        .finalize();
-    
-    try{
-        qDebug() << ">>> 正在尝试连接 MQTT Broker:" << QString::fromStdString(brokerUrl);
-        m_client->connect(m_connOpts);
-    } catch (const mqtt::exception& exc) {
-        // 连接失败，发出连接状态改变信号，携带错误信息
-        emit connectionStatusChanged(false, QString::fromStdString(exc.what()));
+template<int C>
+bool MqttClientManager::publishPacket(const typename proto::Message<C>::Value& value, const char* what){
+    // 打击类指令走 UDP 直连：一律 v2 帧头 (接收端靠序号取最新)，未追踪时序号由打击通道分配
+    if ((C == CMD_MOVE || C == CMD_TARGET) && m_fireLink.isOpen()) {
+        proto::Trace trace;
+        if (m_traceEnabled) m_latency.stamp((uint8_t)C, trace);
+        auto packet = proto::pack<C>(value, &trace);
+        return m_fireLink.send(packet.bytes, packet.size, m_traceEnabled ? &trace : nullptr);
     }
+    if (!m_control->isConnected()) return false;
+
+    // 帧头 + 载荷编码在栈上，逐字段小端写出，不再经过 QByteArray
+    proto::Trace trace;
+    if (m_traceEnabled) m_latency.stamp((uint8_t)C, trace);
+    auto packet = proto::pack<C>(value, m_traceEnabled ? &trace : nullptr);
+
+    // 推荐加上 QoS (0) 和 retained (false)
+    if (!m_control->publish(TOPIC_CMD, packet.data(), packet.size, 0)) {
+        qDebug() << ">>> 发送" << what << "失败";
+        return false;
+    }
+    return true;
 }
 
-void MqttClientManager::disconnectFromBroker(){
-    if (m_client && m_client->is_connected()) {
-        try {
-            m_client->disconnect()->wait();
-        } catch (const mqtt::exception& exc) {
-            qDebug() << ">>> 断开 MQTT 连接时异常:" << exc.what();
+static bool sameMove(const MovePayload& a, const MovePayload& b)
+{
+    return a.vx == b.vx && a.vy == b.vy && a.vz == b.vz;
+}
+
+void MqttClientManager::setMoveCommand(float vx, float vy, float vz){
+    MovePayload payload = {vx, vy, vz};
+    {
+        std::lock_guard<std::mutex> lock(m_moveMutex);
+        m_moveWrites++;
+        if (sameMove(payload, m_moveDesired)) {
+            m_moveDeduped++;
+            return;
         }
+        m_moveDesired = payload;
     }
+    // 速度变了：叫醒发布线程立即发，不等下一个周期
+    m_moveCond.notify_one();
 }
 
-void MqttClientManager::sendMove(float vx, float vy, float vz){
-    if (!m_client || !m_client->is_connected()) return;
-    
-    MovePayload payload = {vx, vy, vz}; 
-    FrameHeader head = {0x5A, CMD_MOVE, sizeof(MovePayload)};
+void MqttClientManager::teleopLoop(){
+    typedef std::chrono::steady_clock Clock;
+    const auto period = std::chrono::microseconds(1000000 / m_teleopHz);
+    auto nextTick = Clock::now() + period;
+    auto statsTime = Clock::now();
 
-    QByteArray packet;
-    packet.append((const char*)&head, sizeof(FrameHeader));
-    packet.append((const char*)&payload, sizeof(MovePayload));
+    MovePayload last = {0.f, 0.f, 0.f};
+    bool haveLast = false;
+    int stopRepeats = 0;
 
-    // 推荐加上 QoS (0) 和 retained (false)
-    try {
-        m_client->publish(TOPIC_CMD, packet.data(), packet.size(), 0, false);
-    } catch (...) {
-        qDebug() << ">>> 发送移动指令失败";
+    while (true) {
+        MovePayload cmd;
+        bool changed = false;
+        {
+            std::unique_lock<std::mutex> lock(m_moveMutex);
+            m_moveCond.wait_until(lock, nextTick, [&]() {
+                return !m_teleopRunning || m_moveResync || !haveLast || !sameMove(m_moveDesired, last);
+            });
+            if (!m_teleopRunning) break;
+            cmd = m_moveDesired;
+            changed = m_moveResync || !haveLast || !sameMove(cmd, last);
+            m_moveResync = false;
+        }
+
+        auto now = Clock::now();
+        bool due = now >= nextTick;
+        if (due) {
+            nextTick += period;
+            // 线程被耽搁了好几个周期时不补发，直接对齐到下一个周期
+            if (nextTick <= now) nextTick = now + period;
+        }
+
+        bool stopped = cmd.vx == 0.f && cmd.vy == 0.f && cmd.vz == 0.f;
+        if (changed) stopRepeats = 0;
+        // 行驶中每个周期都发 (下位机据此做超时刹车)，停车后只补发几次
+        bool send = changed || (due && (!stopped || stopRepeats < kStopRepeats));
+        if (send) {
+            bool ok = publishPacket<CMD_MOVE>(cmd, "移动指令");
+            if (stopped && !changed) stopRepeats++;
+            // 未连接时发送失败也记为已处理，否则会一直被当作新值空转；重连后由 m_moveResync 补发
+            last = cmd;
+            haveLast = true;
+            std::lock_guard<std::mutex> lock(m_moveMutex);
+            if (!ok) m_moveFailed++;
+            else if (changed) m_moveImmediate++;
+            else m_movePeriodic++;
+        }
+
+        double elapsed = std::chrono::duration<double>(now - statsTime).count();
+        if (elapsed >= 10.0) {
+            // 三条通道的收发统计跟着遥控统计一起输出
+            for (MqttChannel* channel : {m_control, m_telemetry, m_bulk}) {
+                channel->dumpStats(elapsed);
+                channel->resetStats();
+            }
+            m_fireLink.dumpStats(elapsed);
+            m_fireLink.resetStats();
+            std::lock_guard<std::mutex> lock(m_moveMutex);
+            qDebug() << ">>> [遥控指令]" << m_teleopHz << "Hz | 写入" << m_moveWrites
+                     << "| 去重" << m_moveDeduped << "| 立即发送" << m_moveImmediate
+                     << "| 周期重发" << m_movePeriodic << "| 失败" << m_moveFailed;
+            m_moveWrites = m_moveDeduped = m_moveImmediate = m_movePeriodic = m_moveFailed = 0;
+            statsTime = now;
+            // 往返时延统计跟着遥控统计一起输出
+            if (m_traceEnabled) {
+                m_latency.dumpStats();
+                m_latency.resetStats();
+            }
+        }
     }
 }
 
 void MqttClientManager::sendControl(bool led, bool buzzer, int mode){
-    if (!m_client || !m_client->is_connected()) return;
-    
     ControlPayload payload;
     payload.mode = (uint8_t)mode;
     payload.led_switch = led ? 1 : 0;
     payload.buzzer_switch = buzzer ? 1 : 0;
     payload.padding = 0;
+    publishPacket<CMD_CONTROL>(payload, "控制指令");
+}
 
-    FrameHeader head = {0x5A, CMD_CONTROL, sizeof(ControlPayload)};
+void MqttClientManager::sendTarget(const TargetPayload& target){
+    publishPacket<CMD_TARGET>(target, "目标坐标");
+}
 
-    QByteArray packet;
-    packet.append((const char*)&head, sizeof(FrameHeader));
-    packet.append((const char*)&payload, sizeof(ControlPayload));
+void MqttClientManager::sendTargetBatch(const TargetBatchHeader& head, const TargetEntry* entries, int count){
+    bool udp = m_fireLink.isOpen();
+    if (!m_control->isConnected() && !udp) return;
 
-    try {
-        m_client->publish(TOPIC_CMD, packet.data(), packet.size(), 0, false);
-    } catch (...) {
-        qDebug() << ">>> 发送控制指令失败";
+    {
+        std::lock_guard<std::mutex> lock(m_batchMutex);
+        BatchSlot& slot = m_batchSlots[head.cameraId % kBatchSlots];
+        // 追踪或走 UDP 时先按 v2 帧头占位，序号和发送时刻在真正发出时补写
+        proto::Trace placeholder;
+        size_t len = targetbatch::encode(head, entries, count, slot.buf, sizeof(slot.buf),
+                                         m_traceEnabled || udp ? &placeholder : nullptr);
+        if (len == 0) return;
+        if (slot.pending) m_batchCoalesced++;
+        slot.len = len;
+        slot.pending = true;
+        m_batchQueued++;
+    }
+    m_batchCond.notify_one();
+}
+
+void MqttClientManager::batchPublishLoop(){
+    uint8_t packet[targetbatch::MAX_PACKET];
+
+    while (true) {
+        size_t len = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_batchMutex);
+            m_batchCond.wait(lock, [this]() {
+                if (!m_batchRunning) return true;
+                for (const auto& slot : m_batchSlots) {
+                    if (slot.pending) return true;
+                }
+                return false;
+            });
+            if (!m_batchRunning) break;
+
+            for (int i = 0; i < kBatchSlots; ++i) {
+                BatchSlot& slot = m_batchSlots[(m_batchNext + i) % kBatchSlots];
+                if (!slot.pending) continue;
+                memcpy(packet, slot.buf, slot.len);
+                len = slot.len;
+                slot.pending = false;
+                m_batchNext = (m_batchNext + i + 1) % kBatchSlots;
+                break;
+            }
+        }
+        if (len == 0) continue;
+        proto::Trace trace;
+        if (m_traceEnabled) {
+            m_latency.stamp(CMD_TARGET_BATCH, trace);
+            proto::restamp(packet, trace);
+        }
+
+        // 拷出槽之后再发，publish 阻塞 (Paho 发送缓冲满) 期间新帧照样能写进槽里覆盖。
+        // UDP 打开之前入槽的 v1 报文还走 MQTT
+        bool sent = false;
+        if (packet[0] == FRAME_MAGIC_V2 && m_fireLink.isOpen()) {
+            sent = m_fireLink.send(packet, len, m_traceEnabled ? &trace : nullptr);
+        } else {
+            sent = m_control->publish(TOPIC_CMD, packet, len, 0) != nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(m_batchMutex);
+        if (sent) m_batchSent++;
+        else m_batchFailed++;
+
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - m_batchStatsTime).count();
+        if (elapsed >= 10.0) {
+            qDebug() << ">>> [批量目标] 入槽" << m_batchQueued << "| 发出" << m_batchSent
+                     << "(" << m_batchSent / elapsed << "帧/秒 )"
+                     << "| 覆盖" << m_batchCoalesced << "| 失败" << m_batchFailed;
+            m_batchQueued = m_batchSent = m_batchCoalesced = m_batchFailed = 0;
+            m_batchStatsTime = now;
+        }
+    }
+}
+
+void MqttClientManager::publishStored(OutboxClass cls, const std::string& topic, const void* data, size_t len){
+    if (!m_outbox.push(cls, topic, data, len)) {
+        qDebug() << "【警告】发件箱写入失败 (未打开或单条过大):" << QString::fromStdString(topic) << (int)len << "字节";
+        return;
+    }
+    // 过一下锁再通知，保证补发线程不会在检查完条件、还没睡下时错过这次唤醒
+    { std::lock_guard<std::mutex> lock(m_drainMutex); }
+    m_drainCond.notify_one();
+}
+
+bool MqttClientManager::publishBulk(const std::string& topic, const void* data, size_t len){
+    return m_bulk->post(topic, data, len);
+}
+
+double MqttClientManager::outboxDrainRate(){
+    std::lock_guard<std::mutex> lock(m_drainMutex);
+    return m_drainLastRate;
+}
+
+void MqttClientManager::outboxDrainLoop(){
+    typedef std::chrono::steady_clock Clock;
+    static const char* kClassNames[Outbox::kClasses] = {"检测", "遥测", "汇总"};
+    const auto ackTimeout = std::chrono::milliseconds(2000);
+    std::vector<uint8_t> buf(m_outbox.maxRecordSize());
+
+    // 令牌桶：条数桶容量 1 (均匀间隔发出，不攒突发)，字节桶容量 1 秒的量
+    double msgTokens = 1.0;
+    double byteTokens = m_drainByteRate;
+    auto refillTime = Clock::now();
+    auto statsTime = Clock::now();
+    int backoffMs = 0;
+
+    while (true) {
+        std::chrono::milliseconds sleepFor(0);
+        bool ready = false;
+        {
+            std::unique_lock<std::mutex> lock(m_drainMutex);
+            m_drainCond.wait_for(lock, std::chrono::seconds(1), [this]() {
+                return !m_drainRunning || !m_outbox.empty();
+            });
+            if (!m_drainRunning) break;
+        }
+        // 遥测通道断开时半秒看一次，重连由 Paho 自动完成
+        ready = m_telemetry->isConnected();
+        if (!ready) sleepFor = std::chrono::milliseconds(500);
+
+        auto now = Clock::now();
+        double dt = std::chrono::duration<double>(now - refillTime).count();
+        refillTime = now;
+        msgTokens = std::min(1.0, msgTokens + dt * m_drainMsgRate);
+        byteTokens = std::min(m_drainByteRate, byteTokens + dt * m_drainByteRate);
+
+        Outbox::Record rec;
+        if (ready && m_outbox.peek(rec, buf.data(), buf.size())) {
+            // 字节桶容量比单条小时按满桶放行，否则大记录永远发不出去
+            double needBytes = std::min((double)rec.len, m_drainByteRate);
+            if (msgTokens < 1.0 || byteTokens < needBytes) {
+                double waitSec = std::max((1.0 - msgTokens) / m_drainMsgRate, (needBytes - byteTokens) / m_drainByteRate);
+                sleepFor = std::chrono::milliseconds((int)(waitSec * 1000) + 1);
+            } else {
+                // 遥测通道先给控制通道让路再发；等 broker 的 PUBACK 时不占任何锁
+                mqtt::delivery_token_ptr token = m_telemetry->publish(rec.topic, buf.data(), rec.len, 1);
+                bool acked = false;
+                try {
+                    acked = token && token->wait_for(ackTimeout);
+                } catch (...) {}
+
+                msgTokens -= 1.0;
+                byteTokens -= needBytes;
+                std::lock_guard<std::mutex> lock(m_drainMutex);
+                if (acked) {
+                    // 确认后才出队；确认前断线的会在重连后再发一次 (至少一次，接收端按 seq / 时间去重)
+                    m_outbox.pop(rec.cls, rec.seq);
+                    m_drainSent++;
+                    m_drainSentBytes += rec.len;
+                    backoffMs = 0;
+                } else {
+                    m_drainFailed++;
+                    backoffMs = std::min(5000, std::max(250, backoffMs * 2));
+                    sleepFor = std::chrono::milliseconds(backoffMs);
+                }
+            }
+        }
+
+        double elapsed = std::chrono::duration<double>(now - statsTime).count();
+        if (elapsed >= 10.0) {
+            std::lock_guard<std::mutex> lock(m_drainMutex);
+            m_drainLastRate = m_drainSent / elapsed;
+            bool any = m_drainSent || m_drainFailed;
+            Outbox::ClassStats st[Outbox::kClasses];
+            for (int c = 0; c < Outbox::kClasses; ++c) {
+                st[c] = m_outbox.stats((OutboxClass)c);
+                any = any || st[c].count || st[c].pushed || st[c].droppedOverflow || st[c].droppedAge;
+            }
+            if (any) {
+                qDebug() << ">>> [发件箱] 补发" << m_drainSent << "条 (" << m_drainLastRate << "条/秒,"
+                         << m_drainSentBytes / elapsed / 1024.0 << "KB/秒 ) | 失败" << m_drainFailed
+                         << "| 链路" << (m_telemetry->isConnected() ? "已连接" : "断开");
+                for (int c = 0; c < Outbox::kClasses; ++c) {
+                    qDebug() << "    " << kClassNames[c] << "| 积压" << st[c].count << "条"
+                             << (int)(st[c].bytes / 1024) << "/" << (int)(st[c].capacity / 1024) << "KB"
+                             << "| 最老" << st[c].oldestAgeSec << "秒 | 入队" << st[c].pushed
+                             << "| 出队" << st[c].drained << "| 挤掉" << st[c].droppedOverflow
+                             << "| 过期" << st[c].droppedAge;
+                }
+            }
+            m_outbox.resetCounters();
+            m_drainSent = m_drainSentBytes = m_drainFailed = 0;
+            statsTime = now;
+        }
+
+        if (sleepFor.count() > 0) {
+            std::unique_lock<std::mutex> lock(m_drainMutex);
+            m_drainCond.wait_for(lock, sleepFor, [this]() { return !m_drainRunning; });
+        }
     }
 }
 
@@ -117,12 +477,15 @@ void MqttClientManager::connected(const mqtt::string& cause){
         qDebug() << ">>> MQTT 自动重连成功，原因:" << statusMsg;
     }
 
-    // 连接成功后，务必订阅主题
-    try {
-        m_client->subscribe(TOPIC_STATUS, 1);
-    } catch (const mqtt::exception& exc) {
-        qDebug() << ">>> 订阅主题失败:" << exc.what();
+    // 重连后立即把当前遥控指令发一遍，不等下一个变化
+    {
+        std::lock_guard<std::mutex> lock(m_moveMutex);
+        m_moveResync = true;
     }
+    m_moveCond.notify_one();
+
+    // 连接成功后，务必订阅主题
+    m_control->subscribe(TOPIC_STATUS, 1);
 
     // 通知 MainWindow 更新 UI
     emit connectionStatusChanged(true, statusMsg);
@@ -133,25 +496,26 @@ void MqttClientManager::connection_lost(const mqtt::string& cause){
     emit connectionStatusChanged(false, QString::fromStdString(cause));
 }
 
+void MqttClientManager::InboundHandler::handle(const ControlPayload& status){
+    TelemetryStore::instance().updateControl(status);
+}
+
+void MqttClientManager::InboundHandler::handle(const EchoPayload& echo){
+    owner->m_latency.onEcho(echo);
+}
+
 void MqttClientManager::message_arrived(mqtt::const_message_ptr msg){
-    // 获取原始内存指针和长度，防止 \x00 截断
+    // 直接在 Paho 的缓冲区上校验、解码，不再拷贝成 QByteArray
     const std::string& raw_payload = msg->get_payload();
-    QByteArray data(raw_payload.data(), raw_payload.length());
-    
-    // 如果需要调试，可以打开下面这行查看二进制 Hex 数据
-    // qDebug() << ">>> 收到 MQTT 原始二进制消息 (Hex):" << data.toHex();
-    
-    if (data.size() < (int)sizeof(FrameHeader)) return;
-
-    FrameHeader* header = reinterpret_cast<FrameHeader*>(data.data());
-    
-    // 校验包头 0x5A
-    if (header->header != 0x5A) return; 
 
-    // 防止越界读取崩溃
-    if (data.size() < (int)(sizeof(FrameHeader) + header->len)) return;
+    InboundHandler handler = {this};
+    proto::Status st = proto::dispatch((const uint8_t*)raw_payload.data(), raw_payload.size(), handler);
+    if (st == proto::Status::Ok) return;
 
-    // 提取载荷并发出信号给 MainWindow 处理
-    QByteArray payload_data = data.mid(sizeof(FrameHeader), header->len);
-    emit dataReceived(header->type, payload_data);
-}
\ No newline at end of file
+    // 坏包按类型计数，第 1、2、4、8... 次时打印，避免刷屏
+    uint64_t n = ++m_rxErrors[(int)st];
+    if ((n & (n - 1)) == 0) {
+        qDebug() << "【警告】丢弃上行报文:" << proto::statusName(st) << "长度" << (int)raw_payload.size()
+                 << "累计" << (unsigned long long)n << "次";
+    }
+}
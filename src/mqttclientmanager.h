@@ -3,7 +3,17 @@
 
 #include <QObject>
 #include <mqtt/async_client.h> // vcpkg 安装的 Paho 核心库
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "protocol_def.h"
+#include "targetbatch.h"
+#include "protocolcodec.h"
+#include "latencytracker.h"
+#include "outbox.h"
+#include "mqttchannel.h"
+#include "udpfirelink.h"
 
 // 继承 mqtt::callback 以处理连接丢失和消息到达事件
 class MqttClientManager : public QObject, public virtual mqtt::callback 
@@ -18,14 +28,29 @@ public:
     void disconnectFromBroker();
 
     // 业务发送接口：内部封装 publish 逻辑
-    void sendMove(float vx, float vy, float vz);
+    // 移动指令只写进最新值槽位就返回，由遥控发布线程按固定频率 (默认 50Hz) 发出：
+    // 速度变化立即发送，不变时每个周期重发一次 (丢一包松开指令最多多走一个周期)，
+    // 停车状态重发 kStopRepeats 次后不再重复，连续写入相同速度只算一次
+    void setMoveCommand(float vx, float vy, float vz);
     void sendControl(bool led, bool buzzer, int mode);
+    void sendTarget(const TargetPayload& target);
+    // 一帧的全部目标打成一条 CMD_TARGET_BATCH，QoS 0。
+    // 只写进该摄像头的发送槽就返回，由发布线程发出；上一帧还没发走时直接覆盖 (最新者胜)，
+    // 链路慢时丢的是过期的帧，而不是在 Paho 队列里越排越晚
+    void sendTargetBatch(const TargetBatchHeader& head, const TargetEntry* entries, int count);
+
+    // 非控制类报文 (检测记录 / 遥测 / 作业汇总) 走断网暂存发件箱：不管当前是否连着都先落盘，
+    // 由补发线程在连上后按优先级、限速逐条以 QoS 1 发出，broker 确认后才出队
+    void publishStored(OutboxClass cls, const std::string& topic, const void* data, size_t len);
+    Outbox::ClassStats outboxStats(OutboxClass cls) { return m_outbox.stats(cls); }
+    // 最近一个统计周期的补发速率 (条/秒)
+    double outboxDrainRate();
+    // 大块数据 (预览图、检测流等) 走独立的大块通道：有界队列、限速发送，给控制通道让路
+    bool publishBulk(const std::string& topic, const void* data, size_t len);
 
 signals:
     // 连接状态改变信号，用于更新 MainWindow 的连接按钮颜色
     void connectionStatusChanged(bool connected, const QString &message);
-    // 收到小车回传数据信号
-    void dataReceived(uint8_t type, const QByteArray &payload);
 
 protected:
     // Paho MQTT 库的回调重写
@@ -34,11 +59,88 @@ protected:
     void message_arrived(mqtt::const_message_ptr msg) override;
 
 private:
-    mqtt::async_client* m_client = nullptr;
-    mqtt::connect_options m_connOpts;
+    void batchPublishLoop();
+    void teleopLoop();
+    void outboxDrainLoop();
+    // 定长指令：栈上编码后直接发布，未连接或发送异常返回 false
+    template<int C>
+    bool publishPacket(const typename proto::Message<C>::Value& value, const char* what);
+
+    // 上行报文的分发处理器 (proto::dispatch 按类型查表调用对应 handle)，
+    // 在 Paho 回调线程里直接写 TelemetryStore，UI 自己轮询
+    struct InboundHandler {
+        MqttClientManager* owner;
+        void handle(const ControlPayload& status);
+        void handle(const EchoPayload& echo);
+    };
+    uint64_t m_rxErrors[proto::kStatusCount] = {0};   // 仅 Paho 回调线程访问
+
+    // 控制 / 遥测 / 大块三条独立连接 (见 mqttchannel.h)，控制通道的回调由本类处理
+    MqttChannel* m_control = nullptr;
+    MqttChannel* m_telemetry = nullptr;
+    MqttChannel* m_bulk = nullptr;
+
+    // UDP 直连打击通道 (CAR_HMI_FIRE_UDP)：打开后移动 / 目标 / 批量目标不再经过 broker
+    UdpFireLink m_fireLink;
+    int m_fireUdpPort = 0;
+
+    // 时延追踪 (CAR_HMI_TRACE)：下行报文改用 v2 帧头并要求回显，按指令类型统计往返时延和丢失
+    bool m_traceEnabled = false;
+    LatencyTracker m_latency;
     
     // 主题定义
     const std::string TOPIC_CMD    = "car/cmd";    // 发送
     const std::string TOPIC_STATUS = "car/status"; // 接收
+
+    // 批量目标发送槽：按摄像头编号分槽，多路之间互不覆盖；报文直接编码在槽里，不做堆分配
+    struct BatchSlot {
+        uint8_t buf[targetbatch::MAX_PACKET];
+        size_t len = 0;
+        bool pending = false;
+    };
+    static const int kBatchSlots = 4;
+    BatchSlot m_batchSlots[kBatchSlots];
+    int m_batchNext = 0;                 // 轮询起点，防止某一路一直抢先
+    std::mutex m_batchMutex;
+    std::condition_variable m_batchCond;
+    std::thread m_batchThread;
+    bool m_batchRunning = false;
+    // 统计 (m_batchMutex 保护)
+    uint64_t m_batchQueued = 0;
+    uint64_t m_batchSent = 0;
+    uint64_t m_batchCoalesced = 0;       // 还没发出就被下一帧覆盖的批次
+    uint64_t m_batchFailed = 0;
+    std::chrono::steady_clock::time_point m_batchStatsTime;
+
+    // 遥控移动指令：最新值槽位 + 固定频率发布线程
+    static const int kStopRepeats = 10;  // 停车指令重发的周期数，之后静默
+    MovePayload m_moveDesired = {0.f, 0.f, 0.f};
+    bool m_moveResync = false;           // 重连后把当前指令当作新值立即重发
+    int m_teleopHz = 50;
+    std::mutex m_moveMutex;
+    std::condition_variable m_moveCond;
+    std::thread m_teleopThread;
+    bool m_teleopRunning = false;
+    // 统计 (m_moveMutex 保护)
+    uint64_t m_moveWrites = 0;
+    uint64_t m_moveDeduped = 0;          // 与槽内当前值相同、没有触发发送的写入
+    uint64_t m_moveImmediate = 0;        // 速度变化后立即发出的
+    uint64_t m_movePeriodic = 0;         // 周期重发的
+    uint64_t m_moveFailed = 0;
+
+    // 断网暂存发件箱 + 补发线程。走遥测通道，补发限速 (条/秒、字节/秒 令牌桶) 且同一时刻只有一条在途，
+    // 每次发布前先给控制通道让路，等 broker 确认时不占锁，遥控 / 目标报文不会被饿住
+    Outbox m_outbox;
+    double m_drainMsgRate = 20.0;        // CAR_HMI_OUTBOX_RATE
+    double m_drainByteRate = 64 * 1024;  // CAR_HMI_OUTBOX_BPS
+    std::mutex m_drainMutex;
+    std::condition_variable m_drainCond;
+    std::thread m_drainThread;
+    bool m_drainRunning = false;
+    // 统计 (m_drainMutex 保护)
+    uint64_t m_drainSent = 0;
+    uint64_t m_drainSentBytes = 0;
+    uint64_t m_drainFailed = 0;
+    double m_drainLastRate = 0.0;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include "nv12letterbox.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define NV12_USE_NEON 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define NV12_USE_SSSE3 1
+#endif
+
+namespace nv12 {
+
+// 双线性插值权重精度：Q7 (0~128)，255*128 在 16 位内不溢出，方便 SIMD
+static const int WEIGHT_BITS = 7;
+static const int WEIGHT_ONE  = 1 << WEIGHT_BITS;
+
+// BT.601 limited range 系数，Q6 定点 (与 OpenCV COLOR_YUV2RGB_NV12 一致)
+static const int CY  = 75;   // 1.164
+static const int CRV = 102;  // 1.596
+static const int CGV = 52;   // 0.813
+static const int CGU = 25;   // 0.391
+static const int CBU = 129;  // 2.018
+
+// 水平方向采样表：每个目标列对应的源列下标和权重，同一尺寸只计算一次
+struct AxisTable {
+    int srcLen = 0;
+    int dstLen = 0;
+    std::vector<int> ofs;
+    std::vector<uint8_t> w;
+};
+
+// 与 OpenCV INTER_LINEAR 相同的像素中心对齐；chroma=true 时映射到半分辨率色度平面
+static void buildAxis(AxisTable& t, int srcLen, int dstLen, bool chroma)
+{
+    if (t.srcLen == srcLen && t.dstLen == dstLen && !t.ofs.empty()) return;
+    t.srcLen = srcLen;
+    t.dstLen = dstLen;
+    t.ofs.resize(dstLen);
+    t.w.resize(dstLen);
+
+    int len = chroma ? srcLen / 2 : srcLen;
+    double s = (double)srcLen / dstLen;
+    for (int d = 0; d < dstLen; ++d) {
+        double f = (d + 0.5) * s;
+        f = chroma ? f * 0.5 - 0.5 : f - 0.5;
+        if (f < 0) f = 0;
+        int i0 = (int)f;
+        double frac = f - i0;
+        if (i0 >= len - 1) { i0 = std::max(0, len - 2); frac = len > 1 ? 1.0 : 0.0; }
+        t.ofs[d] = i0;
+        t.w[d] = (uint8_t)std::lround(frac * WEIGHT_ONE);
+    }
+}
+
+static inline int sat16(int v)
+{
+    return std::min(32767, std::max(-32768, v));
+}
+
+static inline uint8_t lerp8(int a, int b, int w)
+{
+    return (uint8_t)((a * (WEIGHT_ONE - w) + b * w + (WEIGHT_ONE >> 1)) >> WEIGHT_BITS);
+}
+
+// ---------- 标量参考实现 ----------
+
+static void blendRowsScalar(const uint8_t* a, const uint8_t* b, uint8_t* out, int n, int w)
+{
+    for (int i = 0; i < n; ++i) out[i] = lerp8(a[i], b[i], w);
+}
+
+static void yuvToRgbScalar(const uint8_t* Y, const uint8_t* U, const uint8_t* V, uint8_t* rgb, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        int yy = (Y[i] - 16) * CY;
+        int du = U[i] - 128;
+        int dv = V[i] - 128;
+        int r = sat16(sat16(yy + CRV * dv) + 32) >> 6;
+        int g = sat16(yy - CGV * dv - CGU * du + 32) >> 6;
+        int b = sat16(sat16(yy + CBU * du) + 32) >> 6;
+        rgb[3 * i + 0] = (uint8_t)std::min(255, std::max(0, r));
+        rgb[3 * i + 1] = (uint8_t)std::min(255, std::max(0, g));
+        rgb[3 * i + 2] = (uint8_t)std::min(255, std::max(0, b));
+    }
+}
+
+// ---------- SIMD 实现 (结果与标量版逐位一致) ----------
+
+static void blendRowsSimd(const uint8_t* a, const uint8_t* b, uint8_t* out, int n, int w)
+{
+    int i = 0;
+#if defined(NV12_USE_NEON)
+    uint8x8_t wa = vdup_n_u8((uint8_t)(WEIGHT_ONE - w));
+    uint8x8_t wb = vdup_n_u8((uint8_t)w);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t va = vld1q_u8(a + i);
+        uint8x16_t vb = vld1q_u8(b + i);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+        vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, WEIGHT_BITS), vrshrn_n_u16(hi, WEIGHT_BITS)));
+    }
+#elif defined(NV12_USE_SSSE3)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wa = _mm_set1_epi16((short)(WEIGHT_ONE - w));
+    const __m128i wb = _mm_set1_epi16((short)w);
+    const __m128i half = _mm_set1_epi16(WEIGHT_ONE >> 1);
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, half), WEIGHT_BITS);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, half), WEIGHT_BITS);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    blendRowsScalar(a + i, b + i, out + i, n - i, w);
+}
+
+static void yuvToRgbSimd(const uint8_t* Y, const uint8_t* U, const uint8_t* V, uint8_t* rgb, int n)
+{
+    int i = 0;
+#if defined(NV12_USE_NEON)
+    const int16x8_t c16 = vdupq_n_s16(16);
+    const int16x8_t c128 = vdupq_n_s16(128);
+    const int16x8_t c32 = vdupq_n_s16(32);
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t yy = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(Y + i))), c16), CY);
+        int16x8_t du = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(U + i))), c128);
+        int16x8_t dv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(V + i))), c128);
+        int16x8_t r = vqaddq_s16(vqaddq_s16(yy, vmulq_n_s16(dv, CRV)), c32);
+        int16x8_t g = vqaddq_s16(vsubq_s16(vsubq_s16(yy, vmulq_n_s16(dv, CGV)), vmulq_n_s16(du, CGU)), c32);
+        int16x8_t b = vqaddq_s16(vqaddq_s16(yy, vmulq_n_s16(du, CBU)), c32);
+        uint8x8x3_t px;
+        px.val[0] = vqmovun_s16(vshrq_n_s16(r, 6));
+        px.val[1] = vqmovun_s16(vshrq_n_s16(g, 6));
+        px.val[2] = vqmovun_s16(vshrq_n_s16(b, 6));
+        vst3_u8(rgb + 3 * i, px);
+    }
+#elif defined(NV12_USE_SSSE3)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c16 = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c32 = _mm_set1_epi16(32);
+    const __m128i cy = _mm_set1_epi16(CY);
+    const __m128i crv = _mm_set1_epi16(CRV);
+    const __m128i cgv = _mm_set1_epi16(CGV);
+    const __m128i cgu = _mm_set1_epi16(CGU);
+    const __m128i cbu = _mm_set1_epi16(CBU);
+    // 把 [R0..R7 | G0..G7] 与 [B0..B7] 交织成 24 字节的 RGB
+    const __m128i m0rg = _mm_setr_epi8(0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5);
+    const __m128i m0b  = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i m1rg = _mm_setr_epi8(13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m1b  = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (; i + 8 <= n; i += 8) {
+        __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(Y + i)), zero);
+        __m128i du = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(U + i)), zero), c128);
+        __m128i dv = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(V + i)), zero), c128);
+        __m128i yy = _mm_mullo_epi16(_mm_sub_epi16(y, c16), cy);
+        __m128i r = _mm_adds_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(dv, crv)), c32);
+        __m128i g = _mm_adds_epi16(_mm_sub_epi16(_mm_sub_epi16(yy, _mm_mullo_epi16(dv, cgv)),
+                                                 _mm_mullo_epi16(du, cgu)), c32);
+        __m128i b = _mm_adds_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(du, cbu)), c32);
+        __m128i r8 = _mm_packus_epi16(_mm_srai_epi16(r, 6), zero);
+        __m128i g8 = _mm_packus_epi16(_mm_srai_epi16(g, 6), zero);
+        __m128i b8 = _mm_packus_epi16(_mm_srai_epi16(b, 6), zero);
+        __m128i rg = _mm_unpacklo_epi64(r8, g8);
+        __m128i out0 = _mm_or_si128(_mm_shuffle_epi8(rg, m0rg), _mm_shuffle_epi8(b8, m0b));
+        __m128i out1 = _mm_or_si128(_mm_shuffle_epi8(rg, m1rg), _mm_shuffle_epi8(b8, m1b));
+        _mm_storeu_si128((__m128i*)(rgb + 3 * i), out0);
+        _mm_storel_epi64((__m128i*)(rgb + 3 * i + 16), out1);
+    }
+#endif
+    yuvToRgbScalar(Y + i, U + i, V + i, rgb + 3 * i, n - i);
+}
+
+const char* simdName()
+{
+#if defined(NV12_USE_NEON)
+    return "NEON";
+#elif defined(NV12_USE_SSSE3)
+    return "SSSE3";
+#else
+    return "Scalar";
+#endif
+}
+
+LetterboxParams makeLetterbox(int srcW, int srcH, int dstW, int dstH, float* scaleOut)
+{
+    LetterboxParams p;
+    float scale = std::min((float)dstW / srcW, (float)dstH / srcH);
+    p.dstW = dstW;
+    p.dstH = dstH;
+    p.newW = (int)std::round(srcW * scale);
+    p.newH = (int)std::round(srcH * scale);
+    p.padLeft = (dstW - p.newW) / 2;
+    p.padTop = (dstH - p.newH) / 2;
+    if (scaleOut) *scaleOut = scale;
+    return p;
+}
+
+LetterboxParams makeLetterboxEven(int srcW, int srcH, int dstW, int dstH, float* scaleOut)
+{
+    LetterboxParams p = makeLetterbox(srcW, srcH, dstW, dstH, scaleOut);
+    p.newW &= ~1;
+    p.newH &= ~1;
+    p.padLeft = ((dstW - p.newW) / 2) & ~1;
+    p.padTop = ((dstH - p.newH) / 2) & ~1;
+    return p;
+}
+
+// 每个线程自己的行缓存，避免每帧 malloc
+struct RowScratch {
+    std::vector<uint8_t> vy, vuv, y, u, v;
+};
+
+static void processBand(const Nv12Frame& src, uint8_t* dst, const LetterboxParams& p,
+                        const AxisTable& xy, const AxisTable& xc, const AxisTable& yy, const AxisTable& yc,
+                        bool simd, int rowBegin, int rowEnd)
+{
+    thread_local RowScratch s;
+    s.vy.resize(src.width);
+    s.vuv.resize(src.width);
+    s.y.resize(p.newW);
+    s.u.resize(p.newW);
+    s.v.resize(p.newW);
+
+    const int rowBytes = p.dstW * 3;
+    const int uvBytes = src.width & ~1; // UV 交织行的有效字节数
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        uint8_t* out = dst + (size_t)row * rowBytes;
+        int r = row - p.padTop;
+        if (r < 0 || r >= p.newH) {
+            memset(out, p.padValue, rowBytes);
+            continue;
+        }
+        memset(out, p.padValue, p.padLeft * 3);
+        int right = p.padLeft + p.newW;
+        memset(out + right * 3, p.padValue, (p.dstW - right) * 3);
+
+        // 1. 垂直方向：两行源数据按权重混合 (连续内存，SIMD 友好)
+        const uint8_t* y0 = src.y + (size_t)yy.ofs[r] * src.yStride;
+        const uint8_t* uv0 = src.uv + (size_t)yc.ofs[r] * src.uvStride;
+        int wy = yy.w[r], wc = yc.w[r];
+        if (simd) {
+            blendRowsSimd(y0, y0 + src.yStride, s.vy.data(), src.width, wy);
+            blendRowsSimd(uv0, uv0 + src.uvStride, s.vuv.data(), uvBytes, wc);
+        } else {
+            blendRowsScalar(y0, y0 + src.yStride, s.vy.data(), src.width, wy);
+            blendRowsScalar(uv0, uv0 + src.uvStride, s.vuv.data(), uvBytes, wc);
+        }
+
+        // 2. 水平方向：查表取样，Y 与交织的 UV 分别插值
+        const uint8_t* vy = s.vy.data();
+        const uint8_t* vuv = s.vuv.data();
+        for (int i = 0; i < p.newW; ++i) {
+            int xo = xy.ofs[i];
+            s.y[i] = lerp8(vy[xo], vy[xo + 1], xy.w[i]);
+            int co = xc.ofs[i] * 2;
+            int cw = xc.w[i];
+            s.u[i] = lerp8(vuv[co], vuv[co + 2], cw);
+            s.v[i] = lerp8(vuv[co + 1], vuv[co + 3], cw);
+        }
+
+        // 3. YUV -> RGB，直接写进模型输入
+        uint8_t* px = out + p.padLeft * 3;
+        if (simd) yuvToRgbSimd(s.y.data(), s.u.data(), s.v.data(), px, p.newW);
+        else      yuvToRgbScalar(s.y.data(), s.u.data(), s.v.data(), px, p.newW);
+    }
+}
+
+void letterboxRGB(const Nv12Frame& src, uint8_t* dst, const LetterboxParams& params,
+                  KernelPath path, int bands)
+{
+    if (!src.y || !src.uv || !dst || src.width < 2 || src.height < 2) return;
+    if (params.newW <= 0 || params.newH <= 0) return;
+
+    // 采样表按尺寸缓存在调用线程里 (每个推理线程尺寸固定，只会算一次)
+    thread_local AxisTable xy, xc, yy, yc;
+    buildAxis(xy, src.width, params.newW, false);
+    buildAxis(xc, src.width, params.newW, true);
+    buildAxis(yy, src.height, params.newH, false);
+    buildAxis(yc, src.height, params.newH, true);
+
+    bool simd = (path == KernelPath::Simd);
+    if (bands <= 0) bands = std::max(1, std::min(cv::getNumThreads(), params.dstH / 32));
+    bands = std::min(bands, params.dstH);
+
+    if (bands == 1) {
+        processBand(src, dst, params, xy, xc, yy, yc, simd, 0, params.dstH);
+        return;
+    }
+
+    const AxisTable& txy = xy;
+    const AxisTable& txc = xc;
+    const AxisTable& tyy = yy;
+    const AxisTable& tyc = yc;
+    int rowsPerBand = (params.dstH + bands - 1) / bands;
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; ++b) {
+            int begin = b * rowsPerBand;
+            int end = std::min(params.dstH, begin + rowsPerBand);
+            processBand(src, dst, params, txy, txc, tyy, tyc, simd, begin, end);
+        }
+    });
+}
+
+// ==========================================
+// NV12 -> NV12 letterbox (CPU 兜底)
+// ==========================================
+void letterboxNV12(const Nv12Frame& src, uint8_t* dst, const LetterboxParams& p)
+{
+    if (!src.y || !src.uv || !dst || src.width < 4 || src.height < 4) return;
+    if (p.newW <= 0 || p.newH <= 0) return;
+
+    // 亮度按全分辨率、色度按半分辨率各自建采样表
+    thread_local AxisTable xy, yy, xc, yc;
+    buildAxis(xy, src.width, p.newW, false);
+    buildAxis(yy, src.height, p.newH, false);
+    buildAxis(xc, src.width / 2, p.newW / 2, false);
+    buildAxis(yc, src.height / 2, p.newH / 2, false);
+    thread_local std::vector<uint8_t> row;
+    row.resize(src.width);
+
+    // Y 平面
+    for (int r = 0; r < p.dstH; ++r) {
+        uint8_t* out = dst + (size_t)r * p.dstW;
+        int sr = r - p.padTop;
+        if (sr < 0 || sr >= p.newH) {
+            memset(out, PAD_Y, p.dstW);
+            continue;
+        }
+        memset(out, PAD_Y, p.padLeft);
+        memset(out + p.padLeft + p.newW, PAD_Y, p.dstW - p.padLeft - p.newW);
+        const uint8_t* y0 = src.y + (size_t)yy.ofs[sr] * src.yStride;
+        blendRowsSimd(y0, y0 + src.yStride, row.data(), src.width, yy.w[sr]);
+        uint8_t* px = out + p.padLeft;
+        for (int i = 0; i < p.newW; ++i) {
+            int xo = xy.ofs[i];
+            px[i] = lerp8(row[xo], row[xo + 1], xy.w[i]);
+        }
+    }
+
+    // 交织的 UV 平面 (半分辨率)
+    uint8_t* uvDst = dst + (size_t)p.dstW * p.dstH;
+    const int uvBytes = src.width & ~1;
+    const int chromaW = p.newW / 2;
+    const int chromaH = p.newH / 2;
+    for (int r = 0; r < p.dstH / 2; ++r) {
+        uint8_t* out = uvDst + (size_t)r * p.dstW;
+        int sr = r - p.padTop / 2;
+        if (sr < 0 || sr >= chromaH) {
+            memset(out, PAD_UV, p.dstW);
+            continue;
+        }
+        memset(out, PAD_UV, p.padLeft);
+        memset(out + p.padLeft + p.newW, PAD_UV, p.dstW - p.padLeft - p.newW);
+        const uint8_t* uv0 = src.uv + (size_t)yc.ofs[sr] * src.uvStride;
+        blendRowsSimd(uv0, uv0 + src.uvStride, row.data(), uvBytes, yc.w[sr]);
+        uint8_t* px = out + p.padLeft;
+        for (int i = 0; i < chromaW; ++i) {
+            int co = xc.ofs[i] * 2;
+            int cw = xc.w[i];
+            px[2 * i + 0] = lerp8(row[co], row[co + 2], cw);
+            px[2 * i + 1] = lerp8(row[co + 1], row[co + 3], cw);
+        }
+    }
+}
+
+} // namespace nv12
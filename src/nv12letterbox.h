@@ -0,0 +1,64 @@
+#ifndef NV12LETTERBOX_H
+#define NV12LETTERBOX_H
+
+#include <cstdint>
+
+// ==========================================
+// NV12 -> RGB 融合 letterbox 内核 (RGA 不可用时的 CPU 兜底路径)
+// 一次遍历完成：读取 Y/UV 两个平面 -> 双线性缩放 -> BT.601 转 RGB -> 直接写入模型输入
+// 取代原来 cvtColor(NV12->BGR) + resize + copyTo + cvtColor(BGR->RGB) 四步链路
+// ARM 上走 NEON，x86 开发机上走 SSSE3，其余平台走标量参考实现
+// ==========================================
+
+// NV12 图像描述 (Y 与 UV 平面允许不连续，兼容 V4L2 多平面 NV12M)
+struct Nv12Frame {
+    const uint8_t* y  = nullptr;
+    const uint8_t* uv = nullptr;
+    int width    = 0;
+    int height   = 0;
+    int yStride  = 0;
+    int uvStride = 0;
+};
+
+// letterbox 目标描述：dst 为 dstW x dstH 的紧密排列 RGB888
+struct LetterboxParams {
+    int dstW    = 0;
+    int dstH    = 0;
+    int newW    = 0;   // 缩放后的有效图像宽
+    int newH    = 0;   // 缩放后的有效图像高
+    int padLeft = 0;
+    int padTop  = 0;
+    uint8_t padValue = 114;
+};
+
+namespace nv12 {
+
+enum class KernelPath {
+    Scalar, // 标量参考实现，用于校验与兜底
+    Simd    // NEON / SSSE3，编译目标不支持时自动退化为标量
+};
+
+// 按行带切分并行执行；bands <= 0 时由 OpenCV 线程池自动决定
+void letterboxRGB(const Nv12Frame& src, uint8_t* dst, const LetterboxParams& params,
+                  KernelPath path = KernelPath::Simd, int bands = 0);
+
+// 按输入尺寸计算等比缩放 + 居中填充参数
+LetterboxParams makeLetterbox(int srcW, int srcH, int dstW, int dstH, float* scaleOut = nullptr);
+// 输出仍是 NV12 时使用：有效区宽高和填充都取偶数 (色度 2x2 共用)，缩放比例不变，误差不超过 1 像素
+LetterboxParams makeLetterboxEven(int srcW, int srcH, int dstW, int dstH, float* scaleOut = nullptr);
+
+// ---------- NV12 直接喂 NPU (模型图内做颜色转换) ----------
+
+// 填充区的 YUV：RGB(114,114,114) 按 BT.601 limited range 换算
+static const uint8_t PAD_Y  = 114;
+static const uint8_t PAD_UV = 128;
+
+// NV12 -> NV12 的缩放 + letterbox (RGA 不可用时的兜底)：dst 为 dstW x dstH 的连续 NV12 (Y 在上 UV 在下)
+// params 需来自 makeLetterboxEven
+void letterboxNV12(const Nv12Frame& src, uint8_t* dst, const LetterboxParams& params);
+
+const char* simdName();
+
+} // namespace nv12
+
+#endif // NV12LETTERBOX_H
@@ -0,0 +1,322 @@
+#include "outbox.h"
+#include <QDebug>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const uint32_t kFileMagic = 0x3158424F;     // "OBX1"
+static const uint32_t kWrapMarker = 0xFFFFFFFFu;   // 记录头位置写这个表示后面的空间不用，回到环首
+
+// 文件头 (放在映射区开头，随文件持久化)
+struct Outbox::RingMeta {
+    uint64_t offset;      // 环形区在文件里的起点
+    uint64_t capacity;
+    uint64_t head;        // 最老记录的位置
+    uint64_t tail;        // 下一条写入的位置
+    uint64_t used;        // head -> tail 之间占用的字节 (含回绕浪费)
+    uint32_t count;
+    uint32_t nextSeq;
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t classes;
+    uint64_t fileSize;
+};
+
+// 每条记录：记录头 + topic + 载荷，整体按 8 字节对齐
+struct Outbox::RecordHeader {
+    uint32_t len;         // 整条记录长度 (对齐后)，kWrapMarker 表示回绕
+    uint32_t seq;
+    int64_t wallMs;
+    uint32_t payloadLen;
+    uint16_t topicLen;
+    uint8_t cls;
+    uint8_t reserved;
+};
+
+static size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+static const size_t kMetaBytes = align8(sizeof(FileHeader) + Outbox::kClasses * 48);
+
+static int64_t wallNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Outbox::~Outbox()
+{
+    close();
+}
+
+Outbox::RingMeta* Outbox::meta(int cls)
+{
+    return reinterpret_cast<RingMeta*>(m_map + sizeof(FileHeader)) + cls;
+}
+
+uint8_t* Outbox::region(int cls)
+{
+    return m_map + meta(cls)->offset;
+}
+
+bool Outbox::open(const OutboxConfig& config)
+{
+    static_assert(sizeof(RingMeta) == 48, "RingMeta 大小变了要同步 kMetaBytes");
+    close();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_config = config;
+    size_t fileSize = std::max(config.bytes, kMetaBytes + kClasses * (size_t)4096);
+
+    m_fd = ::open(config.path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        qDebug() << "【警告】发件箱文件打开失败:" << QString::fromStdString(config.path);
+        return false;
+    }
+    struct stat st;
+    bool reuse = fstat(m_fd, &st) == 0 && (size_t)st.st_size == fileSize;
+    if (!reuse && ftruncate(m_fd, (off_t)fileSize) != 0) {
+        qDebug() << "【警告】发件箱文件扩容失败:" << QString::fromStdString(config.path);
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    void* p = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) {
+        qDebug() << "【警告】发件箱 mmap 失败";
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_map = static_cast<uint8_t*>(p);
+    m_mapSize = fileSize;
+
+    // 按比例切分三段环形区
+    size_t body = fileSize - kMetaBytes;
+    size_t offsets[kClasses];
+    size_t caps[kClasses];
+    size_t at = kMetaBytes;
+    for (int c = 0; c < kClasses; ++c) {
+        size_t cap = c == kClasses - 1 ? fileSize - at : (size_t)(body * config.share[c]) & ~(size_t)7;
+        offsets[c] = at;
+        caps[c] = cap;
+        at += cap;
+    }
+
+    FileHeader* fh = reinterpret_cast<FileHeader*>(m_map);
+    bool valid = reuse && fh->magic == kFileMagic && fh->classes == (uint32_t)kClasses && fh->fileSize == fileSize;
+    for (int c = 0; valid && c < kClasses; ++c) {
+        RingMeta* m = meta(c);
+        valid = m->offset == offsets[c] && m->capacity == caps[c] &&
+                m->head < m->capacity && m->tail < m->capacity && m->used <= m->capacity;
+    }
+
+    if (valid) {
+        uint32_t total = 0;
+        for (int c = 0; c < kClasses; ++c) total += meta(c)->count;
+        qDebug() << ">>> 发件箱沿用上次未发完的记录:" << total << "条 |" << QString::fromStdString(config.path);
+    } else {
+        fh->magic = kFileMagic;
+        fh->classes = kClasses;
+        fh->fileSize = fileSize;
+        for (int c = 0; c < kClasses; ++c) {
+            RingMeta* m = meta(c);
+            memset(m, 0, sizeof(RingMeta));
+            m->offset = offsets[c];
+            m->capacity = caps[c];
+        }
+        qDebug() << ">>> 发件箱已创建:" << QString::fromStdString(config.path) << (int)(fileSize / 1024) << "KB";
+    }
+    return true;
+}
+
+void Outbox::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_map) {
+        msync(m_map, m_mapSize, MS_ASYNC);
+        munmap(m_map, m_mapSize);
+        m_map = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+size_t Outbox::maxRecordSize()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_map) return 0;
+    size_t cap = 0;
+    for (int c = 0; c < kClasses; ++c) cap = std::max(cap, (size_t)meta(c)->capacity);
+    return cap - sizeof(RecordHeader);
+}
+
+bool Outbox::headLocked(int cls, size_t& offset, RecordHeader& head)
+{
+    RingMeta* m = meta(cls);
+    if (m->count == 0) return false;
+    // head 处放不下一个记录头，或者写着回绕标记：剩下的都是浪费，回到环首
+    if (m->capacity - m->head < sizeof(RecordHeader) ||
+        *reinterpret_cast<const uint32_t*>(region(cls) + m->head) == kWrapMarker) {
+        m->used -= m->capacity - m->head;
+        m->head = 0;
+    }
+    offset = m->head;
+    memcpy(&head, region(cls) + offset, sizeof(head));
+    return true;
+}
+
+void Outbox::popHeadLocked(int cls)
+{
+    size_t offset;
+    RecordHeader head;
+    if (!headLocked(cls, offset, head)) return;
+    RingMeta* m = meta(cls);
+    m->head += head.len;
+    m->used -= head.len;
+    m->count--;
+    if (m->head >= m->capacity) m->head = 0;
+    if (m->count == 0) m->head = m->tail = m->used = 0;
+}
+
+void Outbox::evictOldestLocked(int cls)
+{
+    popHeadLocked(cls);
+    m_droppedOverflow[cls]++;
+}
+
+bool Outbox::push(OutboxClass cls, const std::string& topic, const void* data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_map) return false;
+    int c = (int)cls;
+    RingMeta* m = meta(c);
+    size_t need = align8(sizeof(RecordHeader) + topic.size() + len);
+    if (need > m->capacity || topic.size() > 0xFFFF) return false;
+
+    // 腾出空间：写到末尾放不下时要把末尾那截一起算进去
+    while (true) {
+        size_t contiguous = m->capacity - m->tail;
+        size_t waste = contiguous < need ? contiguous : 0;
+        if (m->capacity - m->used >= need + waste) break;
+        if (m->count == 0) {
+            m->head = m->tail = m->used = 0;
+            continue;
+        }
+        evictOldestLocked(c);
+    }
+    size_t contiguous = m->capacity - m->tail;
+    if (contiguous < need) {
+        if (contiguous >= sizeof(uint32_t)) {
+            uint32_t marker = kWrapMarker;
+            memcpy(region(c) + m->tail, &marker, sizeof(marker));
+        }
+        m->used += contiguous;
+        m->tail = 0;
+    }
+
+    RecordHeader head;
+    memset(&head, 0, sizeof(head));
+    head.len = (uint32_t)need;
+    head.seq = m->nextSeq++;
+    head.wallMs = wallNowMs();
+    head.payloadLen = (uint32_t)len;
+    head.topicLen = (uint16_t)topic.size();
+    head.cls = (uint8_t)c;
+    uint8_t* p = region(c) + m->tail;
+    memcpy(p + sizeof(head), topic.data(), topic.size());
+    if (len) memcpy(p + sizeof(head) + topic.size(), data, len);
+    // 先写内容再写记录头、最后推进 tail，进程中途被杀也不会留下半条记录
+    memcpy(p, &head, sizeof(head));
+    m->tail += need;
+    if (m->tail >= m->capacity) m->tail = 0;
+    m->used += need;
+    m->count++;
+    m_pushed[c]++;
+    return true;
+}
+
+bool Outbox::peek(Record& rec, uint8_t* buf, size_t cap)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_map) return false;
+    int64_t now = wallNowMs();
+    for (int c = 0; c < kClasses; ++c) {
+        size_t offset;
+        RecordHeader head;
+        while (headLocked(c, offset, head)) {
+            double ageSec = (now - head.wallMs) / 1000.0;
+            if (ageSec > m_config.maxAgeSec) {
+                popHeadLocked(c);
+                m_droppedAge[c]++;
+                continue;
+            }
+            if (head.payloadLen > cap) return false;
+            const uint8_t* p = region(c) + offset + sizeof(head);
+            rec.cls = (OutboxClass)c;
+            rec.seq = head.seq;
+            rec.wallMs = head.wallMs;
+            rec.topic.assign(reinterpret_cast<const char*>(p), head.topicLen);
+            rec.len = head.payloadLen;
+            memcpy(buf, p + head.topicLen, head.payloadLen);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Outbox::pop(OutboxClass cls, uint32_t seq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_map) return;
+    int c = (int)cls;
+    size_t offset;
+    RecordHeader head;
+    if (!headLocked(c, offset, head) || head.seq != seq) return;
+    popHeadLocked(c);
+    m_drained[c]++;
+}
+
+bool Outbox::empty()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_map) return true;
+    for (int c = 0; c < kClasses; ++c) {
+        if (meta(c)->count > 0) return false;
+    }
+    return true;
+}
+
+Outbox::ClassStats Outbox::stats(OutboxClass cls)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ClassStats st;
+    if (!m_map) return st;
+    int c = (int)cls;
+    RingMeta* m = meta(c);
+    st.count = m->count;
+    st.bytes = m->used;
+    st.capacity = m->capacity;
+    size_t offset;
+    RecordHeader head;
+    if (headLocked(c, offset, head)) st.oldestAgeSec = (wallNowMs() - head.wallMs) / 1000.0;
+    st.pushed = m_pushed[c];
+    st.drained = m_drained[c];
+    st.droppedOverflow = m_droppedOverflow[c];
+    st.droppedAge = m_droppedAge[c];
+    return st;
+}
+
+void Outbox::resetCounters()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int c = 0; c < kClasses; ++c) {
+        m_pushed[c] = m_drained[c] = m_droppedOverflow[c] = m_droppedAge[c] = 0;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// ==========================================
+// 断网暂存发件箱 (store-and-forward)
+// 检测记录、遥测、作业汇总这类非控制报文先写进这里，由 MqttClientManager 的补发线程在连上
+// broker 时按限速逐条发出 (QoS 1，broker 确认后才出队)。田间 Wi-Fi 断开期间的数据不再丢失。
+//   - 存储：mmap 映射的文件，每个优先级一段独立的环形区，进程重启后未发出的记录还在
+//   - 容量：按字节数限制，满了丢同一优先级里最老的；超过 maxAge 的记录出队时直接丢弃
+//   - 优先级：补发时总是先发优先级高 (编号小) 的一类
+// 控制类报文 (移动 / 打击) 过期即无意义，不走这里。
+// ==========================================
+
+enum class OutboxClass : uint8_t {
+    Detection = 0,   // 检测记录 (新确认的目标)
+    Telemetry = 1,   // 下位机 / 本机遥测
+    Summary   = 2,   // 作业汇总
+};
+
+struct OutboxConfig {
+    std::string path;                      // 映射文件
+    size_t bytes = 4 * 1024 * 1024;        // 文件总大小 (三类按 share 分)
+    double maxAgeSec = 600.0;              // 超过这个时长的记录不再补发
+    double share[3] = {0.5, 0.3, 0.2};     // 各优先级占的比例
+};
+
+class Outbox
+{
+public:
+    static const int kClasses = 3;
+
+    struct Record {
+        OutboxClass cls = OutboxClass::Detection;
+        uint32_t seq = 0;                  // 出队时用来确认还是同一条
+        int64_t wallMs = 0;                // 入队时刻 (系统时间，跨重启也能算年龄)
+        std::string topic;
+        size_t len = 0;                    // 载荷长度，内容拷进调用方缓冲区
+    };
+
+    struct ClassStats {
+        uint32_t count = 0;
+        size_t bytes = 0;                  // 占用字节 (含记录头和回绕浪费)
+        size_t capacity = 0;
+        double oldestAgeSec = 0.0;
+        uint64_t pushed = 0;
+        uint64_t drained = 0;
+        uint64_t droppedOverflow = 0;
+        uint64_t droppedAge = 0;
+    };
+
+    Outbox() = default;
+    ~Outbox();
+    Outbox(const Outbox&) = delete;
+    Outbox& operator=(const Outbox&) = delete;
+
+    // 打开 / 新建映射文件；文件头与配置一致时沿用里面的记录
+    bool open(const OutboxConfig& config);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+
+    // 入队；单条超过该类容量返回 false
+    bool push(OutboxClass cls, const std::string& topic, const void* data, size_t len);
+    // 取优先级最高的一条 (过期的顺手丢掉)，载荷拷进 buf；没有记录或 cap 不够返回 false
+    bool peek(Record& rec, uint8_t* buf, size_t cap);
+    // 发送成功后出队；期间若被新记录挤掉 (seq 对不上) 则什么也不做
+    void pop(OutboxClass cls, uint32_t seq);
+
+    bool empty();
+    // 单条载荷上限 (按最大一段环形区算)，补发线程按这个分配缓冲区
+    size_t maxRecordSize();
+    ClassStats stats(OutboxClass cls);
+    void resetCounters();
+
+private:
+    struct RingMeta;
+    struct RecordHeader;
+    RingMeta* meta(int cls);
+    uint8_t* region(int cls);
+    void evictOldestLocked(int cls);
+    // 读 head 处的记录头 (跳过回绕)；环为空返回 false
+    bool headLocked(int cls, size_t& offset, RecordHeader& head);
+    void popHeadLocked(int cls);
+
+    std::mutex m_mutex;
+    OutboxConfig m_config;
+    uint8_t* m_map = nullptr;
+    size_t m_mapSize = 0;
+    int m_fd = -1;
+
+    // 计数只在内存里，不写文件
+    uint64_t m_pushed[kClasses] = {0};
+    uint64_t m_drained[kClasses] = {0};
+    uint64_t m_droppedOverflow[kClasses] = {0};
+    uint64_t m_droppedAge[kClasses] = {0};
+};
+
+#endif // OUTBOX_H
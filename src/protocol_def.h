@@ -11,7 +11,9 @@ enum CommandType {
     CMD_HEARTBEAT = 0x00, // 心跳包
     CMD_MOVE      = 0x01, // 移动控制 (vx, vy, vz)
     CMD_CONTROL   = 0x02, // 硬件控制 (LED, 蜂鸣器)
-    CMD_TARGET    = 0x03  // AI 目标坐标下发
+    CMD_TARGET    = 0x03, // AI 目标坐标下发 (单个目标)
+    CMD_TARGET_BATCH = 0x04, // 一帧内全部目标打包下发 (TargetBatchHeader + count 个 TargetEntry)
+    CMD_ECHO      = 0x05  // 下位机上行：回显 v2 帧头里的序号和发送时刻 (EchoPayload)
 };
 
 // 1. 移动载荷：对应麦克纳姆轮的三个自由度
@@ -29,12 +31,76 @@ struct ControlPayload {
     uint8_t padding;       // 字节对齐占位
 };
 
-// 3. 统一帧头
+// 3. AI 目标载荷：拍摄时刻的坐标 + 外推到预计打击时刻的坐标
+struct TargetPayload {
+    int16_t  x;           // 拍摄时刻的瞄准点 (检测流像素坐标)
+    int16_t  y;
+    int16_t  predX;       // 按底盘运动外推到打击时刻的瞄准点
+    int16_t  predY;
+    uint32_t captureMs;   // 拍摄时刻 (发送端单调时钟毫秒，低 32 位，用于日志对齐)
+    uint16_t validInMs;   // 预测坐标在报文发出后多少毫秒有效 (即预计打击时刻)
+    uint16_t latencyMs;   // 拍摄 -> 预计打击 的总补偿时长
+    uint8_t  classId;
+    uint8_t  confidence;  // 置信度 x 255
+    uint16_t trackId;     // 跟踪 ID (低 16 位)，0xFFFF 表示未跟踪
+};
+
+// 4. 批量目标载荷：一帧一条报文，密集草丛里报文数不再随目标数增长
+//    载荷 = TargetBatchHeader + count 个 TargetEntry，长度 = sizeof(TargetBatchHeader) + count * sizeof(TargetEntry)
+//    坐标为拍摄时刻的瞄准点；同一帧的运动补偿是同一个平移量，放在头里，下位机打击时加上 (shiftX, shiftY)
+#define TARGET_BATCH_MAX 64   // 单帧最多下发的目标数 (超出部分按优先级截断)
+
+struct TargetBatchHeader {
+    uint32_t frameId;     // 采集帧序号 (低 32 位)，下位机只保留 frameId 最新的一批
+    uint32_t captureMs;   // 拍摄时刻 (发送端单调时钟毫秒，低 32 位)
+    uint16_t validInMs;   // 报文发出后多少毫秒到达预计打击时刻
+    uint16_t latencyMs;   // 拍摄 -> 预计打击 的总补偿时长
+    int16_t  shiftX;      // 拍摄时刻 -> 打击时刻 画面平移量 (像素)
+    int16_t  shiftY;
+    uint8_t  cameraId;
+    uint8_t  count;       // 后面跟着的 TargetEntry 个数
+};
+
+struct TargetEntry {
+    int16_t  x;           // 拍摄时刻的瞄准点 (检测流像素坐标)
+    int16_t  y;
+    uint8_t  classId;
+    uint8_t  confidence;  // 置信度 x 255
+    uint16_t trackId;     // 跟踪 ID (低 16 位)，0xFFFF 表示未跟踪
+};
+
+// 5. 回显载荷：下位机收到带 FRAME_FLAG_ECHO 的 v2 报文后原样带回序号和发送时刻，上位机据此算往返时延
+struct EchoPayload {
+    uint8_t  type;        // 被回显的指令类型
+    uint8_t  status;      // 0: 已执行, 1: 已拒绝 (参数非法 / 未使能)
+    uint16_t seq;         // 原报文的序号
+    uint32_t sendUs;      // 原报文的发送时刻 (上位机单调时钟微秒，低 32 位)
+    uint16_t procUs;      // 下位机 收到 -> 发出回显 的处理耗时，用于从往返时延里扣掉
+    uint16_t reserved;
+};
+
+// 6. 统一帧头
 struct FrameHeader {
     uint8_t  header; // 固定为 0x5A
     uint8_t  type;   // 指令类型 (CommandType)
     uint16_t len;    // 后续载荷长度
 };
 
+// 7. v2 帧头：包头改为 0x5B，在 v1 的基础上带序号和发送时刻，载荷格式不变。
+//    旧固件只认 0x5A，所以只有打开时延追踪 (CAR_HMI_TRACE) 时才发 v2
+#define FRAME_MAGIC_V1  0x5A
+#define FRAME_MAGIC_V2  0x5B
+#define FRAME_FLAG_ECHO 0x01   // 要求下位机回 CMD_ECHO
+
+struct FrameHeaderV2 {
+    uint8_t  header;  // 固定为 0x5B
+    uint8_t  type;    // 指令类型 (CommandType)
+    uint16_t len;     // 后续载荷长度
+    uint8_t  version; // 帧头版本，当前为 2
+    uint8_t  flags;   // FRAME_FLAG_*
+    uint16_t seq;     // 发送序号，每条报文 +1
+    uint32_t sendUs;  // 发送时刻 (单调时钟微秒，低 32 位)
+};
+
 #pragma pack(pop)
 #endif
\ No newline at end of file
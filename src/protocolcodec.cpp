@@ -0,0 +1,20 @@
+#include "protocolcodec.h"
+
+namespace proto {
+
+const char* statusName(Status s)
+{
+    switch (s) {
+    case Status::Ok:          return "正常";
+    case Status::TooShort:    return "过短";
+    case Status::BadMagic:    return "包头错误";
+    case Status::ByteSwapped: return "字节序颠倒";
+    case Status::BadLength:   return "长度不符";
+    case Status::UnknownType: return "未知指令";
+    case Status::BadVersion:  return "帧头版本不符";
+    case Status::Unhandled:   return "未处理";
+    }
+    return "?";
+}
+
+} // namespace proto
@@ -0,0 +1,365 @@
+#ifndef PROTOCOLCODEC_H
+#define PROTOCOLCODEC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "protocol_def.h"
+#include "targetbatch.h"
+
+// ==========================================
+// 编译期协议编解码
+// protocol_def.h 里每个载荷结构体在这里登记一次字段列表 (Layout)，
+// 每种 CommandType 登记一次载荷类型 (Message)，编码 / 解码 / 分发全部由模板在编译期展开：
+//   - 编码写进栈上的 Packet (或调用方给的缓冲区)，逐字段按小端写出，不做堆分配
+//   - 解码先校验包头、长度 (含字节序颠倒的长度)，再逐字段按小端读进结构体，不再 reinterpret_cast
+//   - 分发走按 CommandType 下标的 constexpr 函数表，处理器只需提供对应载荷的 handle() 重载
+// 线上字节序固定为小端 (RK3588 / ESP32 都是小端)，大端主机也能正确编解码。
+// 帧头有两个版本：v1 (0x5A) 只有类型和长度；v2 (0x5B) 另带序号、发送时刻和标志位，用于往返时延追踪。
+// 新增指令：在 protocol_def.h 加结构体 -> 这里加 Layout 和 Message 特化 -> 调大 kCommandCount。
+// ==========================================
+
+namespace proto {
+
+static constexpr uint8_t kMagic = FRAME_MAGIC_V1;
+static constexpr uint8_t kMagicV2 = FRAME_MAGIC_V2;
+static constexpr uint8_t kHeaderVersion = 2;
+// 分发表大小 (最大 CommandType + 1)
+static constexpr int kCommandCount = CMD_ECHO + 1;
+
+// ---------- 小端读写 ----------
+
+template<size_t N> struct UintOfSize;
+template<> struct UintOfSize<1> { typedef uint8_t type; };
+template<> struct UintOfSize<2> { typedef uint16_t type; };
+template<> struct UintOfSize<4> { typedef uint32_t type; };
+template<> struct UintOfSize<8> { typedef uint64_t type; };
+
+template<typename T>
+inline void putLE(uint8_t* p, T v)
+{
+    typedef typename UintOfSize<sizeof(T)>::type U;
+    U u;
+    memcpy(&u, &v, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); ++i) p[i] = (uint8_t)(u >> (8 * i));
+}
+
+template<typename T>
+inline T getLE(const uint8_t* p)
+{
+    typedef typename UintOfSize<sizeof(T)>::type U;
+    U u = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) u |= (U)((U)p[i] << (8 * i));
+    T v;
+    memcpy(&v, &u, sizeof(T));
+    return v;
+}
+
+// ---------- 结构体字段表 ----------
+
+// 心跳没有载荷
+struct Heartbeat {};
+
+template<typename S> struct Layout;
+
+template<> struct Layout<Heartbeat> {
+    static constexpr auto fields = std::make_tuple();
+};
+template<> struct Layout<MovePayload> {
+    static constexpr auto fields = std::make_tuple(&MovePayload::vx, &MovePayload::vy, &MovePayload::vz);
+};
+template<> struct Layout<ControlPayload> {
+    static constexpr auto fields = std::make_tuple(&ControlPayload::mode, &ControlPayload::led_switch,
+                                                   &ControlPayload::buzzer_switch, &ControlPayload::padding);
+};
+template<> struct Layout<TargetPayload> {
+    static constexpr auto fields = std::make_tuple(&TargetPayload::x, &TargetPayload::y,
+                                                   &TargetPayload::predX, &TargetPayload::predY,
+                                                   &TargetPayload::captureMs, &TargetPayload::validInMs,
+                                                   &TargetPayload::latencyMs, &TargetPayload::classId,
+                                                   &TargetPayload::confidence, &TargetPayload::trackId);
+};
+template<> struct Layout<TargetBatchHeader> {
+    static constexpr auto fields = std::make_tuple(&TargetBatchHeader::frameId, &TargetBatchHeader::captureMs,
+                                                   &TargetBatchHeader::validInMs, &TargetBatchHeader::latencyMs,
+                                                   &TargetBatchHeader::shiftX, &TargetBatchHeader::shiftY,
+                                                   &TargetBatchHeader::cameraId, &TargetBatchHeader::count);
+};
+template<> struct Layout<TargetEntry> {
+    static constexpr auto fields = std::make_tuple(&TargetEntry::x, &TargetEntry::y, &TargetEntry::classId,
+                                                   &TargetEntry::confidence, &TargetEntry::trackId);
+};
+template<> struct Layout<EchoPayload> {
+    static constexpr auto fields = std::make_tuple(&EchoPayload::type, &EchoPayload::status, &EchoPayload::seq,
+                                                   &EchoPayload::sendUs, &EchoPayload::procUs, &EchoPayload::reserved);
+};
+template<> struct Layout<FrameHeader> {
+    static constexpr auto fields = std::make_tuple(&FrameHeader::header, &FrameHeader::type, &FrameHeader::len);
+};
+template<> struct Layout<FrameHeaderV2> {
+    static constexpr auto fields = std::make_tuple(&FrameHeaderV2::header, &FrameHeaderV2::type, &FrameHeaderV2::len,
+                                                   &FrameHeaderV2::version, &FrameHeaderV2::flags,
+                                                   &FrameHeaderV2::seq, &FrameHeaderV2::sendUs);
+};
+
+template<typename M> struct MemberType;
+template<typename S, typename F> struct MemberType<F S::*> { typedef F type; };
+
+template<typename Tuple, size_t... I>
+constexpr size_t sumFieldSizes(const Tuple&, std::index_sequence<I...>)
+{
+    return (size_t(0) + ... + sizeof(typename MemberType<std::tuple_element_t<I, Tuple>>::type));
+}
+
+// 线上字节数 = 各字段大小之和
+template<typename S>
+constexpr size_t wireSize()
+{
+    typedef std::remove_const_t<decltype(Layout<S>::fields)> Tuple;
+    return sumFieldSizes(Layout<S>::fields, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+}
+
+// 字段表必须覆盖结构体的每个字节：protocol_def.h 加了字段而这里忘了登记会直接编译失败
+template<typename S>
+constexpr bool layoutComplete()
+{
+    return std::is_empty<S>::value ? wireSize<S>() == 0 : wireSize<S>() == sizeof(S);
+}
+static_assert(layoutComplete<MovePayload>(), "MovePayload 字段表不完整");
+static_assert(layoutComplete<ControlPayload>(), "ControlPayload 字段表不完整");
+static_assert(layoutComplete<TargetPayload>(), "TargetPayload 字段表不完整");
+static_assert(layoutComplete<TargetBatchHeader>(), "TargetBatchHeader 字段表不完整");
+static_assert(layoutComplete<TargetEntry>(), "TargetEntry 字段表不完整");
+static_assert(layoutComplete<EchoPayload>(), "EchoPayload 字段表不完整");
+static_assert(layoutComplete<FrameHeader>(), "FrameHeader 字段表不完整");
+static_assert(layoutComplete<FrameHeaderV2>(), "FrameHeaderV2 字段表不完整");
+
+template<typename S>
+inline uint8_t* writeStruct(const S& s, uint8_t* p)
+{
+    std::apply([&](auto... member) {
+        ((putLE(p, s.*member), p += sizeof(s.*member)), ...);
+    }, Layout<S>::fields);
+    return p;
+}
+
+template<typename S>
+inline const uint8_t* readStruct(const uint8_t* p, S& s)
+{
+    std::apply([&](auto... member) {
+        ((s.*member = getLE<std::remove_reference_t<decltype(s.*member)>>(p), p += sizeof(s.*member)), ...);
+    }, Layout<S>::fields);
+    return p;
+}
+
+static constexpr size_t kHeaderSize = wireSize<FrameHeader>();
+static constexpr size_t kHeaderV2Size = wireSize<FrameHeaderV2>();
+
+// v2 帧头里的追踪信息
+struct Trace {
+    uint16_t seq = 0;
+    uint32_t sendUs = 0;
+    uint8_t flags = 0;
+};
+
+inline size_t headerSize(bool traced) { return traced ? kHeaderV2Size : kHeaderSize; }
+
+// ---------- 指令登记 ----------
+
+// 定长载荷的通用实现
+template<typename S>
+struct FixedMessage {
+    static constexpr bool defined = true;
+    typedef S Value;
+    static constexpr size_t kMinLen = wireSize<S>();
+    static constexpr size_t kMaxLen = kMinLen;
+
+    static bool decode(const uint8_t* p, size_t len, S& v)
+    {
+        if (len != kMinLen) return false;
+        readStruct(p, v);
+        return true;
+    }
+    static size_t encode(const S& v, uint8_t* out)
+    {
+        return (size_t)(writeStruct(v, out) - out);
+    }
+};
+
+template<int C> struct Message { static constexpr bool defined = false; };
+template<> struct Message<CMD_HEARTBEAT> : FixedMessage<Heartbeat> {};
+template<> struct Message<CMD_MOVE> : FixedMessage<MovePayload> {};
+template<> struct Message<CMD_CONTROL> : FixedMessage<ControlPayload> {};
+template<> struct Message<CMD_TARGET> : FixedMessage<TargetPayload> {};
+template<> struct Message<CMD_ECHO> : FixedMessage<EchoPayload> {};
+// 变长：头 + count 个条目，解码结果是指向原报文的视图
+template<> struct Message<CMD_TARGET_BATCH> {
+    static constexpr bool defined = true;
+    typedef targetbatch::View Value;
+    static constexpr size_t kMinLen = wireSize<TargetBatchHeader>();
+    static constexpr size_t kMaxLen = kMinLen + TARGET_BATCH_MAX * wireSize<TargetEntry>();
+
+    static bool decode(const uint8_t* p, size_t len, Value& v) { return targetbatch::decodePayload(p, len, v); }
+};
+
+// ---------- 编码 ----------
+
+// 栈上报文：容量按指令的最大长度在编译期确定
+template<size_t N>
+struct Packet {
+    uint8_t bytes[N];
+    size_t size = 0;
+
+    const uint8_t* data() const { return bytes; }
+};
+
+// 容量按 v2 帧头算，两种帧头都放得下
+template<int C>
+using PacketFor = Packet<kHeaderV2Size + Message<C>::kMaxLen>;
+
+// trace 为空写 v1 帧头，否则写 v2 帧头；返回载荷起点
+inline uint8_t* writeHeader(uint8_t* out, uint8_t type, size_t payloadLen, const Trace* trace = nullptr)
+{
+    if (!trace) {
+        FrameHeader head = {kMagic, type, (uint16_t)payloadLen};
+        return writeStruct(head, out);
+    }
+    FrameHeaderV2 head = {kMagicV2, type, (uint16_t)payloadLen, kHeaderVersion, trace->flags, trace->seq, trace->sendUs};
+    return writeStruct(head, out);
+}
+
+// 已编码好的 v2 报文在真正发出前补写序号和发送时刻 (最新覆盖的发送槽在出队时才知道发送时刻)
+inline void restamp(uint8_t* packet, const Trace& trace)
+{
+    FrameHeaderV2 head;
+    readStruct(packet, head);
+    head.flags = trace.flags;
+    head.seq = trace.seq;
+    head.sendUs = trace.sendUs;
+    writeStruct(head, packet);
+}
+
+// 定长指令编码到栈上：auto pkt = proto::pack<CMD_MOVE>(payload); publish(pkt.data(), pkt.size)
+template<int C>
+inline PacketFor<C> pack(const typename Message<C>::Value& value, const Trace* trace = nullptr)
+{
+    static_assert(Message<C>::kMinLen == Message<C>::kMaxLen, "变长指令请用对应模块的 encode (如 targetbatch::encode)");
+    PacketFor<C> pkt;
+    uint8_t* p = writeHeader(pkt.bytes, (uint8_t)C, Message<C>::kMinLen, trace);
+    pkt.size = (size_t)(Message<C>::encode(value, p) + (p - pkt.bytes));
+    return pkt;
+}
+
+// ---------- 解码与分发 ----------
+
+enum class Status {
+    Ok,
+    TooShort,      // 连帧头都不够
+    BadMagic,      // 包头不是 0x5A
+    ByteSwapped,   // 长度字段按大端解释才对得上：对端字节序错了
+    BadLength,     // 帧头长度与实际长度不符，或载荷长度不符合该指令
+    UnknownType,   // 没有登记的指令
+    BadVersion,    // 0x5B 帧头但版本号不认识
+    Unhandled,     // 合法报文，但处理器没有对应的 handle()
+};
+static constexpr int kStatusCount = (int)Status::Unhandled + 1;
+
+const char* statusName(Status s);
+
+struct FrameView {
+    uint8_t type = 0;
+    const uint8_t* payload = nullptr;
+    size_t len = 0;
+    bool traced = false;   // v2 帧头
+    Trace trace;
+};
+
+// 只校验帧头和总长度
+inline Status decodeFrame(const uint8_t* data, size_t len, FrameView& view)
+{
+    if (!data || len < kHeaderSize) return Status::TooShort;
+    FrameHeader head;
+    readStruct(data, head);
+    size_t headLen = kHeaderSize;
+    view.traced = false;
+    if (head.header == kMagicV2) {
+        if (len < kHeaderV2Size) return Status::TooShort;
+        FrameHeaderV2 v2;
+        readStruct(data, v2);
+        if (v2.version != kHeaderVersion) return Status::BadVersion;
+        view.traced = true;
+        view.trace.seq = v2.seq;
+        view.trace.sendUs = v2.sendUs;
+        view.trace.flags = v2.flags;
+        headLen = kHeaderV2Size;
+    } else if (head.header != kMagic) {
+        return Status::BadMagic;
+    }
+    size_t payloadLen = len - headLen;
+    if (head.len != payloadLen) {
+        uint16_t swapped = (uint16_t)((head.len >> 8) | (head.len << 8));
+        return swapped == payloadLen ? Status::ByteSwapped : Status::BadLength;
+    }
+    view.type = head.type;
+    view.payload = data + headLen;
+    view.len = payloadLen;
+    return Status::Ok;
+}
+
+template<typename H, typename V, typename = void>
+struct CanHandle : std::false_type {};
+template<typename H, typename V>
+struct CanHandle<H, V, decltype(std::declval<H&>().handle(std::declval<const V&>()), void())> : std::true_type {};
+
+// 处理器 H 为每种想接收的载荷提供 void handle(const Payload&)，没提供的指令返回 Unhandled
+template<typename H>
+struct Dispatcher {
+    typedef Status (*Thunk)(H&, const uint8_t*, size_t);
+
+    template<int C>
+    static Status thunk(H& handler, const uint8_t* p, size_t len)
+    {
+        typedef Message<C> M;
+        if (len < M::kMinLen || len > M::kMaxLen) return Status::BadLength;
+        typename M::Value value;
+        if (!M::decode(p, len, value)) return Status::BadLength;
+        if constexpr (CanHandle<H, typename M::Value>::value) {
+            handler.handle(value);
+            return Status::Ok;
+        } else {
+            return Status::Unhandled;
+        }
+    }
+
+    template<int C, bool D = Message<C>::defined>
+    struct Entry { static constexpr Thunk fn = nullptr; };
+    template<int C>
+    struct Entry<C, true> { static constexpr Thunk fn = &Dispatcher::thunk<C>; };
+
+    template<size_t... I>
+    static constexpr std::array<Thunk, sizeof...(I)> makeTable(std::index_sequence<I...>)
+    {
+        return {{ Entry<(int)I>::fn... }};
+    }
+
+    static constexpr std::array<Thunk, kCommandCount> table = makeTable(std::make_index_sequence<kCommandCount>{});
+};
+
+// 完整报文 (含帧头) -> 校验 -> 按类型查表分发
+template<typename H>
+inline Status dispatch(const uint8_t* data, size_t len, H& handler)
+{
+    FrameView view;
+    Status st = decodeFrame(data, len, view);
+    if (st != Status::Ok) return st;
+    if (view.type >= kCommandCount || !Dispatcher<H>::table[view.type]) return Status::UnknownType;
+    return Dispatcher<H>::table[view.type](handler, view.payload, view.len);
+}
+
+} // namespace proto
+
+#endif // PROTOCOLCODEC_H
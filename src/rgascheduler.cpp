@@ -0,0 +1,149 @@
+#include "rgascheduler.h"
+#include <QDebug>
+#include <QString>
+
+RgaScheduler& RgaScheduler::instance()
+{
+    static RgaScheduler scheduler;
+    return scheduler;
+}
+
+RgaScheduler::RgaScheduler()
+{
+    m_cores[0].mask = IM_SCHEDULER_RGA3_CORE0; m_cores[0].name = "RGA3_CORE0";
+    m_cores[1].mask = IM_SCHEDULER_RGA3_CORE1; m_cores[1].name = "RGA3_CORE1";
+    m_cores[2].mask = IM_SCHEDULER_RGA2_CORE0; m_cores[2].name = "RGA2_CORE0";
+    m_windowStart = std::chrono::steady_clock::now();
+}
+
+IM_SCHEDULER_CORE RgaScheduler::coreMask(int core)
+{
+    if (core < 0 || core >= CORE_COUNT) return IM_SCHEDULER_DEFAULT;
+    return instance().m_cores[core].mask;
+}
+
+int RgaScheduler::pickIdleCoreLocked(int preferredCore) const
+{
+    if (preferredCore >= 0 && preferredCore < CORE_COUNT && !m_cores[preferredCore].busy) {
+        return preferredCore;
+    }
+
+    // 专属核心被占用：在空闲核心里挑累计负载最低的那个
+    // RGA2 比 RGA3 慢且只能访问 4G 以内地址，负载相同时优先 RGA3
+    int best = -1;
+    for (int i = 0; i < CORE_COUNT; ++i) {
+        if (m_cores[i].busy) continue;
+        if (best < 0 || m_cores[i].busyMs < m_cores[best].busyMs) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+int RgaScheduler::acquire(int preferredCore, double& waitMs)
+{
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int core = pickIdleCoreLocked(preferredCore);
+    if (core < 0) {
+        // 3 个核心全忙，挂起等待任意一个核心释放
+        m_cond.wait(lock, [&]{ return (core = pickIdleCoreLocked(preferredCore)) >= 0; });
+    }
+
+    Core& c = m_cores[core];
+    c.busy = true;
+    if (core != preferredCore) c.fallbacks++;
+
+    waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    c.waitMs += waitMs;
+    if (waitMs > c.maxWaitMs) c.maxWaitMs = waitMs;
+    return core;
+}
+
+void RgaScheduler::release(int core, double busyMs)
+{
+    if (core < 0 || core >= CORE_COUNT) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Core& c = m_cores[core];
+        c.busy = false;
+        c.jobs++;
+        c.busyMs += busyMs;
+    }
+    m_cond.notify_one();
+}
+
+std::vector<RgaScheduler::CoreStats> RgaScheduler::snapshot()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double windowMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - m_windowStart).count();
+
+    std::vector<CoreStats> stats;
+    for (int i = 0; i < CORE_COUNT; ++i) {
+        const Core& c = m_cores[i];
+        CoreStats s;
+        s.name = c.name;
+        s.jobs = c.jobs;
+        s.fallbacks = c.fallbacks;
+        s.busyMs = c.busyMs;
+        s.avgWaitMs = c.jobs > 0 ? c.waitMs / c.jobs : 0.0;
+        s.maxWaitMs = c.maxWaitMs;
+        s.utilization = windowMs > 0 ? c.busyMs / windowMs : 0.0;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void RgaScheduler::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& c : m_cores) {
+        c.jobs = 0;
+        c.fallbacks = 0;
+        c.busyMs = 0.0;
+        c.waitMs = 0.0;
+        c.maxWaitMs = 0.0;
+    }
+    m_windowStart = std::chrono::steady_clock::now();
+}
+
+void RgaScheduler::dumpStats()
+{
+    for (const auto& s : snapshot()) {
+        qDebug() << "[RGA调度]" << s.name
+                 << "任务:" << s.jobs
+                 << "回退:" << s.fallbacks
+                 << "利用率:" << QString::number(s.utilization * 100.0, 'f', 1) << "%"
+                 << "平均等待:" << QString::number(s.avgWaitMs, 'f', 2) << "ms"
+                 << "最大等待:" << QString::number(s.maxWaitMs, 'f', 2) << "ms";
+    }
+}
+
+// ==========================================
+// RgaCoreGuard
+// ==========================================
+
+// imconfig 的配置是线程私有的，记录当前线程已绑定的核心，避免每帧重复下发
+static thread_local int t_boundCore = -1;
+
+RgaCoreGuard::RgaCoreGuard(int preferredCore)
+{
+    m_core = RgaScheduler::instance().acquire(preferredCore, m_waitMs);
+    if (t_boundCore != m_core) {
+        IM_STATUS ret = imconfig(IM_CONFIG_SCHEDULER_CORE, RgaScheduler::coreMask(m_core));
+        if (ret == IM_STATUS_SUCCESS || ret == IM_STATUS_NOERROR) {
+            t_boundCore = m_core;
+        } else {
+            qDebug() << "【警告】imconfig 绑定 RGA 核心失败:" << imStrError(ret);
+        }
+    }
+    m_start = std::chrono::steady_clock::now();
+}
+
+RgaCoreGuard::~RgaCoreGuard()
+{
+    double busyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    RgaScheduler::instance().release(m_core, busyMs);
+}
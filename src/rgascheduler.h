@@ -0,0 +1,86 @@
+#ifndef RGASCHEDULER_H
+#define RGASCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "im2d.hpp"
+
+// ==========================================
+// RGA 多核调度器
+// RK3588 有 3 个 RGA 核心 (RGA3 core0/core1 + RGA2 core0)，librga 默认全部
+// 挤在同一个核心上串行执行。这里给每个推理线程分配一个专属核心，
+// 专属核心忙时按负载回退到最空闲的核心，并统计每个核心的利用率和排队时间。
+// ==========================================
+class RgaScheduler
+{
+public:
+    static const int CORE_COUNT = 3;
+
+    struct CoreStats {
+        const char* name;
+        uint64_t jobs;       // 完成的任务数
+        uint64_t fallbacks;  // 从其他线程回退过来的任务数
+        double   busyMs;     // 累计占用时间
+        double   avgWaitMs;  // 平均排队时间
+        double   maxWaitMs;  // 最大排队时间
+        double   utilization;// 占用时间 / 统计窗口时长
+    };
+
+    static RgaScheduler& instance();
+
+    // 申请一个核心：优先 preferredCore，忙时回退，全忙时阻塞等待
+    // 返回实际拿到的核心下标，waitMs 输出排队耗时
+    int acquire(int preferredCore, double& waitMs);
+    void release(int core, double busyMs);
+
+    std::vector<CoreStats> snapshot();
+    void resetStats();
+    void dumpStats();
+
+    static IM_SCHEDULER_CORE coreMask(int core);
+
+private:
+    RgaScheduler();
+    RgaScheduler(const RgaScheduler&) = delete;
+    RgaScheduler& operator=(const RgaScheduler&) = delete;
+
+    int pickIdleCoreLocked(int preferredCore) const;
+
+    struct Core {
+        IM_SCHEDULER_CORE mask;
+        const char* name;
+        bool busy = false;
+        uint64_t jobs = 0;
+        uint64_t fallbacks = 0;
+        double busyMs = 0.0;
+        double waitMs = 0.0;
+        double maxWaitMs = 0.0;
+    };
+
+    Core m_cores[CORE_COUNT];
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::chrono::steady_clock::time_point m_windowStart;
+};
+
+// RAII 守卫：构造时申请核心并通过 imconfig 绑定到当前线程，析构时归还
+class RgaCoreGuard
+{
+public:
+    explicit RgaCoreGuard(int preferredCore);
+    ~RgaCoreGuard();
+
+    int core() const { return m_core; }
+    double waitMs() const { return m_waitMs; }
+
+private:
+    int m_core;
+    double m_waitMs = 0.0;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // RGASCHEDULER_H
@@ -0,0 +1,241 @@
+#include "scenegate.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SCENEGATE_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCENEGATE_USE_SSE2 1
+#endif
+
+SceneGateConfig SceneGateConfig::parse(const std::string& spec)
+{
+    SceneGateConfig cfg;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = item.substr(0, eq);
+        double value = atof(item.c_str() + eq + 1);
+        if (key == "pixel") cfg.pixelThresh = std::max(1, std::min(255, (int)value));
+        else if (key == "enter") cfg.enterRatio = (float)std::max(0.0, std::min(1.0, value));
+        else if (key == "exit") cfg.exitRatio = (float)std::max(0.0, std::min(1.0, value));
+        else if (key == "hold") cfg.holdFrames = std::max(1, (int)value);
+        else if (key == "refresh") cfg.refreshMs = std::max(0, (int)value);
+        else qDebug() << "【警告】CAR_HMI_SCENE_GATE 未知参数:" << key.c_str();
+    }
+    // 退出阈值必须不高于进入阈值，否则迟滞区间不存在，会在两个状态间来回抖
+    cfg.exitRatio = std::min(cfg.exitRatio, cfg.enterRatio);
+    return cfg;
+}
+
+SceneGate::SceneGate(const SceneGateConfig& config)
+    : m_config(config)
+{
+}
+
+const char* SceneGate::simdName()
+{
+#if defined(SCENEGATE_USE_NEON)
+    return "NEON";
+#elif defined(SCENEGATE_USE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// ------------------------------------------------------------------
+// 4x4 均值降采样：dst 为 (width/4) x (height/4) 的紧密排列灰度图
+// ------------------------------------------------------------------
+void SceneGate::downsample(const uint8_t* y, int stride, int width, int height, uint8_t* dst, bool simd)
+{
+    const int outW = width / DOWNSCALE;
+    const int outH = height / DOWNSCALE;
+    for (int oy = 0; oy < outH; ++oy) {
+        const uint8_t* r0 = y + (size_t)(oy * DOWNSCALE) * stride;
+        const uint8_t* r1 = r0 + stride;
+        const uint8_t* r2 = r1 + stride;
+        const uint8_t* r3 = r2 + stride;
+        uint8_t* out = dst + (size_t)oy * outW;
+        int ox = 0;
+#if defined(SCENEGATE_USE_NEON)
+        // 一次 16 个输入像素 -> 4 个输出：两两相加 (u8->u16) 累加 4 行，再两两相加一次
+        if (simd) {
+            for (; ox + 4 <= outW; ox += 4) {
+                const int x = ox * DOWNSCALE;
+                uint16x8_t s = vpaddlq_u8(vld1q_u8(r0 + x));
+                s = vpadalq_u8(s, vld1q_u8(r1 + x));
+                s = vpadalq_u8(s, vld1q_u8(r2 + x));
+                s = vpadalq_u8(s, vld1q_u8(r3 + x));
+                uint16x4_t q = vpadd_u16(vget_low_u16(s), vget_high_u16(s));
+                uint8x8_t o = vrshrn_n_u16(vcombine_u16(q, q), 4);
+                vst1_lane_u32((uint32_t*)(out + ox), vreinterpret_u32_u8(o), 0);
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; ox < outW; ++ox) {
+            const int x = ox * DOWNSCALE;
+            unsigned sum = 0;
+            for (int k = 0; k < DOWNSCALE; ++k) {
+                sum += r0[x + k] + r1[x + k] + r2[x + k] + r3[x + k];
+            }
+            out[ox] = (uint8_t)((sum + 8) >> 4);
+        }
+    }
+}
+
+// ------------------------------------------------------------------
+// 8x8 块的绝对差之和 (a、b 行距相同)
+// ------------------------------------------------------------------
+uint32_t SceneGate::blockSad(const uint8_t* a, const uint8_t* b, int stride, bool simd)
+{
+#if defined(SCENEGATE_USE_NEON)
+    if (simd) {
+        uint16x8_t acc = vabdl_u8(vld1_u8(a), vld1_u8(b));
+        for (int row = 1; row < BLOCK; ++row) {
+            acc = vabal_u8(acc, vld1_u8(a + (size_t)row * stride), vld1_u8(b + (size_t)row * stride));
+        }
+        uint32x4_t s32 = vpaddlq_u16(acc);
+        uint64x2_t s64 = vpaddlq_u32(s32);
+        return (uint32_t)(vgetq_lane_u64(s64, 0) + vgetq_lane_u64(s64, 1));
+    }
+#elif defined(SCENEGATE_USE_SSE2)
+    // 两行拼成 16 字节，一条 psadbw 得到两行各自的 SAD
+    if (simd) {
+        __m128i acc = _mm_setzero_si128();
+        for (int row = 0; row < BLOCK; row += 2) {
+            const uint8_t* a0 = a + (size_t)row * stride;
+            const uint8_t* b0 = b + (size_t)row * stride;
+            __m128i va = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a0),
+                                            _mm_loadl_epi64((const __m128i*)(a0 + stride)));
+            __m128i vb = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)b0),
+                                            _mm_loadl_epi64((const __m128i*)(b0 + stride)));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+        return (uint32_t)(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+    }
+#else
+    (void)simd;
+#endif
+    uint32_t sum = 0;
+    for (int row = 0; row < BLOCK; ++row) {
+        const uint8_t* pa = a + (size_t)row * stride;
+        const uint8_t* pb = b + (size_t)row * stride;
+        for (int col = 0; col < BLOCK; ++col) {
+            sum += (uint32_t)std::abs((int)pa[col] - (int)pb[col]);
+        }
+    }
+    return sum;
+}
+
+bool SceneGate::shouldInfer(const CameraFrame& frame)
+{
+    if (frame.nv12.empty() || frame.width < DOWNSCALE * BLOCK || frame.height < DOWNSCALE * BLOCK) return true;
+
+    const int thumbW = frame.width / DOWNSCALE;
+    const int thumbH = frame.height / DOWNSCALE;
+    const int blocksX = thumbW / BLOCK;
+    const int blocksY = thumbH / BLOCK;
+    const uint32_t blockThresh = (uint32_t)(m_config.pixelThresh * BLOCK * BLOCK);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frames++;
+
+    // 缩略图只有原图的 1/16 (800x600 -> 200x150)，加锁做完也就几十微秒
+    if (m_thumbW != thumbW || m_thumbH != thumbH) {
+        m_thumbW = thumbW;
+        m_thumbH = thumbH;
+        m_current.assign((size_t)thumbW * thumbH, 0);
+        m_reference.clear();
+        m_static = false;
+        m_quietFrames = 0;
+    }
+    downsample(frame.nv12.data, (int)frame.nv12.step, frame.width, frame.height, m_current.data());
+
+    auto commit = [&]() {
+        m_reference.swap(m_current);
+        m_current.resize(m_reference.size());
+        m_lastInfer = frame.captureTime;
+        return true;
+    };
+    if (m_reference.empty()) return commit();
+
+    // 和上次推理那一帧比，而不是和上一帧比：缓慢漂移也会累积到阈值
+    int changed = 0;
+    for (int by = 0; by < blocksY; ++by) {
+        const size_t rowOffset = (size_t)by * BLOCK * thumbW;
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const size_t offset = rowOffset + (size_t)bx * BLOCK;
+            if (blockSad(m_current.data() + offset, m_reference.data() + offset, thumbW) > blockThresh) changed++;
+        }
+    }
+    const float ratio = (float)changed / (float)std::max(1, blocksX * blocksY);
+    m_ratioSum += ratio;
+
+    if (m_static) {
+        bool refresh = m_config.refreshMs > 0 &&
+            frame.captureTime - m_lastInfer >= std::chrono::milliseconds(m_config.refreshMs);
+        if (ratio > m_config.enterRatio) {
+            m_static = false;
+            m_quietFrames = 0;
+            return commit();
+        }
+        if (refresh) return commit();
+        m_gated++;
+        return false;
+    }
+
+    // 运动状态：连续 holdFrames 帧都足够安静才切到静止，期间照常推理
+    m_quietFrames = ratio < m_config.exitRatio ? m_quietFrames + 1 : 0;
+    if (m_quietFrames >= m_config.holdFrames) m_static = true;
+    return commit();
+}
+
+void SceneGate::store(uint64_t seq, const std::vector<Detection>& dets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 晚完成的旧帧不能覆盖新帧的结果
+    if (m_haveCached && seq < m_cachedSeq) return;
+    m_cached = dets;
+    m_cachedSeq = seq;
+    m_haveCached = true;
+}
+
+bool SceneGate::cached(std::vector<Detection>& dets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    dets = m_cached;
+    for (auto& det : dets) {
+        det.newTrack = false;
+        det.predicted = true;
+    }
+    return m_haveCached;
+}
+
+void SceneGate::dumpStats(int cameraId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_frames == 0) return;
+    qDebug() << ">>> [静止门控] 摄像头" << cameraId << simdName()
+             << "| 帧" << m_frames
+             << "| 跳过推理" << m_gated << QString::number(100.0 * m_gated / m_frames, 'f', 1) + "%"
+             << "| 平均变化块" << QString::number(100.0 * m_ratioSum / m_frames, 'f', 2) + "%"
+             << "| 当前" << (m_static ? "静止" : "运动");
+}
+
+void SceneGate::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frames = 0;
+    m_gated = 0;
+    m_ratioSum = 0.0;
+}
@@ -0,0 +1,77 @@
+#ifndef SCENEGATE_H
+#define SCENEGATE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "camerasource.h"
+#include "inference.h"
+
+// ==========================================
+// 画面静止门控
+// 小车停在田头或等人操作时，画面几乎不变，3 个 NPU 核心却还在 60fps 跑 YOLO。
+// 这里在 NV12 的 Y 平面上做 4x 降采样，再按 8x8 块和上次推理时的参考画面比 SAD：
+// 变化块占比够大才放行推理，否则直接复用上次的检测结果。
+// 进入静止要连续若干帧低于退出阈值 (迟滞)，并且每隔一段时间强制刷新一次。
+// ARM 上 SAD 走 NEON，x86 开发机走 SSE2，其余平台走标量实现。
+// ==========================================
+
+struct SceneGateConfig {
+    int pixelThresh = 6;          // 块内平均每像素差超过该值 (0~255) 记为变化块
+    float enterRatio = 0.02f;     // 静止状态下，变化块占比超过它就立刻恢复推理
+    float exitRatio = 0.005f;     // 运动状态下，变化块占比连续 holdFrames 帧低于它才进入静止
+    int holdFrames = 10;
+    int refreshMs = 1000;         // 静止状态下最多隔这么久强制推理一次
+
+    // 解析 "pixel=6,enter=0.02,exit=0.005,hold=10,refresh=1000"，只写需要改的项即可
+    static SceneGateConfig parse(const std::string& spec);
+};
+
+class SceneGate
+{
+public:
+    static const int DOWNSCALE = 4;
+    static const int BLOCK = 8;
+
+    explicit SceneGate(const SceneGateConfig& config);
+
+    // 这一帧要不要跑推理；返回 false 时用 cached() 取上次结果
+    bool shouldInfer(const CameraFrame& frame);
+    // 推理 (及跟踪) 完成后回填结果，作为之后静止帧的复用结果。
+    // 多个推理线程处理同一路摄像头时完成顺序不定：只收比已存结果更新的帧 (按采集序号 seq)
+    void store(uint64_t seq, const std::vector<Detection>& dets);
+    // 静止帧复用的结果 (只用于画面显示，不再上报记录 / 打击)：保留原帧的 frameSeq，
+    // 标记为外推且非新目标。还没有任何推理结果回填时返回 false
+    bool cached(std::vector<Detection>& dets);
+
+    void dumpStats(int cameraId);
+    void resetStats();
+
+    // 内核入口 (公开出来便于校验 SIMD 与标量结果一致)
+    static void downsample(const uint8_t* y, int stride, int width, int height, uint8_t* dst, bool simd = true);
+    static uint32_t blockSad(const uint8_t* a, const uint8_t* b, int stride, bool simd = true);
+    static const char* simdName();
+
+private:
+    SceneGateConfig m_config;
+    std::mutex m_mutex;
+
+    std::vector<uint8_t> m_reference;    // 上次推理那帧的缩略图
+    std::vector<uint8_t> m_current;
+    int m_thumbW = 0;
+    int m_thumbH = 0;
+    bool m_static = false;
+    int m_quietFrames = 0;
+    std::chrono::steady_clock::time_point m_lastInfer;
+    std::vector<Detection> m_cached;
+    uint64_t m_cachedSeq = 0;
+    bool m_haveCached = false;
+
+    uint64_t m_frames = 0;
+    uint64_t m_gated = 0;
+    double m_ratioSum = 0.0;
+};
+
+#endif // SCENEGATE_H
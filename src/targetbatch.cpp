@@ -0,0 +1,54 @@
+#include "targetbatch.h"
+#include <cstring>
+#include "protocolcodec.h"
+
+namespace targetbatch {
+
+size_t encode(const TargetBatchHeader& head, const TargetEntry* entries, int count, uint8_t* out, size_t cap,
+              const proto::Trace* trace)
+{
+    if (count < 0 || count > TARGET_BATCH_MAX) return 0;
+    size_t total = packetSize(count, trace != nullptr);
+    if (!out || cap < total) return 0;
+
+    TargetBatchHeader batch = head;
+    batch.count = (uint8_t)count;
+
+    // 逐字段按小端写出，不依赖 out 的对齐和主机字节序
+    uint8_t* p = proto::writeHeader(out, CMD_TARGET_BATCH, total - proto::headerSize(trace != nullptr), trace);
+    p = proto::writeStruct(batch, p);
+    for (int i = 0; i < count; ++i) {
+        p = proto::writeStruct(entries[i], p);
+    }
+    return total;
+}
+
+TargetEntry View::at(int i) const
+{
+    TargetEntry e;
+    proto::readStruct(entries + (size_t)i * sizeof(TargetEntry), e);
+    return e;
+}
+
+bool decodePayload(const uint8_t* payload, size_t len, View& view)
+{
+    if (!payload || len < sizeof(TargetBatchHeader)) return false;
+    proto::readStruct(payload, view.head);
+    int count = view.head.count;
+    if (count > TARGET_BATCH_MAX) return false;
+    // 长度必须刚好对上，截断或多出来的尾巴都当作坏包丢掉
+    if (len != sizeof(TargetBatchHeader) + (size_t)count * sizeof(TargetEntry)) return false;
+    view.entries = payload + sizeof(TargetBatchHeader);
+    view.count = count;
+    return true;
+}
+
+bool decode(const uint8_t* data, size_t len, View& view)
+{
+    proto::FrameView frame;
+    if (proto::decodeFrame(data, len, frame) != proto::Status::Ok) return false;
+    if (frame.type != CMD_TARGET_BATCH) return false;
+    return decodePayload(frame.payload, frame.len, view);
+}
+
+} // namespace targetbatch
@@ -0,0 +1,49 @@
+#ifndef TARGETBATCH_H
+#define TARGETBATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include "protocol_def.h"
+
+namespace proto { struct Trace; }
+
+// ==========================================
+// CMD_TARGET_BATCH 编解码
+// 报文 = FrameHeader (或 FrameHeaderV2) + TargetBatchHeader + count 个 TargetEntry (全部 1 字节对齐、小端)
+// 编码直接写进调用方给的缓冲区，解码返回指向原报文的视图，整个过程不做堆分配，
+// 每帧都发也不会给推理线程 / UI 线程添加内存抖动。
+// ==========================================
+
+namespace targetbatch {
+
+// 一条批量报文的最大字节数 (按 v2 帧头算)
+static const size_t MAX_PACKET = sizeof(FrameHeaderV2) + sizeof(TargetBatchHeader) + TARGET_BATCH_MAX * sizeof(TargetEntry);
+
+// 按 count 计算报文长度
+inline size_t packetSize(int count, bool traced = false)
+{
+    return (traced ? sizeof(FrameHeaderV2) : sizeof(FrameHeader)) + sizeof(TargetBatchHeader) + (size_t)count * sizeof(TargetEntry);
+}
+
+// 编码到 out；count 超过 TARGET_BATCH_MAX 或 cap 不够时返回 0，否则返回写入的字节数。
+// trace 不为空时写 v2 帧头 (发出前可用 proto::restamp 补写序号和发送时刻)
+size_t encode(const TargetBatchHeader& head, const TargetEntry* entries, int count, uint8_t* out, size_t cap,
+              const proto::Trace* trace = nullptr);
+
+// 解码视图：entries 指向原报文内部，调用方要保证报文在使用期间有效
+struct View {
+    TargetBatchHeader head;
+    const uint8_t* entries = nullptr;
+    int count = 0;
+
+    TargetEntry at(int i) const;
+};
+
+// data 为完整报文 (含 FrameHeader)；包头、类型、长度任一不符都返回 false
+bool decode(const uint8_t* data, size_t len, View& view);
+// 只有载荷 (FrameHeader 已被 MqttClientManager 剥掉) 时用这个
+bool decodePayload(const uint8_t* payload, size_t len, View& view);
+
+} // namespace targetbatch
+
+#endif // TARGETBATCH_H
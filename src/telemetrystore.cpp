@@ -0,0 +1,26 @@
+#include "telemetrystore.h"
+
+TelemetryStore& TelemetryStore::instance()
+{
+    static TelemetryStore store;
+    return store;
+}
+
+void TelemetryStore::updateControl(const ControlPayload& status)
+{
+    ControlSlot slot;
+    slot.value = status;
+    slot.receivedAt = std::chrono::steady_clock::now();
+    m_control.store(slot);
+    m_received.fetch_add(1, std::memory_order_relaxed);
+}
+
+Telemetry<ControlPayload> TelemetryStore::control() const
+{
+    ControlSlot slot;
+    Telemetry<ControlPayload> out;
+    out.version = m_control.load(slot);
+    out.value = slot.value;
+    out.receivedAt = slot.receivedAt;
+    return out;
+}
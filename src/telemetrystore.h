@@ -0,0 +1,99 @@
+#ifndef TELEMETRYSTORE_H
+#define TELEMETRYSTORE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "protocol_def.h"
+
+// ==========================================
+// 下位机遥测状态仓库
+// Paho 回调线程解码完直接写进这里 (每种状态一个 seqlock 快照)，不再经过 Qt 事件循环：
+//   - UI 用自己的定时器按刷新率轮询，底盘状态报得再快也不会堆积信号、拖慢界面
+//   - 控制逻辑 (运动补偿、打击调度) 随时读最新值，读端不加锁、不阻塞写端
+// 单写者 (Paho 回调线程) 多读者；读到写了一半的数据会自动重读。
+// ==========================================
+
+// 序列锁：写时序号变奇数，写完变偶数；读端前后两次序号一致且为偶数才算读到完整快照
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock 只能存放可按字节拷贝的结构体");
+
+public:
+    // 仅允许单个写线程
+    void store(const T& value)
+    {
+        uint32_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&m_value, &value, sizeof(T));
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // 返回读到的版本号 (写入次数)
+    uint32_t load(T& out) const
+    {
+        while (true) {
+            uint32_t before = m_seq.load(std::memory_order_acquire);
+            if (before & 1) continue;   // 正在写，写端只拷几十字节，直接自旋
+            memcpy(&out, &m_value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t after = m_seq.load(std::memory_order_relaxed);
+            if (before == after) return before / 2;
+        }
+    }
+
+    // 不读数据，只看有没有更新过
+    uint32_t version() const { return m_seq.load(std::memory_order_acquire) / 2; }
+
+private:
+    std::atomic<uint32_t> m_seq{0};
+    T m_value{};
+};
+
+// 带接收时刻的快照
+template<typename T>
+struct Telemetry {
+    T value{};
+    std::chrono::steady_clock::time_point receivedAt;
+    uint32_t version = 0;    // 0 表示还没收到过
+
+    bool valid() const { return version != 0; }
+    double ageMs(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const
+    {
+        return std::chrono::duration<double, std::milli>(now - receivedAt).count();
+    }
+};
+
+class TelemetryStore
+{
+public:
+    static TelemetryStore& instance();
+
+    // 写端 (Paho 回调线程)
+    void updateControl(const ControlPayload& status);
+
+    // 读端 (任意线程)
+    Telemetry<ControlPayload> control() const;
+    uint32_t controlVersion() const { return m_control.version(); }
+
+    // 统计：收到的状态报文总数
+    uint64_t received() const { return m_received.load(std::memory_order_relaxed); }
+
+private:
+    TelemetryStore() = default;
+    TelemetryStore(const TelemetryStore&) = delete;
+    TelemetryStore& operator=(const TelemetryStore&) = delete;
+
+    struct ControlSlot {
+        ControlPayload value;
+        std::chrono::steady_clock::time_point receivedAt;
+    };
+    SeqLock<ControlSlot> m_control;
+    std::atomic<uint64_t> m_received{0};
+};
+
+#endif // TELEMETRYSTORE_H
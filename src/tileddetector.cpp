@@ -0,0 +1,219 @@
+#include "tileddetector.h"
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <cmath>
+
+bool TileConfig::parse(const std::string& spec, TileConfig& cfg)
+{
+    std::string s = spec;
+    size_t plus = s.find('+');
+    if (plus != std::string::npos) {
+        cfg.fullFrame = (s.substr(plus + 1) == "full");
+        s = s.substr(0, plus);
+    }
+    size_t at = s.find('@');
+    if (at != std::string::npos) {
+        cfg.overlap = (float)atof(s.substr(at + 1).c_str());
+        s = s.substr(0, at);
+    }
+    int cols = 0, rows = 0;
+    if (sscanf(s.c_str(), "%dx%d", &cols, &rows) != 2 || cols <= 0 || rows <= 0) return false;
+    cfg.cols = cols;
+    cfg.rows = rows;
+    cfg.overlap = std::max(0.f, std::min(0.9f, cfg.overlap));
+    return true;
+}
+
+TiledDetector::TiledDetector(const TileConfig& config)
+    : m_config(config)
+{
+}
+
+// 一个方向上的切分：count 块等距铺满 length，相邻块重叠 overlap 比例
+static void splitAxis(int length, int count, float overlap, std::vector<std::pair<int, int>>& spans)
+{
+    length &= ~1;
+    spans.clear();
+    if (count <= 1) {
+        spans.push_back(std::make_pair(0, length));
+        return;
+    }
+    int tile = (int)std::ceil(length / (count - (count - 1) * overlap));
+    tile = std::min(length, (tile + 1) & ~1);
+    for (int i = 0; i < count; ++i) {
+        int start = (int)std::lround((double)i * (length - tile) / (count - 1)) & ~1;
+        spans.push_back(std::make_pair(start, tile));
+    }
+}
+
+std::vector<cv::Rect> TiledDetector::makeTiles(const cv::Size& frameSize, const TileConfig& config)
+{
+    std::vector<std::pair<int, int>> xs, ys;
+    splitAxis(frameSize.width, config.cols, config.overlap, xs);
+    splitAxis(frameSize.height, config.rows, config.overlap, ys);
+    std::vector<cv::Rect> tiles;
+    for (const auto& y : ys) {
+        for (const auto& x : xs) {
+            tiles.push_back(cv::Rect(x.first, y.first, x.second, y.second));
+        }
+    }
+    return tiles;
+}
+
+std::vector<Detection> TiledDetector::merge(std::vector<Detection>& dets, const TileConfig& config)
+{
+    std::sort(dets.begin(), dets.end(), [](const Detection& a, const Detection& b) {
+        return a.confidence > b.confidence;
+    });
+
+    std::vector<Detection> kept;
+    std::vector<bool> suppressed(dets.size(), false);
+    for (size_t i = 0; i < dets.size(); ++i) {
+        if (suppressed[i]) continue;
+        Detection best = dets[i];
+        bool grown = false;
+        for (size_t j = i + 1; j < dets.size(); ++j) {
+            if (suppressed[j] || dets[j].class_id != best.class_id) continue;
+            const cv::Rect& other = dets[j].box;
+            double inter = (best.box & other).area();
+            if (inter <= 0) continue;
+            double areaA = best.box.area(), areaB = other.area();
+            double iou = inter / (areaA + areaB - inter);
+            double ios = inter / std::min(areaA, areaB);
+            if (iou > config.nmsIou) {
+                suppressed[j] = true;
+            } else if (ios > config.mergeIos) {
+                // 块边界把同一棵苗切成了两半：合成外接框
+                best.box |= other;
+                suppressed[j] = true;
+                grown = true;
+            }
+        }
+        if (grown) {
+            best.targetX = best.box.x + best.box.width / 2;
+            best.targetY = best.box.y + best.box.height / 2;
+            best.preciseTarget = cv::Point2f(best.box.x + best.box.width * 0.5f, best.box.y + best.box.height * 0.5f);
+        }
+        kept.push_back(best);
+    }
+    return kept;
+}
+
+void TiledDetector::runJobLocked(std::unique_lock<std::mutex>& lock, const Job& job, Inference* worker)
+{
+    lock.unlock();
+    std::vector<Detection> dets = worker->runInference(job.batch->frame, job.batch->tiles[job.index]);
+    lock.lock();
+    job.batch->results[job.index] = std::move(dets);
+    m_tilesRun++;
+    if (--job.batch->remaining == 0) {
+        m_cond.notify_all();
+    }
+}
+
+std::vector<Detection> TiledDetector::detect(const Nv12Frame& frame, Inference* worker)
+{
+    auto t0 = std::chrono::steady_clock::now();
+
+    Batch batch;
+    batch.frame = frame;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    cv::Size size(frame.width, frame.height);
+    if (size != m_tileFrameSize) {
+        m_tiles = makeTiles(size, m_config);
+        m_tileFrameSize = size;
+    }
+    batch.tiles = m_tiles;
+    if (m_config.fullFrame) {
+        batch.tiles.push_back(cv::Rect(0, 0, frame.width & ~1, frame.height & ~1));
+    }
+    batch.results.resize(batch.tiles.size());
+    batch.remaining = (int)batch.tiles.size();
+
+    for (int i = 0; i < (int)batch.tiles.size(); ++i) {
+        m_jobs.push_back(Job{&batch, i});
+    }
+    m_cond.notify_all();
+
+    // 自己也不闲着：队列里有块就跑 (不一定是本帧的)，没有就等别人把本帧剩下的块跑完
+    while (batch.remaining > 0) {
+        if (m_shutdown) {
+            // 停机：本帧还没开跑的块撤回 (batch 在栈上，不能留在队列里)，只等别人手上正在跑的，返回已经跑完的结果
+            for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+                if (it->batch == &batch) {
+                    it = m_jobs.erase(it);
+                    batch.remaining--;
+                } else {
+                    ++it;
+                }
+            }
+            if (batch.remaining > 0) m_cond.wait(lock);
+        } else if (!m_jobs.empty()) {
+            Job job = m_jobs.front();
+            m_jobs.pop_front();
+            runJobLocked(lock, job, worker);
+        } else {
+            m_cond.wait(lock);
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    m_batches++;
+    m_batchMsSum += ms;
+    m_batchMsMax = std::max(m_batchMsMax, ms);
+    lock.unlock();
+
+    std::vector<Detection> all;
+    for (auto& r : batch.results) {
+        all.insert(all.end(), r.begin(), r.end());
+    }
+    return merge(all, m_config);
+}
+
+bool TiledDetector::runPending(Inference* worker, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]{
+        return m_shutdown || !m_jobs.empty();
+    });
+    if (m_jobs.empty()) return false;
+    Job job = m_jobs.front();
+    m_jobs.pop_front();
+    runJobLocked(lock, job, worker);
+    return true;
+}
+
+void TiledDetector::shutdown()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_cond.notify_all();
+}
+
+void TiledDetector::restart()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = false;
+}
+
+void TiledDetector::dumpStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int tilesPerFrame = (int)m_tiles.size() + (m_config.fullFrame ? 1 : 0);
+    qDebug() << "[切块推理]" << m_config.cols << "x" << m_config.rows
+             << "重叠:" << QString::number(m_config.overlap, 'f', 2)
+             << "每帧块数:" << tilesPerFrame
+             << "帧数:" << m_batches << "块数:" << m_tilesRun
+             << "单帧耗时:" << QString::number(m_batches ? m_batchMsSum / m_batches : 0.0, 'f', 1) << "/"
+             << QString::number(m_batchMsMax, 'f', 1) << "ms";
+}
+
+void TiledDetector::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_batches = 0;
+    m_tilesRun = 0;
+    m_batchMsSum = 0.0;
+    m_batchMsMax = 0.0;
+}
@@ -0,0 +1,89 @@
+#ifndef TILEDDETECTOR_H
+#define TILEDDETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+// ==========================================
+// 切块推理 (小苗高召回模式)
+// 整帧缩到 640x640 后，只有几个像素宽的小苗落在 stride-8 检测头的分辨率以下。
+// 切块模式把高分辨率画面切成互相重叠的若干块，每块单独 letterbox 到 640x640 推理，
+// 同一帧的所有块作为一批分给 3 个 NPU 上下文并行跑，结果映射回整帧坐标后做跨块 NMS。
+// 用富余的 NPU 算力换早期苗期的召回率。
+// ==========================================
+
+struct TileConfig {
+    int cols = 2;
+    int rows = 2;
+    float overlap = 0.2f;      // 相邻块重叠比例 (相对块宽/高)
+    bool fullFrame = false;    // 额外跑一次整帧推理，兜住比块还大的目标
+    float nmsIou = 0.5f;       // 跨块 NMS 的 IoU 阈值
+    float mergeIos = 0.7f;     // 交集 / 较小框面积 超过该值时视为被块边界截断的同一目标，合并成外接框
+
+    // 解析 "列x行[@重叠][+full]"，例如 "3x2@0.25+full"；格式不对返回 false
+    static bool parse(const std::string& spec, TileConfig& cfg);
+};
+
+class TiledDetector
+{
+public:
+    explicit TiledDetector(const TileConfig& config);
+
+    const TileConfig& config() const { return m_config; }
+
+    // 按配置把 frameSize 切成重叠块，块起点与宽高均 2 对齐 (NV12 要求)
+    static std::vector<cv::Rect> makeTiles(const cv::Size& frameSize, const TileConfig& config);
+    // 跨块 NMS：同类框按置信度贪心抑制，被块边界截断的碎框合并成外接框
+    static std::vector<Detection> merge(std::vector<Detection>& dets, const TileConfig& config);
+
+    // 取到帧的推理线程调用：切块入队，自己也参与跑块，直到本帧所有块完成，返回合并后的结果
+    // frame 的内存在返回前必须一直有效
+    std::vector<Detection> detect(const Nv12Frame& frame, Inference* worker);
+    // 其余推理线程调用：有块就用自己的 NPU 上下文跑一块，没有就最多等 timeoutMs
+    bool runPending(Inference* worker, int timeoutMs);
+    // 唤醒所有在等块的线程；正在 detect 的撤回本帧未开跑的块，带着已完成的结果返回
+    void shutdown();
+    // shutdown 之后重新启动推理线程前调用
+    void restart();
+
+    void dumpStats();
+    void resetStats();
+
+private:
+    struct Batch {
+        Nv12Frame frame;
+        std::vector<cv::Rect> tiles;
+        std::vector<std::vector<Detection>> results;
+        int remaining = 0;
+    };
+    struct Job {
+        Batch* batch;
+        int index;
+    };
+
+    // 调用时持有 lock，跑块时临时解锁
+    void runJobLocked(std::unique_lock<std::mutex>& lock, const Job& job, Inference* worker);
+
+    TileConfig m_config;
+    std::deque<Job> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;   // 有新块入队 / 有块完成 / 关闭 都会通知
+    bool m_shutdown = false;
+
+    cv::Size m_tileFrameSize;         // 切块结果按帧尺寸缓存
+    std::vector<cv::Rect> m_tiles;
+
+    // 统计 (受 m_mutex 保护)
+    uint64_t m_batches = 0;
+    uint64_t m_tilesRun = 0;
+    double m_batchMsSum = 0.0;
+    double m_batchMsMax = 0.0;
+};
+
+#endif // TILEDDETECTOR_H
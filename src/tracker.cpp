@@ -0,0 +1,362 @@
+#include "tracker.h"
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <cmath>
+
+// 光流在 1/8 分辨率的 Y 上做，800x600 只有 100x75，相位相关一次不到 0.1ms
+static const int kFlowScale = 8;
+// 相位相关峰值响应低于该值说明画面变化太大 (转弯、遮挡、换行)，光流不可信
+static const double kFlowMinResponse = 0.1;
+
+static double secondsBetween(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+{
+    return std::chrono::duration<double>(b - a).count();
+}
+
+MultiObjectTracker::MultiObjectTracker(const TrackerConfig& config)
+    : m_config(config)
+{
+    m_config.maxDetectInterval = std::max(1, m_config.maxDetectInterval);
+}
+
+void MultiObjectTracker::setChassisVelocity(const cv::Point2f& pxPerSec)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_chassisVelocity = pxPerSec;
+    m_haveChassis = true;
+}
+
+bool MultiObjectTracker::sceneVelocity(const CameraFrame& frame, cv::Point2f& pxPerSec)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_sceneVelocitySeq != frame.seq) return false;
+    pxPerSec = m_sceneVelocity;
+    return true;
+}
+
+int MultiObjectTracker::detectInterval()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_interval;
+}
+
+float MultiObjectTracker::iouOf(const Track& t, const cv::Rect& box)
+{
+    float ax1 = t.cx - t.w * 0.5f, ay1 = t.cy - t.h * 0.5f;
+    float ax2 = t.cx + t.w * 0.5f, ay2 = t.cy + t.h * 0.5f;
+    float bx1 = (float)box.x, by1 = (float)box.y;
+    float bx2 = (float)(box.x + box.width), by2 = (float)(box.y + box.height);
+    float iw = std::min(ax2, bx2) - std::max(ax1, bx1);
+    float ih = std::min(ay2, by2) - std::max(ay1, by1);
+    if (iw <= 0.f || ih <= 0.f) return 0.f;
+    float inter = iw * ih;
+    return inter / (t.w * t.h + (float)box.area() - inter);
+}
+
+bool MultiObjectTracker::needDetection(const CameraFrame& frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool due = m_config.maxDetectInterval <= 1 || m_forceDetect || !m_detectedOnce ||
+               frame.seq < m_lastDetectSeq || frame.seq >= m_lastDetectSeq + (uint64_t)m_interval;
+    if (due) {
+        m_lastDetectSeq = frame.seq;
+        m_detectedOnce = true;
+        m_forceDetect = false;
+    }
+    return due;
+}
+
+void MultiObjectTracker::downsampleY(const CameraFrame& frame, cv::Mat& small) const
+{
+    // 每帧都检测时光流仍然要算：运动补偿 (MotionPredictor) 靠它标定底盘速度
+    if (frame.nv12.empty() || frame.width < kFlowScale * 8 || frame.height < kFlowScale * 8) return;
+    cv::Mat y = frame.nv12(cv::Rect(0, 0, frame.width, frame.height));
+    cv::Mat tmp;
+    cv::resize(y, tmp, cv::Size(frame.width / kFlowScale, frame.height / kFlowScale), 0, 0, cv::INTER_AREA);
+    tmp.convertTo(small, CV_32F);
+}
+
+bool MultiObjectTracker::predictLocked(const CameraFrame& frame, const cv::Mat& small)
+{
+    // 多个推理线程处理同一路摄像头时帧可能乱序完成；过时的帧不再推动轨迹
+    if (m_haveFrame && frame.seq <= m_lastSeq) return false;
+
+    double dt = m_haveFrame ? std::max(0.0, secondsBetween(m_lastTime, frame.captureTime)) : 0.0;
+    cv::Point2f shift(0.f, 0.f);
+    bool haveShift = false;
+
+    if (m_haveFrame && dt > 0.0 && !small.empty() && m_prevSmall.size() == small.size()) {
+        if (m_window.size() != small.size()) {
+            cv::createHanningWindow(m_window, small.size(), CV_32F);
+        }
+        double response = 0.0;
+        cv::Point2d s = cv::phaseCorrelate(m_prevSmall, small, m_window, &response);
+        if (response >= kFlowMinResponse) {
+            shift = cv::Point2f((float)s.x * kFlowScale, (float)s.y * kFlowScale);
+            haveShift = true;
+            m_sceneVelocity = cv::Point2f((float)(shift.x / dt), (float)(shift.y / dt));
+            m_sceneVelocitySeq = frame.seq;
+        }
+        // 光流失效或一帧之内挪了四分之一个画面：下一帧必须重新检测
+        if (!haveShift || std::abs(shift.x) > frame.width / 4 || std::abs(shift.y) > frame.height / 4) {
+            m_forceDetect = true;
+        }
+    }
+    if (!haveShift && m_haveChassis && dt > 0.0) {
+        shift = cv::Point2f((float)(m_chassisVelocity.x * dt), (float)(m_chassisVelocity.y * dt));
+        haveShift = true;
+    }
+
+    for (auto& t : m_tracks) {
+        if (!t.active) continue;
+        if (haveShift) {
+            t.cx += shift.x;
+            t.cy += shift.y;
+        } else if (t.hasVelocity) {
+            t.cx += (float)(t.vx * dt);
+            t.cy += (float)(t.vy * dt);
+        }
+        // 整个框移出画面就不用再跟了
+        if (t.cx + t.w * 0.5f < 0 || t.cy + t.h * 0.5f < 0 ||
+            t.cx - t.w * 0.5f > frame.width || t.cy - t.h * 0.5f > frame.height) {
+            if (t.confirmed) m_lostTracks++;
+            t.active = false;
+        }
+    }
+
+    if (!small.empty()) m_prevSmall = small;
+    m_lastSeq = frame.seq;
+    m_lastTime = frame.captureTime;
+    m_haveFrame = true;
+    m_frameSize = cv::Size(frame.width, frame.height);
+    return true;
+}
+
+int MultiObjectTracker::associateLocked(const std::vector<Detection>& dets, int count, bool highStage,
+                                        bool confirmedOnly, std::chrono::steady_clock::time_point now,
+                                        double& iouSum)
+{
+    // 1. 收集 IoU 足够的候选对 (稀疏，通常远少于 轨迹数 x 检测数)
+    int pairCount = 0;
+    for (int t = 0; t < MAX_TRACKS && pairCount < MAX_PAIRS; ++t) {
+        const Track& track = m_tracks[t];
+        if (!track.active || m_trackUsed[t] || (confirmedOnly && !track.confirmed)) continue;
+        for (int d = 0; d < count && pairCount < MAX_PAIRS; ++d) {
+            if (m_detUsed[d]) continue;
+            if ((dets[d].confidence >= m_config.highThresh) != highStage) continue;
+            float iou = iouOf(track, dets[d].box);
+            if (iou < m_config.matchIou) continue;
+            m_pairs[pairCount].iou = iou;
+            m_pairs[pairCount].track = (short)t;
+            m_pairs[pairCount].det = (short)d;
+            pairCount++;
+        }
+    }
+
+    // 2. 按 IoU 从大到小贪心匹配 (在固定数组上原地排序，不分配内存)
+    std::sort(m_pairs, m_pairs + pairCount, [](const Pair& a, const Pair& b) { return a.iou > b.iou; });
+    int matched = 0;
+    for (int i = 0; i < pairCount; ++i) {
+        const Pair& p = m_pairs[i];
+        if (m_trackUsed[p.track] || m_detUsed[p.det]) continue;
+        m_trackUsed[p.track] = true;
+        m_detUsed[p.det] = true;
+        m_matchOf[p.track] = p.det;
+        iouSum += p.iou;
+        matched++;
+
+        // 3. 量测更新：框直接取检测结果，速度用两次量测之差平滑
+        Track& t = m_tracks[p.track];
+        const Detection& det = dets[p.det];
+        float mcx = det.box.x + det.box.width * 0.5f;
+        float mcy = det.box.y + det.box.height * 0.5f;
+        double dtm = secondsBetween(t.lastMeasure, now);
+        if (dtm > 1e-3) {
+            float ivx = (float)((mcx - t.lastMeasCx) / dtm);
+            float ivy = (float)((mcy - t.lastMeasCy) / dtm);
+            t.vx = t.hasVelocity ? 0.6f * t.vx + 0.4f * ivx : ivx;
+            t.vy = t.hasVelocity ? 0.6f * t.vy + 0.4f * ivy : ivy;
+            t.hasVelocity = true;
+        }
+        t.cx = t.lastMeasCx = mcx;
+        t.cy = t.lastMeasCy = mcy;
+        t.w = (float)det.box.width;
+        t.h = (float)det.box.height;
+        t.lastMeasure = now;
+        t.confidence = det.confidence;
+        t.classId = det.class_id;
+        t.className = det.className;
+        t.aimOffset = cv::Point2f(det.preciseTarget.x - mcx, det.preciseTarget.y - mcy);
+        t.refined = det.refined;
+        t.missed = 0;
+        if (++t.hits >= m_config.minHits) t.confirmed = true;
+    }
+    return matched;
+}
+
+void MultiObjectTracker::adaptIntervalLocked(int matched, int unmatchedDets, int lostTracks, double iouSum)
+{
+    if (m_config.maxDetectInterval <= 1) {
+        m_interval = 1;
+        return;
+    }
+    // 新出现 / 丢失的目标占比衡量场景变化，匹配 IoU 衡量外推准不准
+    int total = matched + unmatchedDets + lostTracks;
+    double churn = total ? (double)(unmatchedDets + lostTracks) / total : 0.0;
+    double meanIou = matched ? iouSum / matched : 1.0;
+    if (churn > 0.3 || meanIou < 0.5) {
+        m_interval = std::max(1, m_interval / 2);
+    } else if (churn < 0.1 && meanIou >= 0.6) {
+        m_interval = std::min(m_config.maxDetectInterval, m_interval + 1);
+    }
+}
+
+void MultiObjectTracker::emitLocked(std::vector<Detection>& out, bool matchedOnly, bool predicted, int cameraId)
+{
+    out.clear();
+    for (int i = 0; i < MAX_TRACKS; ++i) {
+        Track& t = m_tracks[i];
+        if (!t.active || !t.confirmed) continue;
+        if (matchedOnly && m_matchOf[i] < 0) continue;
+
+        Detection det;
+        det.class_id = t.classId;
+        det.className = t.className;
+        det.confidence = t.confidence;
+        det.box = cv::Rect((int)std::round(t.cx - t.w * 0.5f), (int)std::round(t.cy - t.h * 0.5f),
+                           (int)std::round(t.w), (int)std::round(t.h));
+        det.preciseTarget = cv::Point2f(t.cx + t.aimOffset.x, t.cy + t.aimOffset.y);
+        det.targetX = (int)std::round(det.preciseTarget.x);
+        det.targetY = (int)std::round(det.preciseTarget.y);
+        det.refined = t.refined;
+        det.cameraId = cameraId;
+        det.trackId = t.id;
+        det.predicted = predicted;
+        det.newTrack = !t.reported;
+        det.captureTime = m_lastTime;
+        t.reported = true;
+        out.push_back(det);
+    }
+}
+
+void MultiObjectTracker::update(const CameraFrame& frame, std::vector<Detection>& dets)
+{
+    cv::Mat small;
+    downsampleY(frame, small);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!predictLocked(frame, small)) {
+        // 过时帧的测量时刻比轨迹当前状态还早，拿来关联会把位置 / 速度拉回去、把好好的轨迹判丢：
+        // 不碰轨迹，检测原样放行 (trackId = -1)
+        m_staleFrames++;
+        for (auto& det : dets) {
+            det.trackId = -1;
+            det.newTrack = false;
+        }
+        return;
+    }
+    m_detectFrames++;
+
+    int count = std::min((int)dets.size(), (int)MAX_DETS);
+    std::fill(m_trackUsed, m_trackUsed + MAX_TRACKS, false);
+    std::fill(m_detUsed, m_detUsed + MAX_DETS, false);
+    std::fill(m_matchOf, m_matchOf + MAX_TRACKS, (short)-1);
+
+    // 第一轮：高分框对所有轨迹；第二轮：低分框只对已确认轨迹捡漏 (ByteTrack)
+    double iouSum = 0.0;
+    int matched = associateLocked(dets, count, true, false, frame.captureTime, iouSum);
+    matched += associateLocked(dets, count, false, true, frame.captureTime, iouSum);
+
+    // 没匹配上的轨迹累计丢失次数
+    int lost = 0;
+    for (int i = 0; i < MAX_TRACKS; ++i) {
+        Track& t = m_tracks[i];
+        if (!t.active || m_trackUsed[i]) continue;
+        if (++t.missed > m_config.maxMissed || !t.confirmed) {
+            if (t.confirmed) lost++;
+            t.active = false;
+        }
+    }
+    m_lostTracks += lost;
+
+    // 没匹配上的高分框开新轨迹
+    int created = 0;
+    int slot = 0;
+    for (int d = 0; d < count; ++d) {
+        if (m_detUsed[d] || dets[d].confidence < m_config.highThresh) continue;
+        while (slot < MAX_TRACKS && m_tracks[slot].active) slot++;
+        if (slot >= MAX_TRACKS) break;
+
+        const Detection& det = dets[d];
+        Track& t = m_tracks[slot];
+        t = Track();
+        t.active = true;
+        t.id = m_nextId++;
+        t.classId = det.class_id;
+        t.className = det.className;
+        t.confidence = det.confidence;
+        t.cx = t.lastMeasCx = det.box.x + det.box.width * 0.5f;
+        t.cy = t.lastMeasCy = det.box.y + det.box.height * 0.5f;
+        t.w = (float)det.box.width;
+        t.h = (float)det.box.height;
+        t.aimOffset = cv::Point2f(det.preciseTarget.x - t.cx, det.preciseTarget.y - t.cy);
+        t.refined = det.refined;
+        t.hits = 1;
+        t.confirmed = m_config.minHits <= 1;
+        t.lastMeasure = frame.captureTime;
+        m_matchOf[slot] = (short)d;
+        created++;
+    }
+    m_newTracks += created;
+
+    adaptIntervalLocked(matched, created, lost, iouSum);
+
+    // 输出 = 本帧匹配上的已确认轨迹 + 没落到已确认轨迹上的检测原样保留 (trackId = -1)：
+    // 低于 highThresh 的框、还没攒够 minHits 的新目标照常记录和打击，跟踪器只负责去重
+    std::vector<Detection> raw;
+    raw.swap(dets);
+    emitLocked(dets, true, false, frame.cameraId);
+    std::fill(m_detUsed, m_detUsed + MAX_DETS, false);
+    for (int i = 0; i < MAX_TRACKS; ++i) {
+        if (m_tracks[i].active && m_tracks[i].confirmed && m_matchOf[i] >= 0) m_detUsed[m_matchOf[i]] = true;
+    }
+    for (int d = 0; d < (int)raw.size(); ++d) {
+        if (d < count && m_detUsed[d]) continue;
+        raw[d].trackId = -1;
+        raw[d].newTrack = false;
+        dets.push_back(std::move(raw[d]));
+    }
+}
+
+void MultiObjectTracker::propagate(const CameraFrame& frame, std::vector<Detection>& dets)
+{
+    cv::Mat small;
+    downsampleY(frame, small);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    predictLocked(frame, small);
+    m_propagatedFrames++;
+    emitLocked(dets, false, true, frame.cameraId);
+}
+
+void MultiObjectTracker::dumpStats(int cameraId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int active = 0;
+    for (const auto& t : m_tracks) {
+        if (t.active && t.confirmed) active++;
+    }
+    qDebug() << "[跟踪 摄像头" << cameraId << "]"
+             << "检测帧:" << m_detectFrames << "外推帧:" << m_propagatedFrames << "过时帧:" << m_staleFrames
+             << "当前间隔:" << m_interval << "活跃轨迹:" << active
+             << "新轨迹:" << m_newTracks << "丢失:" << m_lostTracks
+             << "光流速度:" << QString::number(m_sceneVelocity.x, 'f', 0) << ","
+             << QString::number(m_sceneVelocity.y, 'f', 0) << "px/s";
+}
+
+void MultiObjectTracker::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_detectFrames = m_propagatedFrames = m_staleFrames = m_newTracks = m_lostTracks = 0;
+}
@@ -0,0 +1,129 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "camerasource.h"
+#include "inference.h"
+
+// ==========================================
+// 多目标跟踪 (ByteTrack 风格的两段式关联)
+// 给检测结果分配稳定的轨迹 ID，同一棵苗只记录 / 打击一次；
+// 并支持每 N 帧才跑一次 NPU：中间帧用全局光流 (或底盘速度) 把轨迹外推过去，
+// N 随场景变化自适应：画面稳定时拉长，出现大量新目标 / 丢目标时立刻缩短。
+// 关联过程全部在固定大小的数组上完成，不做任何堆分配。
+// ==========================================
+
+struct TrackerConfig {
+    float highThresh = 0.6f;     // 高分检测阈值：第一轮只用高分框关联，低分框第二轮捡漏
+    float matchIou = 0.3f;       // 关联所需最小 IoU
+    int minHits = 2;             // 连续命中几次才确认为轨迹 (避免单帧误检)
+    int maxMissed = 5;           // 连续几次检测都没匹配上就删除
+    int maxDetectInterval = 1;   // 最多隔几帧跑一次 NPU，1 表示每帧都检测
+};
+
+class MultiObjectTracker
+{
+public:
+    static const int MAX_TRACKS = 128;
+    static const int MAX_DETS = 256;
+    static const int MAX_PAIRS = 4096;
+
+    explicit MultiObjectTracker(const TrackerConfig& config);
+
+    // 这一帧要不要跑 NPU (返回 true 时同时占下这次检测，多个推理线程并发调用安全)
+    bool needDetection(const CameraFrame& frame);
+    // 跑过 NPU 的帧：关联并更新轨迹，dets 被替换为本帧匹配上的已确认轨迹 (带 trackId)
+    // 加上没匹配到已确认轨迹的原始检测 (trackId = -1)，不会因为跟踪而少报目标
+    void update(const CameraFrame& frame, std::vector<Detection>& dets);
+    // 跳过 NPU 的帧：只做运动外推，dets 输出外推后的已确认轨迹 (predicted = true)
+    void propagate(const CameraFrame& frame, std::vector<Detection>& dets);
+
+    // 外部给出的底盘运动 (换算到图像上的像素/秒)；光流不可用时用它外推
+    void setChassisVelocity(const cv::Point2f& pxPerSec);
+    // 本帧光流得到的画面整体速度 (像素/秒)；这一帧光流不可用时返回 false
+    bool sceneVelocity(const CameraFrame& frame, cv::Point2f& pxPerSec);
+
+    int detectInterval();
+    void dumpStats(int cameraId);
+    void resetStats();
+
+private:
+    struct Track {
+        bool active = false;
+        bool confirmed = false;
+        bool reported = false;   // 已经作为新目标上报过
+        int id = 0;
+        int classId = -1;
+        std::string className;
+        float confidence = 0.f;
+        float cx = 0.f, cy = 0.f, w = 0.f, h = 0.f;
+        float vx = 0.f, vy = 0.f;        // 像素/秒
+        bool hasVelocity = false;
+        cv::Point2f aimOffset;           // 精修瞄准点相对框中心的偏移
+        bool refined = false;
+        int hits = 0;
+        int missed = 0;
+        float lastMeasCx = 0.f, lastMeasCy = 0.f;
+        std::chrono::steady_clock::time_point lastMeasure;
+    };
+
+    struct Pair {
+        float iou;
+        short track;
+        short det;
+    };
+
+    // 估计上一帧 -> 本帧的全局位移 (光流优先，其次底盘速度，再次轨迹自身速度) 并外推所有轨迹；
+    // 帧比已处理过的还旧 (推理线程乱序完成) 时什么都不做，返回 false
+    bool predictLocked(const CameraFrame& frame, const cv::Mat& small);
+    void downsampleY(const CameraFrame& frame, cv::Mat& small) const;
+    // 在 trackUsed / detUsed 之外做一轮贪心 IoU 关联
+    int associateLocked(const std::vector<Detection>& dets, int count, bool highStage, bool confirmedOnly,
+                        std::chrono::steady_clock::time_point now, double& iouSum);
+    void emitLocked(std::vector<Detection>& out, bool matchedOnly, bool predicted, int cameraId);
+    void adaptIntervalLocked(int matched, int unmatchedDets, int lostTracks, double iouSum);
+
+    static float iouOf(const Track& t, const cv::Rect& box);
+
+    TrackerConfig m_config;
+    std::mutex m_mutex;
+
+    Track m_tracks[MAX_TRACKS];
+    Pair m_pairs[MAX_PAIRS];
+    bool m_trackUsed[MAX_TRACKS];
+    bool m_detUsed[MAX_DETS];
+    short m_matchOf[MAX_TRACKS];     // 本帧轨迹匹配到的检测下标，-1 表示没匹配上
+    int m_nextId = 1;
+
+    // 运动估计
+    cv::Mat m_prevSmall;             // 上一帧 1/8 分辨率的 Y (CV_32F)
+    cv::Mat m_window;                // 相位相关用的汉宁窗
+    uint64_t m_lastSeq = 0;
+    bool m_haveFrame = false;
+    std::chrono::steady_clock::time_point m_lastTime;
+    cv::Point2f m_sceneVelocity;     // 光流得到的整体运动 (像素/秒)
+    uint64_t m_sceneVelocitySeq = UINT64_MAX;  // m_sceneVelocity 来自哪一帧
+    cv::Point2f m_chassisVelocity;
+    bool m_haveChassis = false;
+    cv::Size m_frameSize;
+
+    // 检测间隔
+    int m_interval = 1;
+    uint64_t m_lastDetectSeq = 0;
+    bool m_detectedOnce = false;
+    bool m_forceDetect = true;
+
+    // 统计
+    uint64_t m_detectFrames = 0;
+    uint64_t m_propagatedFrames = 0;
+    uint64_t m_staleFrames = 0;
+    uint64_t m_newTracks = 0;
+    uint64_t m_lostTracks = 0;
+};
+
+#endif // TRACKER_H
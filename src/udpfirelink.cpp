@@ -0,0 +1,217 @@
+#include "udpfirelink.h"
+#include <QDebug>
+#include <QString>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+typedef std::chrono::steady_clock Clock;
+
+// ===================== 发送端 =====================
+
+UdpFireLink::~UdpFireLink()
+{
+    close();
+}
+
+bool UdpFireLink::open(const std::string& host, int port)
+{
+    close();
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (port <= 0 || inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        qDebug() << "【警告】UDP 打击通道地址非法:" << QString::fromStdString(host) << port;
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    // DSCP EF：Wi-Fi 上进 WMM 语音队列，比 broker 那条 TCP 流先拿到空口
+    int tos = 0xB8;
+    setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    // connect 之后内核记住对端，send 不用每次带地址
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    qDebug() << ">>> UDP 打击通道已打开:" << QString::fromStdString(host) << ":" << port
+             << "| 冗余" << m_copies.load() << "份";
+    return true;
+}
+
+void UdpFireLink::close()
+{
+    int fd = m_fd.exchange(-1);
+    if (fd >= 0) ::close(fd);
+}
+
+void UdpFireLink::setCopies(int copies)
+{
+    m_copies = std::max(1, std::min(udpfire::kMaxCopies, copies));
+}
+
+bool UdpFireLink::send(uint8_t* packet, size_t len, const proto::Trace* trace)
+{
+    int fd = m_fd.load();
+    if (fd < 0 || !packet || len < proto::kHeaderV2Size || len > udpfire::kMaxDatagram || packet[0] != proto::kMagicV2) {
+        return false;
+    }
+    proto::Trace stamp;
+    if (trace) {
+        stamp = *trace;
+    } else {
+        stamp.seq = ++m_seq;
+        stamp.sendUs = udpfire::nowUs();
+    }
+    proto::restamp(packet, stamp);
+
+    // 副本背靠背发出：单包随机丢失时另一份几乎同时到，不额外增加时延
+    thread_local std::minstd_rand rng(std::random_device{}());
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    int copies = m_copies.load();
+    int sent = 0, errors = 0, dropped = 0;
+    for (int i = 0; i < copies; ++i) {
+        if (m_dropRate > 0 && coin(rng) < m_dropRate) {
+            dropped++;
+            continue;
+        }
+        ssize_t n = ::send(fd, packet, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n == (ssize_t)len) sent++;
+        else errors++;
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.packets++;
+    m_stats.datagrams += sent;
+    m_stats.bytes += (uint64_t)sent * len;
+    m_stats.errors += errors;
+    m_stats.simulatedDrops += dropped;
+    // 模拟丢包算发出去了，和真实链路上丢一样，由调用方看不出来
+    return sent > 0 || dropped > 0;
+}
+
+UdpFireLink::Stats UdpFireLink::stats()
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void UdpFireLink::dumpStats(double elapsedSec)
+{
+    Stats st = stats();
+    if (st.packets == 0 && st.errors == 0) return;
+    qDebug() << ">>> [UDP 打击通道] 报文" << st.packets << "(" << st.packets / elapsedSec << "条/秒 )"
+             << "| 数据报" << st.datagrams << "|" << st.bytes / elapsedSec / 1024.0 << "KB/秒"
+             << "| 失败" << st.errors;
+}
+
+void UdpFireLink::resetStats()
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats = Stats();
+}
+
+// ===================== 接收端 =====================
+
+UdpFireReceiver::~UdpFireReceiver()
+{
+    close();
+}
+
+bool UdpFireReceiver::bind(int port)
+{
+    close();
+    m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_fd < 0) return false;
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    socklen_t addrLen = sizeof(addr);
+    if (::bind(m_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || getsockname(m_fd, (sockaddr*)&addr, &addrLen) != 0) {
+        qDebug() << "【警告】UDP 打击通道接收端绑定失败, 端口" << port;
+        close();
+        return false;
+    }
+    m_port = ntohs(addr.sin_port);
+    for (Latest& l : m_latest) l.valid = false;
+    return true;
+}
+
+void UdpFireReceiver::close()
+{
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+}
+
+bool UdpFireReceiver::accept(const uint8_t* data, size_t len, uint32_t recvUs, uint8_t& type)
+{
+    m_stats.received++;
+    proto::FrameView view;
+    // 没有序号就没法判断新旧，v1 帧头一律不收
+    if (proto::decodeFrame(data, len, view) != proto::Status::Ok || !view.traced || view.type >= proto::kCommandCount) {
+        m_stats.malformed++;
+        return false;
+    }
+    type = view.type;
+    Latest& slot = m_latest[type];
+    auto now = Clock::now();
+    if (slot.valid) {
+        bool quiet = now - m_lastAccept[type] > std::chrono::milliseconds(kResyncMs);
+        if (view.trace.seq == slot.seq && !quiet) {
+            m_stats.duplicates++;
+            return false;
+        }
+        if (!udpfire::seqNewer(view.trace.seq, slot.seq)) {
+            if (!quiet) {
+                m_stats.stale++;
+                return false;
+            }
+            m_stats.resyncs++;
+        }
+    }
+    slot.valid = true;
+    slot.seq = view.trace.seq;
+    slot.sendUs = view.trace.sendUs;
+    slot.recvUs = recvUs;
+    slot.len = len;
+    memcpy(slot.data, data, len);
+    m_lastAccept[type] = now;
+    m_stats.accepted++;
+    return true;
+}
+
+int UdpFireReceiver::drain(int timeoutMs, const std::function<void(uint8_t type, const Latest&)>& onAccepted)
+{
+    if (m_fd < 0) return 0;
+    pollfd pfd = {m_fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0) return 0;
+
+    int accepted = 0;
+    uint8_t buf[udpfire::kMaxDatagram + 1];
+    while (true) {
+        ssize_t n = ::recv(m_fd, buf, sizeof(buf), 0);
+        if (n < 0) break;
+        uint8_t type = 0;
+        // 超长的截断报文按非法处理 (decodeFrame 会对不上长度)
+        if (accept(buf, (size_t)n, udpfire::nowUs(), type)) {
+            accepted++;
+            if (onAccepted) onAccepted(type, m_latest[type]);
+        }
+    }
+    return accepted;
+}
@@ -0,0 +1,135 @@
+#ifndef UDPFIRELINK_H
+#define UDPFIRELINK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "protocol_def.h"
+#include "protocolcodec.h"
+#include "targetbatch.h"
+
+// ==========================================
+// UDP 直连打击通道 (不经过 broker)
+// 移动 / 目标 / 批量目标这类"只有最新值有用"的指令直接发数据报给下位机：
+// 少一跳 broker，也没有 TCP 队头阻塞 (丢一包不会卡住后面的新坐标)。
+//   - 帧格式不变，统一用 v2 帧头 (FrameHeaderV2)，靠其中的 seq 判断新旧、sendUs 算单向时延
+//   - 冗余：每条报文连发 copies 份 (同一 seq)，接收端按 seq 去重，用带宽换丢包率
+//   - 接收端按指令类型"最新者胜"：seq 不比已采纳的新就丢掉，过期的坐标不会再被执行
+// MQTT 仍负责连接状态、控制指令 (CMD_CONTROL)、回显和上行遥测。
+// 启用：CAR_HMI_FIRE_UDP=<下位机 UDP 端口>，CAR_HMI_FIRE_UDP_COPIES 调冗余份数 (默认 2)
+// ==========================================
+
+namespace udpfire {
+
+static const int kDefaultCopies = 2;
+static const int kMaxCopies = 4;
+static const size_t kMaxDatagram = targetbatch::MAX_PACKET;
+
+// 16 位序号按环形比较：a 比 b 新 (差值在半圈以内)
+inline bool seqNewer(uint16_t a, uint16_t b) { return (int16_t)(uint16_t)(a - b) > 0; }
+
+// 与 LatencyTracker 相同的时基：单调时钟微秒，低 32 位
+inline uint32_t nowUs()
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace udpfire
+
+// 发送端：不开线程，调用方 (遥控 / 批量目标发布线程) 直接 send，sendto 非阻塞，缓冲满就丢 (旧坐标不值得等)
+class UdpFireLink
+{
+public:
+    struct Stats {
+        uint64_t packets = 0;       // 逻辑报文数
+        uint64_t datagrams = 0;     // 实际发出的数据报 (含冗余副本)
+        uint64_t bytes = 0;
+        uint64_t errors = 0;        // 发送缓冲满 / 对端不可达
+        uint64_t simulatedDrops = 0;
+    };
+
+    UdpFireLink() = default;
+    ~UdpFireLink();
+    UdpFireLink(const UdpFireLink&) = delete;
+    UdpFireLink& operator=(const UdpFireLink&) = delete;
+
+    bool open(const std::string& host, int port);
+    void close();
+    bool isOpen() const { return m_fd.load() >= 0; }
+
+    void setCopies(int copies);
+    // 测试用：每份副本按概率丢弃，模拟 Wi-Fi 丢包
+    void setDropRate(double p) { m_dropRate = p; }
+
+    // packet 必须带 v2 帧头；trace 为空时由本通道分配序号并补写发送时刻，
+    // 不为空 (时延追踪已分配好序号) 时原样发出，下位机照常通过 MQTT 回显
+    bool send(uint8_t* packet, size_t len, const proto::Trace* trace = nullptr);
+
+    Stats stats();
+    void dumpStats(double elapsedSec);
+    void resetStats();
+
+private:
+    std::atomic<int> m_fd{-1};
+    std::atomic<int> m_copies{udpfire::kDefaultCopies};
+    std::atomic<uint16_t> m_seq{0};
+    double m_dropRate = 0.0;
+    std::mutex m_statsMutex;
+    Stats m_stats;
+};
+
+// 接收端参考实现 (下位机固件照此实现；自检和联调工具也用它)：
+// 每次把 socket 里积压的数据报一次读空，每种指令只保留 seq 最新的一条
+class UdpFireReceiver
+{
+public:
+    struct Latest {
+        bool valid = false;
+        uint16_t seq = 0;
+        uint32_t sendUs = 0;
+        uint32_t recvUs = 0;
+        size_t len = 0;
+        uint8_t data[udpfire::kMaxDatagram];
+    };
+    struct Stats {
+        uint64_t received = 0;
+        uint64_t accepted = 0;
+        uint64_t duplicates = 0;    // 冗余副本 (seq 与已采纳的相同)
+        uint64_t stale = 0;         // 比已采纳的旧 (乱序 / 迟到)
+        uint64_t malformed = 0;
+        uint64_t resyncs = 0;       // 长时间没收到后接受任意序号 (发送端重启)
+    };
+
+    // 超过这么久没采纳过新报文，下一条不论序号直接采纳
+    static constexpr int kResyncMs = 1000;
+
+    UdpFireReceiver() = default;
+    ~UdpFireReceiver();
+    UdpFireReceiver(const UdpFireReceiver&) = delete;
+    UdpFireReceiver& operator=(const UdpFireReceiver&) = delete;
+
+    // port 为 0 时由系统分配，bind 之后用 port() 取
+    bool bind(int port = 0);
+    int port() const { return m_port; }
+    void close();
+
+    // 最多等 timeoutMs 毫秒，把已到达的数据报读空；每采纳一条调用一次 onAccepted (可为空)。返回采纳条数
+    int drain(int timeoutMs, const std::function<void(uint8_t type, const Latest&)>& onAccepted = nullptr);
+    const Latest& latest(uint8_t type) const { return m_latest[type < proto::kCommandCount ? type : 0]; }
+    Stats stats() const { return m_stats; }
+
+private:
+    bool accept(const uint8_t* data, size_t len, uint32_t recvUs, uint8_t& type);
+
+    int m_fd = -1;
+    int m_port = 0;
+    Latest m_latest[proto::kCommandCount];
+    std::chrono::steady_clock::time_point m_lastAccept[proto::kCommandCount];
+    Stats m_stats;
+};
+
+#endif // UDPFIRELINK_H
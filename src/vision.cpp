@@ -1,10 +1,14 @@
 ﻿#include "vision.h"
+#include "rgascheduler.h"
+#include "motionpredictor.h"
+#include "firescheduler.h"
+#include "mediagraph.h"
+#include <linux/media.h>
+#include <linux/media-bus-format.h>
 #include <QDebug>
 #include <QThread>
 #include <QCoreApplication>
 #include <chrono>
-#include <filesystem>
-#include <fstream>
 #include <string>
 #include <atomic>
 
@@ -42,13 +46,9 @@ void Vision::stop()
     m_isRunning = false;
     m_stopThreads = true;
     
-    // 唤醒所有正在沉睡等待任务的打工人，让他们下班
-    m_condition.notify_all();
-
-    // 回收读图包工头线程
-    if (m_cameraThread.joinable()) {
-        m_cameraThread.join();
-    }
+    // 停掉所有读图线程，并唤醒正在沉睡等待任务的打工人，让他们下班
+    m_capture.stop();
+    if (m_tiler) m_tiler->shutdown();
 
     // 回收 3 个打工人线程
     for (int i = 0; i < 3; ++i) {
@@ -56,26 +56,11 @@ void Vision::stop()
             m_workerThreads[i].join();
         }
     }
+    // 打工人可能还扣着高清 buffer 在裁剪，等它们全部下班后再关高清通路
+    m_highRes.stop();
     qDebug() << "🛑 视觉模块已彻底安全关闭。";
 }
 
-// 辅助函数：动态寻找 rkisp_mainpath 节点
-std::string findIspMainpathNode() {
-    std::string basePath = "/sys/class/video4linux/";
-    for (const auto& entry : std::filesystem::directory_iterator(basePath)) {
-        std::string nameFilePath = entry.path().string() + "/name";
-        std::ifstream nameFile(nameFilePath);
-        if (nameFile.is_open()) {
-            std::string name;
-            std::getline(nameFile, name);
-            if (name.find("rkisp_mainpath") != std::string::npos) {
-                return "/dev/" + entry.path().filename().string();
-            }
-        }
-    }
-    return "";
-}
-
 void Vision::loadYoloModel()
 {
     m_fpsStartTime = std::chrono::steady_clock::now();
@@ -93,10 +78,44 @@ void Vision::loadYoloModel()
     m_npuWorkers[1] = new Inference(modelPath, cv::Size(640, 640), classesPath, RKNN_NPU_CORE_1);
     m_npuWorkers[2] = new Inference(modelPath, cv::Size(640, 640), classesPath, RKNN_NPU_CORE_2);
 
+    // 类别白名单 + 优先级：例如 CAR_HMI_CLASSES="weed:2,thistle:5"，只解码、上报这些类别
+    const char* classSpec = getenv("CAR_HMI_CLASSES");
+    if (classSpec && *classSpec) {
+        bool ok = true;
+        for (int i = 0; i < 3; ++i) ok = m_npuWorkers[i]->setClassFilter(classSpec) && ok;
+        if (ok) qDebug() << ">>> 类别白名单已启用:" << classSpec;
+        else qDebug() << "【警告】CAR_HMI_CLASSES 里没有可识别的类别，仍解码全部类别:" << classSpec;
+    }
+
+    // 激光可达区：例如 CAR_HMI_ROI="0,360,800,240" 或 CAR_HMI_ROI="poly:0,600 120,330 680,330 800,600"
+    const char* roiSpec = getenv("CAR_HMI_ROI");
+    if (roiSpec && *roiSpec) {
+        DetectRoi roi;
+        if (DetectRoi::parse(roiSpec, roi)) {
+            for (int i = 0; i < 3; ++i) m_npuWorkers[i]->setRoi(roi);
+            qDebug() << ">>> ROI 推理已启用:" << roiSpec;
+        } else {
+            qDebug() << "【警告】CAR_HMI_ROI 格式错误 (应为 x,y,w,h;... 或 poly:x,y x,y x,y ...):" << roiSpec;
+        }
+    }
+
+    // 切块模式：例如 CAR_HMI_TILES="3x2@0.25"
+    const char* tiles = getenv("CAR_HMI_TILES");
+    TileConfig tileConfig;
+    if (tiles && *tiles) {
+        if (TileConfig::parse(tiles, tileConfig)) {
+            m_tiler.reset(new TiledDetector(tileConfig));
+            qDebug() << ">>> 切块推理已启用:" << tiles;
+        } else {
+            qDebug() << "【警告】CAR_HMI_TILES 格式错误 (应为 列x行[@重叠][+full]):" << tiles;
+        }
+    }
+
     // ==========================================
     // 2. 启动 3 个打工人线程
     // ==========================================
     m_stopThreads = false;
+    if (m_tiler) m_tiler->restart();
     for (int i = 0; i < 3; ++i) {
         m_workerThreads[i] = std::thread(&Vision::workerFunction, this, i);
     }
@@ -104,220 +123,117 @@ void Vision::loadYoloModel()
     qDebug() << "✅ 3 个 NPU 推理线程已就绪，嗷嗷待哺！";
 }
 
-void Vision::startLocalCamera()
-{
-    // 不要在这里写 while 死循环！只负责启动独立线程
-    if (m_isRunning) return;
-    
-    m_isRunning = true;
-    m_cameraThread = std::thread(&Vision::cameraLoop, this);
-}
-
-
-// ==========================================
-// 💥 包工头线程：只负责疯狂读图，塞进队列
-// ==========================================
-/*void Vision::cameraLoop()
+std::vector<CameraConfig> Vision::buildCameraList()
 {
-    qDebug() << ">>> [包工头] 摄像头读取线程启动...";
-
-    std::string isp_node = findIspMainpathNode();
-    if (isp_node.empty()) isp_node = "/dev/video11"; 
-
-    std::string pipeline = "v4l2src device=" + isp_node + " ! video/x-raw, width=1280, height=720, framerate=60/1 ! videoconvert ! appsink";
-    m_cap.open(pipeline, cv::CAP_GSTREAMER);
-
-    if (!m_cap.isOpened()) {
-        qDebug() << "【致命错误】摄像头打开失败！";
-        m_isRunning = false;
-        return;
-    }
-
-    // 预热摄像头
-    cv::Mat frame;
-    for (int i = 0; i < 5; ++i) { m_cap >> frame; QThread::msleep(30); }
-
-    while (m_isRunning) {
-        m_cap >> frame;
-        if (frame.empty()) {
-            QThread::msleep(10);
-            continue;
-        }
-
-        // --- 核心机制：塞入队列 ---
-        {
-            std::lock_guard<std::mutex> lock(m_queueMutex);
-            // ⚠️ 防爆栈策略：如果处理不过来，丢弃最老的帧，保证最新画面的实时性
-            if (m_frameQueue.size() >= 3) {
-                m_frameQueue.pop(); 
-            }
-            m_frameQueue.push(frame.clone()); 
-        }
-        // 队列有图了，喊醒一个空闲的打工人起来干活
-        m_condition.notify_one(); 
+    // 多摄像头 / 虚拟摄像头：例如 CAR_HMI_CAMERAS="/dev/video11,/dev/video20*2,file:/data/row3.nv12@800x600"
+    const char* spec = getenv("CAR_HMI_CAMERAS");
+    if (spec && *spec) {
+        return parseCameraList(spec);
     }
 
-    m_cap.release();
-    qDebug() << ">>> [包工头] 摄像头读取线程安全退出。";
-}*/
-
-void Vision::cameraLoop()
-{
-    qDebug() << ">>> 配置摄像头媒体链路(60fps 全像素模式)...";
-    system("media-ctl -d /dev/media0 --set-v4l2 '\"m00_b_imx415 7-001a\":0[fmt:SGBRG10_1X10/3864x2192@10000/600000]'");
-
-    std::string cameraNode = findIspMainpathNode();
+    // 默认：单路 IMX415，走 ISP 主通路 (拓扑只解析一次，之后直接用缓存)
+    std::vector<CameraConfig> configs;
+    MediaGraph* graph = MediaGraph::findCached("rkisp_mainpath");
+    std::string cameraNode = graph ? graph->videoNode("rkisp_mainpath") : std::string();
     if (cameraNode.empty()) {
         qDebug() << "【致命错误】未在系统中找到 rkisp_mainpath 节点！";
-        m_isRunning = false;
-        return;
-    }
-
-    // 1. 打开设备
-    int fd = open(cameraNode.c_str(), O_RDWR);
-    if (fd < 0) {
-        qDebug() << "【致命错误】打开摄像头设备失败！";
-        m_isRunning = false;
-        return;
+        return configs;
     }
 
-    // 2. 设置格式（multiplanar NV12，800x600，和之前保持一致）
-    v4l2_format fmt;
-    memset(&fmt, 0, sizeof(fmt));
-    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-    fmt.fmt.pix_mp.width = 800;
-    fmt.fmt.pix_mp.height = 600;
-    fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_NV12M;
-    fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
-    fmt.fmt.pix_mp.num_planes = 2;
-
-    if (ioctl(fd, VIDIOC_S_FMT, &fmt) < 0) {
-        qDebug() << "【致命错误】设置摄像头格式失败！";
-        close(fd);
-        m_isRunning = false;
-        return;
+    qDebug() << ">>> 配置摄像头媒体链路(60fps 全像素模式)...";
+    const MediaEntity* sensor = graph->findEntity("imx415");
+    if (!sensor) sensor = graph->findEntityByFunction(MEDIA_ENT_F_CAM_SENSOR);
+    if (sensor) {
+        SensorMode mode;
+        if (!graph->pickSensorMode(*sensor, 60.0, mode)) {
+            // 驱动不支持枚举时退回固定的 60fps 全像素模式
+            mode.code = MEDIA_BUS_FMT_SGBRG10_1X10;
+            mode.width = 3864;
+            mode.height = 2192;
+            mode.intervalNum = 10000;
+            mode.intervalDen = 600000;
+        }
+        if (graph->applySensorMode(*sensor, mode)) {
+            qDebug() << "✅ Sensor" << sensor->name.c_str() << "模式:" << mode.width << "x" << mode.height
+                     << "@" << mode.fps() << "fps";
+        }
+    } else {
+        qDebug() << "【警告】拓扑中没有找到 Sensor 实体，沿用驱动当前模式";
     }
 
-    // 3. 设置帧率60fps
-    v4l2_streamparm parm;
-    memset(&parm, 0, sizeof(parm));
-    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-    parm.parm.capture.timeperframe.numerator = 1;
-    parm.parm.capture.timeperframe.denominator = 60;
-    ioctl(fd, VIDIOC_S_PARM, &parm);
-
-    // 4. 申请3个mmap缓冲区
-    const int NUM_BUFFERS = 3;
-    v4l2_requestbuffers req;
-    memset(&req, 0, sizeof(req));
-    req.count = NUM_BUFFERS;
-    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-    req.memory = V4L2_MEMORY_MMAP;
-    if (ioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
-        qDebug() << "【致命错误】申请缓冲区失败！";
-        close(fd);
-        m_isRunning = false;
-        return;
+    CameraConfig cfg;
+    cfg.source = cameraNode;
+    if (m_tiler) {
+        // 切块模式要的就是细节，主通路直接出 1080p
+        cfg.width = 1920;
+        cfg.height = 1080;
     }
 
-    // 5. mmap每个buffer的每个plane
-    struct PlaneBuf { void* start; size_t length; };
-    std::vector<std::vector<PlaneBuf>> buffers(req.count);
-
-    for (unsigned i = 0; i < req.count; i++) {
-        v4l2_buffer buf;
-        v4l2_plane planes[2];
-        memset(&buf, 0, sizeof(buf));
-        memset(planes, 0, sizeof(planes));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
-        buf.m.planes = planes;
-        buf.length = 2;
-
-        if (ioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
-            qDebug() << "【致命错误】查询缓冲区失败！";
-            close(fd);
-            m_isRunning = false;
-            return;
-        }
-
-        buffers[i].resize(2);
-        for (int p = 0; p < 2; p++) {
-            buffers[i][p].length = planes[p].length;
-            buffers[i][p].start = mmap(NULL, planes[p].length, PROT_READ | PROT_WRITE,
-                                        MAP_SHARED, fd, planes[p].m.mem_offset);
-            if (buffers[i][p].start == MAP_FAILED) {
-                qDebug() << "【致命错误】mmap失败！";
-                close(fd);
-                m_isRunning = false;
-                return;
+    // 双通路：selfpath 出 800x600 给 NPU，mainpath 按 Sensor 全分辨率出图，只在目标框处裁剪
+    const char* dual = getenv("CAR_HMI_ISP_DUALPATH");
+    std::string selfNode = graph->videoNode("rkisp_selfpath");
+    if (dual && atoi(dual) > 0) {
+        if (selfNode.empty()) {
+            qDebug() << "【警告】未找到 rkisp_selfpath 节点，双通路模式不可用";
+        } else {
+            cfg.source = selfNode;
+            m_highResNode = cameraNode;
+            m_highResSize = cv::Size(3864, 2192);
+            if (sensor) {
+                SensorMode mode;
+                if (graph->pickSensorMode(*sensor, 60.0, mode)) m_highResSize = cv::Size(mode.width, mode.height);
             }
+            m_highResCamera = cfg.id;
+            qDebug() << ">>> ISP 双通路: 检测流" << selfNode.c_str() << "高清流" << cameraNode.c_str()
+                     << m_highResSize.width << "x" << m_highResSize.height;
         }
-        ioctl(fd, VIDIOC_QBUF, &buf);
     }
+    configs.push_back(cfg);
+    return configs;
+}
 
-    // 6. 开始streaming
-    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-    if (ioctl(fd, VIDIOC_STREAMON, &type) < 0) {
-        qDebug() << "【致命错误】启动streaming失败！";
-        close(fd);
-        m_isRunning = false;
-        return;
-    }
+void Vision::startLocalCamera()
+{
+    // 不要在这里写 while 死循环！只负责启动各路读图线程
+    if (m_isRunning) return;
 
-    qDebug() << "✅ 原生V4L2 60fps 采集初始化成功，开始捕获视频流...";
-
-    // 7. 主循环：DQBUF取帧 -> 转换 -> 塞队列 -> QBUF还回去
-    while (m_isRunning) {
-        v4l2_buffer buf;
-        v4l2_plane planes[2];
-        memset(&buf, 0, sizeof(buf));
-        memset(planes, 0, sizeof(planes));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.m.planes = planes;
-        buf.length = 2;
-
-        if (ioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
-            QThread::msleep(2);
-            continue;
+    std::vector<CameraConfig> configs = buildCameraList();
+
+    // V4L2 驱动缓冲区个数：多了抗抖动，少了延迟低，默认 4
+    const char* bufs = getenv("CAR_HMI_V4L2_BUFFERS");
+    // 跟踪器：默认每帧都检测，只负责分配稳定 ID；CAR_HMI_DETECT_EVERY=N 时开启隔帧检测
+    TrackerConfig trackerConfig;
+    const char* every = getenv("CAR_HMI_DETECT_EVERY");
+    if (every && atoi(every) > 0) trackerConfig.maxDetectInterval = atoi(every);
+    // 静止门控：CAR_HMI_SCENE_GATE 设置即开启，值可以覆盖默认阈值 (见 SceneGateConfig::parse)
+    const char* gateSpec = getenv("CAR_HMI_SCENE_GATE");
+    SceneGateConfig gateConfig = SceneGateConfig::parse(gateSpec ? gateSpec : "");
+    for (auto& cfg : configs) {
+        if (bufs && atoi(bufs) > 0) cfg.bufferCount = atoi(bufs);
+        if (!m_trackers.count(cfg.id)) {
+            m_trackers[cfg.id].reset(new MultiObjectTracker(trackerConfig));
         }
-
-        // 把两个plane(Y和UV)包装成一个连续NV12格式给OpenCV处理
-        // 800x600的Y平面 + 800x300的UV平面，用一块连续内存拼起来
-        cv::Mat nv12_frame(600 + 600 / 2, 800, CV_8UC1);
-        memcpy(nv12_frame.data, buffers[buf.index][0].start, planes[0].bytesused);
-        memcpy(nv12_frame.data + planes[0].bytesused, buffers[buf.index][1].start, planes[1].bytesused);
-
-        cv::Mat bgr_frame;
-        cv::cvtColor(nv12_frame, bgr_frame, cv::COLOR_YUV2BGR_NV12);
-
-        // 立刻把buffer还给驱动，让它继续采集下一帧
-        ioctl(fd, VIDIOC_QBUF, &buf);
-
-        // 塞入队列
-        {
-            std::lock_guard<std::mutex> lock(m_queueMutex);
-            if (m_frameQueue.size() >= 2) {
-                m_frameQueue.pop();
-            }
-            m_frameQueue.push(bgr_frame);
+        if (gateSpec && !m_sceneGates.count(cfg.id)) {
+            m_sceneGates[cfg.id].reset(new SceneGate(gateConfig));
         }
-        m_condition.notify_one();
+        m_capture.addCamera(cfg);
     }
-
-    // 8. 清理
-    ioctl(fd, VIDIOC_STREAMOFF, &type);
-    for (auto& planeBufs : buffers) {
-        for (auto& pb : planeBufs) {
-            munmap(pb.start, pb.length);
+    if (configs.empty() || !m_capture.start()) {
+        return;
+    }
+    // 高清通路打不开不影响检测，只是不做精修
+    if (!m_highResNode.empty()) {
+        if (m_highRes.open(m_highResNode, m_highResSize.width, m_highResSize.height, 60)) {
+            m_highRes.start();
+        } else {
+            m_highResCamera = -1;
         }
     }
-    close(fd);
-    qDebug() << ">>> [包工头] 摄像头读取线程安全退出。";
+    m_previewCamera = configs.front().id;
+    m_isRunning = true;
 }
 
+
 // ==========================================
 // 💥 打工人线程：死循环等图 -> 推理 -> 渲染
 // ==========================================
@@ -326,27 +242,80 @@ void Vision::workerFunction(int worker_id)
     qDebug() << ">>> [打工人" << worker_id << "] 线程已启动，绑定核心:" << worker_id;
 
     while (!m_stopThreads) {
-        cv::Mat frame;
-        
-        // 1. 从队列中抢任务
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            // 如果没活干且没喊停，就挂起休眠，绝不空转浪费 CPU
-            m_condition.wait(lock, [this]{ return !m_frameQueue.empty() || m_stopThreads; });
-            
-            if (m_stopThreads && m_frameQueue.empty()) break; // 彻底下班
-            
-            frame = m_frameQueue.front();
-            m_frameQueue.pop();
+        // 1. 从各路摄像头按权重轮询抢任务；没活干就挂起休眠，绝不空转浪费 CPU
+        CameraFrame captured;
+        if (m_tiler) {
+            // 切块模式：别人的帧还有块没跑就先帮忙，再去取新帧 (短超时，保证块不会干等)
+            if (m_tiler->runPending(m_npuWorkers[worker_id], 0)) continue;
+            if (!m_capture.waitFrame(captured, 2)) continue;
+        } else if (!m_capture.waitFrame(captured)) {
+            break; // 彻底下班
         }
 
-        if (frame.empty()) continue;
-
-        // 2. 🧠 开始 NPU 专属物理核心推理
+        const cv::Mat& nv12_frame = captured.nv12;
+        if (nv12_frame.empty()) continue;
+
+        // 队列里是连续存放的 NV12 (Y 平面在上，UV 平面在下)
+        Nv12Frame nv12;
+        nv12.width = nv12_frame.cols;
+        nv12.height = nv12_frame.rows * 2 / 3;
+        nv12.y = nv12_frame.data;
+        nv12.uv = nv12_frame.data + (size_t)nv12.width * nv12.height;
+        nv12.yStride = nv12.width;
+        nv12.uvStride = nv12.width;
+
+        // 2. 🧠 开始 NPU 专属物理核心推理 (隔帧检测模式下，中间帧由跟踪器外推，不占 NPU)
+        auto trackerIt = m_trackers.find(captured.cameraId);
+        MultiObjectTracker* tracker = trackerIt != m_trackers.end() ? trackerIt->second.get() : nullptr;
+        auto gateIt = m_sceneGates.find(captured.cameraId);
+        SceneGate* gate = gateIt != m_sceneGates.end() ? gateIt->second.get() : nullptr;
+        std::vector<Detection> dets;
         auto t_inf_start = std::chrono::steady_clock::now();
-        std::vector<Detection> dets = m_npuWorkers[worker_id]->runInference(frame);
+        const bool gated = gate && !gate->shouldInfer(captured);
+        if (gated) {
+            // 画面没变：NPU 和跟踪器都不动，直接复用上次的结果 (带原帧的 frameSeq，只画不报)
+            gate->cached(dets);
+        } else if (!tracker || tracker->needDetection(captured)) {
+            dets = m_tiler ? m_tiler->detect(nv12, m_npuWorkers[worker_id])
+                           : m_npuWorkers[worker_id]->runInference(nv12);
+            for (auto& det : dets) {
+                det.cameraId = captured.cameraId;
+            }
+            // 双通路：回到同一 ISP 帧的高清画面，只把目标框那一小块用 RGA 裁出来精修瞄准点
+            if (captured.cameraId == m_highResCamera && m_highRes.isOpen()) {
+                m_highRes.refineTargets(dets, captured, worker_id);
+            }
+            for (auto& det : dets) {
+                det.captureTime = captured.captureTime;
+            }
+            if (tracker) tracker->update(captured, dets);
+        } else {
+            tracker->propagate(captured, dets);
+        }
+        if (!gated) {
+            for (auto& det : dets) {
+                det.frameSeq = captured.seq;
+            }
+            if (gate) gate->store(captured.seq, dets);
+        }
+        // 主摄像头的光流喂给运动补偿，用来标定 底盘速度 -> 画面速度；标定好之后反过来帮跟踪器外推
+        if (tracker && captured.cameraId == m_previewCamera) {
+            MotionPredictor& predictor = MotionPredictor::instance();
+            cv::Point2f flow, chassis;
+            if (tracker->sceneVelocity(captured, flow)) {
+                predictor.onImageVelocity(flow, captured.captureTime);
+            }
+            if (predictor.chassisImageVelocity(captured.captureTime, chassis)) {
+                tracker->setChassisVelocity(chassis);
+            }
+        }
         auto t_inf_end = std::chrono::steady_clock::now();
         double inferenceTime = std::chrono::duration<double, std::milli>(t_inf_end - t_inf_start).count();
+        m_capture.reportProcessed(captured);
+
+        // 显示用的 BGR 图在各推理线程里并行转换，不再占用读图线程
+        cv::Mat frame;
+        cv::cvtColor(nv12_frame, frame, cv::COLOR_YUV2BGR_NV12);
 
         // 3. 🎨 在当前线程独立完成渲染 (互不干扰，性能最高)
         auto t_draw_start = std::chrono::steady_clock::now();
@@ -354,6 +323,7 @@ void Vision::workerFunction(int worker_id)
             cv::rectangle(frame, det.box, cv::Scalar(0, 255, 0), 2);
             cv::circle(frame, cv::Point(det.targetX, det.targetY), 5, cv::Scalar(0, 0, 255), -1);
             QString labelText = QString::fromStdString(det.className) + " " + QString::number(det.confidence, 'f', 2);
+            if (det.trackId >= 0) labelText += " #" + QString::number(det.trackId);
             cv::putText(frame, labelText.toStdString(), cv::Point(det.box.x, det.box.y - 10), 
                         cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 255), 2);
         }
@@ -373,6 +343,36 @@ void Vision::workerFunction(int worker_id)
                 int count = m_processedCount.exchange(0); // 拿走总数并同时清零
                 m_overallFps = count / elapsed;
                 m_fpsStartTime = currentTime;
+
+                // 每 10 秒输出一次 RGA 各核心的利用率与排队时间，然后重新开始统计
+                if (++m_rgaStatsWindows >= 10) {
+                    m_rgaStatsWindows = 0;
+                    RgaScheduler::instance().dumpStats();
+                    RgaScheduler::instance().resetStats();
+                }
+
+                // 每 5 秒输出一次各路摄像头的帧率与延迟
+                if (++m_captureStatsWindows >= 5) {
+                    m_captureStatsWindows = 0;
+                    m_capture.dumpStats();
+                    m_capture.resetStats();
+                    if (m_highRes.isOpen()) {
+                        m_highRes.dumpStats();
+                        m_highRes.resetStats();
+                    }
+                    if (m_tiler) {
+                        m_tiler->dumpStats();
+                        m_tiler->resetStats();
+                    }
+                    for (auto& kv : m_trackers) {
+                        kv.second->dumpStats(kv.first);
+                        kv.second->resetStats();
+                    }
+                    for (auto& kv : m_sceneGates) {
+                        kv.second->dumpStats(kv.first);
+                        kv.second->resetStats();
+                    }
+                }
             }
         }
 
@@ -403,12 +403,23 @@ void Vision::workerFunction(int worker_id)
         cv::putText(frame, textDrw, cv::Point(20, 95), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
 
         // 4. 将完成的图和数据抛给主线程 UI
-        if (!dets.empty()) {
-            emit sendDetections(dets);
+        // 静止帧复用的结果上一次推理已经报过：不再重复写库，也不再下发打击批次。
+        // 其余帧没有目标也要发：下位机只保留最新一批，空批次才能让它停止打已经移出画面的旧目标
+        if (!gated) {
+            // 打击顺序在这里排好 (NMS 之后是无序的)，排程耗时算在推理线程上，不占 UI 线程
+            FireScheduler::instance().schedule(dets, captured.cameraId);
+            FrameStamp stamp;
+            stamp.cameraId = captured.cameraId;
+            stamp.seq = captured.seq;
+            stamp.captureTime = captured.captureTime;
+            emit sendDetections(dets, stamp);
         }
         
-        QImage qImg = cvMatToQImage(frame);
-        emit sendResult(qImg);
+        // 多路摄像头时 UI 只显示预览那一路，其余路只出检测结果
+        if (captured.cameraId == m_previewCamera) {
+            QImage qImg = cvMatToQImage(frame);
+            emit sendResult(qImg);
+        }
     }
     qDebug() << ">>> [打工人" << worker_id << "] 线程安全退出。";
 }
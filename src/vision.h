@@ -22,6 +22,13 @@
 
 // 引入 NPU 推理引擎的头文件
 #include "inference.h" 
+#include "capturemanager.h"
+#include "highrespath.h"
+#include "tileddetector.h"
+#include "tracker.h"
+#include "scenegate.h"
+#include <map>
+#include <memory>
 
 class Vision : public QObject
 {
@@ -38,7 +45,8 @@ public slots:
 signals:
     // Qt 的跨线程信号传递非常安全，工作线程处理完后直接 emit 这两个信号即可
     void sendResult(QImage img);
-    void sendDetections(std::vector<Detection> dets);
+    // 每个推理过的帧都发一次 (没有目标时 dets 为空)，静止门控跳过的帧不发
+    void sendDetections(std::vector<Detection> dets, FrameStamp frame);
 
 private:
     // 图像转换工具函数
@@ -47,14 +55,15 @@ private:
     // 内部工作线程函数：3个打工人运行的死循环
     void workerFunction(int worker_id);
     
-    // 内部读图线程函数：包工头专门负责读图，防止卡死 Qt 主界面
-    void cameraLoop(); 
+    // 组装摄像头列表：默认只有 rkisp_mainpath，设置 CAR_HMI_CAMERAS 时按列表打开多路
+    std::vector<CameraConfig> buildCameraList();
 
 private:
     std::atomic<int> m_processedCount{0}; // 原子计数器
     float m_overallFps = 0.0f;            // 整体 FPS
     std::chrono::steady_clock::time_point m_fpsStartTime; 
     std::mutex m_fpsMutex;                // 专门用于时间结算的锁
+    int m_rgaStatsWindows = 0;            // RGA 统计输出计数 (受 m_fpsMutex 保护)
     
     cv::VideoCapture m_cap;
     bool m_isRunning;
@@ -67,14 +76,26 @@ private:
     Inference* m_npuWorkers[3] = {nullptr, nullptr, nullptr}; 
     std::thread m_workerThreads[3]; // 3 个推理线程
 
-    // 2. 读图包工头 (单独开一个线程读摄像头，绝不能在主线程 while 死循环)
-    std::thread m_cameraThread; 
+    // 2. 多摄像头采集 + 公平调度 (每路摄像头一个读图线程，3 个打工人共享)
+    CaptureManager m_capture;
+    int m_previewCamera = 0;   // UI 上显示哪一路摄像头的画面
+    int m_captureStatsWindows = 0;   // 摄像头统计输出计数 (受 m_fpsMutex 保护)
+
+    // 3. ISP 双通路 (CAR_HMI_ISP_DUALPATH=1)：selfpath 小图做检测，mainpath 全分辨率只按目标框裁剪精修
+    HighResPath m_highRes;
+    std::string m_highResNode;       // 为空表示未启用双通路
+    cv::Size m_highResSize;
+    int m_highResCamera = -1;        // 与高清通路同源的检测流摄像头编号
+
+    // 4. 切块推理 (CAR_HMI_TILES="列x行[@重叠][+full]")：高分辨率采集，一帧切多块分给 3 个 NPU
+    std::unique_ptr<TiledDetector> m_tiler;
+
+    // 5. 每路摄像头一个跟踪器 (启动采集前建好，之后只读)；CAR_HMI_DETECT_EVERY=N 时最多隔 N 帧跑一次 NPU
+    std::map<int, std::unique_ptr<MultiObjectTracker>> m_trackers;
+
+    // 6. 每路摄像头一个静止门控 (CAR_HMI_SCENE_GATE)：画面没变化时不跑 NPU，复用上次结果
+    std::map<int, std::unique_ptr<SceneGate>> m_sceneGates;
 
-    // 3. 任务分发中心 (生产者-消费者队列)
-    std::queue<cv::Mat> m_frameQueue;  // 待处理的图像队列
-    std::mutex m_queueMutex;           // 线程锁（防止多个线程抢同一张图）
-    std::condition_variable m_condition; // 唤醒机制（队列有图了就叫醒空闲的线程）
-    
     bool m_stopThreads; // 控制所有线程安全退出的标志位
 };
 
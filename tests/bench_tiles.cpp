@@ -0,0 +1,159 @@
+#include "tileddetector.h"
+#include "camerasource.h"
+#include <QDebug>
+#include <QString>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// ==========================================
+// 切块推理离线评测 (需要 NPU，不进 ctest)
+// 用法：car_hmi_tile_bench <model.rknn> <图片目录> [切块配置，默认 2x2] [classes.txt，默认与模型同目录]
+// 图片为 *.jpg / *.png，可带同名 YOLO 标注 *.txt；3 个 NPU 上下文与主程序一样分别绑定 Core 0/1/2
+// ==========================================
+
+struct GroundTruth {
+    int classId;
+    cv::Rect box;
+};
+
+// YOLO 标注：每行 "类别 cx cy w h"，坐标为相对图像宽高的比例
+static std::vector<GroundTruth> loadYoloLabels(const std::string& path, const cv::Size& size)
+{
+    std::vector<GroundTruth> gts;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        GroundTruth gt;
+        float cx, cy, w, h;
+        if (!(ss >> gt.classId >> cx >> cy >> w >> h)) continue;
+        gt.box = cv::Rect((int)std::round((cx - w / 2) * size.width), (int)std::round((cy - h / 2) * size.height),
+                          (int)std::round(w * size.width), (int)std::round(h * size.height));
+        gts.push_back(gt);
+    }
+    return gts;
+}
+
+static int countHits(const std::vector<GroundTruth>& gts, const std::vector<Detection>& dets)
+{
+    int hits = 0;
+    for (const auto& gt : gts) {
+        for (const auto& det : dets) {
+            if (det.class_id != gt.classId) continue;
+            double inter = (gt.box & det.box).area();
+            double uni = gt.box.area() + det.box.area() - inter;
+            if (uni > 0 && inter / uni >= 0.5) {
+                hits++;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+// 对目录下的图片分别跑整帧和切块两种模式，输出吞吐与召回率 (IoU >= 0.5 且类别一致算命中)
+static bool benchmark(Inference* const* workers, int workerCount, const std::string& dir, const TileConfig& config)
+{
+    std::vector<cv::String> files, png;
+    cv::glob(dir + "/*.jpg", files, false);
+    cv::glob(dir + "/*.png", png, false);
+    files.insert(files.end(), png.begin(), png.end());
+    if (files.empty() || workerCount <= 0) {
+        qDebug() << "【警告】切块评测目录里没有图片:" << dir.c_str();
+        return false;
+    }
+
+    // 其余 NPU 上下文作为切块帮手
+    TiledDetector tiler(config);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < workerCount; ++i) {
+        helpers.push_back(std::thread([&tiler, &done, workers, i]{
+            while (!done) tiler.runPending(workers[i], 20);
+        }));
+    }
+
+    double fullMs = 0.0, tiledMs = 0.0;
+    int frames = 0, gtTotal = 0, fullHits = 0, tiledHits = 0;
+    size_t fullDets = 0, tiledDets = 0;
+    cv::Mat nv12;
+    for (const auto& file : files) {
+        cv::Mat bgr = cv::imread(file);
+        if (bgr.empty()) continue;
+        bgr = bgr(cv::Rect(0, 0, bgr.cols & ~1, bgr.rows & ~1));
+        bgrToNv12(bgr.clone(), nv12);
+
+        Nv12Frame frame;
+        frame.width = bgr.cols;
+        frame.height = bgr.rows;
+        frame.y = nv12.data;
+        frame.uv = nv12.data + (size_t)frame.width * frame.height;
+        frame.yStride = frame.uvStride = frame.width;
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<Detection> full = workers[0]->runInference(frame);
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<Detection> tiled = tiler.detect(frame, workers[0]);
+        auto t2 = std::chrono::steady_clock::now();
+        fullMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        tiledMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        fullDets += full.size();
+        tiledDets += tiled.size();
+        frames++;
+
+        std::string labelPath = file.substr(0, file.find_last_of('.')) + ".txt";
+        std::vector<GroundTruth> gts = loadYoloLabels(labelPath, bgr.size());
+        gtTotal += (int)gts.size();
+        fullHits += countHits(gts, full);
+        tiledHits += countHits(gts, tiled);
+    }
+    done = true;
+    tiler.shutdown();
+    for (auto& t : helpers) t.join();
+    if (frames == 0) return false;
+
+    // 整帧模式下 3 个上下文各跑各的帧，吞吐按并行折算；切块模式单帧已经占满所有上下文
+    double fullFrameMs = fullMs / frames, tiledFrameMs = tiledMs / frames;
+    qDebug() << "========== 切块推理评测 (" << frames << "帧," << dir.c_str() << ") ==========";
+    qDebug() << "整帧: 单帧" << QString::number(fullFrameMs, 'f', 1) << "ms"
+             << "吞吐约" << QString::number(workerCount * 1000.0 / fullFrameMs, 'f', 1) << "fps"
+             << "平均目标数" << QString::number((double)fullDets / frames, 'f', 1)
+             << "召回" << (gtTotal ? QString::number(100.0 * fullHits / gtTotal, 'f', 1) + "%" : QString("-"));
+    qDebug() << "切块" << config.cols << "x" << config.rows << "@" << QString::number(config.overlap, 'f', 2)
+             << (config.fullFrame ? "+整帧" : "") << ": 单帧" << QString::number(tiledFrameMs, 'f', 1) << "ms"
+             << "吞吐约" << QString::number(1000.0 / tiledFrameMs, 'f', 1) << "fps"
+             << "平均目标数" << QString::number((double)tiledDets / frames, 'f', 1)
+             << "召回" << (gtTotal ? QString::number(100.0 * tiledHits / gtTotal, 'f', 1) + "%" : QString("-"));
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        qDebug() << "用法: car_hmi_tile_bench <model.rknn> <图片目录> [列x行[@重叠][+full]] [classes.txt]";
+        return 2;
+    }
+    std::string modelPath = argv[1];
+    TileConfig config;
+    if (argc > 3 && !TileConfig::parse(argv[3], config)) {
+        qDebug() << "【警告】切块配置格式错误 (应为 列x行[@重叠][+full]):" << argv[3];
+        return 2;
+    }
+    QString classesPath;
+    if (argc > 4) {
+        classesPath = argv[4];
+    } else {
+        size_t slash = modelPath.find_last_of('/');
+        std::string dir = slash == std::string::npos ? std::string(".") : modelPath.substr(0, slash);
+        classesPath = QString::fromStdString(dir + "/classes.txt");
+    }
+
+    Inference core0(modelPath, cv::Size(640, 640), classesPath, RKNN_NPU_CORE_0);
+    Inference core1(modelPath, cv::Size(640, 640), classesPath, RKNN_NPU_CORE_1);
+    Inference core2(modelPath, cv::Size(640, 640), classesPath, RKNN_NPU_CORE_2);
+    Inference* workers[3] = {&core0, &core1, &core2};
+    return benchmark(workers, 3, argv[2], config) ? 0 : 1;
+}
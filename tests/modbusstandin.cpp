@@ -0,0 +1,261 @@
+#include "modbusstandin.h"
+#include "modbusclient.h"
+#include <QDebug>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+using namespace modbus;
+
+ModbusStandIn::~ModbusStandIn()
+{
+    stop();
+}
+
+bool ModbusStandIn::start(uint16_t port)
+{
+    stop();
+    m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenFd < 0) return false;
+    int one = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t addrLen = sizeof(addr);
+    if (::bind(m_listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(m_listenFd, 4) != 0 ||
+        getsockname(m_listenFd, (sockaddr*)&addr, &addrLen) != 0) {
+        qDebug() << "【警告】Modbus 服务端替身监听失败, 端口" << port;
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    m_port = ntohs(addr.sin_port);
+    m_running = true;
+    m_thread = std::thread(&ModbusStandIn::serveLoop, this);
+    return true;
+}
+
+void ModbusStandIn::stop()
+{
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+    if (m_listenFd >= 0) {
+        ::close(m_listenFd);
+        m_listenFd = -1;
+    }
+}
+
+bool ModbusStandIn::coil(int addr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return addr >= 0 && addr < kCoils && m_coils[addr];
+}
+
+uint16_t ModbusStandIn::reg(int addr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return addr >= 0 && addr < kRegisters ? m_regs[addr] : 0;
+}
+
+void ModbusStandIn::setReg(int addr, uint16_t value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (addr >= 0 && addr < kRegisters) m_regs[addr] = value;
+}
+
+void ModbusStandIn::dropNextWrite(int addr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dropAddr = addr;
+}
+
+void ModbusStandIn::failNextWrite(int addr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failAddr = addr;
+}
+
+ModbusStandIn::Stats ModbusStandIn::stats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ModbusStandIn::serveLoop()
+{
+    int client = -1;
+    std::vector<uint8_t> rx;
+    std::vector<uint8_t> tx;
+
+    while (m_running) {
+        pollfd fds[2];
+        int nfds = 0;
+        fds[nfds++] = {m_listenFd, POLLIN, 0};
+        if (client >= 0) fds[nfds++] = {client, POLLIN, 0};
+        if (poll(fds, nfds, 50) <= 0) continue;
+
+        if (fds[0].revents & POLLIN) {
+            int fd = ::accept(m_listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                // 新连接顶掉旧连接 (客户端重连)
+                if (client >= 0) ::close(client);
+                client = fd;
+                int one = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                rx.clear();
+                continue;
+            }
+        }
+        if (client < 0 || nfds < 2 || !(fds[1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        uint8_t buf[4096];
+        ssize_t r = ::recv(client, buf, sizeof(buf), 0);
+        if (r <= 0) {
+            ::close(client);
+            client = -1;
+            continue;
+        }
+        rx.insert(rx.end(), buf, buf + r);
+
+        int handled = 0;
+        tx.clear();
+        while (true) {
+            int n = frameLength(rx.data(), rx.size());
+            if (n < 0) {
+                // 帧头坏了没法再对齐，和真 PLC 一样直接断开
+                ::close(client);
+                client = -1;
+                break;
+            }
+            if (n == 0) break;
+            if (m_delayMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(m_delayMs.load()));
+            handle(rx.data(), (size_t)n, tx);
+            rx.erase(rx.begin(), rx.begin() + n);
+            handled++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.maxBacklog = std::max(m_stats.maxBacklog, handled);
+        }
+        if (client >= 0 && !tx.empty()) {
+            ssize_t w = ::send(client, tx.data(), tx.size(), MSG_NOSIGNAL);
+            (void)w;
+        }
+    }
+    if (client >= 0) ::close(client);
+}
+
+void ModbusStandIn::handle(const uint8_t* adu, size_t len, std::vector<uint8_t>& out)
+{
+    const uint8_t* pdu = adu + MBAP_SIZE;
+    size_t pduLen = len - MBAP_SIZE;
+    uint8_t fc = pdu[0];
+    uint8_t resp[MAX_PDU];
+    size_t respLen = 0;
+    uint8_t exception = EX_NONE;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.requests++;
+    uint16_t addr = pduLen >= 3 ? getU16(pdu + 1) : 0;
+    uint16_t qty = pduLen >= 5 ? getU16(pdu + 3) : 0;
+
+    // 故障注入：被丢掉的写请求既不生效也不回响应，和 PLC 漏收一样
+    bool regWrite = fc == FC_WRITE_SINGLE_REGISTER || fc == FC_WRITE_MULTIPLE_REGISTERS;
+    if (regWrite && addr == m_dropAddr) {
+        m_dropAddr = -1;
+        m_stats.dropped++;
+        return;
+    }
+
+    switch (fc) {
+    case FC_READ_COILS:
+        if (pduLen != 5 || qty < 1 || qty > 2000) { exception = EX_ILLEGAL_VALUE; break; }
+        if (addr + qty > kCoils) { exception = EX_ILLEGAL_ADDRESS; break; }
+        resp[0] = fc;
+        resp[1] = (uint8_t)((qty + 7) / 8);
+        memset(resp + 2, 0, resp[1]);
+        for (int i = 0; i < qty; ++i) {
+            if (m_coils[addr + i]) resp[2 + i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+        respLen = 2 + resp[1];
+        break;
+    case FC_READ_HOLDING_REGISTERS:
+        if (pduLen != 5 || qty < 1 || qty > MAX_READ_REGISTERS) { exception = EX_ILLEGAL_VALUE; break; }
+        if (addr + qty > kRegisters) { exception = EX_ILLEGAL_ADDRESS; break; }
+        // 车速每被读一次向设定值靠近 1/4 (至少 1)，模拟底盘加减速
+        if (addr <= Reg_CurrentSpeed && Reg_CurrentSpeed < addr + qty) {
+            int cur = (int16_t)m_regs[Reg_CurrentSpeed];
+            int set = (int16_t)m_regs[Reg_SpeedSet];
+            int step = (set - cur) / 4;
+            if (step == 0 && set != cur) step = set > cur ? 1 : -1;
+            m_regs[Reg_CurrentSpeed] = (uint16_t)(cur + step);
+        }
+        resp[0] = fc;
+        resp[1] = (uint8_t)(qty * 2);
+        for (int i = 0; i < qty; ++i) putU16(resp + 2 + i * 2, m_regs[addr + i]);
+        respLen = 2 + qty * 2;
+        break;
+    case FC_WRITE_SINGLE_COIL:
+        if (pduLen != 5 || (qty != 0xFF00 && qty != 0x0000)) { exception = EX_ILLEGAL_VALUE; break; }
+        if (addr >= kCoils) { exception = EX_ILLEGAL_ADDRESS; break; }
+        m_coils[addr] = qty == 0xFF00;
+        memcpy(resp, pdu, 5);
+        respLen = 5;
+        break;
+    case FC_WRITE_SINGLE_REGISTER:
+        if (pduLen != 5) { exception = EX_ILLEGAL_VALUE; break; }
+        if (addr >= kRegisters) { exception = EX_ILLEGAL_ADDRESS; break; }
+        if (addr == m_failAddr) { m_failAddr = -1; exception = EX_SERVER_FAILURE; break; }
+        m_regs[addr] = qty;
+        memcpy(resp, pdu, 5);
+        respLen = 5;
+        break;
+    case FC_WRITE_MULTIPLE_COILS:
+        if (pduLen < 6 || qty < 1 || qty > MAX_WRITE_COILS || pdu[5] != (qty + 7) / 8 || pduLen != 6u + pdu[5]) {
+            exception = EX_ILLEGAL_VALUE;
+            break;
+        }
+        if (addr + qty > kCoils) { exception = EX_ILLEGAL_ADDRESS; break; }
+        for (int i = 0; i < qty; ++i) m_coils[addr + i] = (pdu[6 + i / 8] >> (i % 8)) & 1;
+        memcpy(resp, pdu, 5);
+        respLen = 5;
+        break;
+    case FC_WRITE_MULTIPLE_REGISTERS:
+        if (pduLen < 6 || qty < 1 || qty > MAX_WRITE_REGISTERS || pdu[5] != qty * 2 || pduLen != 6u + pdu[5]) {
+            exception = EX_ILLEGAL_VALUE;
+            break;
+        }
+        if (addr + qty > kRegisters) { exception = EX_ILLEGAL_ADDRESS; break; }
+        if (addr == m_failAddr) { m_failAddr = -1; exception = EX_SERVER_FAILURE; break; }
+        for (int i = 0; i < qty; ++i) m_regs[addr + i] = getU16(pdu + 6 + i * 2);
+        m_stats.writeMultipleRegisters++;
+        memcpy(resp, pdu, 5);
+        respLen = 5;
+        break;
+    default:
+        exception = EX_ILLEGAL_FUNCTION;
+        break;
+    }
+    if (exception != EX_NONE) {
+        m_stats.exceptions++;
+        resp[0] = (uint8_t)(fc | 0x80);
+        resp[1] = exception;
+        respLen = 2;
+    }
+
+    uint8_t head[MBAP_SIZE];
+    writeMbap(head, getU16(adu), adu[6], respLen);
+    out.insert(out.end(), head, head + MBAP_SIZE);
+    out.insert(out.end(), resp, resp + respLen);
+}
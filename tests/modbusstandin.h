@@ -0,0 +1,69 @@
+#ifndef MODBUSSTANDIN_H
+#define MODBUSSTANDIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ==========================================
+// 进程内 Modbus TCP 服务端替身 (模拟 PLC 底盘)
+// 不接 PLC 也能联调 ModbusClient：监听 127.0.0.1，支持 FC01/03/05/06/15/16，
+// 越界地址回 EX_ILLEGAL_ADDRESS，不认识的功能码回 EX_ILLEGAL_FUNCTION。
+// Reg_CurrentSpeed 每被读一次就向 Reg_SpeedSet 靠近一步，模拟底盘加减速。
+// 一次只服务一条连接，请求按到达顺序处理 (可设每条的处理耗时，模拟 PLC 扫描周期)。
+// ==========================================
+class ModbusStandIn
+{
+public:
+    static const int kCoils = 64;
+    static const int kRegisters = 64;
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t writeMultipleRegisters = 0;
+        uint64_t exceptions = 0;
+        uint64_t dropped = 0;            // 按 dropNextWrite 吞掉、没有回响应的写请求
+        int maxBacklog = 0;              // 一次读到的请求条数峰值，>1 说明客户端确实在流水线发送
+    };
+
+    ModbusStandIn() = default;
+    ~ModbusStandIn();
+    ModbusStandIn(const ModbusStandIn&) = delete;
+    ModbusStandIn& operator=(const ModbusStandIn&) = delete;
+
+    // port 为 0 时由系统分配，start 之后用 port() 取
+    bool start(uint16_t port = 0);
+    void stop();
+    uint16_t port() const { return m_port; }
+
+    bool coil(int addr);
+    uint16_t reg(int addr);
+    void setReg(int addr, uint16_t value);
+    void setResponseDelayMs(int ms) { m_delayMs = ms; }
+    // 故障注入：下一条写 addr 的 FC06 / FC16 不生效。drop 为不回响应 (客户端超时)，fail 为回 EX_SERVER_FAILURE
+    void dropNextWrite(int addr);
+    void failNextWrite(int addr);
+    Stats stats();
+
+private:
+    void serveLoop();
+    // 处理一条请求 ADU，响应追加到 out
+    void handle(const uint8_t* adu, size_t len, std::vector<uint8_t>& out);
+
+    int m_listenFd = -1;
+    uint16_t m_port = 0;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_delayMs{0};
+
+    std::mutex m_mutex;
+    bool m_coils[kCoils] = {false};
+    uint16_t m_regs[kRegisters] = {0};
+    int m_dropAddr = -1;
+    int m_failAddr = -1;
+    Stats m_stats;
+};
+
+#endif // MODBUSSTANDIN_H
@@ -0,0 +1,214 @@
+#include "tests.h"
+#include "firescheduler.h"
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// 合成草场滚动仿真：草从可打击带上沿按泊松过程进入、随底盘匀速移过，每帧按当前可见的草重新排程，
+// 振镜按计划执行到下一帧，对比各策略每秒打掉的草数 / 漏打率 / 排程耗时。
+// 通过条件：计划里的目标都能在截止前打完，贪心+2opt 不比按检测顺序打差。
+
+namespace {
+
+struct SimWeed {
+    float spawnMs;
+    float x;
+    float dwellMs;
+    float weight;
+    float order;        // 模拟检测输出顺序 (置信度)，InputOrder 用
+    bool done = false;
+};
+
+struct SimResult {
+    double treatedPerSec = 0.0;
+    double missRate = 0.0;
+    double weightedPerSec = 0.0;
+    std::vector<double> planUs;
+    int budgetHits = 0;
+    int violations = 0;        // 计划里的目标实际没能在截止前打完 (不应出现)
+};
+
+double percentile(std::vector<double> v, double p)
+{
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+// 草从可打击带上沿进入，地面以 groundPxPerMs 向下 (+y) 移动；30fps 每帧按当前可见的草重新排程，
+// 振镜执行到下一帧，已经开始跳转的那棵一定打完，下一帧从它打完的时刻和位置接着排
+SimResult simulate(const FireScheduler& scheduler, FireScheduler::Strategy strategy, const std::vector<SimWeed>& field,
+                   float groundPxPerMs, float durationMs)
+{
+    const FireScheduler::Config& cfg = scheduler.config();
+    const cv::Rect2f& band = cfg.band;
+    const cv::Point2f ground(0.f, groundPxPerMs);
+    const float frameMs = 1000.f / 30.f;
+    const float crossMs = band.height / groundPxPerMs;
+
+    std::vector<SimWeed> weeds = field;
+    SimResult r;
+    float freeAt = 0.f;
+    cv::Point2f galvo(band.x + band.width * 0.5f, band.y + band.height * 0.5f);
+    std::vector<FireTask> tasks;
+    std::vector<int> source;
+
+    for (float frame = 0.f; frame < durationMs; frame += frameMs) {
+        // 振镜这一帧都还在打上一批的最后一棵，下一帧再排
+        if (freeAt >= frame + frameMs) continue;
+        float t0 = std::max(frame, freeAt);
+        tasks.clear();
+        source.clear();
+        for (size_t i = 0; i < weeds.size(); ++i) {
+            const SimWeed& w = weeds[i];
+            if (w.done || w.spawnMs > frame || t0 - w.spawnMs >= crossMs) continue;
+            FireTask task;
+            task.pos = cv::Point2f(w.x, band.y + (t0 - w.spawnMs) * groundPxPerMs);
+            task.dwellMs = w.dwellMs;
+            task.deadlineMs = scheduler.exitTimeMs(task.pos, ground);
+            task.weight = w.weight;
+            tasks.push_back(task);
+            source.push_back((int)i);
+        }
+        if (tasks.empty()) continue;
+        // 排程前的检测顺序：优先级高的在前，同优先级按置信度
+        if (strategy == FireScheduler::InputOrder) {
+            std::vector<int> idx(tasks.size());
+            std::iota(idx.begin(), idx.end(), 0);
+            std::stable_sort(idx.begin(), idx.end(), [&](int a, int b) {
+                const SimWeed& wa = weeds[source[a]];
+                const SimWeed& wb = weeds[source[b]];
+                return wa.weight != wb.weight ? wa.weight > wb.weight : wa.order > wb.order;
+            });
+            std::vector<FireTask> sortedTasks;
+            std::vector<int> sortedSource;
+            for (int k : idx) {
+                sortedTasks.push_back(tasks[k]);
+                sortedSource.push_back(source[k]);
+            }
+            tasks.swap(sortedTasks);
+            source.swap(sortedSource);
+        }
+
+        FireScheduler::Plan p = scheduler.plan(tasks, galvo, ground, strategy);
+        r.planUs.push_back(p.elapsedUs);
+        if (p.budgetHit) r.budgetHits++;
+
+        // 按计划给出的完成时刻执行到下一帧；开始跳转的那棵打完，振镜停在它打完时的位置
+        float t = 0.f;
+        for (size_t k = 0; k < p.order.size(); ++k) {
+            if (t0 + t >= frame + frameMs) break;
+            int idx = p.order[k];
+            t = p.finishMs[k];
+            galvo = tasks[idx].pos + ground * t;
+            if (t > tasks[idx].deadlineMs) r.violations++;
+            else weeds[source[idx]].done = true;
+        }
+        freeAt = t0 + t;
+    }
+
+    // 只统计在仿真结束前已经离开可打击带的草
+    int total = 0, treated = 0;
+    double weight = 0.0;
+    for (const SimWeed& w : weeds) {
+        if (w.spawnMs + crossMs > durationMs) continue;
+        total++;
+        if (w.done) {
+            treated++;
+            weight += w.weight;
+        }
+    }
+    double sec = durationMs / 1000.0;
+    r.treatedPerSec = treated / sec;
+    r.weightedPerSec = weight / sec;
+    r.missRate = total ? 1.0 - (double)treated / total : 0.0;
+    return r;
+}
+
+} // namespace
+
+bool tests::fireScheduler()
+{
+    const FireScheduler& scheduler = FireScheduler::instance();
+    const FireScheduler::Config& cfg = scheduler.config();
+    const float groundPxPerMs = 0.25f;     // 250 像素/秒，草穿过 600 像素的带约 2.4 秒
+    const float durationMs = 30000.f;
+    const float thistleDwell = cfg.defaultDwellMs * 2.f;
+    const double rates[] = {8.0, 20.0, 40.0};
+    static const FireScheduler::Strategy kStrategies[] = {
+        FireScheduler::InputOrder, FireScheduler::EarliestDeadline, FireScheduler::Greedy, FireScheduler::GreedyTwoOpt};
+    static const char* kNames[] = {"检测顺序", "截止优先", "贪心", "贪心+2opt"};
+
+    qDebug() << ">>> [打击排程基准] 可打击带" << cfg.band.width << "x" << cfg.band.height << "| 地面" << groundPxPerMs * 1000
+             << "像素/秒 | 振镜" << cfg.galvoPxPerMs << "像素/ms + 稳定" << cfg.settleMs << "ms | 驻留" << cfg.defaultDwellMs
+             << "/" << thistleDwell << "ms (30% 高优先级) | 预算" << cfg.budgetUs << "us";
+
+    bool ok = true;
+    for (double rate : rates) {
+        // 同一片草场给所有策略用
+        std::mt19937 rng(20261018u + (unsigned)rate);
+        std::exponential_distribution<float> gap((float)(rate / 1000.0));
+        std::uniform_real_distribution<float> uni(0.f, 1.f);
+        std::vector<SimWeed> field;
+        for (float t = gap(rng); t < durationMs; t += gap(rng)) {
+            SimWeed w;
+            w.spawnMs = t;
+            w.x = cfg.band.x + uni(rng) * cfg.band.width;
+            bool thistle = uni(rng) < 0.3f;
+            w.dwellMs = thistle ? thistleDwell : cfg.defaultDwellMs;
+            w.weight = thistle ? 2.f : 1.f;
+            w.order = uni(rng);
+            field.push_back(w);
+        }
+
+        qDebug() << "    草" << rate << "棵/秒:";
+        double inputOrder = 0.0, best = 0.0;
+        for (int s = 0; s < 4; ++s) {
+            SimResult r = simulate(scheduler, kStrategies[s], field, groundPxPerMs, durationMs);
+            qDebug() << "      " << kNames[s] << "| 打掉" << r.treatedPerSec << "棵/秒 (加权" << r.weightedPerSec
+                     << ") | 漏打" << r.missRate * 100 << "% | 排程 p50" << percentile(r.planUs, 0.5) << "us p99"
+                     << percentile(r.planUs, 0.99) << "us | 超预算" << r.budgetHits << "帧";
+            if (r.violations > 0) {
+                qDebug() << "【警告】[打击排程基准]" << kNames[s] << "计划里有" << r.violations << "个目标实际来不及";
+                ok = false;
+            }
+            if (kStrategies[s] == FireScheduler::InputOrder) inputOrder = r.weightedPerSec;
+            if (kStrategies[s] == FireScheduler::GreedyTwoOpt) best = r.weightedPerSec;
+        }
+        if (best + 1e-9 < inputOrder) {
+            qDebug() << "【警告】[打击排程基准] 贪心+2opt 反而不如按检测顺序打";
+            ok = false;
+        }
+    }
+
+    // 预算同样约束贪心本身 (O(n²))：目标极多时必须按时收手，没排上的全部留在 dropped 里
+    {
+        FireScheduler& mutableScheduler = FireScheduler::instance();
+        const FireScheduler::Config saved = mutableScheduler.config();
+        FireScheduler::Config tight = saved;
+        tight.budgetUs = 200;
+        mutableScheduler.setConfig(tight);
+        std::mt19937 rng(7u);
+        std::uniform_real_distribution<float> uni(0.f, 1.f);
+        std::vector<FireTask> many(3000);
+        for (FireTask& task : many) {
+            task.pos = cv::Point2f(saved.band.x + uni(rng) * saved.band.width, saved.band.y + uni(rng) * saved.band.height);
+            task.dwellMs = 1.f;
+            task.deadlineMs = FireScheduler::kNoDeadline;
+        }
+        cv::Point2f center(saved.band.x + saved.band.width * 0.5f, saved.band.y + saved.band.height * 0.5f);
+        FireScheduler::Plan p = mutableScheduler.plan(many, center, cv::Point2f(0.f, groundPxPerMs), FireScheduler::Greedy);
+        mutableScheduler.setConfig(saved);
+        qDebug() << "    贪心预算: 3000 个目标，预算" << tight.budgetUs << "us | 实际" << p.elapsedUs << "us | 排上"
+                 << (int)p.order.size() << "个";
+        if (!p.budgetHit || p.order.size() + p.dropped.size() != many.size() || p.elapsedUs > tight.budgetUs * 10) {
+            qDebug() << "【警告】[打击排程基准] 贪心阶段没有守住排程预算";
+            ok = false;
+        }
+    }
+
+    if (ok) qDebug() << "✅ [打击排程基准] 完成";
+    return ok;
+}
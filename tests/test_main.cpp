@@ -0,0 +1,49 @@
+#include "tests.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+struct TestCase {
+    const char* name;
+    bool (*run)();
+};
+
+const TestCase kTests[] = {
+    {"targetbatch", tests::targetBatch},
+    {"protocol", tests::protocolCodec},
+    {"udpfire", tests::udpFireLink},
+    {"modbus", tests::modbusClient},
+    {"firescheduler", tests::fireScheduler},
+    {"nv12", tests::nv12Letterbox},
+    {"scenegate", tests::sceneGate},
+};
+
+} // namespace
+
+// 用法：car_hmi_tests            依次跑全部
+//       car_hmi_tests <名字> ...  只跑指定的几项 (ctest 每项单独调用一次)
+int main(int argc, char* argv[])
+{
+    int failed = 0;
+    int ran = 0;
+    for (const TestCase& t : kTests) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            if (strcmp(argv[i], t.name) == 0) selected = true;
+        }
+        if (!selected) continue;
+        ran++;
+        qDebug() << ">>> [测试]" << t.name;
+        if (!t.run()) {
+            qDebug() << "【警告】[测试]" << t.name << "失败";
+            failed++;
+        }
+    }
+    if (ran == 0) {
+        qDebug() << "【警告】没有匹配的测试项，可选:";
+        for (const TestCase& t : kTests) qDebug() << "   " << t.name;
+        return 2;
+    }
+    return failed == 0 ? 0 : 1;
+}
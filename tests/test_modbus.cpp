@@ -0,0 +1,116 @@
+#include "tests.h"
+#include "modbusclient.h"
+#include "modbusstandin.h"
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+using namespace modbus;
+
+// 客户端对进程内服务端替身联调：流水线、瞄准点合并、移动 / 车速轮询、写失败重发、异常码、断线检测
+
+static bool waitUntil(const std::function<bool()>& cond, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+bool tests::modbusClient()
+{
+    // 回调里用到的计数放在 client 前面声明，client 析构 (I/O 线程退出) 之后才销毁
+    std::atomic<int> done{0};
+    std::atomic<int> good{0};
+    std::atomic<int> exceptionCode{-1};
+
+    ModbusStandIn server;
+    if (!server.start()) {
+        qDebug() << "【警告】[Modbus] 自检失败：服务端替身无法启动";
+        return false;
+    }
+    server.setResponseDelayMs(1);
+    ModbusClient client;
+    client.setPollIntervalMs(10);
+    client.connectToServer("127.0.0.1", server.port());
+
+    bool ok = true;
+    auto check = [&ok](bool cond, const char* what) {
+        if (!cond) {
+            qDebug() << "【警告】[Modbus] 自检失败：" << what;
+            ok = false;
+        }
+    };
+    check(waitUntil([&]() { return client.isConnected(); }, 2000), "连不上服务端替身");
+
+    // 1. 流水线：一口气排 32 个写寄存器，全部成功且服务端一次收到多条
+    const int kWrites = 32;
+    for (int i = 0; i < kWrites; ++i) {
+        client.writeRegister((uint16_t)(16 + i % 16), (uint16_t)(1000 + i), [&](const ModbusClient::Result& r) {
+            if (r.ok) good++;
+            done++;
+        });
+    }
+    check(waitUntil([&]() { return done.load() == kWrites; }, 3000) && good.load() == kWrites, "写寄存器未全部成功");
+    check(server.reg(31) == 1000 + kWrites - 1, "写入值不对");
+    check(client.stats().maxInFlight > 1 && server.stats().maxBacklog > 1, "请求没有流水线发送");
+
+    // 2. 合并：连续改 200 次瞄准点，PLC 最终拿到最后一次，FC16 条数远少于 200
+    uint64_t fc16Before = server.stats().writeMultipleRegisters;
+    for (int i = 0; i < 200; ++i) client.setLaserTarget(i, 1000 - i);
+    check(waitUntil([&]() { return server.reg(Reg_LaserTargetX) == 199 && server.reg(Reg_LaserTargetY) == 801; }, 2000),
+          "瞄准点最终值不对");
+    uint64_t fc16 = server.stats().writeMultipleRegisters - fc16Before;
+    check(fc16 < 200, "瞄准点没有合并");
+
+    // 3. 移动 + 车速轮询：前进 40，回报车速逐步追上；停车后方向线圈清零
+    client.setMove(40.f, 0.f);
+    check(waitUntil([&]() {
+              return server.coil(Addr_DirectionForward) && !server.coil(Addr_DirectionBackward) &&
+                     server.reg(Reg_SpeedSet) == 40;
+          }, 2000), "移动指令未写入");
+    check(waitUntil([&]() { return client.lastReportedSpeed() == 40; }, 3000), "车速轮询未追上设定值");
+    client.setMove(0.f, 0.f);
+    check(waitUntil([&]() { return server.reg(Reg_SpeedSet) == 0 && !server.coil(Addr_DirectionForward); }, 2000),
+          "停车指令未写入");
+
+    // 4. 写失败要重发槽里的最新值：PLC 漏收停车那条速度清零 (客户端超时)，底盘不能一直跑；
+    //    瞄准点写入回异常码同样重发
+    client.setMove(40.f, 0.f);
+    check(waitUntil([&]() { return server.reg(Reg_SpeedSet) == 40; }, 2000), "移动指令未写入");
+    server.dropNextWrite(Reg_SpeedSet);
+    client.setMove(0.f, 0.f);
+    check(waitUntil([&]() { return server.stats().dropped == 1 && server.reg(Reg_SpeedSet) == 0; }, 3000),
+          "停车指令丢失后没有重发");
+    server.failNextWrite(Reg_LaserTargetX);
+    client.setLaserTarget(321, 123);
+    check(waitUntil([&]() { return server.reg(Reg_LaserTargetX) == 321 && server.reg(Reg_LaserTargetY) == 123; }, 2000),
+          "瞄准点写入异常后没有重发");
+    check(client.stats().retries >= 2, "失败重发计数不对");
+
+    // 5. 越界地址必须回异常码
+    done = 0;
+    client.readHoldingRegisters(ModbusStandIn::kRegisters, 1, [&](const ModbusClient::Result& r) {
+        exceptionCode = r.exception;
+        done++;
+    });
+    check(waitUntil([&]() { return done.load() == 1; }, 2000) && exceptionCode.load() == EX_ILLEGAL_ADDRESS,
+          "越界读没有返回 EX_ILLEGAL_ADDRESS");
+
+    ModbusClient::Stats st = client.stats();
+    // 6. 服务端停掉后客户端要检测到断开
+    server.stop();
+    check(waitUntil([&]() { return !client.isConnected(); }, 3000), "服务端关闭后客户端未检测到断开");
+    client.disconnectFromServer();
+
+    if (ok) {
+        qDebug() << "✅ [Modbus] 客户端 / 服务端替身联调自检通过 | 流水线峰值" << st.maxInFlight
+                 << "| 200 次瞄准点合并为" << (unsigned long long)fc16 << "条 FC16"
+                 << "| RTT 平均" << (st.responses ? st.sumRttMs / st.responses : 0.0) << "ms";
+    }
+    return ok;
+}
@@ -0,0 +1,195 @@
+#include "tests.h"
+#include "nv12letterbox.h"
+#include <opencv2/opencv.hpp>
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+using namespace nv12;
+
+// ==========================================
+// 颜色转换浮点参考 (模型图内运算的 CPU 版本)
+// 与 export_rknn.py --nv12-input 插进模型图里的运算完全一致
+// (色度 2 倍双线性上采样 + BT.601 limited range)，dst 为 width x height 的紧密 RGB888
+// ==========================================
+static void referenceRGB(const Nv12Frame& src, uint8_t* dst)
+{
+    const int cw = src.width / 2;
+    const int ch = src.height / 2;
+    // 色度上采样：align_corners=False 的双线性 (与 torch F.interpolate 一致)
+    auto chromaAt = [&](float fx, float fy, int comp) {
+        fx = std::max(0.f, std::min((float)(cw - 1), fx));
+        fy = std::max(0.f, std::min((float)(ch - 1), fy));
+        int x0 = (int)fx, y0 = (int)fy;
+        int x1 = std::min(cw - 1, x0 + 1), y1 = std::min(ch - 1, y0 + 1);
+        float ax = fx - x0, ay = fy - y0;
+        const uint8_t* r0 = src.uv + (size_t)y0 * src.uvStride;
+        const uint8_t* r1 = src.uv + (size_t)y1 * src.uvStride;
+        float top = r0[2 * x0 + comp] * (1.f - ax) + r0[2 * x1 + comp] * ax;
+        float bot = r1[2 * x0 + comp] * (1.f - ax) + r1[2 * x1 + comp] * ax;
+        return top * (1.f - ay) + bot * ay;
+    };
+    auto clamp8 = [](float v) { return (uint8_t)std::lround(std::max(0.f, std::min(255.f, v))); };
+
+    for (int r = 0; r < src.height; ++r) {
+        const uint8_t* yRow = src.y + (size_t)r * src.yStride;
+        uint8_t* out = dst + (size_t)r * src.width * 3;
+        float fy = (r + 0.5f) * 0.5f - 0.5f;
+        for (int c = 0; c < src.width; ++c) {
+            float fx = (c + 0.5f) * 0.5f - 0.5f;
+            float yy = (yRow[c] - 16.f) * 1.164f;
+            float du = chromaAt(fx, fy, 0) - 128.f;
+            float dv = chromaAt(fx, fy, 1) - 128.f;
+            out[3 * c + 0] = clamp8(yy + 1.596f * dv);
+            out[3 * c + 1] = clamp8(yy - 0.813f * dv - 0.391f * du);
+            out[3 * c + 2] = clamp8(yy + 2.018f * du);
+        }
+    }
+}
+
+// 同一张图分别走 "NV12 缩放 + 图内转换" 与现有 "letterboxRGB" 两条路，统计模型输入的像素误差。
+// 两条路的缩放和取整方式不同，逐像素会有出入，平均误差超过 2 说明图内转换和 CPU 内核对不上了
+static bool validateNv12Input(int srcW, int srcH, int dstW, int dstH)
+{
+    // 与 benchmark 相同的合成图，再叠一层平滑色度，避免误差全被高频噪声主导
+    cv::Mat nv12(srcH * 3 / 2, srcW, CV_8UC1);
+    for (int r = 0; r < nv12.rows; ++r) {
+        uint8_t* p = nv12.ptr<uint8_t>(r);
+        for (int c = 0; c < srcW; ++c) {
+            p[c] = r < srcH ? (uint8_t)((r * 7 + c * 3 + (c * r) % 17) & 0xFF)
+                            : (uint8_t)(96 + ((c / 2) * 64 / srcW) + ((r - srcH) * 64 / (srcH / 2)));
+        }
+    }
+    Nv12Frame src;
+    src.y = nv12.data;
+    src.uv = nv12.data + (size_t)srcW * srcH;
+    src.width = srcW;
+    src.height = srcH;
+    src.yStride = srcW;
+    src.uvStride = srcW;
+
+    // 现有路径：CPU 融合内核直接出 RGB
+    LetterboxParams p = makeLetterboxEven(srcW, srcH, dstW, dstH);
+    std::vector<uint8_t> rgbPath((size_t)dstW * dstH * 3);
+    letterboxRGB(src, rgbPath.data(), p, KernelPath::Scalar, 1);
+
+    // NV12 路径：先缩放成模型尺寸的 NV12，再按图内运算转 RGB
+    std::vector<uint8_t> nv12Input((size_t)dstW * dstH * 3 / 2);
+    auto t0 = std::chrono::steady_clock::now();
+    letterboxNV12(src, nv12Input.data(), p);
+    double scaleMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    Nv12Frame scaled;
+    scaled.y = nv12Input.data();
+    scaled.uv = nv12Input.data() + (size_t)dstW * dstH;
+    scaled.width = dstW;
+    scaled.height = dstH;
+    scaled.yStride = dstW;
+    scaled.uvStride = dstW;
+    std::vector<uint8_t> graphPath((size_t)dstW * dstH * 3);
+    referenceRGB(scaled, graphPath.data());
+
+    // 只统计有效区 (填充区两边都是 114)
+    int maxDiff = 0;
+    double sumDiff = 0.0;
+    size_t count = 0;
+    for (int r = p.padTop; r < p.padTop + p.newH; ++r) {
+        for (int c = p.padLeft; c < p.padLeft + p.newW; ++c) {
+            for (int k = 0; k < 3; ++k) {
+                size_t i = ((size_t)r * dstW + c) * 3 + k;
+                int d = std::abs((int)rgbPath[i] - (int)graphPath[i]);
+                maxDiff = std::max(maxDiff, d);
+                sumDiff += d;
+                count++;
+            }
+        }
+    }
+    double meanDiff = count ? sumDiff / count : 0.0;
+    qDebug() << "[NV12输入校验]" << srcW << "x" << srcH << "->" << dstW << "x" << dstH
+             << "| NV12缩放(CPU):" << QString::number(scaleMs, 'f', 2) << "ms"
+             << "| 模型输入误差: 最大" << maxDiff
+             << "平均" << QString::number(meanDiff, 'f', 3);
+    if (meanDiff >= 2.0) {
+        qDebug() << "【警告】[NV12输入校验] 平均误差过大，图内颜色转换与 CPU 内核不一致";
+        return false;
+    }
+    return true;
+}
+
+// ==========================================
+// 性能对比：OpenCV 四步链路 vs 标量 vs SIMD
+// SIMD (单带 / 多带) 必须与标量逐字节一致；与 OpenCV 的差异只输出不判定 (取整方式不同)
+// ==========================================
+static bool benchmark(int srcW, int srcH, int dstSize, int iterations)
+{
+    // 合成一张带渐变和噪声的 NV12 测试图
+    cv::Mat nv12(srcH * 3 / 2, srcW, CV_8UC1);
+    for (int r = 0; r < nv12.rows; ++r) {
+        uint8_t* p = nv12.ptr<uint8_t>(r);
+        for (int c = 0; c < srcW; ++c) p[c] = (uint8_t)((r * 7 + c * 3 + (c * r) % 17) & 0xFF);
+    }
+    Nv12Frame src;
+    src.y = nv12.data;
+    src.uv = nv12.data + (size_t)srcW * srcH;
+    src.width = srcW;
+    src.height = srcH;
+    src.yStride = srcW;
+    src.uvStride = srcW;
+
+    float scale = 1.f;
+    LetterboxParams p = makeLetterbox(srcW, srcH, dstSize, dstSize, &scale);
+
+    auto timeIt = [&](const std::function<void()>& fn) {
+        fn(); // 预热
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / iterations;
+    };
+
+    cv::Mat ref(dstSize, dstSize, CV_8UC3);
+    double cvMs = timeIt([&]{
+        cv::Mat bgr, resized;
+        cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+        cv::resize(bgr, resized, cv::Size(p.newW, p.newH), 0, 0, cv::INTER_LINEAR);
+        ref.setTo(cv::Scalar(114, 114, 114));
+        resized.copyTo(ref(cv::Rect(p.padLeft, p.padTop, p.newW, p.newH)));
+        cv::cvtColor(ref, ref, cv::COLOR_BGR2RGB);
+    });
+
+    cv::Mat outScalar(dstSize, dstSize, CV_8UC3);
+    cv::Mat outSimd1(dstSize, dstSize, CV_8UC3);
+    cv::Mat outSimd(dstSize, dstSize, CV_8UC3);
+    double scalarMs = timeIt([&]{ letterboxRGB(src, outScalar.data, p, KernelPath::Scalar, 1); });
+    double simd1Ms  = timeIt([&]{ letterboxRGB(src, outSimd1.data, p, KernelPath::Simd, 1); });
+    double simdMs   = timeIt([&]{ letterboxRGB(src, outSimd.data, p, KernelPath::Simd, 0); });
+
+    int diffScalar = 0, diffCv = 0;
+    size_t n = (size_t)dstSize * dstSize * 3;
+    for (size_t i = 0; i < n; ++i) {
+        diffScalar = std::max(diffScalar, std::abs(outSimd.data[i] - outScalar.data[i]));
+        diffScalar = std::max(diffScalar, std::abs(outSimd1.data[i] - outScalar.data[i]));
+        diffCv = std::max(diffCv, std::abs(outSimd.data[i] - ref.data[i]));
+    }
+
+    qDebug() << "[NV12基准]" << srcW << "x" << srcH << "->" << dstSize << "x" << dstSize
+             << "| OpenCV链路:" << QString::number(cvMs, 'f', 2) << "ms"
+             << "| 标量:" << QString::number(scalarMs, 'f', 2) << "ms"
+             << "|" << simdName() << "单线程:" << QString::number(simd1Ms, 'f', 2) << "ms"
+             << "|" << simdName() << "多线程:" << QString::number(simdMs, 'f', 2) << "ms";
+    qDebug() << "[NV12基准] 最大误差: SIMD vs 标量 =" << diffScalar << "| SIMD vs OpenCV =" << diffCv;
+    if (diffScalar != 0) {
+        qDebug() << "【警告】[NV12基准]" << simdName() << "与标量参考实现不一致";
+        return false;
+    }
+    return true;
+}
+
+bool tests::nv12Letterbox()
+{
+    bool ok = benchmark(800, 600, 640, 100);
+    ok &= validateNv12Input(800, 600, 640, 640);
+    return ok;
+}
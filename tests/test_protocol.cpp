@@ -0,0 +1,241 @@
+#include "tests.h"
+#include "protocolcodec.h"
+#include "targetbatch.h"
+#include <QDebug>
+#include <cstring>
+
+// ==========================================
+// 1. 批量目标报文 CMD_TARGET_BATCH
+// ==========================================
+
+static bool sameEntry(const TargetEntry& a, const TargetEntry& b)
+{
+    return a.x == b.x && a.y == b.y && a.classId == b.classId &&
+           a.confidence == b.confidence && a.trackId == b.trackId;
+}
+
+bool tests::targetBatch()
+{
+    uint8_t buf[targetbatch::MAX_PACKET + 8];
+    TargetEntry entries[TARGET_BATCH_MAX];
+    for (int i = 0; i < TARGET_BATCH_MAX; ++i) {
+        entries[i].x = (int16_t)(i * 37 - 900);
+        entries[i].y = (int16_t)(32767 - i * 11);
+        entries[i].classId = (uint8_t)(i % 80);
+        entries[i].confidence = (uint8_t)(255 - i);
+        entries[i].trackId = i == 3 ? 0xFFFF : (uint16_t)(i * 1000);
+    }
+    TargetBatchHeader head;
+    memset(&head, 0, sizeof(head));
+    head.frameId = 0xDEADBEEF;
+    head.captureMs = 123456789;
+    head.validInMs = 30;
+    head.latencyMs = 95;
+    head.shiftX = -12;
+    head.shiftY = 340;
+    head.cameraId = 1;
+
+    bool ok = true;
+    const int counts[] = {0, 1, 7, TARGET_BATCH_MAX};
+    for (int count : counts) {
+        size_t n = targetbatch::encode(head, entries, count, buf, sizeof(buf));
+        targetbatch::View view;
+        if (n != targetbatch::packetSize(count) || !targetbatch::decode(buf, n, view) || view.count != count ||
+            view.head.frameId != head.frameId || view.head.captureMs != head.captureMs ||
+            view.head.shiftX != head.shiftX || view.head.shiftY != head.shiftY ||
+            view.head.validInMs != head.validInMs || view.head.cameraId != head.cameraId) {
+            ok = false;
+            continue;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (!sameEntry(view.at(i), entries[i])) ok = false;
+        }
+        // 截断、加尾巴、改类型都必须被拒绝
+        targetbatch::View bad;
+        if (targetbatch::decode(buf, n - 1, bad) || targetbatch::decode(buf, n + 1, bad)) ok = false;
+        buf[1] = CMD_TARGET;
+        if (targetbatch::decode(buf, n, bad)) ok = false;
+    }
+    // 超过上限和缓冲区不够都不能写
+    if (targetbatch::encode(head, entries, TARGET_BATCH_MAX + 1, buf, sizeof(buf)) != 0) ok = false;
+    if (targetbatch::encode(head, entries, 2, buf, targetbatch::packetSize(2) - 1) != 0) ok = false;
+
+    if (ok) {
+        qDebug() << "✅ [批量目标协议] 编解码自检通过，单帧最大报文" << (int)targetbatch::MAX_PACKET << "字节";
+    } else {
+        qDebug() << "【警告】[批量目标协议] 编解码自检失败！";
+    }
+    return ok;
+}
+
+// ==========================================
+// 2. 定长指令编解码 + 模糊测试
+// ==========================================
+
+namespace {
+
+using namespace proto;
+
+// 自检用的处理器：记下收到的值，便于和发出的比对
+struct ProbeHandler {
+    int heartbeats = 0;
+    MovePayload move = {};
+    ControlPayload control = {};
+    TargetPayload target = {};
+    EchoPayload echo = {};
+    int batches = 0;
+    int batchCount = -1;
+
+    void handle(const Heartbeat&) { heartbeats++; }
+    void handle(const MovePayload& v) { move = v; }
+    void handle(const ControlPayload& v) { control = v; }
+    void handle(const TargetPayload& v) { target = v; }
+    void handle(const EchoPayload& v) { echo = v; }
+    void handle(const targetbatch::View& v) { batches++; batchCount = v.count; }
+};
+
+// 只收移动指令，其余都应返回 Unhandled
+struct MoveOnlyHandler {
+    int moves = 0;
+    void handle(const MovePayload&) { moves++; }
+};
+
+struct XorShift {
+    uint32_t s = 0x9E3779B9u;
+    uint32_t next() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+};
+
+} // namespace
+
+bool tests::protocolCodec()
+{
+    using namespace proto;
+    const int fuzzIterations = 200000;
+    bool ok = true;
+
+    // 1. 往返
+    MovePayload move = {0.5f, -1.25f, 3.0f};
+    auto movePkt = pack<CMD_MOVE>(move);
+    ControlPayload control = {1, 1, 0, 0};
+    auto controlPkt = pack<CMD_CONTROL>(control);
+    TargetPayload target = {-100, 200, -300, 32767, 0xA1B2C3D4u, 30, 95, 7, 200, 0xFFFF};
+    auto targetPkt = pack<CMD_TARGET>(target);
+    auto heartbeatPkt = pack<CMD_HEARTBEAT>(Heartbeat());
+
+    ProbeHandler probe;
+    ok &= dispatch(movePkt.data(), movePkt.size, probe) == Status::Ok &&
+          probe.move.vx == move.vx && probe.move.vy == move.vy && probe.move.vz == move.vz;
+    ok &= dispatch(controlPkt.data(), controlPkt.size, probe) == Status::Ok &&
+          memcmp(&probe.control, &control, sizeof(control)) == 0;
+    ok &= dispatch(targetPkt.data(), targetPkt.size, probe) == Status::Ok &&
+          memcmp(&probe.target, &target, sizeof(target)) == 0;
+    ok &= dispatch(heartbeatPkt.data(), heartbeatPkt.size, probe) == Status::Ok && probe.heartbeats == 1;
+    ok &= heartbeatPkt.size == kHeaderSize;
+
+    // 2. 线上字节序：长度字段和 float 都是小端
+    ok &= movePkt.size == 16 && movePkt.bytes[0] == kMagic && movePkt.bytes[1] == CMD_MOVE &&
+          movePkt.bytes[2] == 12 && movePkt.bytes[3] == 0;
+    ok &= movePkt.bytes[4] == 0x00 && movePkt.bytes[5] == 0x00 && movePkt.bytes[6] == 0x00 && movePkt.bytes[7] == 0x3F;
+    ok &= targetPkt.bytes[kHeaderSize + 8] == 0xD4 && targetPkt.bytes[kHeaderSize + 11] == 0xA1;
+
+    // 3. 大端对端发来的长度能被识别出来
+    auto swapped = movePkt;
+    swapped.bytes[2] = 0;
+    swapped.bytes[3] = 12;
+    ok &= dispatch(swapped.data(), swapped.size, probe) == Status::ByteSwapped;
+
+    // 4. 处理器没有对应 handle() 的指令
+    MoveOnlyHandler moveOnly;
+    ok &= dispatch(controlPkt.data(), controlPkt.size, moveOnly) == Status::Unhandled;
+    ok &= dispatch(movePkt.data(), movePkt.size, moveOnly) == Status::Ok && moveOnly.moves == 1;
+
+    // 5. 批量目标走同一张分发表
+    uint8_t batchBuf[targetbatch::MAX_PACKET];
+    TargetBatchHeader batchHead = {};
+    batchHead.frameId = 42;
+    TargetEntry entries[3] = {};
+    size_t batchLen = targetbatch::encode(batchHead, entries, 3, batchBuf, sizeof(batchBuf));
+    ok &= dispatch(batchBuf, batchLen, probe) == Status::Ok && probe.batchCount == 3;
+
+    // 6. v2 帧头：序号 / 发送时刻原样带过去，载荷不变；补写后能读回新值
+    Trace trace;
+    trace.seq = 0xBEEF;
+    trace.sendUs = 0x01020304u;
+    trace.flags = FRAME_FLAG_ECHO;
+    auto tracedPkt = pack<CMD_MOVE>(move, &trace);
+    FrameView tracedView;
+    ok &= tracedPkt.size == kHeaderV2Size + 12 && tracedPkt.bytes[0] == kMagicV2;
+    ok &= decodeFrame(tracedPkt.data(), tracedPkt.size, tracedView) == Status::Ok && tracedView.traced &&
+          tracedView.trace.seq == 0xBEEF && tracedView.trace.sendUs == 0x01020304u && tracedView.trace.flags == FRAME_FLAG_ECHO;
+    ok &= dispatch(tracedPkt.data(), tracedPkt.size, probe) == Status::Ok && probe.move.vz == move.vz;
+    trace.seq = 7;
+    restamp(tracedPkt.bytes, trace);
+    ok &= decodeFrame(tracedPkt.data(), tracedPkt.size, tracedView) == Status::Ok && tracedView.trace.seq == 7;
+    tracedPkt.bytes[4] = 9;
+    ok &= dispatch(tracedPkt.data(), tracedPkt.size, probe) == Status::BadVersion;
+    EchoPayload echo = {CMD_MOVE, 0, 7, 0x01020304u, 150, 0};
+    auto echoPkt = pack<CMD_ECHO>(echo);
+    ok &= dispatch(echoPkt.data(), echoPkt.size, probe) == Status::Ok && probe.echo.seq == 7 && probe.echo.procUs == 150;
+
+    // 7. 模糊测试：对合法报文随机改字节 / 截断 / 加长 / 纯随机数据。
+    //    不能越界、不能崩溃；判为 Ok 的定长报文重新编码后必须和输入逐字节一致
+    auto tracedTarget = pack<CMD_TARGET>(target, &trace);
+    const uint8_t* seeds[] = {movePkt.data(), controlPkt.data(), targetPkt.data(), heartbeatPkt.data(), batchBuf,
+                              echoPkt.data(), tracedTarget.data()};
+    const size_t seedLens[] = {movePkt.size, controlPkt.size, targetPkt.size, heartbeatPkt.size, batchLen,
+                               echoPkt.size, tracedTarget.size};
+    const int seedCount = 7;
+    uint8_t buf[targetbatch::MAX_PACKET + 16];
+    XorShift rng;
+    int counts[kStatusCount] = {0};
+    for (int it = 0; it < fuzzIterations; ++it) {
+        int k = (int)(rng.next() % seedCount);
+        size_t len = seedLens[k];
+        memcpy(buf, seeds[k], len);
+        switch (rng.next() % 4) {
+        case 0: {
+            int flips = 1 + (int)(rng.next() % 3);
+            for (int f = 0; f < flips; ++f) buf[rng.next() % len] = (uint8_t)rng.next();
+            break;
+        }
+        case 1: len = rng.next() % (len + 1); break;
+        case 2: {
+            size_t extra = 1 + rng.next() % 8;
+            for (size_t e = 0; e < extra; ++e) buf[len + e] = (uint8_t)rng.next();
+            len += extra;
+            break;
+        }
+        default:
+            len = rng.next() % sizeof(buf);
+            for (size_t e = 0; e < len; ++e) buf[e] = (uint8_t)rng.next();
+            break;
+        }
+
+        ProbeHandler h;
+        Status st = dispatch(buf, len, h);
+        counts[(int)st]++;
+        if (st != Status::Ok) continue;
+        FrameView fv;
+        decodeFrame(buf, len, fv);
+        const Trace* tr = fv.traced ? &fv.trace : nullptr;
+        size_t n = 0;
+        uint8_t again[targetbatch::MAX_PACKET];
+        if (fv.type == CMD_MOVE) { auto p = pack<CMD_MOVE>(h.move, tr); n = p.size; memcpy(again, p.bytes, n); }
+        else if (fv.type == CMD_CONTROL) { auto p = pack<CMD_CONTROL>(h.control, tr); n = p.size; memcpy(again, p.bytes, n); }
+        else if (fv.type == CMD_TARGET) { auto p = pack<CMD_TARGET>(h.target, tr); n = p.size; memcpy(again, p.bytes, n); }
+        else if (fv.type == CMD_ECHO) { auto p = pack<CMD_ECHO>(h.echo, tr); n = p.size; memcpy(again, p.bytes, n); }
+        else continue;
+        if (n != len || memcmp(again, buf, n) != 0) ok = false;
+    }
+
+    if (ok) {
+        qDebug() << "✅ [协议编解码] 往返 / 字节序 / 分发自检通过，模糊测试" << fuzzIterations << "次"
+                 << "| 正常" << counts[(int)Status::Ok]
+                 << "| 长度不符" << counts[(int)Status::BadLength]
+                 << "| 包头错误" << counts[(int)Status::BadMagic]
+                 << "| 未知指令" << counts[(int)Status::UnknownType];
+    } else {
+        qDebug() << "【警告】[协议编解码] 自检失败！";
+    }
+    return ok;
+}
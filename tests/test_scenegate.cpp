@@ -0,0 +1,72 @@
+#include "tests.h"
+#include "scenegate.h"
+#include <QDebug>
+#include <random>
+#include <vector>
+
+// 画面静止门控的两个内核：SIMD 与标量结果必须逐字节一致，否则开发机上调好的阈值到车上就不准了。
+// 宽度 / 行距故意取非 16 整数倍和带填充的值，覆盖 SIMD 主循环之后的标量尾巴
+
+bool tests::sceneGate()
+{
+    bool ok = true;
+    std::mt19937 rng(20260418);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    // 1. 4x4 均值降采样
+    const int sizes[][3] = {{640, 480, 640}, {800, 600, 832}, {332, 244, 340}, {36, 36, 48}};
+    for (const auto& s : sizes) {
+        const int width = s[0], height = s[1], stride = s[2];
+        std::vector<uint8_t> y((size_t)stride * height);
+        for (auto& v : y) v = (uint8_t)byte(rng);
+        const size_t outSize = (size_t)(width / SceneGate::DOWNSCALE) * (height / SceneGate::DOWNSCALE);
+        std::vector<uint8_t> simd(outSize), scalar(outSize);
+        SceneGate::downsample(y.data(), stride, width, height, simd.data(), true);
+        SceneGate::downsample(y.data(), stride, width, height, scalar.data(), false);
+        if (simd != scalar) {
+            qDebug() << "【警告】[静止门控] 降采样" << SceneGate::simdName() << "与标量不一致:"
+                     << width << "x" << height << "行距" << stride;
+            ok = false;
+        }
+    }
+
+    // 2. 8x8 块 SAD：随机块 + 全 0 对全 255 (累加不能溢出) + 相同块
+    const int strides[] = {8, 13, 160, 200};
+    int blocks = 0;
+    for (int stride : strides) {
+        std::vector<uint8_t> a((size_t)stride * SceneGate::BLOCK), b(a.size());
+        for (int round = 0; round < 500; ++round) {
+            if (round == 0) {
+                std::fill(a.begin(), a.end(), 0);
+                std::fill(b.begin(), b.end(), 255);
+            } else {
+                for (auto& v : a) v = (uint8_t)byte(rng);
+                if (round == 1) b = a;
+                else for (auto& v : b) v = (uint8_t)byte(rng);
+            }
+            uint32_t simd = SceneGate::blockSad(a.data(), b.data(), stride, true);
+            uint32_t scalar = SceneGate::blockSad(a.data(), b.data(), stride, false);
+            blocks++;
+            if (simd != scalar) {
+                qDebug() << "【警告】[静止门控] 块 SAD" << SceneGate::simdName() << "与标量不一致: 行距" << stride
+                         << "第" << round << "轮" << simd << "!=" << scalar;
+                ok = false;
+                break;
+            }
+            if (round == 0 && scalar != 64u * 255u) {
+                qDebug() << "【警告】[静止门控] 全 0 对全 255 的块 SAD 应为" << 64 * 255 << "实际" << scalar;
+                ok = false;
+            }
+            if (round == 1 && scalar != 0) {
+                qDebug() << "【警告】[静止门控] 相同块的 SAD 应为 0，实际" << scalar;
+                ok = false;
+            }
+        }
+    }
+
+    if (ok) {
+        qDebug() << "✅ [静止门控]" << SceneGate::simdName() << "内核与标量一致 | 降采样" << (int)(sizeof(sizes) / sizeof(sizes[0]))
+                 << "种尺寸 | 块 SAD" << blocks << "组";
+    }
+    return ok;
+}
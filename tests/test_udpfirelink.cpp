@@ -0,0 +1,134 @@
+#include "tests.h"
+#include "udpfirelink.h"
+#include "targetbatch.h"
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// 本机回环收发：单向时延 p50 / p99、冗余副本去重与降丢包、最新者胜
+// 与 MQTT 路径 (经 broker) 的 p99 对比要起 broker，不放进 ctest：见 tools/fire_latency.py，同频率同帧格式两条路径并排出数
+
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+bool tests::udpFireLink()
+{
+    bool ok = true;
+    auto check = [&ok](bool cond, const char* what) {
+        if (!cond) {
+            qDebug() << "【警告】[UDP 打击通道] 自检失败：" << what;
+            ok = false;
+        }
+    };
+
+    UdpFireReceiver receiver;
+    UdpFireLink link;
+    if (!receiver.bind(0) || !link.open("127.0.0.1", receiver.port())) {
+        qDebug() << "【警告】[UDP 打击通道] 自检失败：回环收发端无法打开";
+        return false;
+    }
+
+    // 接收线程一直读；latencies 和 receiver 的统计在 join 之后再看，运行中只看原子计数
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> moves{0};
+    std::atomic<uint64_t> batches{0};
+    std::vector<double> latencies;
+    std::thread rx([&]() {
+        while (running) {
+            receiver.drain(20, [&](uint8_t type, const UdpFireReceiver::Latest& l) {
+                if (type == CMD_MOVE) {
+                    latencies.push_back((int32_t)(l.recvUs - l.sendUs) / 1000.0);
+                    moves++;
+                } else if (type == CMD_TARGET_BATCH) {
+                    batches++;
+                }
+            });
+        }
+    });
+
+    // 1. 单向时延：2 份冗余、2kHz 发 2000 条移动指令
+    const int kMoves = 2000;
+    for (int i = 0; i < kMoves; ++i) {
+        MovePayload move = {(float)i, 0.f, 0.f};
+        proto::Trace placeholder;
+        auto pkt = proto::pack<CMD_MOVE>(move, &placeholder);
+        link.send(pkt.bytes, pkt.size);
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t movesAccepted = moves.load();
+
+    // 2. 冗余：每份副本 20% 丢包，1 份和 2 份各发 1000 条批量目标，比较送达的独立报文数
+    TargetBatchHeader head;
+    memset(&head, 0, sizeof(head));
+    TargetEntry entry = {100, 200, 1, 200, 7};
+    uint8_t packet[udpfire::kMaxDatagram];
+    uint64_t delivered[2] = {0, 0};
+    link.setDropRate(0.2);
+    for (int copies = 1; copies <= 2; ++copies) {
+        link.setCopies(copies);
+        uint64_t before = batches.load();
+        for (int i = 0; i < 1000; ++i) {
+            head.frameId = (uint32_t)i;
+            proto::Trace placeholder;
+            size_t len = targetbatch::encode(head, &entry, 1, packet, sizeof(packet), &placeholder);
+            link.send(packet, len);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        delivered[copies - 1] = batches.load() - before;
+    }
+    link.setDropRate(0.0);
+    running = false;
+    rx.join();
+
+    check(movesAccepted == (uint64_t)kMoves, "回环上移动指令有丢失");
+    check(receiver.stats().duplicates >= (uint64_t)kMoves * 9 / 10, "冗余副本没有被去重");
+    check(delivered[1] > delivered[0] && delivered[1] >= 900, "冗余没有降低丢包");
+    double p50 = percentile(latencies, 0.5);
+    double p99 = percentile(latencies, 0.99);
+    double maxMs = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+    check(!latencies.empty() && p99 < 5.0, "回环单向时延 p99 超过 5ms");
+
+    // 3. 最新者胜：积压 10 条一次读空后槽里是最后一条；之后再来一条旧序号的必须丢弃
+    link.setCopies(1);
+    for (int i = 0; i < 10; ++i) {
+        MovePayload move = {(float)(9000 + i), 0.f, 0.f};
+        proto::Trace placeholder;
+        auto pkt = proto::pack<CMD_MOVE>(move, &placeholder);
+        link.send(pkt.bytes, pkt.size);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    receiver.drain(100);
+    const UdpFireReceiver::Latest& last = receiver.latest(CMD_MOVE);
+    MovePayload lastMove = {0.f, 0.f, 0.f};
+    proto::FrameView view;
+    if (last.valid && proto::decodeFrame(last.data, last.len, view) == proto::Status::Ok) {
+        proto::Message<CMD_MOVE>::decode(view.payload, view.len, lastMove);
+    }
+    check(lastMove.vx == 9009.f, "积压后最新值不是最后一条");
+
+    uint64_t staleBefore = receiver.stats().stale;
+    proto::Trace old;
+    old.seq = (uint16_t)(last.seq - 5);
+    old.sendUs = udpfire::nowUs();
+    MovePayload oldMove = {-1.f, 0.f, 0.f};
+    auto oldPkt = proto::pack<CMD_MOVE>(oldMove, &old);
+    link.send(oldPkt.bytes, oldPkt.size, &old);
+    receiver.drain(100);
+    check(receiver.stats().stale == staleBefore + 1 && receiver.latest(CMD_MOVE).seq == last.seq, "旧序号报文没有被丢弃");
+
+    if (ok) {
+        qDebug() << "✅ [UDP 打击通道] 回环自检通过 | 单向时延 p50" << p50 << "ms p99" << p99 << "ms max" << maxMs
+                 << "ms | 20% 丢包下送达: 1 份" << (unsigned long long)delivered[0] << "/1000, 2 份"
+                 << (unsigned long long)delivered[1] << "/1000";
+    }
+    return ok;
+}
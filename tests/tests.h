@@ -0,0 +1,22 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+// ==========================================
+// 离线自检 / 基准 (car_hmi_tests)
+// 与主程序分开编译，不进生产二进制：ctest 逐项运行，也可以 car_hmi_tests <名字> 单独跑。
+// 每项返回 true 表示通过，过程和结果数字用 qDebug 输出。
+// ==========================================
+
+namespace tests {
+
+bool targetBatch();      // CMD_TARGET_BATCH 编解码往返 + 非法报文
+bool protocolCodec();    // 定长指令往返 / 字节序 / 分发表 + 随机变异模糊测试
+bool udpFireLink();      // UDP 打击通道回环：单向时延、冗余去重、最新者胜
+bool modbusClient();     // Modbus TCP 客户端对服务端替身：流水线、合并、写失败重发、异常码、断线
+bool fireScheduler();    // 合成草场滚动仿真：各排程策略的吞吐 / 漏打率 / 排程耗时
+bool nv12Letterbox();    // NV12 融合内核：SIMD 与标量逐字节一致，NV12 输入路径误差，与 OpenCV 链路对比耗时
+bool sceneGate();        // 画面静止门控：降采样 / 块 SAD 的 SIMD 与标量结果一致
+
+} // namespace tests
+
+#endif // TESTS_H
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+打击通道单向时延对比 —— MQTT (经 broker) vs UDP 直连，本机回环，只用标准库
+
+两条路径发同样的 v2 帧 (CMD_MOVE，12 字节 FrameHeaderV2 + 12 字节载荷)，同频率发送，
+接收端用同一个单调时钟算单向时延，打印 p50 / p99 / max 和送达率：
+  mqtt   上位机 -> broker 替身 (mqtt_saturation.py 里那个) -> 订阅端，两段 TCP
+  udp    上位机 -> 下位机端口，一个数据报；每条连发 --copies 份，接收端按 seq 最新者胜
+--drop 在 UDP 发送端按份随机丢包，看冗余能把送达率拉回多少 (MQTT 走 TCP，丢包变成重传时延，回环上模拟不了)。
+
+接收端的最新者胜逻辑 (LatestWins) 与 src/udpfirelink.cpp 的 UdpFireReceiver 一致，
+sim_controller.py --udp-port 也用它，下位机固件照此实现。
+
+用法：
+  python3 fire_latency.py                          # 两条路径各跑 5 秒，500Hz
+  python3 fire_latency.py --hz 50 --drop 0.1 --copies 2
+  ctest -R udpfire -V                              # C++ 侧 UdpFireLink 回环自检，打印 p50 / p99
+"""
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+from mqtt_saturation import Broker, Client, percentile
+
+MAGIC_V2 = 0x5B
+CMD_MOVE = 0x01
+RESYNC_SEC = 1.0          # 与 UdpFireReceiver::kResyncMs 一致
+
+
+def now_us():
+    return (time.monotonic_ns() // 1000) & 0xFFFFFFFF
+
+
+def frame_v2(cmd, seq, send_us, payload):
+    return struct.pack("<BBHBBHI", MAGIC_V2, cmd, len(payload), 2, 0, seq & 0xFFFF, send_us) + payload
+
+
+def seq_newer(a, b):
+    """16 位序号环形比较：a 比 b 新"""
+    d = (a - b) & 0xFFFF
+    return d != 0 and d < 0x8000
+
+
+class LatestWins:
+    """按指令类型只保留 seq 最新的一条；重复副本和迟到的旧报文丢掉"""
+
+    def __init__(self):
+        self.latest = {}          # type -> (seq, send_us, payload, 采纳时刻)
+        self.accepted = self.duplicates = self.stale = self.malformed = 0
+
+    def offer(self, data):
+        """采纳返回 (type, seq, send_us, payload)，否则返回 None"""
+        if len(data) < 12:
+            self.malformed += 1
+            return None
+        magic, cmd, length, version, _flags, seq, send_us = struct.unpack_from("<BBHBBHI", data, 0)
+        if magic != MAGIC_V2 or version != 2 or len(data) != 12 + length:
+            self.malformed += 1
+            return None
+        now = time.monotonic()
+        last = self.latest.get(cmd)
+        if last is not None and now - last[3] <= RESYNC_SEC:
+            if seq == last[0]:
+                self.duplicates += 1
+                return None
+            if not seq_newer(seq, last[0]):
+                self.stale += 1
+                return None
+        payload = data[12:]
+        self.latest[cmd] = (seq, send_us, payload, now)
+        self.accepted += 1
+        return cmd, seq, send_us, payload
+
+
+def summary(name, latencies, sent, extra=""):
+    print("%-5s 送达 %5d / %5d | p50 %7.3f ms | p99 %7.3f ms | max %7.3f ms%s" % (
+        name, len(latencies), sent, percentile(latencies, 0.5), percentile(latencies, 0.99),
+        max(latencies) if latencies else float("nan"), extra))
+
+
+def run_mqtt(args):
+    broker = Broker(0, args.link_kbps).start()
+    monitor = Client(broker.port, "fire_monitor")
+    monitor.subscribe("car/cmd")
+    control = Client(broker.port, "fire_control")
+    latencies = []
+    stop = threading.Event()
+
+    def monitor_loop():
+        for topic, payload in monitor.messages():
+            if topic == "car/cmd" and len(payload) == 24:
+                send_us = struct.unpack_from("<I", payload, 8)[0]
+                latencies.append(((now_us() - send_us) & 0xFFFFFFFF) / 1000.0)
+            if stop.is_set():
+                return
+
+    threading.Thread(target=monitor_loop, daemon=True).start()
+    sent = 0
+    period = 1.0 / args.hz
+    next_tick = time.monotonic()
+    end = next_tick + args.seconds
+    while time.monotonic() < end:
+        sent += 1
+        control.publish("car/cmd", frame_v2(CMD_MOVE, sent, now_us(), bytes(12)))
+        next_tick += period
+        time.sleep(max(0.0, next_tick - time.monotonic()))
+    time.sleep(0.2)
+    stop.set()
+    control.close()
+    monitor.close()
+    summary("mqtt", latencies, sent)
+
+
+def run_udp(args):
+    rx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    rx.bind(("127.0.0.1", 0))
+    rx.settimeout(0.05)
+    tx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx.connect(rx.getsockname())
+    receiver = LatestWins()
+    latencies = []
+    stop = threading.Event()
+
+    def receive_loop():
+        while not stop.is_set():
+            try:
+                data = rx.recv(2048)
+            except socket.timeout:
+                continue
+            got = receiver.offer(data)
+            if got is not None:
+                latencies.append(((now_us() - got[2]) & 0xFFFFFFFF) / 1000.0)
+
+    thread = threading.Thread(target=receive_loop, daemon=True)
+    thread.start()
+    sent = 0
+    period = 1.0 / args.hz
+    next_tick = time.monotonic()
+    end = next_tick + args.seconds
+    while time.monotonic() < end:
+        sent += 1
+        packet = frame_v2(CMD_MOVE, sent, now_us(), bytes(12))
+        for _ in range(args.copies):
+            if random.random() >= args.drop:
+                tx.send(packet)
+        next_tick += period
+        time.sleep(max(0.0, next_tick - time.monotonic()))
+    time.sleep(0.2)
+    stop.set()
+    thread.join()
+    summary("udp", latencies, sent, " | %d 份冗余, 丢包 %.0f%% | 去重 %d | 过期 %d" % (
+        args.copies, args.drop * 100, receiver.duplicates, receiver.stale))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="打击通道单向时延：MQTT 经 broker vs UDP 直连")
+    parser.add_argument("--hz", type=float, default=500, help="发送频率")
+    parser.add_argument("--seconds", type=float, default=5.0, help="每条路径时长")
+    parser.add_argument("--copies", type=int, default=2, help="UDP 每条报文的副本数")
+    parser.add_argument("--drop", type=float, default=0.0, help="UDP 每份副本的丢包概率 (0~1)")
+    parser.add_argument("--link-kbps", type=float, default=100000, help="broker 替身的上行带宽 (kbit/s)，默认不成瓶颈")
+    args = parser.parse_args()
+
+    print(">>> %.0f Hz，每条路径 %.1f 秒" % (args.hz, args.seconds))
+    run_mqtt(args)
+    run_udp(args)
+
+
+if __name__ == "__main__":
+    main()
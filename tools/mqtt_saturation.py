@@ -0,0 +1,394 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+MQTT 通道拆分压测 —— 自带一个 mosquitto 替身，只用标准库，不装任何依赖就能跑
+
+替身 broker 支持 MQTT 3.1.1 的 CONNECT / PUBLISH (QoS 0/1) / SUBSCRIBE / PING / DISCONNECT，
+并模拟一条共享的 Wi-Fi 上行：所有连接发往 broker 的字节按 --link-kbps 限速，
+各连接之间按轮询公平分配 (和 AP 上各 TCP 流大致公平分带宽一样)，
+每条连接的接收缓冲有上限，塞满后 TCP 自然反压到发送端。
+
+压测在同一进程里对比三种接法下控制报文 (50Hz，模拟 car/cmd) 的单向时延：
+  shared        控制和大块数据共用一条连接 (拆分前的 MqttClientManager)
+  split         控制、大块各一条连接，大块不限速
+  split+limit   各一条连接，大块按 --bulk-kbps 限速 (对应 CAR_HMI_BULK_BPS 的默认配置)
+
+用法：
+  python3 mqtt_saturation.py                      # 跑压测，打印各场景控制时延 p50 / p99 / max
+  python3 mqtt_saturation.py --serve --port 1883  # 只起替身 broker，给上位机 + sim_controller.py 用
+  python3 mqtt_saturation.py --flood 3200 --host <broker> --port 1883
+                                                  # 在上位机上跑：往真实 broker 持续灌大块数据占满上行，
+                                                  # 同时 CAR_HMI_TRACE=1 ./car_hmi 看 [往返时延] 里移动指令是否平稳
+"""
+
+import argparse
+import socket
+import struct
+import threading
+import time
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 12, 13, 14
+
+SOCK_BUF = 64 * 1024      # 每条连接在 broker 侧最多攒这么多没过"链路"的字节
+QUANTUM = 1500            # 轮询时每条连接每轮过一个 MTU
+
+
+def encode_length(n):
+    out = bytearray()
+    while True:
+        byte = n % 128
+        n //= 128
+        out.append(byte | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def packet(kind, flags, body):
+    return bytes([(kind << 4) | flags]) + encode_length(len(body)) + body
+
+
+def mqtt_string(s):
+    data = s.encode()
+    return struct.pack("!H", len(data)) + data
+
+
+def split_packet(buf):
+    """从 buf 头部切出一个完整报文，返回 (首字节, 报文体, 消耗字节数)；不完整返回 None"""
+    if len(buf) < 2:
+        return None
+    mult, length, pos = 1, 0, 1
+    while True:
+        if pos >= len(buf):
+            return None
+        byte = buf[pos]
+        length += (byte & 0x7F) * mult
+        mult *= 128
+        pos += 1
+        if not byte & 0x80:
+            break
+    if len(buf) < pos + length:
+        return None
+    return buf[0], bytes(buf[pos:pos + length]), pos + length
+
+
+def topic_matches(pattern, topic):
+    p, t = pattern.split("/"), topic.split("/")
+    for i, part in enumerate(p):
+        if part == "#":
+            return True
+        if i >= len(t) or (part != "+" and part != t[i]):
+            return False
+    return len(p) == len(t)
+
+
+# ===================== 替身 broker =====================
+
+class Conn:
+    def __init__(self, sock):
+        self.sock = sock
+        self.pending = bytearray()    # 已从 socket 读出、还没过链路
+        self.linked = bytearray()     # 已过链路、待解析
+        self.subs = []
+        self.send_lock = threading.Lock()
+        self.alive = True
+
+
+class Broker:
+    def __init__(self, port, link_kbps):
+        self.rate = link_kbps * 1000 / 8.0
+        self.lock = threading.Condition()
+        self.conns = []
+        self.server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server.bind(("127.0.0.1", port))
+        self.server.listen(16)
+        self.port = self.server.getsockname()[1]
+
+    def start(self):
+        threading.Thread(target=self.accept_loop, daemon=True).start()
+        threading.Thread(target=self.link_loop, daemon=True).start()
+        return self
+
+    def accept_loop(self):
+        while True:
+            sock, _ = self.server.accept()
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, SOCK_BUF)
+            conn = Conn(sock)
+            with self.lock:
+                self.conns.append(conn)
+            threading.Thread(target=self.read_loop, args=(conn,), daemon=True).start()
+
+    def read_loop(self, conn):
+        while conn.alive:
+            with self.lock:
+                # 缓冲满了就不读，让发送端的 TCP 窗口关上
+                self.lock.wait_for(lambda: len(conn.pending) < SOCK_BUF or not conn.alive)
+            try:
+                data = conn.sock.recv(SOCK_BUF)
+            except OSError:
+                data = b""
+            with self.lock:
+                if not data:
+                    conn.alive = False
+                    self.conns.remove(conn)
+                    return
+                conn.pending += data
+                self.lock.notify_all()
+
+    def link_loop(self):
+        last = time.monotonic()
+        credit = 0.0
+        turn = 0
+        while True:
+            time.sleep(0.0005)
+            now = time.monotonic()
+            credit = min(credit + (now - last) * self.rate, self.rate * 0.01)
+            last = now
+            ready = []
+            with self.lock:
+                while credit >= 1:
+                    busy = [c for c in self.conns if c.pending]
+                    if not busy:
+                        credit = 0.0
+                        break
+                    conn = busy[turn % len(busy)]
+                    turn += 1
+                    n = int(min(QUANTUM, len(conn.pending), credit))
+                    conn.linked += conn.pending[:n]
+                    del conn.pending[:n]
+                    credit -= n
+                    if conn not in ready:
+                        ready.append(conn)
+                self.lock.notify_all()
+            for conn in ready:
+                self.parse(conn)
+
+    def parse(self, conn):
+        while True:
+            cut = split_packet(conn.linked)
+            if cut is None:
+                return
+            first, body, used = cut
+            del conn.linked[:used]
+            self.handle(conn, first >> 4, first & 0x0F, body)
+
+    def send(self, conn, data):
+        try:
+            with conn.send_lock:
+                conn.sock.sendall(data)
+        except OSError:
+            conn.alive = False
+
+    def handle(self, conn, kind, flags, body):
+        if kind == CONNECT:
+            self.send(conn, packet(CONNACK, 0, b"\x00\x00"))
+        elif kind == PUBLISH:
+            qos = (flags >> 1) & 0x03
+            tlen = struct.unpack_from("!H", body, 0)[0]
+            topic = body[2:2 + tlen].decode()
+            pos = 2 + tlen
+            if qos:
+                self.send(conn, packet(PUBACK, 0, body[pos:pos + 2]))
+                pos += 2
+            out = packet(PUBLISH, 0, mqtt_string(topic) + body[pos:])
+            with self.lock:
+                targets = [c for c in self.conns if any(topic_matches(s, topic) for s in c.subs)]
+            for target in targets:
+                self.send(target, out)
+        elif kind == SUBSCRIBE:
+            pid, pos, granted = body[:2], 2, bytearray()
+            while pos < len(body):
+                tlen = struct.unpack_from("!H", body, pos)[0]
+                conn.subs.append(body[pos + 2:pos + 2 + tlen].decode())
+                pos += 2 + tlen + 1
+                granted.append(0)
+            self.send(conn, packet(SUBACK, 0, pid + bytes(granted)))
+        elif kind == PINGREQ:
+            self.send(conn, packet(PINGRESP, 0, b""))
+        elif kind == DISCONNECT:
+            conn.alive = False
+            conn.sock.close()
+
+
+# ===================== 压测客户端 =====================
+
+class Client:
+    def __init__(self, port, client_id, host="127.0.0.1"):
+        self.sock = socket.create_connection((host, port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_SNDBUF, SOCK_BUF)
+        self.lock = threading.Lock()   # 共用连接时两个发送线程抢同一个 socket，和 Paho 单连接一样
+        body = mqtt_string("MQTT") + bytes([4, 0x02]) + struct.pack("!H", 30) + mqtt_string(client_id)
+        self.sock.sendall(packet(CONNECT, 0, body))
+        self.read_exact(4)
+
+    def read_exact(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError("broker 断开")
+            data += chunk
+        return data
+
+    def publish(self, topic, payload):
+        with self.lock:
+            self.sock.sendall(packet(PUBLISH, 0, mqtt_string(topic) + payload))
+
+    def subscribe(self, topic):
+        self.sock.sendall(packet(SUBSCRIBE, 0x02, b"\x00\x01" + mqtt_string(topic) + b"\x00"))
+        self.read_exact(5)
+
+    def messages(self):
+        buf = bytearray()
+        while True:
+            cut = split_packet(buf)
+            if cut is None:
+                chunk = self.sock.recv(65536)
+                if not chunk:
+                    return
+                buf += chunk
+                continue
+            first, body, used = cut
+            del buf[:used]
+            if first >> 4 == PUBLISH:
+                tlen = struct.unpack_from("!H", body, 0)[0]
+                yield body[2:2 + tlen].decode(), body[2 + tlen:]
+
+    def close(self):
+        try:
+            self.sock.sendall(packet(DISCONNECT, 0, b""))
+            self.sock.close()
+        except OSError:
+            pass
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p * len(values)))]
+
+
+def run_scenario(port, name, split, bulk_kbps, seconds, control_hz, bulk_size):
+    latencies = []                 # (发送时刻 ns, 时延 ms)
+    stop = threading.Event()
+    bulk_bytes = [0]
+    control_sent = [0]
+
+    start_ns = time.monotonic_ns()
+    monitor = Client(port, "bench_monitor_" + name)
+    monitor.subscribe("car/cmd")
+
+    def monitor_loop():
+        for topic, payload in monitor.messages():
+            if topic == "car/cmd" and len(payload) >= 8:
+                sent = struct.unpack_from("<Q", payload, 0)[0]
+                if sent < start_ns:
+                    continue   # 上一个场景残留在链路里的
+                latencies.append((sent, (time.monotonic_ns() - sent) / 1e6))
+            if stop.is_set():
+                return
+
+    control = Client(port, "bench_control_" + name)
+    bulk = Client(port, "bench_bulk_" + name) if split else control
+
+    def control_loop():
+        period = 1.0 / control_hz
+        next_tick = time.monotonic()
+        while not stop.is_set():
+            # 12 字节 v2 帧头 + 12 字节 MovePayload 的大小，前 8 字节放发送时刻
+            control.publish("car/cmd", struct.pack("<Q", time.monotonic_ns()) + bytes(16))
+            control_sent[0] += 1
+            next_tick += period
+            time.sleep(max(0.0, next_tick - time.monotonic()))
+
+    def bulk_loop():
+        filler = bytes(bulk_size)
+        rate = bulk_kbps * 1000 / 8.0
+        start = time.monotonic()
+        while not stop.is_set():
+            if rate > 0:
+                ahead = bulk_bytes[0] / rate - (time.monotonic() - start)
+                if ahead > 0:
+                    time.sleep(ahead)
+            bulk.publish("car/bulk/flood", filler)
+            bulk_bytes[0] += len(filler)
+
+    threads = [threading.Thread(target=f, daemon=True) for f in (monitor_loop, control_loop, bulk_loop)]
+    for t in threads:
+        t.start()
+    time.sleep(seconds)
+    stop.set()
+    time.sleep(0.2)
+    for c in {control, bulk, monitor}:
+        c.close()
+
+    # 丢掉前 1 秒发出的 (链路刚被塞满的过渡段)；结束时还没送达的单独计数
+    steady = [ms for sent, ms in latencies if sent - start_ns >= 1e9]
+    print("%-12s 控制 送达 %4d / %4d | p50 %8.1f ms | p99 %8.1f ms | max %8.1f ms | 大块写出 %6.0f KB/秒" % (
+        name, len(latencies), control_sent[0], percentile(steady, 0.5), percentile(steady, 0.99),
+        max(steady) if steady else float("nan"), bulk_bytes[0] / 1024.0 / seconds))
+    return steady
+
+
+def run_flood(host, port, kbps, bulk_size):
+    """按 kbps 往 car/bulk/flood 持续发大块报文，Ctrl+C 结束 (原先 car_hmi 里 CAR_HMI_BULK_FLOOD 的做法)"""
+    client = Client(port, "car_hmi_flood", host)
+    filler = bytes([0xA5]) * bulk_size
+    rate = kbps * 1000 / 8.0
+    sent = 0
+    start = time.monotonic()
+    last_report = start
+    print(">>> 大块灌流已开启: %s:%d | %.0f kbit/s | 单条 %d 字节" % (host, port, kbps, bulk_size))
+    try:
+        while True:
+            ahead = sent / rate - (time.monotonic() - start)
+            if ahead > 0:
+                time.sleep(ahead)
+            client.publish("car/bulk/flood", filler)
+            sent += len(filler)
+            now = time.monotonic()
+            if now - last_report >= 10.0:
+                print(">>> 已写出 %.0f KB (%.0f KB/秒)" % (sent / 1024.0, sent / 1024.0 / (now - start)))
+                last_report = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="MQTT 控制 / 大块通道拆分压测 (自带 broker 替身)")
+    parser.add_argument("--serve", action="store_true", help="只运行替身 broker")
+    parser.add_argument("--port", type=int, default=0, help="替身 broker 端口，0 为随机；--flood 时为目标 broker 端口")
+    parser.add_argument("--flood", type=float, default=0, metavar="KBPS",
+                        help="不起替身，按该速率 (kbit/s) 往 --host:--port 的 broker 持续灌大块数据")
+    parser.add_argument("--host", default="127.0.0.1", help="--flood 的目标 broker 地址")
+    parser.add_argument("--link-kbps", type=float, default=4000, help="模拟上行带宽 (kbit/s)")
+    parser.add_argument("--bulk-kbps", type=float, default=2048, help="split+limit 场景大块限速 (kbit/s)")
+    parser.add_argument("--bulk-size", type=int, default=16384, help="单条大块报文字节数")
+    parser.add_argument("--control-hz", type=int, default=50)
+    parser.add_argument("--seconds", type=float, default=6.0, help="每个场景时长")
+    args = parser.parse_args()
+
+    if args.flood > 0:
+        run_flood(args.host, args.port or 1883, args.flood, args.bulk_size)
+        return
+
+    broker = Broker(args.port, args.link_kbps).start()
+    if args.serve:
+        print(">>> broker 替身已启动: 127.0.0.1:%d | 上行 %.0f kbit/s" % (broker.port, args.link_kbps))
+        while True:
+            time.sleep(3600)
+
+    print(">>> 模拟上行 %.0f kbit/s，控制 %d Hz，大块单条 %d 字节" % (args.link_kbps, args.control_hz, args.bulk_size))
+    run_scenario(broker.port, "shared", False, 0, args.seconds, args.control_hz, args.bulk_size)
+    run_scenario(broker.port, "split", True, 0, args.seconds, args.control_hz, args.bulk_size)
+    run_scenario(broker.port, "split+limit", True, args.bulk_kbps, args.seconds, args.control_hz, args.bulk_size)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+模拟下位机 (ESP32) —— 不上车就能验证上位机的协议、回显和时延统计
+
+订阅 car/cmd，按 protocol_def.h 解析 v1 (0x5A) / v2 (0x5B) 帧头：
+  - v2 且带 FRAME_FLAG_ECHO 的报文回一条 CMD_ECHO 到 car/status (原样带回 seq / sendUs)
+  - CMD_CONTROL 回一条同内容的 CMD_CONTROL 状态 (上位机界面上的模式 / 激光状态)
+  - 可按 --status-hz 周期性上报 CMD_CONTROL 状态，模拟高频遥测
+  - --delay-ms / --jitter-ms / --drop 模拟链路和固件处理的延迟、抖动、丢包
+  - --udp-port 同时收 UDP 打击通道 (CAR_HMI_FIRE_UDP)，按 seq 最新者胜，回显照样走 car/status
+
+用法 (本机起一个 mosquitto)：
+  mosquitto -p 1883 &
+  python3 sim_controller.py --broker 127.0.0.1 --delay-ms 3 --jitter-ms 2 --drop 0.01
+  CAR_HMI_TRACE=1 ./car_hmi        # 连接 127.0.0.1:1883，10 秒一次输出 [往返时延] 统计
+  python3 sim_controller.py --udp-port 9010 & CAR_HMI_FIRE_UDP=9010 CAR_HMI_TRACE=1 ./car_hmi
+依赖：pip install paho-mqtt
+"""
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+import paho.mqtt.client as mqtt
+
+from fire_latency import LatestWins
+
+MAGIC_V1 = 0x5A
+MAGIC_V2 = 0x5B
+FLAG_ECHO = 0x01
+
+CMD_MOVE = 0x01
+CMD_CONTROL = 0x02
+CMD_TARGET = 0x03
+CMD_TARGET_BATCH = 0x04
+CMD_ECHO = 0x05
+
+NAMES = {0x00: "心跳", CMD_MOVE: "移动", CMD_CONTROL: "控制", CMD_TARGET: "目标",
+         CMD_TARGET_BATCH: "批量目标", CMD_ECHO: "回显"}
+
+
+def frame_v1(cmd, payload):
+    return struct.pack("<BBH", MAGIC_V1, cmd, len(payload)) + payload
+
+
+def parse(data):
+    """返回 (type, payload, seq, send_us, flags)；非法报文返回 None"""
+    if len(data) < 4:
+        return None
+    magic, cmd, length = struct.unpack_from("<BBH", data, 0)
+    if magic == MAGIC_V1:
+        head = 4
+        seq = send_us = flags = None
+    elif magic == MAGIC_V2:
+        if len(data) < 12:
+            return None
+        version, flags, seq, send_us = struct.unpack_from("<BBHI", data, 4)
+        if version != 2:
+            return None
+        head = 12
+    else:
+        return None
+    if len(data) != head + length:
+        return None
+    return cmd, data[head:], seq, send_us, flags
+
+
+class SimController:
+    def __init__(self, args):
+        self.args = args
+        self.client = mqtt.Client(client_id="SimController")
+        self.client.on_connect = self.on_connect
+        self.client.on_message = self.on_message
+        self.lock = threading.Lock()
+        self.mode = 0
+        self.led = 0
+        self.counts = {}
+        self.dropped = 0
+        self.udp = LatestWins()
+
+    def on_connect(self, client, userdata, flags, rc):
+        print(">>> 模拟下位机已连接 broker, rc =", rc)
+        client.subscribe("car/cmd", qos=0)
+
+    def publish(self, packet):
+        self.client.publish("car/status", packet, qos=0)
+
+    def on_message(self, client, userdata, msg):
+        self.handle(msg.payload, time.monotonic())
+
+    def udp_loop(self):
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.bind(("0.0.0.0", self.args.udp_port))
+        print(">>> UDP 打击通道监听端口", self.args.udp_port)
+        while True:
+            data = sock.recv(2048)
+            recv = time.monotonic()
+            # 冗余副本和迟到的旧序号在这里丢掉，和固件一样只执行最新的
+            with self.lock:
+                fresh = self.udp.offer(data) is not None
+            if fresh:
+                self.handle(data, recv)
+
+    def handle(self, data, recv):
+        parsed = parse(data)
+        if parsed is None:
+            print("【警告】收到非法报文:", data.hex())
+            return
+        cmd, payload, seq, send_us, flags = parsed
+        with self.lock:
+            self.counts[cmd] = self.counts.get(cmd, 0) + 1
+        if random.random() < self.args.drop:
+            with self.lock:
+                self.dropped += 1
+            return
+
+        if cmd == CMD_CONTROL and len(payload) == 4:
+            self.mode, self.led = payload[0], payload[1]
+            self.publish(frame_v1(CMD_CONTROL, payload))
+
+        if seq is not None and flags & FLAG_ECHO:
+            delay = self.args.delay_ms + random.uniform(0, self.args.jitter_ms)
+            proc_us = int((time.monotonic() - recv) * 1e6 + delay * 1000)
+            echo = struct.pack("<BBHIHH", cmd, 0, seq, send_us, min(proc_us, 0xFFFF), 0)
+            packet = frame_v1(CMD_ECHO, echo)
+            if delay > 0:
+                threading.Timer(delay / 1000.0, self.publish, args=(packet,)).start()
+            else:
+                self.publish(packet)
+
+    def status_loop(self):
+        period = 1.0 / self.args.status_hz
+        while True:
+            time.sleep(period)
+            self.publish(frame_v1(CMD_CONTROL, bytes([self.mode, self.led, 0, 0])))
+
+    def report_loop(self):
+        while True:
+            time.sleep(10)
+            with self.lock:
+                summary = ", ".join("%s %d" % (NAMES.get(k, hex(k)), v) for k, v in sorted(self.counts.items()))
+                print(">>> 10 秒内收到:", summary or "无", "| 模拟丢弃", self.dropped)
+                if self.args.udp_port:
+                    print("    UDP 采纳 %d | 去重 %d | 过期 %d | 非法 %d" % (
+                        self.udp.accepted, self.udp.duplicates, self.udp.stale, self.udp.malformed))
+                    self.udp.accepted = self.udp.duplicates = self.udp.stale = self.udp.malformed = 0
+                self.counts.clear()
+                self.dropped = 0
+
+    def run(self):
+        self.client.connect(self.args.broker, self.args.port, keepalive=5)
+        if self.args.status_hz > 0:
+            threading.Thread(target=self.status_loop, daemon=True).start()
+        threading.Thread(target=self.report_loop, daemon=True).start()
+        if self.args.udp_port:
+            threading.Thread(target=self.udp_loop, daemon=True).start()
+        self.client.loop_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="模拟 ESP32 下位机 (协议回显 / 遥测)")
+    parser.add_argument("--broker", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--delay-ms", type=float, default=0.0, help="回显前固定延迟")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="回显前额外随机延迟上限")
+    parser.add_argument("--drop", type=float, default=0.0, help="丢弃收到报文的概率 (0~1)")
+    parser.add_argument("--status-hz", type=float, default=0.0, help="周期上报 CMD_CONTROL 状态的频率")
+    parser.add_argument("--udp-port", type=int, default=0, help="UDP 打击通道端口，0 为不监听")
+    SimController(parser.parse_args()).run()
+
+
+if __name__ == "__main__":
+    main()